@@ -40,6 +40,8 @@
 import os
 import unittest
 import logging
+import hashlib
+import json
 import vtk, qt, ctk, slicer
 from vtk.util.numpy_support import vtk_to_numpy, numpy_to_vtk
 from slicer.ScriptedLoadableModule import *
@@ -180,6 +182,11 @@ class LiverWidget(ScriptedLoadableModuleWidget):
     self.numComps = 0
     self._distanceContourNode = None
     self._preprocessedLiverNode = None
+    # Segments edited since the label maps of the distance maps were exported
+    self._distanceMapSegmentation = None
+    self._distanceMapSegmentationObserver = None
+    self._distanceMapSegmentIds = None
+    self._modifiedDistanceMapSegmentIds = set()
 
   def setup(self):
     """
@@ -273,6 +280,8 @@ class LiverWidget(ScriptedLoadableModuleWidget):
     self.resectionsWidget.GridThicknessDoubleSlider.connect('valueChanged(double)', self.onGridThicknessChanged)
     self.resectionsWidget.Grid3DVisibility.connect('stateChanged(int)', self.onGrid3DVisibilityChanged)
     self.resectionsWidget.ResectionLockCheckBox.connect('stateChanged(int)', self.onResectionLockChanged)
+    self.resectionsWidget.UndoResectionEditButton.connect('clicked(bool)', self.onUndoResectionEdit)
+    self.resectionsWidget.RedoResectionEditButton.connect('clicked(bool)', self.onRedoResectionEdit)
     self.resectionsWidget.UncertaintyMarginSpinBox.connect('valueChanged(double)', self.onUncertaintyMarginChanged)
     self.resectionsWidget.UncertaintyMarginColorPickerButton.connect('colorChanged(QColor)', self.onUncertaintyMarginColorChanged)
     self.resectionsWidget.UncertaintyMarginComboBox.connect('currentIndexChanged(int)', self.onUncertaintyMaginComboBoxChanged)
@@ -305,7 +314,6 @@ class LiverWidget(ScriptedLoadableModuleWidget):
       segmentationNode.CreateClosedSurfaceRepresentation()
       liverNode = segmentationNode.GetClosedSurfaceInternalRepresentation(parenchymaSegmentId)
 
-    # liverNode = self.logic.preprocessing(segmentationNode, parenchymaSegmentId)
     if rdbutton.isChecked():
       if rdbutton.text == "Curved":
         lvLogic.HideInitializationMarkupFromResection(activeResectionNode)
@@ -316,29 +324,21 @@ class LiverWidget(ScriptedLoadableModuleWidget):
         liverNode = activeResectionNode.GetTargetOrganModelNode()
         if self._distanceContourNode is not None:
           self._distanceContourNode.SetDisplayVisibility(True)
-          liverPolyData = liverNode.GetPolyData()
-          self._preprocessedLiverNode = self.logic.preprocessing(liverPolyData)
           self._distanceContourNode.AddObserver(slicer.vtkMRMLMarkupsNode.PointEndInteractionEvent,
-                                               lambda x, y: self.logic.runSurfacefromEFD(activeResectionNode,
-                                                                                         self._distanceContourNode,
-                                                                                         self._preprocessedLiverNode))
+                                               lambda x, y: self.onDistanceContourEndInteraction(activeResectionNode, x))
           self._distanceContourNode.AddObserver(slicer.vtkMRMLMarkupsNode.PointModifiedEvent,
                                           self.onDistanceContourStartInteraction)
         else:
           activeResectionNode.SetInitMode(activeResectionNode.Curved)
           activeResectionNode.SetTargetOrganModelNode(liverNode)
           lvLogic.AddResectionContour(activeResectionNode)
-          liverPolyData = liverNode.GetPolyData()
-          self._preprocessedLiverNode = self.logic.preprocessing(liverPolyData)
           node = slicer.util.getNodesByClass("vtkMRMLMarkupsDistanceContourNode")[-1]
           self.resectionsWidget.DistanceContourComboBox.setCurrentNode(node)
           # self._distanceContourNode = slicer.mrmlScene.GetFirstNodeByClass("vtkMRMLMarkupsDistanceContourNode")
           self._distanceContourNode = self.resectionsWidget.DistanceContourComboBox.currentNode()
 
           self._distanceContourNode.AddObserver(slicer.vtkMRMLMarkupsNode.PointEndInteractionEvent,
-                                        lambda x, y: self.logic.runSurfacefromEFD(activeResectionNode,
-                                                                                  self._distanceContourNode,
-                                                                                  self._preprocessedLiverNode))
+                                        lambda x, y: self.onDistanceContourEndInteraction(activeResectionNode, x))
           self._distanceContourNode.AddObserver(slicer.vtkMRMLMarkupsNode.PointModifiedEvent,
                                         self.onDistanceContourStartInteraction)
           BezierNode = activeResectionNode.GetBezierSurfaceNode()
@@ -642,6 +642,16 @@ class LiverWidget(ScriptedLoadableModuleWidget):
     lvLogic = slicer.modules.liverresections.logic()
     lvLogic.HideBezierSurfaceMarkupFromResection(self._currentResectionNode)
 
+  def onDistanceContourEndInteraction(self, resectionNode, distanceContourNode):
+    """
+    This function is called when distance contour end interaction. Contours registered with the
+    resections logic are refitted by the logic itself.
+    """
+    lvLogic = slicer.modules.liverresections.logic()
+    if lvLogic.GetResectionRegistry().Contains(distanceContourNode):
+      return
+    lvLogic.InitializeCurvedResection(resectionNode, distanceContourNode)
+
   def BezierSurfaceModified(self, distanceNode):
     distanceNode.SetDisplayVisibility(False)
 
@@ -675,11 +685,28 @@ class LiverWidget(ScriptedLoadableModuleWidget):
       self._currentResectionNode.SetClipOut(self.resectionsWidget.ResectionLockCheckBox.isChecked())
       self._currentResectionNode.SetWidgetVisibility(not self.resectionsWidget.ResectionLockCheckBox.isChecked())
 
+  def onUndoResectionEdit(self):
+    """
+    This function is called when the undo edit button is clicked.
+    """
+    if self._currentResectionNode is not None:
+      slicer.modules.liverresections.logic().UndoResectionEdit(self._currentResectionNode)
+
+  def onRedoResectionEdit(self):
+    """
+    This function is called when the redo edit button is clicked.
+    """
+    if self._currentResectionNode is not None:
+      slicer.modules.liverresections.logic().RedoResectionEdit(self._currentResectionNode)
+
   def onComputeDistanceMapButtonClicked(self):
     """
     This function is called when the distance map calculation button is pressed
     """
 
+    # The label maps of a running computation are removed before exporting new ones
+    self.logic.cancelProgressiveDistanceMaps()
+
     qt.QApplication.setOverrideCursor(qt.Qt.WaitCursor)
     segmentationNode = self.distanceMapsWidget.SegmentationSelectorComboBox.currentNode()
     refVolumeNode = self.distanceMapsWidget.ReferenceVolumeSelector.currentNode()
@@ -689,6 +716,11 @@ class LiverWidget(ScriptedLoadableModuleWidget):
     portalSegmentId = self.distanceMapsWidget.PortalSegmentSelectorWidget.currentSegmentID()
     segmentationIds = vtk.vtkStringArray()
 
+    # Only the structures edited since the last export are updated
+    segmentIds = [tumorSegmentId, parenchymaSegmentId, hepaticSegmentId, portalSegmentId]
+    modifiedStructures = self.modifiedDistanceMapStructures(segmentationNode, segmentIds)
+    self.observeDistanceMapSegments(segmentationNode, segmentIds)
+
     """
     Export labelmaps volumes for the selected segmentations
     """
@@ -750,19 +782,82 @@ class LiverWidget(ScriptedLoadableModuleWidget):
     # threeDView = threeDWidget.threeDView()
     # threeDView.resetFocalPoint()
 
+    labelMapVolumeNodes = [tumorLabelmapVolumeNode, parenchymaLabelmapVolumeNode, hepaticLabelmapVolumeNode, portalLabelmapVolumeNode]
+
+    def removeLabelMapVolumeNodes():
+      # slicer.app.resumeRender()
+      for labelMapVolumeNode in labelMapVolumeNodes:
+        slicer.mrmlScene.RemoveNode(labelMapVolumeNode)
+
     downSamplingRate = self.distanceMapsWidget.DownsamplingRateSpinBox.value
-    self.logic.computeDistanceMaps(tumorLabelmapVolumeNode, parenchymaLabelmapVolumeNode, hepaticLabelmapVolumeNode, portalLabelmapVolumeNode, outputVolumeNode, downSamplingRate)
 
-    # slicer.app.resumeRender()
-    slicer.mrmlScene.RemoveNode(tumorLabelmapVolumeNode)
-    slicer.mrmlScene.RemoveNode(parenchymaLabelmapVolumeNode)
-    slicer.mrmlScene.RemoveNode(hepaticLabelmapVolumeNode)
-    slicer.mrmlScene.RemoveNode(portalLabelmapVolumeNode)
+    # After segmentation edits only the changed regions are recomputed
+    if self.logic.updateDistanceMaps(*labelMapVolumeNodes, outputVolumeNode, downSamplingRate,
+                                     cache=self.logic.distanceMapCache, modifiedStructures=modifiedStructures):
+      removeLabelMapVolumeNodes()
+      qt.QApplication.restoreOverrideCursor()
+      slicer.util.showStatusMessage("Distance maps updated.", 3000)
+      return
+
+    if downSamplingRate != 1:
+      self.logic.computeDistanceMaps(*labelMapVolumeNodes, outputVolumeNode, downSamplingRate,
+                                     cache=self.logic.distanceMapCache)
+      removeLabelMapVolumeNodes()
+      #slicer.app.resumeRender()
+      qt.QApplication.restoreOverrideCursor()
+      qt.QMessageBox.information(None, "Information", "Distance maps computed.")
+      slicer.util.showStatusMessage('')
+      return
+
+    # A coarse distance map is shown right away and refined in the background;
+    # the label maps are needed until the last level
+    def onDistanceMapsFinished(completed):
+      removeLabelMapVolumeNodes()
+      if completed:
+        slicer.util.showStatusMessage("Distance maps computed.", 3000)
+
+    slicer.util.showStatusMessage("Refining distance maps...")
+    try:
+      self.logic.computeDistanceMapsProgressive(*labelMapVolumeNodes, outputVolumeNode,
+                                                cache=self.logic.distanceMapCache,
+                                                finished=onDistanceMapsFinished)
+    finally:
+      qt.QApplication.restoreOverrideCursor()
 
-    #slicer.app.resumeRender()
-    qt.QApplication.restoreOverrideCursor()
-    qt.QMessageBox.information(None, "Information", "Distance maps computed.")
-    slicer.util.showStatusMessage('')
+  def observeDistanceMapSegments(self, segmentationNode, segmentIds):
+    """
+    Records the segments of the segmentation edited from now on, for the next
+    distance map update
+    """
+    segmentation = segmentationNode.GetSegmentation() if segmentationNode is not None else None
+    if segmentation is not self._distanceMapSegmentation:
+      self.removeDistanceMapSegmentationObserver()
+      if segmentation is not None:
+        self._distanceMapSegmentationObserver = segmentation.AddObserver(slicer.vtkSegmentation.SegmentModified,
+                                                                         self.onDistanceMapSegmentModified)
+      self._distanceMapSegmentation = segmentation
+    self._distanceMapSegmentIds = segmentIds
+    self._modifiedDistanceMapSegmentIds = set()
+
+  def removeDistanceMapSegmentationObserver(self):
+    if self._distanceMapSegmentationObserver is not None:
+      self._distanceMapSegmentation.RemoveObserver(self._distanceMapSegmentationObserver)
+    self._distanceMapSegmentation = None
+    self._distanceMapSegmentationObserver = None
+
+  @vtk.calldata_type(vtk.VTK_STRING)
+  def onDistanceMapSegmentModified(self, caller, event, segmentId):
+    self._modifiedDistanceMapSegmentIds.add(segmentId)
+
+  def modifiedDistanceMapStructures(self, segmentationNode, segmentIds):
+    """
+    Structures (tumor, parenchyma, hepatic, portal) whose segment was edited or
+    selected since the last export of the label maps, None if unknown
+    """
+    if segmentationNode is None or segmentationNode.GetSegmentation() is not self._distanceMapSegmentation:
+      return None
+    return [structure for structure, segmentId in enumerate(segmentIds)
+            if segmentId != self._distanceMapSegmentIds[structure] or segmentId in self._modifiedDistanceMapSegmentIds]
 
   def onUncertaintyMaginComboBoxChanged(self):
     """
@@ -961,7 +1056,9 @@ class LiverWidget(ScriptedLoadableModuleWidget):
     """
     Called when the application closes and the module widget is destroyed.
     """
-    pass
+    if self.logic is not None:
+      self.logic.cancelProgressiveDistanceMaps()
+    self.removeDistanceMapSegmentationObserver()
 
   def enter(self):
     """
@@ -976,6 +1073,177 @@ class LiverWidget(ScriptedLoadableModuleWidget):
     pass
 
 
+#
+# DistanceMapCache
+#
+
+class DistanceMapCache:
+  """
+  Content-addressed on-disk cache of composite distance maps. Entries are
+  keyed by a hash of the label maps (voxels and geometry) and of the
+  computation parameters, and stored as numpy files under the Slicer cache
+  directory that are memory mapped when loaded. The least recently used
+  entries are evicted beyond maximumSize (bytes).
+  """
+
+  FormatVersion = 1
+
+  def __init__(self, directory=None, maximumSize=None):
+    if directory is None:
+      directory = os.path.join(slicer.app.cachePath, "LiverDistanceMaps")
+    if maximumSize is None:
+      maximumSize = int(qt.QSettings().value("Liver/DistanceMapCacheMaximumSizeMB", 2048)) * 1024 * 1024
+    self.directory = directory
+    self.maximumSize = maximumSize
+
+  def paths(self, key):
+    return os.path.join(self.directory, key + ".npy"), os.path.join(self.directory, key + ".json")
+
+  @staticmethod
+  def matrixToList(matrix):
+    return [matrix.GetElement(row, column) for row in range(4) for column in range(4)]
+
+  def key(self, labelMapNodes, parameters):
+    """
+    Hash of the label maps (voxels, scalar type and IJK to RAS) and of the
+    parameters (a dictionary of the computation settings)
+    """
+    digest = hashlib.sha256()
+    digest.update(f"format={self.FormatVersion};".encode())
+    for name, value in sorted(parameters.items()):
+      digest.update(f"{name}={value!r};".encode())
+    for node in labelMapNodes:
+      if node is None or node.GetImageData() is None:
+        digest.update(b"none;")
+        continue
+      array = np.ascontiguousarray(slicer.util.arrayFromVolume(node))
+      ijkToRAS = vtk.vtkMatrix4x4()
+      node.GetIJKToRASMatrix(ijkToRAS)
+      digest.update(f"{array.shape};{array.dtype.str};".encode())
+      digest.update(np.array(self.matrixToList(ijkToRAS)).tobytes())
+      digest.update(array)
+    return digest.hexdigest()
+
+  def load(self, key, volumeNode):
+    """
+    Sets the cached distance map of the key to the volume node, memory mapped.
+    Returns False if there is no such entry; incomplete or corrupted entries
+    are removed.
+    """
+    dataPath, metadataPath = self.paths(key)
+    if not os.path.exists(metadataPath):
+      return False
+    try:
+      with open(metadataPath, "r") as metadataFile:
+        metadata = json.load(metadataFile)
+      if metadata["format"] != self.FormatVersion or os.path.getsize(dataPath) != metadata["dataSize"]:
+        raise ValueError("inconsistent entry")
+      # Copy on write: the distance maps may be updated in place afterwards
+      array = np.load(dataPath, mmap_mode="c")
+      if list(array.shape) != metadata["shape"] or array.dtype.str != metadata["dtype"]:
+        raise ValueError("unexpected array")
+    except (OSError, ValueError, KeyError) as error:
+      logging.warning(f"Discarding distance map cache entry {key}: {error}")
+      self.remove(key)
+      return False
+
+    # The image data uses the mapped memory (numpy_to_vtk keeps a reference)
+    numberOfComponents = array.shape[3] if array.ndim == 4 else 1
+    scalars = numpy_to_vtk(array.reshape(-1, numberOfComponents), deep=False)
+    scalars.SetName("DistanceMap")
+    imageData = vtk.vtkImageData()
+    imageData.SetDimensions(array.shape[2], array.shape[1], array.shape[0])
+    imageData.GetPointData().SetScalars(scalars)
+    ijkToRAS = vtk.vtkMatrix4x4()
+    ijkToRAS.DeepCopy(metadata["ijkToRAS"])
+
+    wasModifying = volumeNode.StartModify()
+    volumeNode.SetIJKToRASMatrix(ijkToRAS)
+    for name, value in metadata["attributes"].items():
+      volumeNode.SetAttribute(name, value)
+    volumeNode.SetAndObserveImageData(imageData)
+    volumeNode.EndModify(wasModifying)
+
+    # Recently used entries are evicted last
+    os.utime(metadataPath)
+    return True
+
+  def store(self, key, volumeNode, attributeNames=("DistanceMap.Scale", "DistanceMap.Offset")):
+    """
+    Stores the distance map of the volume node under the key, then evicts
+    entries beyond the maximum size
+    """
+    os.makedirs(self.directory, exist_ok=True)
+    dataPath, metadataPath = self.paths(key)
+    array = np.ascontiguousarray(slicer.util.arrayFromVolume(volumeNode))
+    ijkToRAS = vtk.vtkMatrix4x4()
+    volumeNode.GetIJKToRASMatrix(ijkToRAS)
+
+    # Files are written under temporary names and renamed when complete. The
+    # metadata is renamed last and marks the entry as valid, so an interrupted
+    # write never leaves an entry that loads.
+    temporarySuffix = f".{os.getpid()}.tmp"
+    try:
+      with open(dataPath + temporarySuffix, "wb") as dataFile:
+        np.save(dataFile, array)
+        dataFile.flush()
+        os.fsync(dataFile.fileno())
+      os.replace(dataPath + temporarySuffix, dataPath)
+      metadata = {
+        "format": self.FormatVersion,
+        "shape": list(array.shape),
+        "dtype": array.dtype.str,
+        "dataSize": os.path.getsize(dataPath),
+        "ijkToRAS": self.matrixToList(ijkToRAS),
+        "attributes": {name: volumeNode.GetAttribute(name) for name in attributeNames if volumeNode.GetAttribute(name)},
+        }
+      with open(metadataPath + temporarySuffix, "w") as metadataFile:
+        json.dump(metadata, metadataFile)
+        metadataFile.flush()
+        os.fsync(metadataFile.fileno())
+      os.replace(metadataPath + temporarySuffix, metadataPath)
+    except OSError as error:
+      logging.warning(f"Could not store distance map cache entry {key}: {error}")
+      for path in (dataPath + temporarySuffix, metadataPath + temporarySuffix):
+        if os.path.exists(path):
+          os.remove(path)
+      return
+    self.evict()
+
+  def remove(self, key):
+    for path in self.paths(key):
+      try:
+        os.remove(path)
+      except OSError:
+        # Missing, or still mapped (Windows)
+        pass
+
+  def evict(self):
+    """
+    Removes the least recently used entries until the cache fits its maximum
+    size. Data files without metadata and temporary files older than a day
+    (interrupted writes) go first.
+    """
+    import time
+    if not os.path.isdir(self.directory):
+      return
+    entries = {}
+    for fileName in os.listdir(self.directory):
+      key, extension = os.path.splitext(fileName)
+      path = os.path.join(self.directory, fileName)
+      if extension == ".tmp" and os.path.getmtime(path) < time.time() - 24 * 3600:
+        os.remove(path)
+      if extension not in (".npy", ".json"):
+        continue
+      size, lastUse = entries.get(key, (0, 0.0))
+      entries[key] = (size + os.path.getsize(path), os.path.getmtime(path) if extension == ".json" else lastUse)
+    totalSize = sum(size for size, _ in entries.values())
+    for key, (size, _) in sorted(entries.items(), key=lambda entry: entry[1][1]):
+      if totalSize <= self.maximumSize:
+        break
+      self.remove(key)
+      totalSize -= size
+
 #
 # LiverLogic
 #
@@ -995,8 +1263,309 @@ https://github.com/Slicer/Slicer/blob/master/Base/Python/slicer/ScriptedLoadable
     Called when the logic class is instantiated. Can be used for initializing member variables.
     """
     ScriptedLoadableModuleLogic.__init__(self)
+    self.distanceMapCache = DistanceMapCache()
+    self._progressiveTimer = None
+    self._progressiveFinished = None
+    # Label maps and parameters of the distance maps held by the distance map
+    # engine of the resections logic, for updateDistanceMaps
+    self._engineLabelMaps = None
+
+  def computeDistanceMaps(self, tumorNode, parenchymaNode, hepaticNode, portalNode, outputNode, downSamplingRate=1, bandWidth=0.0, cropMargin=None, quantizationRange=None, cache=None, targetSpacing=None):
+    """
+    Computes the signed distance maps of the structures into a vector volume
+    (one component per structure), natively by the resections logic.
+    With a targetSpacing (mm per axis, 0 keeps the spacing of the label maps),
+    the distance maps are computed on a grid downsampled by the closest
+    integer factors; the structures are max pooled and the distances lowered
+    so that margins stay conservative. A downSamplingRate other than 1 is a
+    target spacing of that many voxels of the label maps along every axis.
+    A non-zero bandWidth (mm) limits the native computation to that distance
+    from the structures, beyond which the values saturate. With a cropMargin
+    (mm), the native output only covers the parenchyma grown by that margin.
+    With a quantizationRange (mm), the native output stores the distances
+    clamped to that range as 16-bit fixed point; the 'DistanceMap.Scale' and
+    'DistanceMap.Offset' attributes of the output convert them to mm.
+    With a DistanceMapCache, distance maps computed before for the same label
+    maps and parameters are loaded from it, and new ones are stored in it.
+    """
+    if outputNode is None:
+      return
+
+    labelMapNodes = [tumorNode, parenchymaNode, hepaticNode, portalNode]
+    targetSpacing = self.distanceMapTargetSpacing(labelMapNodes, downSamplingRate, targetSpacing)
+    parameters = self.distanceMapParameters(downSamplingRate, bandWidth, cropMargin, quantizationRange, targetSpacing)
+
+    if cache is not None:
+      key = cache.key(labelMapNodes, parameters)
+      if cache.load(key, outputNode):
+        # The output does not match the label maps of the engine anymore
+        self._engineLabelMaps = None
+        outputNode.SetAttribute('DistanceMap', "True");
+        outputNode.SetAttribute('Computed', "True");
+        return
+      self.computeDistanceMaps(*labelMapNodes, outputNode, downSamplingRate, bandWidth, cropMargin, quantizationRange,
+                               targetSpacing=targetSpacing)
+      cache.store(key, outputNode)
+      return
 
-  def computeDistanceMaps(self, tumorNode, parenchymaNode, hepaticNode, portalNode, outputNode, downSamplingRate=1):
+    lvLogic = slicer.modules.liverresections.logic()
+    self.setDistanceMapEngineParameters(parenchymaNode is not None, bandWidth, cropMargin, quantizationRange,
+                                        targetSpacing)
+    self._engineLabelMaps = None
+    if not lvLogic.ComputeDistanceMaps(tumorNode, parenchymaNode, hepaticNode, portalNode, outputNode):
+      raise RuntimeError("Distance map computation failed")
+    self.setEngineLabelMaps(labelMapNodes, outputNode, parameters)
+    outputNode.SetAttribute('DistanceMap', "True");
+    outputNode.SetAttribute('Computed', "True");
+
+  def updateDistanceMaps(self, tumorNode, parenchymaNode, hepaticNode, portalNode, outputNode, downSamplingRate=1, bandWidth=0.0, cropMargin=None, quantizationRange=None, cache=None, targetSpacing=None, modifiedStructures=None):
+    """
+    Updates the distance maps of the last computeDistanceMaps (or completed
+    computeDistanceMapsProgressive) into the same output after the label maps
+    were edited, e.g. re-exported after segment editor changes: only the
+    modified structures are updated, by UpdateDistanceMap of the resections
+    logic, around the bounding boxes of their voxels before and after the
+    edit (the changed voxels are within them). modifiedStructures lists the
+    indices (tumor, parenchyma, hepatic, portal) of the structures edited
+    since the last computation, e.g. from the SegmentModified events of the
+    segmentation they are exported from; by default, the structures whose
+    label map image data was modified since then are updated. Returns False,
+    leaving the distance maps to computeDistanceMaps, if the structures, the
+    geometry of the label maps, the output or the parameters differ from the
+    last computation.
+    """
+    labelMapNodes = [tumorNode, parenchymaNode, hepaticNode, portalNode]
+    targetSpacing = self.distanceMapTargetSpacing(labelMapNodes, downSamplingRate, targetSpacing)
+    parameters = self.distanceMapParameters(downSamplingRate, bandWidth, cropMargin, quantizationRange, targetSpacing)
+    engineLabelMaps = self._engineLabelMaps
+    if (outputNode is None or engineLabelMaps is None or engineLabelMaps["outputNodeID"] != outputNode.GetID()
+        or engineLabelMaps["parameters"] != parameters):
+      return False
+
+    changedStructures = []
+    for structure, node in enumerate(labelMapNodes):
+      engineLabelMap = engineLabelMaps["labelMaps"][structure]
+      if node is None or node.GetImageData() is None or engineLabelMap is None:
+        if (node is None or node.GetImageData() is None) != (engineLabelMap is None):
+          return False
+        continue
+      if self.labelMapGeometry(node) != engineLabelMap["geometry"]:
+        return False
+      if modifiedStructures is not None:
+        if structure not in modifiedStructures:
+          continue
+      elif node.GetImageData().GetMTime() == engineLabelMap["modifiedTime"]:
+        continue
+      voxelExtent = self.labelMapVoxelExtent(node)
+      engineVoxelExtent = engineLabelMap["voxelExtent"]
+      if voxelExtent is None or engineVoxelExtent is None:
+        changedExtent = voxelExtent or engineVoxelExtent
+        if changedExtent is None:
+          continue
+      else:
+        changedExtent = [min(voxelExtent[axis], engineVoxelExtent[axis]) if axis % 2 == 0
+                         else max(voxelExtent[axis], engineVoxelExtent[axis]) for axis in range(6)]
+      changedStructures.append((structure, node, changedExtent))
+
+    lvLogic = slicer.modules.liverresections.logic()
+    self._engineLabelMaps = None
+    for structure, node, changedExtent in changedStructures:
+      if not lvLogic.UpdateDistanceMap(structure, node, changedExtent, outputNode):
+        return False
+    self.setEngineLabelMaps(labelMapNodes, outputNode, parameters)
+    if changedStructures and cache is not None:
+      cache.store(cache.key(labelMapNodes, parameters), outputNode)
+    return True
+
+  @staticmethod
+  def labelMapGeometry(labelMapNode):
+    """
+    Extent and IJK to RAS matrix of a label map
+    """
+    ijkToRAS = vtk.vtkMatrix4x4()
+    labelMapNode.GetIJKToRASMatrix(ijkToRAS)
+    return list(labelMapNode.GetImageData().GetExtent()), DistanceMapCache.matrixToList(ijkToRAS)
+
+  @staticmethod
+  def labelMapVoxelExtent(labelMapNode):
+    """
+    Bounding box (IJK extent) of the voxels of a label map, None if it is empty
+    """
+    # The arrays are indexed KJI, from the start of the image extent
+    array = slicer.util.arrayFromVolume(labelMapNode)
+    imageExtent = labelMapNode.GetImageData().GetExtent()
+    voxelExtent = []
+    for axis, otherAxes in enumerate(((0, 1), (0, 2), (1, 2))):
+      indices = np.nonzero(array.any(axis=otherAxes))[0]
+      if indices.size == 0:
+        return None
+      voxelExtent += [imageExtent[2 * axis] + int(indices[0]), imageExtent[2 * axis] + int(indices[-1])]
+    return voxelExtent
+
+  @classmethod
+  def engineLabelMap(cls, labelMapNode):
+    """
+    What updateDistanceMaps keeps of a label map given to the distance map
+    engine (geometry, modification time and bounding box of its voxels),
+    None if the structure is missing
+    """
+    if labelMapNode is None or labelMapNode.GetImageData() is None:
+      return None
+    return {"geometry": cls.labelMapGeometry(labelMapNode),
+            "modifiedTime": labelMapNode.GetImageData().GetMTime(),
+            "voxelExtent": cls.labelMapVoxelExtent(labelMapNode)}
+
+  def setEngineLabelMaps(self, labelMapNodes, outputNode, parameters):
+    self._engineLabelMaps = {"labelMaps": [self.engineLabelMap(node) for node in labelMapNodes],
+                             "outputNodeID": outputNode.GetID(), "parameters": parameters}
+
+  def computeDistanceMapsProgressive(self, tumorNode, parenchymaNode, hepaticNode, portalNode, outputNode, bandWidth=0.0, cropMargin=None, quantizationRange=None, cache=None, finished=None):
+    """
+    Computes the distance maps of computeDistanceMaps (at the spacing of the
+    label maps) coarse to fine in the background: the output gets a coarse
+    level first, and is replaced by the finer levels as they complete. The
+    finished callback is called with True once the output has the final
+    level, or with False if the computation was cancelled or failed. The
+    label map nodes must be kept until then: modifying or removing one
+    cancels the computation, as does starting another one.
+    """
+    if outputNode is None:
+      return
+
+    self.cancelProgressiveDistanceMaps()
+    labelMapNodes = [tumorNode, parenchymaNode, hepaticNode, portalNode]
+    parameters = self.distanceMapParameters(1, bandWidth, cropMargin, quantizationRange, None)
+    key = None
+    if cache is not None:
+      key = cache.key(labelMapNodes, parameters)
+      if cache.load(key, outputNode):
+        self._engineLabelMaps = None
+        outputNode.SetAttribute('DistanceMap', "True");
+        outputNode.SetAttribute('Computed', "True");
+        if finished is not None:
+          finished(True)
+        return
+
+    lvLogic = slicer.modules.liverresections.logic()
+    self.setDistanceMapEngineParameters(parenchymaNode is not None, bandWidth, cropMargin, quantizationRange, None)
+    self._engineLabelMaps = None
+    if not lvLogic.StartProgressiveDistanceMaps(tumorNode, parenchymaNode, hepaticNode, portalNode, outputNode):
+      raise RuntimeError("Distance map computation failed")
+    progressiveEngine = lvLogic.GetProgressiveDistanceMapEngine()
+
+    def processLevels():
+      level = lvLogic.ProcessProgressiveDistanceMaps()
+      if level >= 0:
+        outputNode.SetAttribute('DistanceMap', "True");
+        outputNode.SetAttribute('Computed', "True");
+      completed = progressiveEngine.GetFetchedLevel() == progressiveEngine.GetNumberOfLevels() - 1
+      if level >= 0 and completed:
+        self.setEngineLabelMaps(labelMapNodes, outputNode, parameters)
+      if level >= 0 and completed and key is not None:
+        cache.store(key, outputNode)
+      if not lvLogic.IsProgressiveDistanceMapsRunning():
+        if progressiveEngine.GetFailed():
+          logging.error("Distance map computation failed")
+        self.stopProgressiveDistanceMaps(completed)
+
+    self._progressiveFinished = finished
+    self._progressiveTimer = qt.QTimer()
+    self._progressiveTimer.setInterval(50)
+    self._progressiveTimer.connect('timeout()', processLevels)
+    self._progressiveTimer.start()
+
+  def cancelProgressiveDistanceMaps(self):
+    """
+    Cancels the distance maps started by computeDistanceMapsProgressive (the
+    levels already in the output are kept).
+    """
+    if self._progressiveTimer is None:
+      return
+    slicer.modules.liverresections.logic().CancelProgressiveDistanceMaps()
+    self.stopProgressiveDistanceMaps(False)
+
+  def stopProgressiveDistanceMaps(self, completed):
+    self._progressiveTimer.stop()
+    self._progressiveTimer = None
+    finished, self._progressiveFinished = self._progressiveFinished, None
+    if finished is not None:
+      finished(completed)
+
+  @staticmethod
+  def distanceMapTargetSpacing(labelMapNodes, downSamplingRate, targetSpacing):
+    """
+    Target spacing of computeDistanceMaps for a downSamplingRate
+    """
+    if targetSpacing is None and downSamplingRate != 1:
+      referenceNode = next((node for node in labelMapNodes if node is not None), None)
+      if referenceNode is not None:
+        targetSpacing = [downSamplingRate * spacing for spacing in referenceNode.GetSpacing()]
+    return targetSpacing
+
+  @staticmethod
+  def distanceMapParameters(downSamplingRate, bandWidth, cropMargin, quantizationRange, targetSpacing):
+    """
+    Parameters of the distance maps identifying them in a DistanceMapCache
+    """
+    parameters = {"downSamplingRate": downSamplingRate, "bandWidth": bandWidth,
+                  "cropMargin": cropMargin, "quantizationRange": quantizationRange}
+    if targetSpacing is not None:
+      parameters["targetSpacing"] = [float(spacing) for spacing in targetSpacing]
+    return parameters
+
+  @staticmethod
+  def setDistanceMapEngineParameters(hasParenchyma, bandWidth, cropMargin, quantizationRange, targetSpacing):
+    """
+    Sets the parameters of computeDistanceMaps to the distance map engine of
+    the resections logic
+    """
+    engine = slicer.modules.liverresections.logic().GetDistanceMapEngine()
+    engine.SetTargetSpacing(*(targetSpacing if targetSpacing is not None else [0.0, 0.0, 0.0]))
+    engine.SetBandWidth(bandWidth)
+    engine.SetCropToParenchyma(cropMargin is not None and hasParenchyma)
+    engine.SetCropMargin(cropMargin if cropMargin is not None else 0.0)
+    engine.SetQuantizeOutput(quantizationRange is not None)
+    if quantizationRange is not None:
+      engine.SetQuantizationRange(quantizationRange)
+
+  def computeMeshDistanceMaps(self, segmentationNode, segmentIds, referenceNode, outputNode, spacing=None, bandWidth=0.0, quantizationRange=None):
+    """
+    Computes the signed distance maps of the closed surfaces of the segments
+    (tumor, parenchyma, hepatic and portal segment IDs, None to skip one) into
+    a vector volume covering the reference volume, natively by the resections
+    logic. The distances are exact at every voxel instead of being limited by
+    the voxels of label maps, so a coarser spacing (mm per axis, 0 keeps the
+    spacing of the reference volume) keeps accurate margins with less memory.
+    bandWidth and quantizationRange are as in computeDistanceMaps.
+    """
+    if outputNode is None:
+      return
+
+    segmentationNode.CreateClosedSurfaceRepresentation()
+    surfaces = []
+    for segmentId in segmentIds:
+      surface = None
+      if segmentId:
+        surface = vtk.vtkPolyData()
+        segmentationNode.GetClosedSurfaceRepresentation(segmentId, surface)
+      surfaces.append(surface)
+
+    # The next levels of a running progressive computation would replace the output
+    self.cancelProgressiveDistanceMaps()
+    lvLogic = slicer.modules.liverresections.logic()
+    lvLogic.GetMeshDistanceMapEngine().SetBandWidth(bandWidth)
+    lvLogic.GetMeshDistanceMapEngine().SetQuantizeOutput(quantizationRange is not None)
+    if quantizationRange is not None:
+      lvLogic.GetMeshDistanceMapEngine().SetQuantizationRange(quantizationRange)
+    if not lvLogic.ComputeMeshDistanceMaps(*surfaces, referenceNode, spacing if spacing is not None else [0.0, 0.0, 0.0], outputNode):
+      raise RuntimeError("Distance map computation failed")
+    # The output does not match the label maps of the engine anymore
+    if self._engineLabelMaps is not None and self._engineLabelMaps["outputNodeID"] == outputNode.GetID():
+      self._engineLabelMaps = None
+    outputNode.SetAttribute('DistanceMap', "True");
+    outputNode.SetAttribute('Computed', "True");
+
+  def computeDistanceMapsSimpleITK(self, tumorNode, parenchymaNode, hepaticNode, portalNode, outputNode, downSamplingRate=1):
 
     if outputNode is not None:
       import sitkUtils
@@ -1034,20 +1603,18 @@ https://github.com/Slicer/Slicer/blob/master/Base/Python/slicer/ScriptedLoadable
         logging.debug("Computing Portal Distance Map...")
 
       #Combine distance maps
+      distanceImages = [i for i in [tumorDistanceImage, parenchymaDistanceImage, hepaticDistanceImage, portalDistanceImage] if i]
       if downSamplingRate != 1:
-        imageSize = tumorImage.GetSize()
+        imageSize = distanceImages[0].GetSize()
         newSize = [round(i/downSamplingRate) for i in imageSize]
-        tumorDistanceImageDown =  self.imageResample( tumorDistanceImage, [newSize[0],newSize[1],newSize[2]], "linear")
-        parenchymaDistanceImageDown = self.imageResample( parenchymaDistanceImage, [newSize[0],newSize[1],newSize[2]], "linear")
-        hepaticDistanceImageDown = self.imageResample( hepaticDistanceImage, [newSize[0],newSize[1],newSize[2]], "linear")
-        portalDistanceImageDown = self.imageResample( portalDistanceImage, [newSize[0],newSize[1],newSize[2]], "linear")
-        compositeDistanceMap = sitk.Compose(*[i for i in [tumorDistanceImageDown, parenchymaDistanceImageDown, hepaticDistanceImageDown, portalDistanceImageDown] if i])
-      else:
-        compositeDistanceMap = sitk.Compose(*[i for i in [tumorDistanceImage, parenchymaDistanceImage, hepaticDistanceImage, portalDistanceImage] if i])
+        distanceImages = [self.imageResample(i, newSize, "linear") for i in distanceImages]
+      compositeDistanceMap = sitk.Compose(*distanceImages)
 
       sitkUtils.PushVolumeToSlicer(compositeDistanceMap, targetNode = outputNode, className='vtkMRMLVectorVolumeNode')
       outputNode.SetAttribute('DistanceMap', "True");
       outputNode.SetAttribute('Computed', "True");
+      outputNode.SetAttribute('DistanceMap.Scale', "1");
+      outputNode.SetAttribute('DistanceMap.Offset', "0");
 
   def imageResample(self, inputImage, resampledSize, interpolatorType):
     """
@@ -1092,78 +1659,6 @@ https://github.com/Slicer/Slicer/blob/master/Base/Python/slicer/ScriptedLoadable
 
     return resampledImage
 
-  def preprocessing(self, surfacePolyData, targetNumberOfPoints=800000, decimationAggressiveness=2):
-    numberOfInputPoints = surfacePolyData.GetNumberOfPoints()
-
-    if numberOfInputPoints == 0:
-      raise ValueError("Input surface model is empty")
-
-    elif numberOfInputPoints <= 400000:
-      subdiv = vtk.vtkLinearSubdivisionFilter()
-      subdiv.SetInputData(surfacePolyData)
-      subdiv.SetNumberOfSubdivisions(1)
-      subdiv.Update()
-      subPolyData = subdiv.GetOutput()
-
-      if subPolyData.GetNumberOfPoints() == 0:
-        logging.warning("Mesh subdivision failed. Skip subdivision step.")
-
-      numberOfPoints = subPolyData.GetNumberOfPoints()
-      reductionFactor = (numberOfPoints - targetNumberOfPoints) / numberOfPoints
-      print('reduction factor',reductionFactor)
-
-      if reductionFactor > 0.0:
-        surfacePolyData = self.run_decimation(subPolyData, reductionFactor)
-      else:
-        surfacePolyData = vtk.vtkPolyData()  # Create an empty vtkPolyData object
-        surfacePolyData.DeepCopy(subPolyData)
-
-    preprocessedPolyData = self.process_polydata(surfacePolyData)
-    return self.create_model_node(preprocessedPolyData)
-
-  def run_decimation(self, inputPolyData, reductionFactor):
-    decimation = vtk.vtkDecimatePro()
-    decimation.SetInputData(inputPolyData)
-    decimation.SetTargetReduction(reductionFactor)
-    decimation.SetPreserveTopology(True)
-    decimation.SetFeatureAngle(60.0)
-    decimation.SetBoundaryVertexDeletion(False)
-    decimation.SetDegree(20)
-    decimation.SetMaximumError(0.001)
-    decimation.Update()
-    return decimation.GetOutput()
-
-  def process_polydata(self, inputPolyData):
-    cleaner = vtk.vtkCleanPolyData()
-    cleaner.SetInputData(inputPolyData)
-    cleaner.Update()
-
-    triangulator = vtk.vtkTriangleFilter()
-    triangulator.SetInputData(cleaner.GetOutput())
-    triangulator.PassLinesOff()
-    triangulator.PassVertsOff()
-    triangulator.Update()
-
-    normals = vtk.vtkPolyDataNormals()
-    normals.SetInputData(triangulator.GetOutput())
-    normals.SetAutoOrientNormals(1)
-    normals.SetFlipNormals(0)
-    normals.SetConsistency(1)
-    normals.SplittingOff()
-    normals.Update()
-
-    return normals.GetOutput()
-
-  def create_model_node(self, polyData):
-    modelNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLModelNode')
-    modelNode.SetName("PreprocessedLiver")
-    modelNode.CreateDefaultDisplayNodes()
-    modelDisplayNode = modelNode.GetDisplayNode()
-    modelDisplayNode.SetOpacity(0.2)
-    modelDisplayNode.Visibility3DOff()
-    modelNode.SetAndObservePolyData(polyData)
-    return modelNode
-
   def CreatePolyDataFromCoords(self, coordinates):
     """
     Takes the x, y, and z coordinates of a 3D numpy array and creates a vtkPolyData object
@@ -1188,283 +1683,6 @@ https://github.com/Slicer/Slicer/blob/master/Base/Python/slicer/ScriptedLoadable
 
     return polydata
 
-  def extract_points(self, liverNode, point1, refDist, contourThickness):
-    points = liverNode.GetPolyData().GetPoints()
-    numberOfPoints = liverNode.GetPolyData().GetNumberOfPoints()
-    points = np.array([points.GetPoint(i) for i in range(0, numberOfPoints)])
-    dist = np.linalg.norm(points - point1, axis=1)
-    final_points = points[np.abs(dist - refDist) < contourThickness]
-    return final_points
-
-  def distance(self, P1, P2):
-    res = ((P1[0] - P2[0]) ** 2 + (P1[1] - P2[1]) ** 2 + (P1[2] - P2[2]) ** 2) ** 0.5
-    return res
-
-  def optimized_path(self, coords, start=None):
-    """
-    This function finds the nearest point to a point
-    coords should be a numpy array
-    """
-    if start is None:
-      start = coords[0]
-    pass_by = coords
-    path = [start]
-    pass_by = np.delete(pass_by, 0, axis=0)
-    distances = []
-    while pass_by.shape[0] > 0:
-      nearest = pass_by[np.argmin(np.linalg.norm(path[-1] - pass_by, axis=1))]
-      dist = np.linalg.norm(path[-1] - nearest)
-      distances.append(dist)
-      path.append(nearest)
-      pass_by = np.delete(pass_by, np.argwhere(np.all(pass_by == nearest, axis=1)), axis=0)
-
-    return np.asarray(path), np.asarray(distances)
-
-  def normalize_efd3d(self, coeffs, size_invariant=True, return_transformation=False):
-    """ This method should be used when the original coordinates don't need to be preserved, for example for allowing
-    comparison between polygons of differing sizes. It implements the normalization procedure in Bose, Paromita. The
-    encoding and Fourier descriptors of arbitrary curves in 3-dimensional space. Diss. State University System of
-    Florida, 2000.
-    This function is a modified 3D version from https://github.com/hbldh/pyefd
-    """
-
-    # ToDO: check the affidability of this normalization method for 3D points in case you may want to use it for
-    #  other purpose
-
-    A = np.array([
-      [coeffs[0, 0], coeffs[0, 1], (coeffs[0, 2] * coeffs[0, 5] - coeffs[0, 4] * coeffs[0, 3])],
-      [coeffs[0, 2], coeffs[0, 3], (coeffs[0, 1] * coeffs[0, 4] - coeffs[0, 0] * coeffs[0, 5])],
-      [coeffs[0, 4], coeffs[0, 5], (coeffs[0, 0] * coeffs[0, 3] - coeffs[0, 1] * coeffs[0, 2])],
-    ]
-    )
-
-    inv_A = np.linalg.inv(A)
-    # print(inv_A)
-    ace_new = []
-    bdf_new = []
-    for n in range(1, coeffs.shape[0] + 1):
-      x = inv_A.dot(
-        np.array(
-          [
-            [coeffs[n - 1, 1]],
-            [coeffs[n - 1, 3]],
-            [coeffs[n - 1, 5]],
-          ]
-        ).flatten()
-      )
-      ace_new.append(x)
-
-      y = inv_A.dot(
-        np.array(
-          [
-            [coeffs[n - 1, 0]],
-            [coeffs[n - 1, 2]],
-            [coeffs[n - 1, 4]],
-          ]
-        )
-      ).flatten()
-      bdf_new.append(y)
-
-    ace_array = np.array(ace_new)
-    bdf_array = np.array(bdf_new)
-    normalized_coeffs = np.vstack(
-      (ace_array[:, 0], bdf_array[:, 0], ace_array[:, 1], bdf_array[:, 1], ace_array[:, 2], bdf_array[:, 2])).T
-    # print('ace', ace_array)
-    # print('bdf', bdf_array)
-    # print('result', normalized_coeffs)
-
-    size = np.sqrt(coeffs[0, 0] ** 2 + coeffs[0, 2] ** 2 + coeffs[0, 4] ** 2)
-    if size_invariant:
-      # Obtain size-invariance by normalizing.
-      coeffs /= np.abs(size)
-
-    if return_transformation:
-      return coeffs, size
-    else:
-
-      return normalized_coeffs
-
-  def elliptic_fourier_descriptors(self,
-                                   contour, order=8, normalize=False, return_transformation=False
-                                   ):
-    """Calculate elliptical Fourier descriptors for a contour.
-
-    Args:
-         contour: A numpy.ndarray contour array of size [M x 3].
-         order: The order of Fourier coefficients to calculate.
-         normalize: If the coefficients should be normalized.
-         return_transformation: If the normalization parametres should be returned. Default is False.
-
-    Returns:
-        coeffs: A [order x 6]array of Fourier coefficients and optionally the
-        transformation parametres scale, psi_1 (rotation) and theta_1(phase)
-
-    This function is a modified 3D version from https://github.com/hbldh/pyefd
-
-    """
-    dxyz = np.diff(contour, axis=0)
-    dt = np.sqrt((dxyz ** 2).sum(axis=1))
-    t = np.concatenate([([0.0]), np.cumsum(dt)])  # Return the cumulative sum of the elements along a given axis
-
-    T = t[-1]
-
-    phi = (2 * np.pi * t) / T
-
-    orders = np.arange(1, order + 1)
-    consts = T / (2 * orders * orders * np.pi * np.pi)
-    phi = phi * orders.reshape((order, -1))
-    d_cos_phi = np.cos(phi[:, 1:]) - np.cos(phi[:, :-1])
-    d_sin_phi = np.sin(phi[:, 1:]) - np.sin(phi[:, :-1])
-    a = consts * np.sum((dxyz[:, 0] / dt) * d_cos_phi, axis=1)
-    b = consts * np.sum((dxyz[:, 0] / dt) * d_sin_phi, axis=1)
-    c = consts * np.sum((dxyz[:, 1] / dt) * d_cos_phi, axis=1)
-    d = consts * np.sum((dxyz[:, 1] / dt) * d_sin_phi, axis=1)
-    e = consts * np.sum((dxyz[:, 2] / dt) * d_cos_phi, axis=1)
-    f = consts * np.sum((dxyz[:, 2] / dt) * d_sin_phi, axis=1)
-
-    coeffs = np.concatenate(
-      [
-        a.reshape((order, 1)),
-        b.reshape((order, 1)),
-        c.reshape((order, 1)),
-        d.reshape((order, 1)),
-        e.reshape((order, 1)),
-        f.reshape((order, 1))
-      ],
-      axis=1,
-    )
-
-    if normalize:
-      coeffs = self.normalize_efd3d(coeffs, return_transformation=return_transformation)
-      # print(coeffs)
-
-    return coeffs
-
-  def inverse_transform(self, coeffs, locus=(0, 0, 0), n_coords=12, harmonic=10):
-    '''
-    Perform an inverse fourier transform to convert the coefficients back into
-    spatial coordinates.
-    Implements Kuhl and Giardina method of computing the performing the
-    transform for a specified number of harmonics. This code is adapted
-    from the pyefd module. See the original paper for more detail:
-    Kuhl, FP and Giardina, CR (1982). Elliptic Fourier features of a closed
-    contour. Computer graphics and image processing, 18(3), 236-258.
-    Args:
-        coeffs (numpy.ndarray): A numpy array of shape (harmonic, 6)
-            representing the four coefficients for each harmonic computed.
-        locus (tuple): The x,y,z coordinates of the centroid of the contour being
-            generated. Use calculate_dc_coefficients() to generate the correct
-            locus for a shape.
-        n_coords (int): The number of coordinate pairs to compute. A larger
-            value will result in a more complex shape at the expense of
-            increased computational time. Defaults to 300.
-        harmonics (int): The number of harmonics to be used to generate
-            coordinates, defaults to 10. Must be <= coeffs.shape[0]. Supply a
-            smaller value to produce coordinates for a more generalized shape.
-    Returns:
-        numpy.ndarray: A numpy array of shape (harmonics, 6) representing the
-        four coefficients for each harmonic computed.
-
-    This function is a modified 3D version from https://github.com/hbldh/pyefd
-    '''
-
-    t = np.linspace(0, 1, n_coords).reshape(1, -1)
-    n = np.arange(harmonic).reshape(-1, 1)
-
-    xt = (np.matmul(coeffs[:harmonic, 0].reshape(1, -1),
-                    np.cos(2. * (n + 1) * np.pi * t)) +
-          np.matmul(coeffs[:harmonic, 1].reshape(1, -1),
-                    np.sin(2. * (n + 1) * np.pi * t)) +
-          locus[0])
-
-    yt = (np.matmul(coeffs[:harmonic, 2].reshape(1, -1),
-                    np.cos(2. * (n + 1) * np.pi * t)) +
-          np.matmul(coeffs[:harmonic, 3].reshape(1, -1),
-                    np.sin(2. * (n + 1) * np.pi * t)) +
-          locus[1])
-
-    zt = (np.matmul(coeffs[:harmonic, 4].reshape(1, -1),
-                    np.cos(2. * (n + 1) * np.pi * t)) +
-          np.matmul(coeffs[:harmonic, 5].reshape(1, -1),
-                    np.sin(2. * (n + 1) * np.pi * t)) +
-          locus[2])
-
-    reconstruction = np.stack([xt, yt, zt], axis=1)
-
-    return reconstruction
-
-  def calculate_dc_coefficients(self, contour):
-    """ Calculate the :math:`A_0`, :math:`C_0` and :math:`E_0` coefficients of the elliptic Fourier series.
-     Args
-     numpy.ndarray contour: A contour array of size [M x 3]
-
-     Returns:
-        The A_0`, C_0, E_0` coefficients
-
-    This function is a modified 3D version from https://github.com/hbldh/pyefd
-    """
-    dxyz = np.diff(contour, axis=0)
-    dt = np.sqrt((dxyz ** 2).sum(axis=1))
-    t = np.concatenate([([0.0]), np.cumsum(dt)])
-    T = t[-1]
-
-    xi = np.cumsum(dxyz[:, 0]) - (dxyz[:, 0] / dt) * t[1:]
-    A0 = (1 / T) * np.sum(((dxyz[:, 0] / (2 * dt)) * np.diff(t ** 2)) + xi * dt)
-    delta = np.cumsum(dxyz[:, 1]) - (dxyz[:, 1] / dt) * t[1:]
-    C0 = (1 / T) * np.sum(((dxyz[:, 1] / (2 * dt)) * np.diff(t ** 2)) + delta * dt)
-    zi = np.cumsum(dxyz[:, 2]) - (dxyz[:, 2] / dt) * t[1:]
-    E0 = (1 / T) * np.sum(((dxyz[:, 2] / (2 * dt)) * np.diff(t ** 2)) + zi * dt)
-
-    # Adding those values to the coefficients to make them relate to true origin.
-    return contour[0, 0] + A0, contour[0, 1] + C0, contour[0, 2] + E0
-
-  def Nyquist(self, X):
-    """
-    The total number of harmonics that can be computed for any outline is equal to half of the total number of
-    outline coordinates (i.e. the ‘Nyquist frequency’). len(X)=len(Y)=len(Z)
-    Args:
-        X (list): A list (or numpy array) of x coordinate values.
-
-    Returns:
-        int: The nyquist frequency, expressed as a number of harmonics.
-    """
-    return len(X) // 2
-
-  def FourierPower(self, coeffs, X, threshold=0.9999):
-    '''
-    Compute the total Fourier power and find the minium number of harmonics
-    required to exceed the threshold fraction of the total power (precisely, total energy spectral density).
-    This is a good method for identifying the number of harmonics to use to
-    describe a polygon. For more details see:
-    C. Costa et al. / Postharvest Biology and Technology 54 (2009) 38-47
-    Warning:
-        The number of coeffs must be >= the nyquist freqency.
-    Args:
-        coeffs (numpy.ndarray): A numpy array of shape (n, 6) representing the
-            four coefficients for each harmonic computed.
-        X (list): A list (or numpy array) of x coordinate values.
-        threshold (float): The threshold fraction of the total Fourier power,
-            the default is 0.9999.
-    Returns:
-        int: The number of harmonics required to represent the contour above
-        the threshold Fourier power.
-    '''
-    nyquist = self.Nyquist(X)
-
-    totalPower = 0
-    currentPower = 0
-
-    for n in range(nyquist):
-      totalPower += ((coeffs[n, 0] ** 2) + (coeffs[n, 1] ** 2) +
-                     (coeffs[n, 2] ** 2) + (coeffs[n, 3] ** 2) + (coeffs[n, 4] ** 2) + (coeffs[n, 5] ** 2)) / 3
-
-    for i in range(nyquist):
-      currentPower += ((coeffs[i, 0] ** 2) + (coeffs[i, 1] ** 2.) +
-                       (coeffs[i, 2] ** 2) + (coeffs[i, 3] ** 2.) + (coeffs[i, 4] ** 2) + (coeffs[i, 5] ** 2)) / 3
-
-      if (currentPower / totalPower) > threshold:
-        return i + 1
-
   def compute_simple_pca(self, poly_data_input):
     """
     Computes Principal Component Analysis of a mesh
@@ -1536,110 +1754,6 @@ https://github.com/Slicer/Slicer/blob/master/Base/Python/slicer/ScriptedLoadable
     # TODO: It could be better using a cross product as direction contour's profile
     return eigen_vectors_array[1], eigenvalues[0]
 
-  def project_points_to_plane(self, mesh, origin=None, normal=(0, 0, 1)):
-    """
-    Project points of this mesh to a plane and find the furthest point to the center of mass.
-    Return the max pointID
-    """
-
-    # Make plane
-    normal = normal / np.linalg.norm(normal)  # MUST HAVE MAGNITUDE OF 1
-    plane = vtk.vtkPlane()
-    plane.SetOrigin(origin)
-    plane.SetNormal(normal)
-    projPts = vtk.vtkPoints()
-    for i in range(mesh.GetNumberOfPoints()):
-      currPoint = mesh.GetPoint(i)
-      newPoint = np.zeros(3)
-      plane.ProjectPoint(currPoint, newPoint)
-      projPts.InsertNextPoint(newPoint)
-
-    projPd = vtk.vtkPolyData()
-    projPd.SetPoints(projPts)
-    projected_array = vtk_to_numpy(projPd.GetPoints().GetData())
-
-    center = vtk.vtkCenterOfMass()
-    center.SetInputDataObject(projPd)
-    center.Update()
-    center = np.array(center.GetCenter())
-
-    distances = np.linalg.norm(projected_array - center, axis=1)
-    max_id = distances.argmax()
-
-    return max_id
-
-  def Unordered2orderedPointCloud(self, positions):
-
-    global newpoints
-    N = len(positions)
-    listpoints = []
-
-    for x in range(int(N / 2) + 1):
-      if N % 2 == 0:
-        listpoints.append(positions[x])
-        listpoints.append(positions[-x])
-        newpoints = np.asarray([listpoints[1:-1]]).squeeze()
-      else:
-        listpoints.append(positions[x])
-        listpoints.append(positions[-x])
-        newpoints = np.asarray([listpoints[1:]]).squeeze()
-
-    # pointCloud = CreatePolyDataFromCoords(newpoints)
-    xSpline = vtk.vtkKochanekSpline()
-    ySpline = vtk.vtkKochanekSpline()
-    zSpline = vtk.vtkKochanekSpline()
-
-    pointCloud_list = list()
-    final_parametric_spline_list = list()
-    parametric_spline_list = list()
-    source_spline_list = list()
-    final_source_spline_list = list()
-
-    for i in range(N):
-      if i % 2 == 0:
-        pointCloud_list.append(
-          self.CreatePolyDataFromCoords(newpoints[i:i + 2, :]))
-
-        # parametric_spline_list.append(spline)
-        parametric_spline_list.append(vtk.vtkParametricSpline())
-        source_spline_list.append(vtk.vtkParametricFunctionSource())
-
-    for i in range(len(pointCloud_list)):
-      parametric_spline_list[i].SetXSpline(xSpline)
-      parametric_spline_list[i].SetYSpline(ySpline)
-      parametric_spline_list[i].SetZSpline(zSpline)
-      parametric_spline_list[i].SetPoints(pointCloud_list[i].GetPoints())
-      # print(i)
-      final_parametric_spline_list.append(parametric_spline_list[i])
-
-      source_spline_list[i].SetParametricFunction(final_parametric_spline_list[i])
-      source_spline_list[i].SetUResolution(20)
-      source_spline_list[i].SetVResolution(20)
-      source_spline_list[i].SetWResolution(20)
-      source_spline_list[i].SetScalarModeToDistance()
-      final_source_spline_list.append(source_spline_list[i])
-      final_source_spline_list[i].Update()
-
-    appendFilter = vtk.vtkAppendPolyData()
-    for i in range(len(pointCloud_list)):
-      appendFilter.AddInputData(final_source_spline_list[i].GetOutput())
-
-    appendFilter.Update()
-
-    spline_lines = appendFilter.GetOutput()
-    points = spline_lines.GetPoints().GetData()
-    points_array = vtk_to_numpy(points)
-    # print("Number of points in the mask: {}".format(spline_lines.GetNumberOfPoints()))
-
-    # newNode = slicer.vtkMRMLModelNode()
-    # slicer.mrmlScene.AddNode(newNode)
-    # newNode.SetName("MaskPoints")
-    # newNode.SetAndObservePolyData(spline_lines)
-    # display = slicer.vtkMRMLModelDisplayNode()
-    # slicer.mrmlScene.AddNode(display)
-
-    return points_array, spline_lines
-
   def compute_pca(self, poly_data_input, extent, start=0, stop=500, step=1):
     """
     Computes Principal Component Analysis of a mesh
@@ -2039,158 +2153,6 @@ https://github.com/Slicer/Slicer/blob/master/Base/Python/slicer/ScriptedLoadable
     BezierDisplay.VisibilityOn()
     # BezierDisplay.SetClipOut(True)
 
-  def runSurfacefromEFD(self, resectionNode, distanceNode, liverNode):
-
-    point1 = distanceNode.GetNthControlPointPosition(1)
-    lenghtText = distanceNode.GetPropertiesLabelText()
-    refDist = float(lenghtText.split('m')[0])
-    contourThickness = 0.05
-
-    final_points = self.extract_points(liverNode, point1, refDist, contourThickness)
-
-    # Step 2: order the points according the shape of the contour
-    optimazing = self.optimized_path(final_points)
-    sorted1 = optimazing[0]
-    distances = optimazing[1]
-    # print("max", np.max(distances))
-    # print("distances", distances)
-
-    for i in range(len(distances)):
-      if distances[i] > 30:
-        max_id = np.argmax(distances)
-        sorted1 = sorted1[0:max_id]
-
-    # Step 3: Calculate the harmonics and 3DEF coefficients in frequency space
-
-    nyquist = self.Nyquist(sorted1[:, 0])
-    tmpcoeffs = self.elliptic_fourier_descriptors(sorted1, normalize=False, order=nyquist)
-    harmonic = self.FourierPower(tmpcoeffs, sorted1[:, 0], threshold=0.9999)
-    # print('harmonic', harmonic)
-    efd = self.elliptic_fourier_descriptors(sorted1, normalize=False, order=harmonic)
-
-    # Step 4: Reconstruction in 3D space
-    coeffs0 = self.calculate_dc_coefficients(sorted1)
-    rec = self.inverse_transform(efd, harmonic=harmonic, locus=coeffs0, n_coords=100)
-    squeeze_rec = np.squeeze(rec)
-    points = squeeze_rec.T
-
-    poly_contour = self.CreatePolyDataFromCoords(points)
-
-    # Step 5: deciding the starting point
-    normal = self.compute_simple_pca(poly_contour)
-    origin = np.array(poly_contour.GetCenter())
-    length = np.array(poly_contour.GetLength())
-    origin -= length
-    max_id = self.project_points_to_plane(poly_contour, origin=origin, normal=normal[0])
-
-    poly_points = poly_contour.GetPoints().GetData()
-    poly_points = vtk_to_numpy(poly_points)
-
-    new_points = poly_points[max_id:]
-    last_part = poly_points[0:max_id]
-    organizedPoints = np.vstack((new_points, last_part))
-
-    distanceContourPoints = self.CreatePolyDataFromCoords(organizedPoints)
-
-    # Review the need for this: merging points on the same position
-    cleanFilter = vtk.vtkCleanPolyData()
-    cleanFilter.SetInputData(distanceContourPoints)
-    cleanFilter.ConvertPolysToLinesOn()
-    cleanFilter.ConvertStripsToPolysOn()
-    cleanFilter.PointMergingOn()
-    cleanFilter.Update()
-    surfaceFilter = vtk.vtkDataSetSurfaceFilter()
-    surfaceFilter.SetInputData(cleanFilter.GetOutput())
-    surfaceFilter.Update()
-
-    points = surfaceFilter.GetOutput().GetPoints().GetData()
-    organizedPoints = vtk_to_numpy(points)
-
-    points_array = self.Unordered2orderedPointCloud(organizedPoints)
-
-    # print('number of points', points_array[0].shape)
-    #
-    # create the extent
-    origin = np.mean(points_array[0], axis=0)
-    euclidian_distance = np.linalg.norm(points_array[0] - origin, axis=1)
-    extent = np.max(euclidian_distance)
-
-    # create the extent with pca
-    splines_poly = points_array[1]
-    first_eigen = self.compute_simple_pca(splines_poly)
-    extent_pca = 4 * np.sqrt(first_eigen[1])
-
-    sub_pca = [self.compute_pca(points_array[1], extent_pca / 2, start=21 * i, stop=21 * (i + 1)) for i in
-               range(50)]
-
-    # convert a list of dictionaries into a dict of list
-    sub_pca_dict = {}
-    for k, v in [(key, d[key]) for d in sub_pca for key in d]:
-      if k not in sub_pca_dict:
-        sub_pca_dict[k] = [v]
-      else:
-        sub_pca_dict[k].append(v)
-
-    eigen_average_center = np.average(np.vstack(sub_pca_dict['eigen_vector'][4:46]), axis=0)
-
-    # TODo: the slops of the superior and inferior part of the point cloud could affect bezier Surface
-    eigen_average_start = np.average(np.vstack(sub_pca_dict['eigen_vector'][:4]), axis=0)
-    eigen_average_end = np.average(np.vstack(sub_pca_dict['eigen_vector'][46:50]), axis=0)
-
-    # ToDO: Review the need for this: maybe check if there is a resampling function for vtk Spline
-    center = sub_pca_dict['center']
-
-    organized_data = np.vstack(
-      np.array(
-        [self.line3D_afterSlopeAverage(center[i], eigen_average_center, extent_pca / 2) for i in
-         range(len(center))]))
-
-    points_grid = organized_data.reshape(50, 50, 3)
-
-    bezier_list_u = list()
-    bezier_list_v = list()
-
-    # u = self.compute_parametrization(points_grid[:, 0, 0].reshape(len(points_grid[:, 0, 0]), 1))
-    # v = self.compute_parametrization(points_grid[0, :, 0].reshape(len(points_grid[0, :, 0]), 1))
-
-    param_surface = self.compute_averaging_params_surface(points_grid, 50, 50)
-    u = param_surface[0].reshape(-1, 1)
-    v = param_surface[1].reshape(-1, 1)
-
-    # for u direction
-
-    for i in range(u.shape[0]):
-      bezier_basis = self.evaluate_basis_bezier(u[i], 3)
-      bezier_list_u.append(bezier_basis)
-
-    bezier_basis_u = np.array(bezier_list_u)
-
-    # for v direction
-
-    for i in range(v.shape[0]):
-      bezier_basis = self.evaluate_basis_bezier(v[i], 3)
-      bezier_list_v.append(bezier_basis)
-
-    bezier_basis_v = np.array(bezier_list_v)
-
-    ctrl_points = self.fit_bezier_surface(points_grid, bezier_basis_u, bezier_basis_v)
-
-    control_points = ctrl_points.reshape(-1, 3)
-    points = vtk.vtkPoints()
-    #
-    for i in range(0, len(control_points)):
-      points.InsertNextPoint(control_points[i])
-
-    # BezierNode = slicer.mrmlScene.GetNthNodeByClass(0, "vtkMRMLMarkupsBezierSurfaceNode")
-    # Transfer the control points to the resection node
-    BezierNode = resectionNode.GetBezierSurfaceNode()
-    BezierNode.RemoveAllControlPoints()
-    BezierNode.SetControlPointPositionsWorld(points)
-    BezierDisplay = BezierNode.GetDisplayNode()
-    BezierDisplay.VisibilityOn()
-
-    # BezierDisplay.SetClipOut(True)
-
 #
 # LiverTest
 #
@@ -2214,6 +2176,12 @@ class LiverTest(ScriptedLoadableModuleTest):
     """
     self.setUp()
     self.test_Liver1()
+    self.setUp()
+    self.test_DistanceMapsSimpleITK()
+    self.setUp()
+    self.test_DistanceMapCache()
+    self.setUp()
+    self.test_DistanceMapUpdate()
 
   def test_Liver1(self):
     pass
@@ -2279,3 +2247,149 @@ class LiverTest(ScriptedLoadableModuleTest):
     inputSegmentation = SampleData.downloadSample('LiverSegmentation000')
     inputVolume = SampleData.downloadSample('LiverVolume000')
     self.delayDisplay('Loaded test data set')
+
+  def test_DistanceMapsSimpleITK(self):
+    """
+    Compares the values of the native distance maps with the SimpleITK ones on
+    synthetic structures
+    """
+    self.delayDisplay("Starting distance map comparison")
+
+    shape = (40, 56, 56)
+    spacing = (0.8, 0.8, 1.5)
+    k, j, i = np.mgrid[0:shape[0], 0:shape[1], 0:shape[2]]
+    z, y, x = k * spacing[2], j * spacing[1], i * spacing[0]
+
+    def addLabelMap(name, mask):
+      node = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLLabelMapVolumeNode', name)
+      node.SetSpacing(spacing)
+      slicer.util.updateVolumeFromArray(node, mask.astype(np.uint8))
+      return node
+
+    parenchyma = addLabelMap("Parenchyma", (x - 22)**2 / 18**2 + (y - 22)**2 / 15**2 + (z - 30)**2 / 24**2 < 1.0)
+    tumor = addLabelMap("Tumor", (x - 17)**2 + (y - 21)**2 + (z - 27)**2 < 5**2)
+    hepatic = addLabelMap("Hepatic", ((x - 28)**2 + (y - 25)**2 < 2.5**2) & (z > 12) & (z < 50))
+    portal = addLabelMap("Portal", ((y - 17)**2 + (z - 33)**2 < 3**2) & (x > 6) & (x < 38))
+
+    logic = LiverLogic()
+    nativeNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "NativeDistanceMap")
+    logic.computeDistanceMaps(tumor, parenchyma, hepatic, portal, nativeNode)
+    simpleITKNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "SimpleITKDistanceMap")
+    logic.computeDistanceMapsSimpleITK(tumor, parenchyma, hepatic, portal, simpleITKNode)
+
+    nativeArray = slicer.util.arrayFromVolume(nativeNode)
+    simpleITKArray = slicer.util.arrayFromVolume(simpleITKNode)
+    self.assertEqual(nativeArray.shape, simpleITKArray.shape)
+    # Both measure the distance to the centers of the boundary voxels; the
+    # boundaries may differ by one voxel where the structures are diagonal
+    self.assertLessEqual(np.abs(nativeArray - simpleITKArray).max(), np.linalg.norm(spacing))
+    self.delayDisplay("Distance map comparison passed")
+
+  def test_DistanceMapCache(self):
+    """
+    Distance maps are stored in and loaded from the cache, corrupted entries
+    are discarded and the least recently used ones are evicted
+    """
+    import tempfile
+
+    self.delayDisplay("Starting distance map cache test")
+
+    shape = (30, 40, 40)
+    k, j, i = np.mgrid[0:shape[0], 0:shape[1], 0:shape[2]]
+    parenchyma = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLLabelMapVolumeNode', "Parenchyma")
+    parenchyma.SetSpacing(0.8, 0.8, 1.5)
+    slicer.util.updateVolumeFromArray(parenchyma, ((i - 20)**2 + (j - 20)**2 + (k - 15)**2 < 12**2).astype(np.uint8))
+    tumor = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLLabelMapVolumeNode', "Tumor")
+    tumor.SetSpacing(0.8, 0.8, 1.5)
+    slicer.util.updateVolumeFromArray(tumor, ((i - 18)**2 + (j - 22)**2 + (k - 15)**2 < 4**2).astype(np.uint8))
+
+    logic = LiverLogic()
+    with tempfile.TemporaryDirectory() as directory:
+      cache = DistanceMapCache(directory, maximumSize=1024**3)
+      computedNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "Computed")
+      logic.computeDistanceMaps(tumor, parenchyma, None, None, computedNode, quantizationRange=50.0, cache=cache)
+      key = cache.key([tumor, parenchyma, None, None],
+                      {"downSamplingRate": 1, "bandWidth": 0.0, "cropMargin": None, "quantizationRange": 50.0})
+      dataPath, metadataPath = cache.paths(key)
+      self.assertTrue(os.path.exists(dataPath) and os.path.exists(metadataPath))
+
+      # Cached: same voxels, geometry and scale
+      cachedNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "Cached")
+      self.assertTrue(cache.load(key, cachedNode))
+      np.testing.assert_array_equal(slicer.util.arrayFromVolume(cachedNode), slicer.util.arrayFromVolume(computedNode))
+      self.assertEqual(cachedNode.GetAttribute("DistanceMap.Scale"), computedNode.GetAttribute("DistanceMap.Scale"))
+      computedIJKToRAS, cachedIJKToRAS = vtk.vtkMatrix4x4(), vtk.vtkMatrix4x4()
+      computedNode.GetIJKToRASMatrix(computedIJKToRAS)
+      cachedNode.GetIJKToRASMatrix(cachedIJKToRAS)
+      self.assertEqual(DistanceMapCache.matrixToList(computedIJKToRAS), DistanceMapCache.matrixToList(cachedIJKToRAS))
+
+      # Other parameters or label maps have other keys
+      self.assertNotEqual(key, cache.key([tumor, parenchyma, None, None],
+                                         {"downSamplingRate": 1, "bandWidth": 0.0, "cropMargin": None, "quantizationRange": None}))
+      self.assertNotEqual(key, cache.key([None, parenchyma, None, None],
+                                         {"downSamplingRate": 1, "bandWidth": 0.0, "cropMargin": None, "quantizationRange": 50.0}))
+
+      # A truncated entry is discarded
+      slicer.mrmlScene.RemoveNode(cachedNode)
+      with open(dataPath, "r+b") as dataFile:
+        dataFile.truncate(os.path.getsize(dataPath) // 2)
+      otherNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "Other")
+      self.assertFalse(cache.load(key, otherNode))
+      self.assertFalse(os.path.exists(metadataPath))
+
+      # Beyond the maximum size, the least recently used entries are evicted
+      logic.computeDistanceMaps(tumor, parenchyma, None, None, otherNode, quantizationRange=50.0, cache=cache)
+      entrySize = os.path.getsize(dataPath) + os.path.getsize(metadataPath)
+      os.utime(metadataPath, (0, 0))
+      cache.maximumSize = int(1.5 * entrySize)
+      logic.computeDistanceMaps(tumor, parenchyma, None, None, otherNode, bandWidth=5.0, quantizationRange=50.0, cache=cache)
+      self.assertFalse(os.path.exists(metadataPath))
+      self.assertEqual(len([name for name in os.listdir(directory) if name.endswith(".json")]), 1)
+
+    self.delayDisplay("Distance map cache test passed")
+
+  def test_DistanceMapUpdate(self):
+    """
+    Distance maps updated after a label map edit match the recomputed ones,
+    and are only updated for the label maps and parameters they were
+    computed with
+    """
+    self.delayDisplay("Starting distance map update test")
+
+    shape = (30, 40, 40)
+    k, j, i = np.mgrid[0:shape[0], 0:shape[1], 0:shape[2]]
+    parenchyma = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLLabelMapVolumeNode', "Parenchyma")
+    parenchyma.SetSpacing(0.8, 0.8, 1.5)
+    slicer.util.updateVolumeFromArray(parenchyma, ((i - 20)**2 + (j - 20)**2 + (k - 15)**2 < 12**2).astype(np.uint8))
+    tumor = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLLabelMapVolumeNode', "Tumor")
+    tumor.SetSpacing(0.8, 0.8, 1.5)
+    slicer.util.updateVolumeFromArray(tumor, ((i - 18)**2 + (j - 22)**2 + (k - 15)**2 < 4**2).astype(np.uint8))
+
+    logic = LiverLogic()
+    updatedNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "Updated")
+    self.assertFalse(logic.updateDistanceMaps(tumor, parenchyma, None, None, updatedNode))
+    logic.computeDistanceMaps(tumor, parenchyma, None, None, updatedNode)
+
+    # The tumor grows on one side
+    slicer.util.updateVolumeFromArray(tumor, ((i - 19)**2 + (j - 22)**2 + (k - 15)**2 < 5**2).astype(np.uint8))
+    self.assertTrue(logic.updateDistanceMaps(tumor, parenchyma, None, None, updatedNode))
+    computedNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "Computed")
+    logic.computeDistanceMaps(tumor, parenchyma, None, None, computedNode)
+    np.testing.assert_allclose(slicer.util.arrayFromVolume(updatedNode), slicer.util.arrayFromVolume(computedNode),
+                               atol=1e-4)
+
+    # Other parameters, structures or output are computed again
+    self.assertFalse(logic.updateDistanceMaps(tumor, parenchyma, None, None, computedNode, bandWidth=5.0))
+    self.assertFalse(logic.updateDistanceMaps(None, parenchyma, None, None, computedNode))
+    self.assertFalse(logic.updateDistanceMaps(tumor, parenchyma, None, None, updatedNode))
+    self.assertTrue(logic.updateDistanceMaps(tumor, parenchyma, None, None, computedNode))
+
+    # Only the listed structures are updated, e.g. those of the edited segments
+    slicer.util.updateVolumeFromArray(tumor, ((i - 17)**2 + (j - 22)**2 + (k - 15)**2 < 4**2).astype(np.uint8))
+    self.assertTrue(logic.updateDistanceMaps(tumor, parenchyma, None, None, computedNode, modifiedStructures=[0]))
+    recomputedNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLVectorVolumeNode', "Recomputed")
+    logic.computeDistanceMaps(tumor, parenchyma, None, None, recomputedNode)
+    np.testing.assert_allclose(slicer.util.arrayFromVolume(computedNode), slicer.util.arrayFromVolume(recomputedNode),
+                               atol=1e-4)
+
+    self.delayDisplay("Distance map update test passed")
@@ -52,7 +52,7 @@ vtkMRMLNodeNewMacro(vtkMRMLMarkupsBezierSurfaceNode);
 
 //--------------------------------------------------------------------------------
 vtkMRMLMarkupsBezierSurfaceNode::vtkMRMLMarkupsBezierSurfaceNode()
-  :Target(nullptr), DistanceMap(nullptr), VascularSegments(nullptr), ResectionMargin(0.0), UncertaintyMargin(0.0), HepaticContourThickness(0.3f), PortalContourThickness(0.3f)
+  :Target(nullptr), DistanceMap(nullptr), VascularSegments(nullptr), ResectionMargin(0.0), UncertaintyMargin(0.0), HepaticContourThickness(0.3f), PortalContourThickness(0.3f), TexturesRevision(0)
 {
   this->MaximumNumberOfControlPoints = 16;
   this->RequiredNumberOfControlPoints = 16;
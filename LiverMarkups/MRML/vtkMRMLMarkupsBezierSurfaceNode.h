@@ -97,6 +97,14 @@ public:
   vtkMRMLScalarVolumeNode* GetVascularSegmentsVolumeNode() const
   {return this->VascularSegments;}
 
+  /// Signal that the content of the distance map or vascular segments volumes
+  /// changed, so that their textures are transferred again
+  void TexturesModified()
+  {++this->TexturesRevision; this->Modified();}
+
+  /// Number of TexturesModified calls
+  vtkGetMacro(TexturesRevision, unsigned int);
+
   /// Get the distance map margin
   vtkGetMacro(ResectionMargin, double);
 
@@ -138,6 +146,7 @@ private:
  double UncertaintyMargin;
  double HepaticContourThickness;
  double PortalContourThickness;
+ unsigned int TexturesRevision;
 
 private:
  vtkMRMLMarkupsBezierSurfaceNode(const vtkMRMLMarkupsBezierSurfaceNode&);
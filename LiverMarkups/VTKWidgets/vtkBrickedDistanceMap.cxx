@@ -0,0 +1,544 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// This module includes
+#include "vtkBrickedDistanceMap.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+constexpr int vtkBrickedDistanceMap::BrickSize;
+constexpr int vtkBrickedDistanceMap::AtlasBrickSize;
+
+namespace
+{
+//------------------------------------------------------------------------------
+/// Whether all the voxels of the brick and of its apron (clamped to the
+/// volume) have the same value
+template <typename T>
+bool IsUniformBrick(const T* values, const int dimensions[3], int numberOfComponents, const int brick[3])
+{
+  constexpr int brickSize = vtkBrickedDistanceMap::BrickSize;
+  int first[3];
+  int last[3];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    first[axis] = std::max(brick[axis] * brickSize - 1, 0);
+    last[axis] = std::min((brick[axis] + 1) * brickSize, dimensions[axis] - 1);
+    }
+
+  const vtkIdType rowStep = dimensions[0];
+  const vtkIdType sliceStep = rowStep * dimensions[1];
+  const T* reference = values + numberOfComponents * (first[0] + rowStep * first[1] + sliceStep * first[2]);
+  for (int k = first[2]; k <= last[2]; ++k)
+    {
+    for (int j = first[1]; j <= last[1]; ++j)
+      {
+      const T* row = values + numberOfComponents * (rowStep * j + sliceStep * k);
+      for (int i = first[0]; i <= last[0]; ++i)
+        {
+        const T* tuple = row + numberOfComponents * i;
+        for (int c = 0; c < numberOfComponents; ++c)
+          {
+          if (tuple[c] != reference[c])
+            {
+            return false;
+            }
+          }
+        }
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/// Copies the stored bricks (with their apron) to the atlas and the values
+/// of the elided ones to the constants
+template <typename T>
+void FillBricks(const T* values, const int dimensions[3], int numberOfComponents,
+                const int brickDimensions[3], const std::vector<vtkIdType>& brickSlots,
+                const int atlasSlots[3], T* atlas, T* constants, float* table)
+{
+  constexpr int brickSize = vtkBrickedDistanceMap::BrickSize;
+  constexpr int atlasBrickSize = vtkBrickedDistanceMap::AtlasBrickSize;
+  const vtkIdType rowStep = dimensions[0];
+  const vtkIdType sliceStep = rowStep * dimensions[1];
+  const vtkIdType atlasRowStep = static_cast<vtkIdType>(atlasSlots[0]) * atlasBrickSize;
+  const vtkIdType atlasSliceStep = atlasRowStep * atlasSlots[1] * atlasBrickSize;
+  const vtkIdType numberOfBricks = static_cast<vtkIdType>(brickDimensions[0]) * brickDimensions[1] * brickDimensions[2];
+
+  vtkSMPTools::For(0, numberOfBricks, [&](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType b = begin; b < end; ++b)
+      {
+      const int brick[3] = {static_cast<int>(b % brickDimensions[0]),
+                            static_cast<int>((b / brickDimensions[0]) % brickDimensions[1]),
+                            static_cast<int>(b / (static_cast<vtkIdType>(brickDimensions[0]) * brickDimensions[1]))};
+      const vtkIdType slot = brickSlots[b];
+      float* entry = table + 4 * b;
+      T* constant = constants + numberOfComponents * b;
+      if (slot < 0)
+        {
+        const T* tuple = values + numberOfComponents * (brick[0] * brickSize + rowStep * brick[1] * brickSize
+                                                        + sliceStep * brick[2] * brickSize);
+        std::copy(tuple, tuple + numberOfComponents, constant);
+        std::fill(entry, entry + 4, 0.0f);
+        continue;
+        }
+
+      std::fill(constant, constant + numberOfComponents, T(0));
+      const int origin[3] = {static_cast<int>(slot % atlasSlots[0]) * atlasBrickSize,
+                             static_cast<int>((slot / atlasSlots[0]) % atlasSlots[1]) * atlasBrickSize,
+                             static_cast<int>(slot / (static_cast<vtkIdType>(atlasSlots[0]) * atlasSlots[1])) * atlasBrickSize};
+      entry[0] = static_cast<float>(origin[0]);
+      entry[1] = static_cast<float>(origin[1]);
+      entry[2] = static_cast<float>(origin[2]);
+      entry[3] = 1.0f;
+
+      for (int lk = 0; lk < atlasBrickSize; ++lk)
+        {
+        const int k = std::min(std::max(brick[2] * brickSize + lk - 1, 0), dimensions[2] - 1);
+        for (int lj = 0; lj < atlasBrickSize; ++lj)
+          {
+          const int j = std::min(std::max(brick[1] * brickSize + lj - 1, 0), dimensions[1] - 1);
+          T* atlasRow = atlas + numberOfComponents * (origin[0] + atlasRowStep * (origin[1] + lj)
+                                                      + atlasSliceStep * (origin[2] + lk));
+          for (int li = 0; li < atlasBrickSize; ++li)
+            {
+            const int i = std::min(std::max(brick[0] * brickSize + li - 1, 0), dimensions[0] - 1);
+            const T* tuple = values + numberOfComponents * (i + rowStep * j + sliceStep * k);
+            std::copy(tuple, tuple + numberOfComponents, atlasRow + numberOfComponents * li);
+            }
+          }
+        }
+      }
+    });
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+void CopyBricksToVolume(const vtkBrickedDistanceMap* map, const int dimensions[3], int numberOfComponents,
+                        const T* atlas, const T* constants, T* values)
+{
+  constexpr int brickSize = vtkBrickedDistanceMap::BrickSize;
+  const int* brickDimensions = map->GetBrickDimensions();
+  const int* atlasDimensions = map->GetAtlas()->GetDimensions();
+  const float* table = static_cast<const float*>(map->GetBrickTable()->GetScalarPointer());
+  const vtkIdType rowStep = dimensions[0];
+  const vtkIdType sliceStep = rowStep * dimensions[1];
+  const vtkIdType atlasRowStep = atlasDimensions[0];
+  const vtkIdType atlasSliceStep = atlasRowStep * atlasDimensions[1];
+
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType beginSlice, vtkIdType endSlice)
+    {
+    for (int k = static_cast<int>(beginSlice); k < endSlice; ++k)
+      {
+      for (int j = 0; j < dimensions[1]; ++j)
+        {
+        for (int i = 0; i < dimensions[0]; ++i)
+          {
+          const vtkIdType b = i / brickSize + brickDimensions[0]
+            * (j / brickSize + static_cast<vtkIdType>(brickDimensions[1]) * (k / brickSize));
+          const float* entry = table + 4 * b;
+          const T* tuple = constants + numberOfComponents * b;
+          if (entry[3] != 0.0f)
+            {
+            const vtkIdType ai = static_cast<vtkIdType>(entry[0]) + i % brickSize + 1;
+            const vtkIdType aj = static_cast<vtkIdType>(entry[1]) + j % brickSize + 1;
+            const vtkIdType ak = static_cast<vtkIdType>(entry[2]) + k % brickSize + 1;
+            tuple = atlas + numberOfComponents * (ai + atlasRowStep * aj + atlasSliceStep * ak);
+            }
+          std::copy(tuple, tuple + numberOfComponents,
+                    values + numberOfComponents * (i + rowStep * j + sliceStep * k));
+          }
+        }
+      }
+    });
+}
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkBrickedDistanceMap);
+
+//------------------------------------------------------------------------------
+vtkBrickedDistanceMap::vtkBrickedDistanceMap()
+{
+  this->Initialize();
+}
+
+//------------------------------------------------------------------------------
+vtkBrickedDistanceMap::~vtkBrickedDistanceMap() = default;
+
+//------------------------------------------------------------------------------
+void vtkBrickedDistanceMap::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Dimensions: " << this->Dimensions[0] << " " << this->Dimensions[1] << " "
+     << this->Dimensions[2] << "\n";
+  os << indent << "NumberOfComponents: " << this->NumberOfComponents << "\n";
+  os << indent << "Scale: " << this->Scale << "\n";
+  os << indent << "Offset: " << this->Offset << "\n";
+  os << indent << "NumberOfBricks: " << this->GetNumberOfBricks() << "\n";
+  os << indent << "NumberOfStoredBricks: " << this->NumberOfStoredBricks << "\n";
+  os << indent << "MemorySize: " << this->GetMemorySize() << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkBrickedDistanceMap::Initialize()
+{
+  this->Scale = 1.0;
+  this->Offset = 0.0;
+  std::fill(this->Extent, this->Extent + 6, 0);
+  std::fill(this->Dimensions, this->Dimensions + 3, 0);
+  std::fill(this->Origin, this->Origin + 3, 0.0);
+  std::fill(this->Spacing, this->Spacing + 3, 1.0);
+  this->ScalarType = VTK_FLOAT;
+  this->NumberOfComponents = 0;
+  std::fill(this->BrickDimensions, this->BrickDimensions + 3, 0);
+  this->NumberOfStoredBricks = 0;
+  this->BrickSlots.clear();
+  this->Atlas = nullptr;
+  this->BrickTable = nullptr;
+  this->BrickConstants = nullptr;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+bool vtkBrickedDistanceMap::Build(vtkImageData* volume, double scale, double offset)
+{
+  this->Initialize();
+
+  vtkDataArray* scalars = volume && volume->GetPointData() ? volume->GetPointData()->GetScalars() : nullptr;
+  if (!scalars || volume->GetNumberOfPoints() < 1)
+    {
+    vtkErrorMacro("Build: no volume to build the bricks from.");
+    return false;
+    }
+  const int scalarType = scalars->GetDataType();
+  if (scalarType != VTK_FLOAT && scalarType != VTK_SHORT)
+    {
+    vtkErrorMacro("Build: unsupported scalar type " << scalars->GetDataTypeAsString()
+                  << " (float or short expected).");
+    return false;
+    }
+
+  this->Scale = scale;
+  this->Offset = offset;
+  volume->GetExtent(this->Extent);
+  volume->GetDimensions(this->Dimensions);
+  volume->GetOrigin(this->Origin);
+  volume->GetSpacing(this->Spacing);
+  this->ScalarType = scalarType;
+  this->NumberOfComponents = scalars->GetNumberOfComponents();
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    this->BrickDimensions[axis] = (this->Dimensions[axis] + BrickSize - 1) / BrickSize;
+    }
+
+  // Classify the bricks and assign the atlas slots of the stored ones
+  const vtkIdType numberOfBricks = this->GetNumberOfBricks();
+  std::vector<char> stored(numberOfBricks);
+  vtkSMPTools::For(0, numberOfBricks, [&](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType b = begin; b < end; ++b)
+      {
+      const int brick[3] = {static_cast<int>(b % this->BrickDimensions[0]),
+                            static_cast<int>((b / this->BrickDimensions[0]) % this->BrickDimensions[1]),
+                            static_cast<int>(b / (static_cast<vtkIdType>(this->BrickDimensions[0])
+                                                  * this->BrickDimensions[1]))};
+      stored[b] = scalarType == VTK_FLOAT
+        ? !IsUniformBrick(static_cast<const float*>(scalars->GetVoidPointer(0)), this->Dimensions,
+                          this->NumberOfComponents, brick)
+        : !IsUniformBrick(static_cast<const short*>(scalars->GetVoidPointer(0)), this->Dimensions,
+                          this->NumberOfComponents, brick);
+      }
+    });
+
+  this->BrickSlots.resize(numberOfBricks);
+  for (vtkIdType b = 0; b < numberOfBricks; ++b)
+    {
+    this->BrickSlots[b] = stored[b] ? this->NumberOfStoredBricks++ : -1;
+    }
+
+  // Nearly cubic atlas (at least one slot, so that it is a valid texture)
+  int atlasSlots[3] = {1, 1, 1};
+  while (static_cast<vtkIdType>(atlasSlots[0]) * atlasSlots[0] * atlasSlots[0] < this->NumberOfStoredBricks)
+    {
+    ++atlasSlots[0];
+    }
+  atlasSlots[1] = atlasSlots[0];
+  const vtkIdType slotsPerSlice = static_cast<vtkIdType>(atlasSlots[0]) * atlasSlots[1];
+  atlasSlots[2] = static_cast<int>(std::max<vtkIdType>((this->NumberOfStoredBricks + slotsPerSlice - 1) / slotsPerSlice, 1));
+
+  this->Atlas = vtkSmartPointer<vtkImageData>::New();
+  this->Atlas->SetDimensions(atlasSlots[0] * AtlasBrickSize, atlasSlots[1] * AtlasBrickSize,
+                             atlasSlots[2] * AtlasBrickSize);
+  this->Atlas->AllocateScalars(scalarType, this->NumberOfComponents);
+  vtkDataArray* atlasScalars = this->Atlas->GetPointData()->GetScalars();
+  std::memset(atlasScalars->GetVoidPointer(0), 0,
+              atlasScalars->GetNumberOfValues() * atlasScalars->GetDataTypeSize());
+
+  this->BrickTable = vtkSmartPointer<vtkImageData>::New();
+  this->BrickTable->SetDimensions(this->BrickDimensions);
+  this->BrickTable->AllocateScalars(VTK_FLOAT, 4);
+
+  this->BrickConstants = vtkSmartPointer<vtkImageData>::New();
+  this->BrickConstants->SetDimensions(this->BrickDimensions);
+  this->BrickConstants->AllocateScalars(scalarType, this->NumberOfComponents);
+
+  float* table = static_cast<float*>(this->BrickTable->GetScalarPointer());
+  if (scalarType == VTK_FLOAT)
+    {
+    FillBricks(static_cast<const float*>(scalars->GetVoidPointer(0)), this->Dimensions, this->NumberOfComponents,
+               this->BrickDimensions, this->BrickSlots, atlasSlots,
+               static_cast<float*>(this->Atlas->GetScalarPointer()),
+               static_cast<float*>(this->BrickConstants->GetScalarPointer()), table);
+    }
+  else
+    {
+    FillBricks(static_cast<const short*>(scalars->GetVoidPointer(0)), this->Dimensions, this->NumberOfComponents,
+               this->BrickDimensions, this->BrickSlots, atlasSlots,
+               static_cast<short*>(this->Atlas->GetScalarPointer()),
+               static_cast<short*>(this->BrickConstants->GetScalarPointer()), table);
+    }
+
+  this->Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkBrickedDistanceMap::GetNumberOfBricks() const
+{
+  return static_cast<vtkIdType>(this->BrickDimensions[0]) * this->BrickDimensions[1] * this->BrickDimensions[2];
+}
+
+//------------------------------------------------------------------------------
+bool vtkBrickedDistanceMap::IsBrickStored(int i, int j, int k) const
+{
+  if (i < 0 || j < 0 || k < 0
+      || i >= this->BrickDimensions[0] || j >= this->BrickDimensions[1] || k >= this->BrickDimensions[2])
+    {
+    return false;
+    }
+  return this->BrickSlots[i + this->BrickDimensions[0]
+                          * (j + static_cast<vtkIdType>(this->BrickDimensions[1]) * k)] >= 0;
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkBrickedDistanceMap::GetMemorySize() const
+{
+  vtkIdType size = static_cast<vtkIdType>(this->BrickSlots.size() * sizeof(vtkIdType));
+  for (vtkImageData* image : {this->Atlas.GetPointer(), this->BrickTable.GetPointer(),
+                              this->BrickConstants.GetPointer()})
+    {
+    if (image)
+      {
+      vtkDataArray* scalars = image->GetPointData()->GetScalars();
+      size += scalars->GetNumberOfValues() * scalars->GetDataTypeSize();
+      }
+    }
+  return size;
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkBrickedDistanceMap::GetDenseMemorySize() const
+{
+  const int valueSize = this->ScalarType == VTK_SHORT ? static_cast<int>(sizeof(short)) : static_cast<int>(sizeof(float));
+  return static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1] * this->Dimensions[2]
+    * this->NumberOfComponents * valueSize;
+}
+
+//------------------------------------------------------------------------------
+double vtkBrickedDistanceMap::GetValue(int i, int j, int k, int component) const
+{
+  const int brick[3] = {i / BrickSize, j / BrickSize, k / BrickSize};
+  const vtkIdType b = brick[0] + this->BrickDimensions[0]
+    * (brick[1] + static_cast<vtkIdType>(this->BrickDimensions[1]) * brick[2]);
+  if (this->BrickSlots[b] < 0)
+    {
+    return this->BrickConstants->GetPointData()->GetScalars()->GetComponent(b, component);
+    }
+
+  const float* entry = static_cast<const float*>(this->BrickTable->GetScalarPointer()) + 4 * b;
+  const int* atlasDimensions = this->Atlas->GetDimensions();
+  const vtkIdType ai = static_cast<vtkIdType>(entry[0]) + i - brick[0] * BrickSize + 1;
+  const vtkIdType aj = static_cast<vtkIdType>(entry[1]) + j - brick[1] * BrickSize + 1;
+  const vtkIdType ak = static_cast<vtkIdType>(entry[2]) + k - brick[2] * BrickSize + 1;
+  return this->Atlas->GetPointData()->GetScalars()->GetComponent(
+    ai + atlasDimensions[0] * (aj + static_cast<vtkIdType>(atlasDimensions[1]) * ak), component);
+}
+
+//------------------------------------------------------------------------------
+double vtkBrickedDistanceMap::GetDistance(int i, int j, int k, int component) const
+{
+  i -= this->Extent[0];
+  j -= this->Extent[2];
+  k -= this->Extent[4];
+  if (i < 0 || j < 0 || k < 0 || i >= this->Dimensions[0] || j >= this->Dimensions[1] || k >= this->Dimensions[2]
+      || component < 0 || component >= this->NumberOfComponents)
+    {
+    vtkErrorMacro("GetDistance: voxel (" << i << ", " << j << ", " << k << ") component " << component
+                  << " out of the volume.");
+    return 0.0;
+    }
+  return this->GetValue(i, j, k, component) * this->Scale + this->Offset;
+}
+
+//------------------------------------------------------------------------------
+bool vtkBrickedDistanceMap::InterpolateDistance(const double ijk[3], double* distances) const
+{
+  if (this->NumberOfComponents < 1)
+    {
+    return false;
+    }
+
+  int first[3];
+  int last[3];
+  double weights[3];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const double position = ijk[axis] - this->Extent[2 * axis];
+    if (!(position >= 0.0 && position <= this->Dimensions[axis] - 1))
+      {
+      return false;
+      }
+    first[axis] = std::min(static_cast<int>(position), std::max(this->Dimensions[axis] - 2, 0));
+    last[axis] = std::min(first[axis] + 1, this->Dimensions[axis] - 1);
+    weights[axis] = position - first[axis];
+    }
+
+  for (int c = 0; c < this->NumberOfComponents; ++c)
+    {
+    double value = 0.0;
+    for (int corner = 0; corner < 8; ++corner)
+      {
+      const int i = corner & 1 ? last[0] : first[0];
+      const int j = corner & 2 ? last[1] : first[1];
+      const int k = corner & 4 ? last[2] : first[2];
+      const double weight = (corner & 1 ? weights[0] : 1.0 - weights[0])
+        * (corner & 2 ? weights[1] : 1.0 - weights[1])
+        * (corner & 4 ? weights[2] : 1.0 - weights[2]);
+      if (weight != 0.0)
+        {
+        value += weight * this->GetValue(i, j, k, c);
+        }
+      }
+    distances[c] = value * this->Scale + this->Offset;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkBrickedDistanceMap::ToImageData(vtkImageData* volume) const
+{
+  if (!volume)
+    {
+    return;
+    }
+  volume->Initialize();
+  if (this->NumberOfComponents < 1)
+    {
+    return;
+    }
+
+  volume->SetExtent(this->Extent[0], this->Extent[1], this->Extent[2], this->Extent[3], this->Extent[4], this->Extent[5]);
+  volume->SetOrigin(this->Origin[0], this->Origin[1], this->Origin[2]);
+  volume->SetSpacing(this->Spacing[0], this->Spacing[1], this->Spacing[2]);
+  volume->AllocateScalars(this->ScalarType, this->NumberOfComponents);
+  if (this->ScalarType == VTK_FLOAT)
+    {
+    CopyBricksToVolume(this, this->Dimensions, this->NumberOfComponents,
+                       static_cast<const float*>(this->Atlas->GetScalarPointer()),
+                       static_cast<const float*>(this->BrickConstants->GetScalarPointer()),
+                       static_cast<float*>(volume->GetScalarPointer()));
+    }
+  else
+    {
+    CopyBricksToVolume(this, this->Dimensions, this->NumberOfComponents,
+                       static_cast<const short*>(this->Atlas->GetScalarPointer()),
+                       static_cast<const short*>(this->BrickConstants->GetScalarPointer()),
+                       static_cast<short*>(volume->GetScalarPointer()));
+    }
+}
+
+//------------------------------------------------------------------------------
+std::string vtkBrickedDistanceMap::GetShaderSamplingFunction()
+{
+  const std::string brickSize = std::to_string(BrickSize) + ".0";
+  return
+    "uniform sampler3D brickTableTexture;\n"
+    "uniform sampler3D brickConstantsTexture;\n"
+    "uniform int uBrickedDistanceMap;\n"
+    "uniform vec3 uDistanceMapDimensions;\n"
+    "uniform vec3 uBrickDimensions;\n"
+    "uniform vec3 uAtlasDimensions;\n"
+    "uniform float uDistanceMapBorder;\n"
+    "vec4 sampleDistanceMap(vec3 textureCoordinates)\n"
+    "{\n"
+    "  if (uBrickedDistanceMap == 0)\n"
+    "    {\n"
+    "    return texture(distanceTexture, textureCoordinates);\n"
+    "    }\n"
+    "  if (any(lessThan(textureCoordinates, vec3(0.0))) || any(greaterThan(textureCoordinates, vec3(1.0))))\n"
+    "    {\n"
+    "    return vec4(uDistanceMapBorder, uDistanceMapBorder, 0.0, 0.0);\n"
+    "    }\n"
+    // Continuous voxel index and its brick: within the brick and its apron
+    // for both voxels interpolated along each axis
+    "  vec3 voxel = clamp(textureCoordinates*uDistanceMapDimensions - 0.5, vec3(0.0), uDistanceMapDimensions - 1.0);\n"
+    "  vec3 brick = min(floor((voxel + 0.5)/" + brickSize + "), uBrickDimensions - 1.0);\n"
+    "  vec3 brickCoordinates = (brick + 0.5)/uBrickDimensions;\n"
+    "  vec4 entry = texture(brickTableTexture, brickCoordinates);\n"
+    "  if (entry.w < 0.5)\n"
+    "    {\n"
+    "    return texture(brickConstantsTexture, brickCoordinates);\n"
+    "    }\n"
+    "  return texture(distanceTexture, (entry.xyz + voxel - " + brickSize + "*brick + 1.5)/uAtlasDimensions);\n"
+    "}\n";
+}
@@ -0,0 +1,170 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkBrickedDistanceMap_h
+#define __vtkBrickedDistanceMap_h
+
+#include "vtkSlicerLiverMarkupsModuleVTKWidgetsExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkImageData;
+
+//------------------------------------------------------------------------------
+/// \brief Sparse bricked representation of a distance map.
+///
+/// The volume is split in bricks of BrickSize^3 voxels. Bricks whose voxels
+/// are all the same (e.g. saturated out of the band of a banded or quantized
+/// distance map) are elided and only keep their constant value; the others
+/// are stored in an atlas of bricks with a one voxel apron (the neighbor
+/// voxels, replicated at the borders of the volume), so that the trilinear
+/// interpolation within a brick never needs the neighbor bricks. A brick is
+/// only elided if its apron is uniform too, so interpolating the elided
+/// bricks is exact.
+///
+/// The brick table (one tuple per brick with the voxel origin of the brick in
+/// the atlas and whether the brick is stored), the constants and the atlas are
+/// images with the scalar type of the dense volume (float or short), ready to
+/// be uploaded as textures. Values are the ones of the dense volume; distances
+/// are value * Scale + Offset (mm), as in the quantized distance maps.
+class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkBrickedDistanceMap
+  : public vtkObject
+{
+public:
+  static vtkBrickedDistanceMap* New();
+  vtkTypeMacro(vtkBrickedDistanceMap, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Voxels per brick along each axis
+  static constexpr int BrickSize = 16;
+  /// Voxels per atlas brick along each axis (brick and apron)
+  static constexpr int AtlasBrickSize = BrickSize + 2;
+
+  /// Builds the bricks from a dense float or short volume. Returns false (and
+  /// leaves the map empty) for other scalar types or an empty volume.
+  bool Build(vtkImageData* volume, double scale = 1.0, double offset = 0.0);
+  void Initialize();
+
+  /// Mapping of the values to distances (mm)
+  vtkGetMacro(Scale, double);
+  vtkGetMacro(Offset, double);
+
+  /// Geometry of the dense volume
+  const int* GetExtent() const { return this->Extent; }
+  const int* GetDimensions() const { return this->Dimensions; }
+  int GetScalarType() const { return this->ScalarType; }
+  int GetNumberOfComponents() const { return this->NumberOfComponents; }
+
+  /// Number of bricks along each axis
+  const int* GetBrickDimensions() const { return this->BrickDimensions; }
+  vtkIdType GetNumberOfBricks() const;
+  vtkIdType GetNumberOfStoredBricks() const { return this->NumberOfStoredBricks; }
+
+  /// Whether the brick (brick indices) is stored in the atlas
+  bool IsBrickStored(int i, int j, int k) const;
+
+  /// Atlas of the stored bricks (AtlasBrickSize^3 voxels each)
+  vtkImageData* GetAtlas() const { return this->Atlas; }
+  /// One float tuple per brick: voxel origin of the brick in the atlas and 1
+  /// if stored, 0 if elided
+  vtkImageData* GetBrickTable() const { return this->BrickTable; }
+  /// One tuple per brick with the value of the elided bricks
+  vtkImageData* GetBrickConstants() const { return this->BrickConstants; }
+
+  /// Memory of the bricked representation and of the dense volume (bytes)
+  vtkIdType GetMemorySize() const;
+  vtkIdType GetDenseMemorySize() const;
+
+  /// Distance (mm) at a voxel (structured indices of the dense volume)
+  double GetDistance(int i, int j, int k, int component) const;
+
+  /// Trilinear interpolation of the distances (mm) at continuous structured
+  /// indices of the dense volume. Returns false out of the volume.
+  bool InterpolateDistance(const double ijk[3], double* distances) const;
+
+  /// Reconstructs the dense volume (same values and geometry)
+  void ToImageData(vtkImageData* volume) const;
+
+  /// GLSL of vec4 sampleDistanceMap(vec3 textureCoordinates), which samples
+  /// the distanceTexture sampler (texture coordinates of the dense volume).
+  /// If uBrickedDistanceMap is set, distanceTexture is the atlas and the
+  /// brick table and constants are in brickTableTexture and
+  /// brickConstantsTexture (nearest filtering); uDistanceMapDimensions,
+  /// uBrickDimensions and uAtlasDimensions are the dimensions of the dense
+  /// volume, of the brick table and of the atlas, and uDistanceMapBorder is
+  /// the value out of the volume. Unlike the dense texture, the voxels at the
+  /// border of the volume are replicated up to half a voxel out of it.
+  static std::string GetShaderSamplingFunction();
+
+protected:
+  vtkBrickedDistanceMap();
+  ~vtkBrickedDistanceMap() override;
+
+  /// Value of a voxel (indices relative to the extent origin)
+  double GetValue(int i, int j, int k, int component) const;
+
+  double Scale;
+  double Offset;
+  int Extent[6];
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+  int ScalarType;
+  int NumberOfComponents;
+  int BrickDimensions[3];
+  vtkIdType NumberOfStoredBricks;
+  /// Atlas slot of each brick (-1 for elided bricks)
+  std::vector<vtkIdType> BrickSlots;
+  vtkSmartPointer<vtkImageData> Atlas;
+  vtkSmartPointer<vtkImageData> BrickTable;
+  vtkSmartPointer<vtkImageData> BrickConstants;
+
+private:
+  vtkBrickedDistanceMap(const vtkBrickedDistanceMap&) = delete;
+  void operator=(const vtkBrickedDistanceMap&) = delete;
+};
+
+#endif // __vtkBrickedDistanceMap_h
@@ -39,6 +39,7 @@ bool vtkMultiTextureObjectHelper::CreateSeq2DFromRaw(
   this->GetDataType(dataType);
   this->GetInternalFormat(dataType, numComps, false);
   this->GetFormat(dataType, numComps, false);
+  this->UseNormalizedFormat(dataType, numComps);
 
   if (!this->InternalFormat || !this->Format || !this->Type)
     {
@@ -83,6 +84,7 @@ bool vtkMultiTextureObjectHelper::CreateSeq3DFromRaw(unsigned int width, unsigne
   this->GetDataType(dataType);
   this->GetInternalFormat(dataType, numComps, false);
   this->GetFormat(dataType, numComps, false);
+  this->UseNormalizedFormat(dataType, numComps);
 
   if (!this->InternalFormat || !this->Format || !this->Type)
     {
@@ -114,6 +116,21 @@ bool vtkMultiTextureObjectHelper::CreateSeq3DFromRaw(unsigned int width, unsigne
   return vtkOpenGLCheckErrors("Failed to allocate 3D texture.");
 }
 
+void vtkMultiTextureObjectHelper::UseNormalizedFormat(int dataType, int numComps)
+{
+  if (!this->NormalizedIntegers || numComps < 1 || numComps > 4
+      || (dataType != VTK_SHORT && dataType != VTK_UNSIGNED_SHORT))
+    {
+    return;
+    }
+
+  static const GLenum formats[4] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+  static const GLenum signedFormats[4] = {GL_R16_SNORM, GL_RG16_SNORM, GL_RGB16_SNORM, GL_RGBA16_SNORM};
+  static const GLenum unsignedFormats[4] = {GL_R16, GL_RG16, GL_RGB16, GL_RGBA16};
+  this->InternalFormat = dataType == VTK_SHORT ? signedFormats[numComps - 1] : unsignedFormats[numComps - 1];
+  this->Format = formats[numComps - 1];
+}
+
 void vtkMultiTextureObjectHelper::CreateSeqTexture(int texSeq)
 {
   assert(this->Context);
@@ -24,6 +24,18 @@ class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkMultiTextureObjectHelp
 
   void CreateSeqTexture(int texSeq=0);
 
+  /// Upload 16-bit integer data as normalized textures (shaders read signed
+  /// values in [-1, 1] and unsigned ones in [0, 1], linearly interpolated)
+  /// instead of integer textures
+  vtkSetMacro(NormalizedIntegers, bool);
+  vtkGetMacro(NormalizedIntegers, bool);
+  vtkBooleanMacro(NormalizedIntegers, bool);
+
+ protected:
+  bool NormalizedIntegers = false;
+
+  /// Switch the formats of 16-bit integer data to normalized ones
+  void UseNormalizedFormat(int dataType, int numComps);
 };
 
 #endif //SLICERLIVER_VTKMULTITEXTUREOBJECTHELPER_H
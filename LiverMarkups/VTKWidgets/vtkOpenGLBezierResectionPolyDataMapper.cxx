@@ -39,6 +39,7 @@
 
 // This module VTK includes
 #include "vtkOpenGLBezierResectionPolyDataMapper.h"
+#include "vtkBrickedDistanceMap.h"
 
 // VTK includes
 #include <vtkCellData.h>
@@ -67,6 +68,9 @@ public:
   : Parent(parent), DistanceMapTextureObject(nullptr),
     RasToIjkMatrixT(nullptr), IjkToTextureMatrixT(nullptr),
     ResectionMargin(0.0f), UncertaintyMargin(0.0f),
+    DistanceScale(1.0f), DistanceOffset(0.0f),
+    BrickedDistanceMap(false), DistanceMapDimensions{1.0f, 1.0f, 1.0f},
+    BrickDimensions{1.0f, 1.0f, 1.0f}, AtlasDimensions{1.0f, 1.0f, 1.0f}, DistanceMapBorder(0.0f),
     ResectionMarginColor{1.0f, 0.0f, 0.0f},
     UncertaintyMarginColor{1.0f, 1.0f, 0.0f},
     ResectionColor{1.0f,1.0f, 1.0f},
@@ -84,6 +88,13 @@ public:
   vtkSmartPointer<vtkMatrix4x4> IjkToTextureMatrixT;
   float ResectionMargin;
   float UncertaintyMargin;
+  float DistanceScale;
+  float DistanceOffset;
+  bool BrickedDistanceMap;
+  float DistanceMapDimensions[3];
+  float BrickDimensions[3];
+  float AtlasDimensions[3];
+  float DistanceMapBorder;
   float ResectionMarginColor[3];
   float UncertaintyMarginColor[3];
   float ResectionColor[3];
@@ -159,12 +170,15 @@ void vtkOpenGLBezierResectionPolyDataMapper::ReplaceShaderValues(
     "#define M_PI 3.1415926535897932384626433832795\n"
     "uniform sampler3D distanceTexture;\n"
     "uniform sampler2D posMarker;\n"
-    "//vec4 fragPositionMC = vertexWCVSOutput;\n");
+    "//vec4 fragPositionMC = vertexWCVSOutput;\n"
+    + vtkBrickedDistanceMap::GetShaderSamplingFunction());
 
   vtkShaderProgram::Substitute(
     FSSource, "//VTK::Color::Dec",
     "//VTK::Color::Dec\n"
     "uniform float uResectionMargin;\n"
+    "uniform float uDistanceScale;\n"
+    "uniform float uDistanceOffset;\n"
     "uniform float uUncertaintyMargin;\n"
     "uniform float uResectionOpacity;\n"
     "uniform vec3 uResectionMarginColor;\n"
@@ -183,7 +197,7 @@ void vtkOpenGLBezierResectionPolyDataMapper::ReplaceShaderValues(
     FSSource, "//VTK::Color::Impl",
     "//VTK::Color::Impl\n"
     "vec4 marker = texture(posMarker, uvCoordsOutput);\n"
-    "vec4 dist = texture(distanceTexture, fragPositionMC.xyz);\n"
+    "vec4 dist = sampleDistanceMap(fragPositionMC.xyz)*uDistanceScale + uDistanceOffset;\n"
     "float lowMargin = uResectionMargin - uUncertaintyMargin;\n"
     "float highMargin = uResectionMargin + uUncertaintyMargin;\n"
     "if(uResectionClipOut == 1 && dist[1] > 2.0){\n"
@@ -307,6 +321,31 @@ void vtkOpenGLBezierResectionPolyDataMapper::SetMapperShaderParameters(
     cellBO.Program->SetUniformf("uResectionMargin", this->Impl->ResectionMargin);
     }
 
+  if (cellBO.Program->IsUniformUsed("uDistanceScale"))
+    {
+    cellBO.Program->SetUniformf("uDistanceScale", this->Impl->DistanceScale);
+    }
+
+  if (cellBO.Program->IsUniformUsed("uDistanceOffset"))
+    {
+    cellBO.Program->SetUniformf("uDistanceOffset", this->Impl->DistanceOffset);
+    }
+
+  if (cellBO.Program->IsUniformUsed("uBrickedDistanceMap"))
+    {
+    cellBO.Program->SetUniformi("uBrickedDistanceMap", this->Impl->BrickedDistanceMap);
+    }
+
+  if (this->Impl->BrickedDistanceMap)
+    {
+    cellBO.Program->SetUniformi("brickTableTexture", 2);
+    cellBO.Program->SetUniformi("brickConstantsTexture", 3);
+    cellBO.Program->SetUniform3f("uDistanceMapDimensions", this->Impl->DistanceMapDimensions);
+    cellBO.Program->SetUniform3f("uBrickDimensions", this->Impl->BrickDimensions);
+    cellBO.Program->SetUniform3f("uAtlasDimensions", this->Impl->AtlasDimensions);
+    cellBO.Program->SetUniformf("uDistanceMapBorder", this->Impl->DistanceMapBorder);
+    }
+
   if (cellBO.Program->IsUniformUsed("uUncertaintyMargin"))
     {
     cellBO.Program->SetUniformf("uUncertaintyMargin", this->Impl->UncertaintyMargin);
@@ -457,6 +496,55 @@ void vtkOpenGLBezierResectionPolyDataMapper::SetResectionMargin(float margin)
   this->Modified();
 }
 
+//------------------------------------------------------------------------------
+float vtkOpenGLBezierResectionPolyDataMapper::GetDistanceScale() const
+{
+  return this->Impl->DistanceScale;
+}
+
+//------------------------------------------------------------------------------
+void vtkOpenGLBezierResectionPolyDataMapper::SetDistanceScale(float scale)
+{
+  this->Impl->DistanceScale = scale;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+float vtkOpenGLBezierResectionPolyDataMapper::GetDistanceOffset() const
+{
+  return this->Impl->DistanceOffset;
+}
+
+//------------------------------------------------------------------------------
+void vtkOpenGLBezierResectionPolyDataMapper::SetDistanceOffset(float offset)
+{
+  this->Impl->DistanceOffset = offset;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkOpenGLBezierResectionPolyDataMapper::SetDistanceMapBricks(vtkBrickedDistanceMap* bricks, float borderValue)
+{
+  this->Impl->BrickedDistanceMap = bricks && bricks->GetNumberOfComponents() > 0;
+  if (this->Impl->BrickedDistanceMap)
+    {
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      this->Impl->DistanceMapDimensions[axis] = static_cast<float>(bricks->GetDimensions()[axis]);
+      this->Impl->BrickDimensions[axis] = static_cast<float>(bricks->GetBrickDimensions()[axis]);
+      this->Impl->AtlasDimensions[axis] = static_cast<float>(bricks->GetAtlas()->GetDimensions()[axis]);
+      }
+    }
+  this->Impl->DistanceMapBorder = borderValue;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+bool vtkOpenGLBezierResectionPolyDataMapper::GetBrickedDistanceMap() const
+{
+  return this->Impl->BrickedDistanceMap;
+}
+
 //------------------------------------------------------------------------------
 float vtkOpenGLBezierResectionPolyDataMapper::GetUncertaintyMargin() const
 {
@@ -50,6 +50,7 @@
 #include <memory>
 
 //-------------------------------------------------------------------------------
+class vtkBrickedDistanceMap;
 class vtkTextureObject;
 
 //-------------------------------------------------------------------------------
@@ -85,6 +86,25 @@ public:
   /// Set the resection margin
   void SetResectionMargin(float margin);
 
+  /// Get the scale of the distance map texture values (distance = value *
+  /// scale + offset, in mm)
+  float GetDistanceScale() const;
+  /// Set the scale of the distance map texture values
+  void SetDistanceScale(float scale);
+
+  /// Get the offset of the distance map texture values
+  float GetDistanceOffset() const;
+  /// Set the offset of the distance map texture values
+  void SetDistanceOffset(float offset);
+
+  /// Sample the distance map texture as the atlas of a bricked distance map,
+  /// with its brick table and constants on texture units 2 and 3 (see
+  /// vtkBrickedDistanceMap::GetShaderSamplingFunction). borderValue is the
+  /// texture value out of the volume. nullptr samples a dense volume again.
+  void SetDistanceMapBricks(vtkBrickedDistanceMap* bricks, float borderValue = 0.0f);
+  /// Whether the distance map texture is a bricked one
+  bool GetBrickedDistanceMap() const;
+
   /// Get the uncertainty margin
   float GetUncertaintyMargin() const;
   /// Set the resection margin
@@ -38,6 +38,7 @@
   ==============================================================================*/
 
 #include "vtkOpenGLResection2DPolyDataMapper.h"
+#include "vtkBrickedDistanceMap.h"
 // VTK includes
 #include <vtkCellData.h>
 #include <vtkFloatArray.h>
@@ -63,8 +64,11 @@ class vtkOpenGLResection2DPolyDataMapper::vtkInternal
  public:
   vtkInternal(vtkOpenGLResection2DPolyDataMapper* parent)
     : Parent(parent), DistanceMapTextureObject(nullptr), VascularSegmentsTextureObject(nullptr),
-      RasToIjkMatrixT(nullptr), IjkToTextureMatrixT(nullptr),
+      RasToIjkMatrixT(nullptr), IjkToTextureMatrixT(nullptr), DistanceToVascularTextureMatrixT(nullptr),
       ResectionMargin(0.0f), UncertaintyMargin(0.0f),
+      DistanceScale(1.0f), DistanceOffset(0.0f),
+      BrickedDistanceMap(false), DistanceMapDimensions{1.0f, 1.0f, 1.0f},
+      BrickDimensions{1.0f, 1.0f, 1.0f}, AtlasDimensions{1.0f, 1.0f, 1.0f}, DistanceMapBorder(0.0f),
       ResectionMarginColor{1.0f, 0.0f, 0.0f},
       UncertaintyMarginColor{1.0f, 1.0f, 0.0f},
       ResectionColor{1.0f,1.0f, 1.0f},
@@ -77,6 +81,7 @@ class vtkOpenGLResection2DPolyDataMapper::vtkInternal
   {
     this->RasToIjkMatrixT = vtkSmartPointer<vtkMatrix4x4>::New();
     this->IjkToTextureMatrixT = vtkSmartPointer<vtkMatrix4x4>::New();
+    this->DistanceToVascularTextureMatrixT = vtkSmartPointer<vtkMatrix4x4>::New();
   }
 
   vtkWeakPointer<vtkOpenGLResection2DPolyDataMapper> Parent;
@@ -84,8 +89,16 @@ class vtkOpenGLResection2DPolyDataMapper::vtkInternal
   vtkSmartPointer<vtkTextureObject> VascularSegmentsTextureObject;
   vtkSmartPointer<vtkMatrix4x4> RasToIjkMatrixT;
   vtkSmartPointer<vtkMatrix4x4> IjkToTextureMatrixT;
+  vtkSmartPointer<vtkMatrix4x4> DistanceToVascularTextureMatrixT;
   float ResectionMargin;
   float UncertaintyMargin;
+  float DistanceScale;
+  float DistanceOffset;
+  bool BrickedDistanceMap;
+  float DistanceMapDimensions[3];
+  float BrickDimensions[3];
+  float AtlasDimensions[3];
+  float DistanceMapBorder;
   float ResectionMarginColor[3];
   float UncertaintyMarginColor[3];
   float ResectionColor[3];
@@ -186,13 +199,16 @@ void vtkOpenGLResection2DPolyDataMapper::ReplaceShaderValues(
     "uniform sampler3D distanceTexture;\n"
     "uniform sampler3D vesselSegTexture;\n"
     "uniform sampler2D posMarker;\n"
-    "//vec4 fragPositionMC = vertexWCVSOutput;\n");
+    "//vec4 fragPositionMC = vertexWCVSOutput;\n"
+    + vtkBrickedDistanceMap::GetShaderSamplingFunction());
 
   vtkShaderProgram::Substitute(
     FSSource, "//VTK::Color::Dec",
     "//VTK::Color::Dec\n"
     "uniform vec4 colorChart[8];\n"
     "uniform float uResectionMargin;\n"
+    "uniform float uDistanceScale;\n"
+    "uniform float uDistanceOffset;\n"
     "uniform float uUncertaintyMargin;\n"
     "uniform vec3 uResectionMarginColor;\n"
     "uniform vec3 uUncertaintyMarginColor;\n"
@@ -208,14 +224,15 @@ void vtkOpenGLResection2DPolyDataMapper::ReplaceShaderValues(
     "uniform vec3 uHepaticContourColor;\n"
     "uniform int uTextureNumComps;\n"
     "uniform float uPortalContourThickness;\n"
-    "uniform float uHepaticContourThickness;\n");
+    "uniform float uHepaticContourThickness;\n"
+    "uniform mat4 uDistanceToVascularTexture;\n");
 
   vtkShaderProgram::Substitute(
     FSSource, "//VTK::Color::Impl",
     "//VTK::Color::Impl\n"
     "vec4 marker = texture(posMarker, uvCoordsOutput);\n"
-    "vec4 dist = texture(distanceTexture, fragPositionMCBS.xyz);\n"
-    "vec4 vesselBg = texture(vesselSegTexture, fragPositionMCBS.xyz);\n"
+    "vec4 dist = sampleDistanceMap(fragPositionMCBS.xyz)*uDistanceScale + uDistanceOffset;\n"
+    "vec4 vesselBg = texture(vesselSegTexture, (uDistanceToVascularTexture*fragPositionMCBS).xyz);\n"
     "float lowMargin = uResectionMargin - uUncertaintyMargin;\n"
     "float highMargin = uResectionMargin + uUncertaintyMargin;\n"
 
@@ -408,11 +425,41 @@ void vtkOpenGLResection2DPolyDataMapper::SetMapperShaderParameters(
     cellBO.Program->SetUniformMatrix("uIjkToTexture", this->Impl->IjkToTextureMatrixT);
     }
 
+  if (cellBO.Program->IsUniformUsed("uDistanceToVascularTexture"))
+    {
+    cellBO.Program->SetUniformMatrix("uDistanceToVascularTexture", this->Impl->DistanceToVascularTextureMatrixT);
+    }
+
   if (cellBO.Program->IsUniformUsed("uResectionMargin"))
     {
     cellBO.Program->SetUniformf("uResectionMargin", this->Impl->ResectionMargin);
     }
 
+  if (cellBO.Program->IsUniformUsed("uDistanceScale"))
+    {
+    cellBO.Program->SetUniformf("uDistanceScale", this->Impl->DistanceScale);
+    }
+
+  if (cellBO.Program->IsUniformUsed("uDistanceOffset"))
+    {
+    cellBO.Program->SetUniformf("uDistanceOffset", this->Impl->DistanceOffset);
+    }
+
+  if (cellBO.Program->IsUniformUsed("uBrickedDistanceMap"))
+    {
+    cellBO.Program->SetUniformi("uBrickedDistanceMap", this->Impl->BrickedDistanceMap);
+    }
+
+  if (this->Impl->BrickedDistanceMap)
+    {
+    cellBO.Program->SetUniformi("brickTableTexture", 2);
+    cellBO.Program->SetUniformi("brickConstantsTexture", 3);
+    cellBO.Program->SetUniform3f("uDistanceMapDimensions", this->Impl->DistanceMapDimensions);
+    cellBO.Program->SetUniform3f("uBrickDimensions", this->Impl->BrickDimensions);
+    cellBO.Program->SetUniform3f("uAtlasDimensions", this->Impl->AtlasDimensions);
+    cellBO.Program->SetUniformf("uDistanceMapBorder", this->Impl->DistanceMapBorder);
+    }
+
   if (cellBO.Program->IsUniformUsed("uUncertaintyMargin"))
     {
     cellBO.Program->SetUniformf("uUncertaintyMargin", this->Impl->UncertaintyMargin);
@@ -593,6 +640,25 @@ void vtkOpenGLResection2DPolyDataMapper::SetIjkToTextureMatrix(const vtkMatrix4x
   this->Impl->IjkToTextureMatrixT->Transpose();
   this->Modified();
 }
+//------------------------------------------------------------------------------
+vtkMatrix4x4 const* vtkOpenGLResection2DPolyDataMapper::GetDistanceToVascularTextureMatrixT() const
+{
+  return this->Impl->DistanceToVascularTextureMatrixT;
+}
+
+//------------------------------------------------------------------------------
+void vtkOpenGLResection2DPolyDataMapper::SetDistanceToVascularTextureMatrix(const vtkMatrix4x4* matrix)
+{
+  if (matrix == nullptr)
+    {
+    return;
+    }
+
+  this->Impl->DistanceToVascularTextureMatrixT->DeepCopy(matrix);
+  this->Impl->DistanceToVascularTextureMatrixT->Transpose();
+  this->Modified();
+}
+
 //------------------------------------------------------------------------------
 float vtkOpenGLResection2DPolyDataMapper::GetResectionMargin() const
 {
@@ -606,6 +672,55 @@ void vtkOpenGLResection2DPolyDataMapper::SetResectionMargin(float margin)
   this->Modified();
 }
 
+//------------------------------------------------------------------------------
+float vtkOpenGLResection2DPolyDataMapper::GetDistanceScale() const
+{
+  return this->Impl->DistanceScale;
+}
+
+//------------------------------------------------------------------------------
+void vtkOpenGLResection2DPolyDataMapper::SetDistanceScale(float scale)
+{
+  this->Impl->DistanceScale = scale;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+float vtkOpenGLResection2DPolyDataMapper::GetDistanceOffset() const
+{
+  return this->Impl->DistanceOffset;
+}
+
+//------------------------------------------------------------------------------
+void vtkOpenGLResection2DPolyDataMapper::SetDistanceOffset(float offset)
+{
+  this->Impl->DistanceOffset = offset;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkOpenGLResection2DPolyDataMapper::SetDistanceMapBricks(vtkBrickedDistanceMap* bricks, float borderValue)
+{
+  this->Impl->BrickedDistanceMap = bricks && bricks->GetNumberOfComponents() > 0;
+  if (this->Impl->BrickedDistanceMap)
+    {
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      this->Impl->DistanceMapDimensions[axis] = static_cast<float>(bricks->GetDimensions()[axis]);
+      this->Impl->BrickDimensions[axis] = static_cast<float>(bricks->GetBrickDimensions()[axis]);
+      this->Impl->AtlasDimensions[axis] = static_cast<float>(bricks->GetAtlas()->GetDimensions()[axis]);
+      }
+    }
+  this->Impl->DistanceMapBorder = borderValue;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+bool vtkOpenGLResection2DPolyDataMapper::GetBrickedDistanceMap() const
+{
+  return this->Impl->BrickedDistanceMap;
+}
+
 //------------------------------------------------------------------------------
 float vtkOpenGLResection2DPolyDataMapper::GetUncertaintyMargin() const
 {
@@ -42,6 +42,7 @@
 #include "vtkMRMLMarkupsBezierSurfaceNode.h"
 #include "vtkMRMLMarkupsBezierSurfaceDisplayNode.h"
 #include "vtkBezierSurfaceSource.h"
+#include "vtkBrickedDistanceMap.h"
 #include "vtkMRMLScalarVolumeNode.h"
 #include "vtkSlicerMarkupsWidgetRepresentation.h"
 #include "vtkOpenGLBezierResectionPolyDataMapper.h"
@@ -89,9 +90,35 @@
 #include "vtkRendererCollection.h"
 #include <vtkNamedColors.h>
 #include <vtkTypeFloat32Array.h>
+#include <vtkVariant.h>
 #include <vtkImageCast.h>
 #include <vtkRenderWindowInteractor.h>
 
+namespace
+{
+//------------------------------------------------------------------------------
+/// RAS to texture coordinates of a volume: texture coordinates span the
+/// extent of the image data, which may not start at zero
+bool GetRASToTextureMatrix(vtkMRMLScalarVolumeNode* node, vtkMatrix4x4* rasToTexture)
+{
+  vtkImageData* imageData = node ? node->GetImageData() : nullptr;
+  if (!imageData)
+    {
+    return false;
+    }
+  const int* extent = imageData->GetExtent();
+  const int* dimensions = imageData->GetDimensions();
+
+  vtkNew<vtkMatrix4x4> rasToIjk;
+  node->GetRASToIJKMatrix(rasToIjk);
+  vtkNew<vtkTransform> ijkToTexture;
+  ijkToTexture->Scale(1.0 / dimensions[0], 1.0 / dimensions[1], 1.0 / dimensions[2]);
+  ijkToTexture->Translate(-extent[0], -extent[2], -extent[4]);
+  vtkMatrix4x4::Multiply4x4(ijkToTexture->GetMatrix(), rasToIjk, rasToTexture);
+  return true;
+}
+}
+
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerBezierSurfaceRepresentation3D);
 static const int RENDERER_LAYER = 1;
@@ -170,6 +197,7 @@ vtkSlicerBezierSurfaceRepresentation3D::vtkSlicerBezierSurfaceRepresentation3D()
   this->ControlPolygonActor->SetMapper(this->ControlPolygonMapper);
 
   this->DistanceMapVolumeNode = nullptr;
+  this->TexturesRevision = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -206,19 +234,24 @@ void vtkSlicerBezierSurfaceRepresentation3D::UpdateFromMRML(vtkMRMLNode* caller,
 
   this->ControlPolygonActor->SetProperty(this->GetControlPointsPipeline(controlPointType)->Property);
 
+  // The volumes are transferred again when their content changed
+  bool texturesModified = this->TexturesRevision != liverMarkupsBezierSurfaceNode->GetTexturesRevision();
+  this->TexturesRevision = liverMarkupsBezierSurfaceNode->GetTexturesRevision();
+
   // Update the Vascular Segments as 3D texture (if changed)
   auto VascularSegments = liverMarkupsBezierSurfaceNode->GetVascularSegmentsVolumeNode();
-  if (this->VascularSegmentsVolumeNode != VascularSegments)
+  if (this->VascularSegmentsVolumeNode != VascularSegments || (texturesModified && VascularSegments))
     {
     this->CreateAndTransferVascularSegmentsTexture(VascularSegments);
     this->VascularSegmentsVolumeNode = VascularSegments;
+    this->UpdateVascularSegmentsTextureMatrix();
     }
 
   // Update the distance map as 3D texture (if changed)
   auto distanceMap = liverMarkupsBezierSurfaceNode->GetDistanceMapVolumeNode();
   auto BezierSurfaceDisplayNode = vtkMRMLMarkupsBezierSurfaceDisplayNode::SafeDownCast(liverMarkupsBezierSurfaceNode->GetDisplayNode());
 
-  if (this->DistanceMapVolumeNode != distanceMap)
+  if (this->DistanceMapVolumeNode != distanceMap || (texturesModified && distanceMap))
     {
     this->CreateAndTransferDistanceMapTexture(distanceMap, BezierSurfaceDisplayNode->GetTextureNumComps());
 
@@ -230,12 +263,15 @@ void vtkSlicerBezierSurfaceRepresentation3D::UpdateFromMRML(vtkMRMLNode* caller,
       auto ijkToTextureT = vtkSmartPointer<vtkMatrix4x4>::New();
 
       auto dimensions = imageData->GetDimensions();
+      auto extent = imageData->GetExtent();
 
       distanceMap->GetRASToIJKMatrix(rasToIjkT);
       rasToIjkT->Transpose();
 
+      // The texture spans the extent of the image data
       auto scaling = vtkSmartPointer<vtkTransform>::New();
       scaling->Scale(1.0 / dimensions[0], 1.0 / dimensions[1], 1.0 / dimensions[2]);
+      scaling->Translate(-extent[0], -extent[2], -extent[4]);
       scaling->GetTranspose(ijkToTextureT);
 
       this->BezierSurfaceResectionMapper->SetRasToIjkMatrixT(rasToIjkT);
@@ -245,6 +281,7 @@ void vtkSlicerBezierSurfaceRepresentation3D::UpdateFromMRML(vtkMRMLNode* caller,
       }
 
     this->DistanceMapVolumeNode = distanceMap;
+    this->UpdateVascularSegmentsTextureMatrix();
     }
 
   //------------------- add new renderer here ----------------------//
@@ -539,17 +576,101 @@ void vtkSlicerBezierSurfaceRepresentation3D::CreateAndTransferDistanceMapTexture
     return;
     }
 
+  // Quantized distance maps (16-bit fixed point) are uploaded as signed
+  // normalized textures: the shaders read value / VTK_SHORT_MAX and map it
+  // back to mm with the scale and offset of the volume
+  const bool quantized = imageData->GetScalarType() == VTK_SHORT;
+  const char* scaleAttribute = node->GetAttribute("DistanceMap.Scale");
+  const char* offsetAttribute = node->GetAttribute("DistanceMap.Offset");
+  const double valueScale = scaleAttribute ? vtkVariant(scaleAttribute).ToDouble() : 1.0;
+  const double offset = offsetAttribute ? vtkVariant(offsetAttribute).ToDouble() : 0.0;
+  const double scale = quantized ? valueScale * VTK_SHORT_MAX : valueScale;
+  this->BezierSurfaceResectionMapper->SetDistanceScale(static_cast<float>(scale));
+  this->BezierSurfaceResectionMapper->SetDistanceOffset(static_cast<float>(offset));
+  this->BezierSurfaceResectionMapper2D->SetDistanceScale(static_cast<float>(scale));
+  this->BezierSurfaceResectionMapper2D->SetDistanceOffset(static_cast<float>(offset));
+
+  // Distance maps with large uniform (e.g. saturated) regions are uploaded
+  // as bricks, without the uniform ones, if that at least halves the memory
+  // of the texture
+  const float border = quantized ? 1.0f : 1000.0f;
+  auto bricks = vtkSmartPointer<vtkBrickedDistanceMap>::New();
+  if ((quantized || imageData->GetScalarType() == VTK_FLOAT) && bricks->Build(imageData, valueScale, offset)
+      && 2 * bricks->GetMemorySize() <= bricks->GetDenseMemorySize())
+    {
+    this->CreateAndTransferDistanceMapBricks(bricks);
+    this->BezierSurfaceResectionMapper->SetDistanceMapBricks(bricks, border);
+    this->BezierSurfaceResectionMapper2D->SetDistanceMapBricks(bricks, border);
+    return;
+    }
+  this->BrickTableTexture = nullptr;
+  this->BrickConstantsTexture = nullptr;
+  this->BezierSurfaceResectionMapper->SetDistanceMapBricks(nullptr);
+  this->BezierSurfaceResectionMapper2D->SetDistanceMapBricks(nullptr);
+
   auto dimensions = imageData->GetDimensions();
   this->DistanceMapTexture->SetWrapS(vtkTextureObject::ClampToBorder);
   this->DistanceMapTexture->SetWrapT(vtkTextureObject::ClampToBorder);
   this->DistanceMapTexture->SetWrapR(vtkTextureObject::ClampToBorder);
   this->DistanceMapTexture->SetMinificationFilter(vtkTextureObject::Linear);
   this->DistanceMapTexture->SetMagnificationFilter(vtkTextureObject::Linear);
-  this->DistanceMapTexture->SetBorderColor(1000.0f, 1000.0f, 0.0f, 0.0f);
-  this->DistanceMapTexture->CreateSeq3DFromRaw(dimensions[0], dimensions[1], dimensions[2], numComps, VTK_FLOAT, imageData->GetScalarPointer(), 0);
+  if (quantized)
+    {
+    // Normalized border values are clamped: out of the volume is as far as
+    // the quantization range
+    this->DistanceMapTexture->SetBorderColor(1.0f, 1.0f, 0.0f, 0.0f);
+    this->DistanceMapTexture->NormalizedIntegersOn();
+    }
+  else
+    {
+    this->DistanceMapTexture->SetBorderColor(1000.0f, 1000.0f, 0.0f, 0.0f);
+    }
+  this->DistanceMapTexture->CreateSeq3DFromRaw(dimensions[0], dimensions[1], dimensions[2], numComps,
+                                               quantized ? VTK_SHORT : VTK_FLOAT, imageData->GetScalarPointer(), 0);
 }
 
 
+//----------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::CreateAndTransferDistanceMapBricks(vtkBrickedDistanceMap* bricks)
+{
+  auto renderWindow = vtkOpenGLRenderWindow::SafeDownCast(this->GetRenderer()->GetRenderWindow());
+  const bool quantized = bricks->GetScalarType() == VTK_SHORT;
+  const int numComps = bricks->GetNumberOfComponents();
+
+  // Atlas of the stored bricks, interpolated within the bricks (their apron
+  // keeps the interpolation off the neighbor slots)
+  vtkImageData* atlas = bricks->GetAtlas();
+  auto atlasDimensions = atlas->GetDimensions();
+  this->DistanceMapTexture->SetWrapS(vtkTextureObject::ClampToEdge);
+  this->DistanceMapTexture->SetWrapT(vtkTextureObject::ClampToEdge);
+  this->DistanceMapTexture->SetWrapR(vtkTextureObject::ClampToEdge);
+  this->DistanceMapTexture->SetMinificationFilter(vtkTextureObject::Linear);
+  this->DistanceMapTexture->SetMagnificationFilter(vtkTextureObject::Linear);
+  this->DistanceMapTexture->SetNormalizedIntegers(quantized);
+  this->DistanceMapTexture->CreateSeq3DFromRaw(atlasDimensions[0], atlasDimensions[1], atlasDimensions[2], numComps,
+                                               bricks->GetScalarType(), atlas->GetScalarPointer(), 0);
+
+  // Brick table and values of the elided bricks, one texel per brick
+  auto brickDimensions = bricks->GetBrickDimensions();
+  this->BrickTableTexture = vtkSmartPointer<vtkMultiTextureObjectHelper>::New();
+  this->BrickConstantsTexture = vtkSmartPointer<vtkMultiTextureObjectHelper>::New();
+  for (auto texture : {this->BrickTableTexture.GetPointer(), this->BrickConstantsTexture.GetPointer()})
+    {
+    texture->SetContext(renderWindow);
+    texture->SetWrapS(vtkTextureObject::ClampToEdge);
+    texture->SetWrapT(vtkTextureObject::ClampToEdge);
+    texture->SetWrapR(vtkTextureObject::ClampToEdge);
+    texture->SetMinificationFilter(vtkTextureObject::Nearest);
+    texture->SetMagnificationFilter(vtkTextureObject::Nearest);
+    }
+  this->BrickTableTexture->CreateSeq3DFromRaw(brickDimensions[0], brickDimensions[1], brickDimensions[2], 4,
+                                              VTK_FLOAT, bricks->GetBrickTable()->GetScalarPointer(), 2);
+  this->BrickConstantsTexture->SetNormalizedIntegers(quantized);
+  this->BrickConstantsTexture->CreateSeq3DFromRaw(brickDimensions[0], brickDimensions[1], brickDimensions[2],
+                                                  numComps, bricks->GetScalarType(),
+                                                  bricks->GetBrickConstants()->GetScalarPointer(), 3);
+}
+
 //----------------------------------------------------------------------
 void vtkSlicerBezierSurfaceRepresentation3D::CreateAndTransferVascularSegmentsTexture(vtkMRMLScalarVolumeNode *node) {
 
@@ -587,6 +708,21 @@ void vtkSlicerBezierSurfaceRepresentation3D::CreateAndTransferVascularSegmentsTe
                                                     cast->GetOutput()->GetScalarPointer(), 1);
 }
 
+//----------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::UpdateVascularSegmentsTextureMatrix()
+{
+  vtkNew<vtkMatrix4x4> distanceToVascularTexture;
+  vtkNew<vtkMatrix4x4> rasToDistanceTexture;
+  vtkNew<vtkMatrix4x4> rasToVascularTexture;
+  if (GetRASToTextureMatrix(this->DistanceMapVolumeNode, rasToDistanceTexture)
+      && GetRASToTextureMatrix(this->VascularSegmentsVolumeNode, rasToVascularTexture))
+    {
+    rasToDistanceTexture->Invert();
+    vtkMatrix4x4::Multiply4x4(rasToVascularTexture, rasToDistanceTexture, distanceToVascularTexture);
+    }
+  this->BezierSurfaceResectionMapper2D->SetDistanceToVascularTextureMatrix(distanceToVascularTexture);
+}
+
 //----------------------------------------------------------------------
 void vtkSlicerBezierSurfaceRepresentation3D::UpdateBezierSurfaceDisplay(vtkMRMLMarkupsBezierSurfaceNode* node)
 {
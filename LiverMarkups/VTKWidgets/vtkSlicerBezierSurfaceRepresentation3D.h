@@ -58,6 +58,7 @@
 
 //------------------------------------------------------------------------------
 class vtkBezierSurfaceSource;
+class vtkBrickedDistanceMap;
 class vtkOpenGLActor;
 class vtkPolyData;
 class vtkPolyDataNormals;
@@ -96,7 +97,12 @@ public:
 protected:
   /// TransferDistanceMap
   void CreateAndTransferDistanceMapTexture(vtkMRMLScalarVolumeNode* node, int numComps);
+  /// Transfer the atlas, brick table and constants of a bricked distance map
+  void CreateAndTransferDistanceMapBricks(vtkBrickedDistanceMap* bricks);
   void CreateAndTransferVascularSegmentsTexture(vtkMRMLScalarVolumeNode *node);
+  /// Map the distance map texture coordinates to the vascular segments ones
+  /// (the volumes may cover different regions, e.g. a cropped distance map)
+  void UpdateVascularSegmentsTextureMatrix();
   void Ratio(bool flexibleBoundery);
   void ResectogramPlaneCenter(bool mirror);
 
@@ -122,6 +128,8 @@ protected:
 
   // Distance mapping related elements
   vtkSmartPointer<vtkMultiTextureObjectHelper> DistanceMapTexture;
+  vtkSmartPointer<vtkMultiTextureObjectHelper> BrickTableTexture;
+  vtkSmartPointer<vtkMultiTextureObjectHelper> BrickConstantsTexture;
   vtkWeakPointer<vtkMRMLScalarVolumeNode> DistanceMapVolumeNode;
   vtkNew<vtkMatrix4x4> VBOShiftScale;
   vtkNew<vtkTransform> VBOInverseTransform;
@@ -132,6 +140,9 @@ protected:
   vtkSmartPointer<vtkMultiTextureObjectHelper> VascularSegmentsTexture;
   vtkWeakPointer<vtkMRMLScalarVolumeNode> VascularSegmentsVolumeNode;
 
+  // Revision of the textures of the bezier surface node last transferred
+  unsigned int TexturesRevision;
+
 
 protected:
   vtkSlicerBezierSurfaceRepresentation3D();
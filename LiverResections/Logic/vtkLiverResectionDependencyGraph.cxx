@@ -0,0 +1,498 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkLiverResectionDependencyGraph.h"
+
+// MRML includes
+#include <vtkMRMLLiverResectionNode.h>
+#include <vtkMRMLMarkupsBezierSurfaceNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+//------------------------------------------------------------------------------
+/// 64-bit FNV-1a hash accumulated over several values (over 64-bit words for
+/// bulk data)
+class ContentHash
+{
+public:
+  void Add(const void* data, size_t size)
+  {
+    // Bulk data (e.g. voxels) is hashed a 64-bit word at a time
+    auto bytes = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+      {
+      uint64_t word;
+      std::memcpy(&word, bytes + i, sizeof(uint64_t));
+      this->Hash ^= word;
+      this->Hash *= 1099511628211ULL;
+      }
+    for (; i < size; ++i)
+      {
+      this->Hash ^= bytes[i];
+      this->Hash *= 1099511628211ULL;
+      }
+  }
+
+  template <class T>
+  void Add(const T& value)
+  {this->Add(&value, sizeof(T));}
+
+  uint64_t Get() const
+  {return this->Hash;}
+
+private:
+  uint64_t Hash = 14695981039346656037ULL;
+};
+
+//------------------------------------------------------------------------------
+vtkObject* GetInputObject(vtkMRMLLiverResectionNode* resection, int input)
+{
+  switch (input)
+    {
+    case vtkLiverResectionDependencyGraph::BezierSurfaceInput:
+      return resection->GetBezierSurfaceNode();
+    case vtkLiverResectionDependencyGraph::DistanceMapInput:
+      return resection->GetDistanceMapVolumeNode();
+    case vtkLiverResectionDependencyGraph::VascularSegmentsInput:
+      return resection->GetVascularSegmentsVolumeNode();
+    case vtkLiverResectionDependencyGraph::TargetOrganInput:
+      return resection->GetTargetOrganModelNode();
+    default:
+      return resection;
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkMTimeType GetInputMTime(vtkObject* object)
+{
+  vtkMTimeType mtime = object->GetMTime();
+  if (auto volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(object))
+    {
+    if (volumeNode->GetImageData())
+      {
+      mtime = std::max(mtime, volumeNode->GetImageData()->GetMTime());
+      }
+    }
+  else if (auto modelNode = vtkMRMLModelNode::SafeDownCast(object))
+    {
+    if (modelNode->GetPolyData())
+      {
+      mtime = std::max(mtime, modelNode->GetPolyData()->GetMTime());
+      }
+    }
+  return mtime;
+}
+
+//------------------------------------------------------------------------------
+void HashDataArray(ContentHash& hash, vtkDataArray* array)
+{
+  if (!array)
+    {
+    hash.Add(vtkIdType(-1));
+    return;
+    }
+  hash.Add(array->GetDataType());
+  hash.Add(array->GetNumberOfComponents());
+  hash.Add(array->GetNumberOfTuples());
+  hash.Add(array->GetVoidPointer(0),
+           static_cast<size_t>(array->GetNumberOfValues() * array->GetDataTypeSize()));
+}
+
+//------------------------------------------------------------------------------
+void HashVolume(ContentHash& hash, vtkMRMLScalarVolumeNode* volumeNode)
+{
+  vtkImageData* imageData = volumeNode->GetImageData();
+  if (!imageData)
+    {
+    return;
+    }
+
+  int extent[6];
+  double directions[3][3];
+  imageData->GetExtent(extent);
+  volumeNode->GetIJKToRASDirections(directions);
+  hash.Add(extent);
+  hash.Add(directions);
+  hash.Add(volumeNode->GetSpacing(), 3 * sizeof(double));
+  hash.Add(volumeNode->GetOrigin(), 3 * sizeof(double));
+  HashDataArray(hash, imageData->GetPointData()->GetScalars());
+}
+
+//------------------------------------------------------------------------------
+void HashModel(ContentHash& hash, vtkMRMLModelNode* modelNode)
+{
+  vtkPolyData* polyData = modelNode->GetPolyData();
+  if (!polyData || !polyData->GetPoints())
+    {
+    return;
+    }
+
+  HashDataArray(hash, polyData->GetPoints()->GetData());
+  HashDataArray(hash, polyData->GetPolys()->GetOffsetsArray());
+  HashDataArray(hash, polyData->GetPolys()->GetConnectivityArray());
+}
+
+//------------------------------------------------------------------------------
+void HashBezierSurface(ContentHash& hash, vtkMRMLMarkupsBezierSurfaceNode* bezierSurfaceNode)
+{
+  const int numberOfControlPoints = bezierSurfaceNode->GetNumberOfControlPoints();
+  hash.Add(numberOfControlPoints);
+  for (int i = 0; i < numberOfControlPoints; ++i)
+    {
+    double position[3];
+    bezierSurfaceNode->GetNthControlPointPosition(i, position);
+    hash.Add(position);
+    }
+}
+
+//------------------------------------------------------------------------------
+void HashMargins(ContentHash& hash, vtkMRMLLiverResectionNode* resection)
+{
+  hash.Add(resection->GetResectionMargin());
+  hash.Add(resection->GetUncertaintyMargin());
+  hash.Add(resection->GetInterpolatedMargins());
+  hash.Add(resection->GetTextureNumComps());
+}
+
+//------------------------------------------------------------------------------
+void HashDisplay(ContentHash& hash, vtkMRMLLiverResectionNode* resection)
+{
+  hash.Add(resection->GetResectionColor(), 3 * sizeof(float));
+  hash.Add(resection->GetResectionGridColor(), 3 * sizeof(float));
+  hash.Add(resection->GetResectionMarginColor(), 3 * sizeof(float));
+  hash.Add(resection->GetUncertaintyMarginColor(), 3 * sizeof(float));
+  hash.Add(resection->GetHepaticContourColor(), 3 * sizeof(float));
+  hash.Add(resection->GetPortalContourColor(), 3 * sizeof(float));
+  hash.Add(resection->GetHepaticContourThickness());
+  hash.Add(resection->GetPortalContourThickness());
+  hash.Add(resection->GetResectionOpacity());
+  hash.Add(resection->GetGridDivisions());
+  hash.Add(resection->GetGridThickness());
+  hash.Add(resection->GetGridVisibility());
+  hash.Add(resection->GetGrid3DVisibility());
+  hash.Add(resection->GetGrid2DVisibility());
+  hash.Add(resection->GetShowResection2D());
+  hash.Add(resection->GetMirrorDisplay());
+  hash.Add(resection->GetClipOut());
+  hash.Add(resection->GetWidgetVisibility());
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLiverResectionDependencyGraph);
+
+//----------------------------------------------------------------------------
+vtkLiverResectionDependencyGraph::vtkLiverResectionDependencyGraph()
+{
+  this->ProductDependencies[TessellationProduct] = 1u << BezierSurfaceInput;
+  this->ProductDependencies[TextureProduct] = (1u << DistanceMapInput) | (1u << VascularSegmentsInput);
+  std::fill(this->NumberOfRecomputations, this->NumberOfRecomputations + NumberOfProducts, 0);
+}
+
+//----------------------------------------------------------------------------
+vtkLiverResectionDependencyGraph::~vtkLiverResectionDependencyGraph() = default;
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfResections: " << this->Stamps.size() << "\n";
+  for (int product = 0; product < NumberOfProducts; ++product)
+    {
+    os << indent << "Product " << product << ": dependencies " << this->ProductDependencies[product]
+       << ", recomputations " << this->NumberOfRecomputations[product] << "\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::SetProductDependencies(int product, unsigned int inputMask)
+{
+  if (product < 0 || product >= NumberOfProducts)
+    {
+    vtkErrorMacro("SetProductDependencies: invalid product " << product);
+    return;
+    }
+
+  this->ProductDependencies[product] = inputMask & ((1u << NumberOfInputs) - 1);
+  for (auto& stamps : this->Stamps)
+    {
+    stamps.second.Products[product].Computed = false;
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkLiverResectionDependencyGraph::GetProductDependencies(int product) const
+{
+  if (product < 0 || product >= NumberOfProducts)
+    {
+    return 0;
+    }
+  return this->ProductDependencies[product];
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::SetProductUpdateFunction(int product, UpdateFunction function)
+{
+  if (product < 0 || product >= NumberOfProducts)
+    {
+    vtkErrorMacro("SetProductUpdateFunction: invalid product " << product);
+    return;
+    }
+  this->ProductUpdateFunctions[product] = function;
+}
+
+//----------------------------------------------------------------------------
+uint64_t vtkLiverResectionDependencyGraph::GetInputHash(vtkMRMLLiverResectionNode* resection,
+                                                        ResectionStamps& stamps,
+                                                        int input) const
+{
+  InputStamp& stamp = stamps.Inputs[input];
+  vtkObject* object = GetInputObject(resection, input);
+  if (!object)
+    {
+    stamp = InputStamp();
+    return 0;
+    }
+
+  // Control points are few and moving them does not always modify the
+  // markups node, so the bezier surface is hashed on every query
+  vtkMTimeType mtime = GetInputMTime(object);
+  if (input != BezierSurfaceInput && stamp.Object == object && stamp.MTime == mtime)
+    {
+    return stamp.Hash;
+    }
+
+  ContentHash hash;
+  hash.Add(object);
+  switch (input)
+    {
+    case BezierSurfaceInput:
+      HashBezierSurface(hash, resection->GetBezierSurfaceNode());
+      break;
+    case DistanceMapInput:
+    case VascularSegmentsInput:
+      HashVolume(hash, vtkMRMLScalarVolumeNode::SafeDownCast(object));
+      break;
+    case TargetOrganInput:
+      HashModel(hash, vtkMRMLModelNode::SafeDownCast(object));
+      break;
+    case MarginsInput:
+      HashMargins(hash, resection);
+      break;
+    case DisplayInput:
+      HashDisplay(hash, resection);
+      break;
+    }
+
+  stamp.Object = object;
+  stamp.MTime = mtime;
+  stamp.Hash = hash.Get();
+  return stamp.Hash;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionDependencyGraph::IsProductStale(vtkMRMLLiverResectionNode* resection,
+                                                      ResectionStamps& stamps,
+                                                      int product) const
+{
+  const ProductStamp& productStamp = stamps.Products[product];
+  if (!productStamp.Computed)
+    {
+    return true;
+    }
+
+  for (int input = 0; input < NumberOfInputs; ++input)
+    {
+    if ((this->ProductDependencies[product] & (1u << input)) &&
+        this->GetInputHash(resection, stamps, input) != productStamp.InputHashes[input])
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+vtkLiverResectionDependencyGraph::ProductStamp
+vtkLiverResectionDependencyGraph::StampProduct(vtkMRMLLiverResectionNode* resection,
+                                               ResectionStamps& stamps,
+                                               int product) const
+{
+  ProductStamp productStamp;
+  productStamp.Computed = true;
+  for (int input = 0; input < NumberOfInputs; ++input)
+    {
+    if (this->ProductDependencies[product] & (1u << input))
+      {
+      productStamp.InputHashes[input] = this->GetInputHash(resection, stamps, input);
+      }
+    }
+  return productStamp;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionDependencyGraph::IsProductStale(vtkMRMLLiverResectionNode* resection, int product)
+{
+  if (!resection || product < 0 || product >= NumberOfProducts)
+    {
+    vtkErrorMacro("IsProductStale: invalid resection or product.");
+    return false;
+    }
+  return this->IsProductStale(resection, this->Stamps[resection], product);
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionDependencyGraph::UpdateProduct(vtkMRMLLiverResectionNode* resection, int product)
+{
+  if (!resection || product < 0 || product >= NumberOfProducts)
+    {
+    vtkErrorMacro("UpdateProduct: invalid resection or product.");
+    return false;
+    }
+
+  if (!this->IsProductStale(resection, this->Stamps[resection], product))
+    {
+    return false;
+    }
+
+  // The product is stamped with the inputs it is computed from
+  ProductStamp productStamp = this->StampProduct(resection, this->Stamps[resection], product);
+
+  if (this->ProductUpdateFunctions[product])
+    {
+    this->ProductUpdateFunctions[product](resection);
+    }
+  ++this->NumberOfRecomputations[product];
+
+  // The update function may have removed the resection
+  auto it = this->Stamps.find(resection);
+  if (it != this->Stamps.end())
+    {
+    it->second.Products[product] = productStamp;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverResectionDependencyGraph::UpdateProducts(vtkMRMLLiverResectionNode* resection)
+{
+  int numberOfUpdatedProducts = 0;
+  for (int product = 0; product < NumberOfProducts; ++product)
+    {
+    if (this->UpdateProduct(resection, product))
+      {
+      ++numberOfUpdatedProducts;
+      }
+    }
+  return numberOfUpdatedProducts;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::InvalidateProduct(vtkMRMLLiverResectionNode* resection, int product)
+{
+  if (product < 0 || product >= NumberOfProducts)
+    {
+    vtkErrorMacro("InvalidateProduct: invalid product " << product);
+    return;
+    }
+
+  auto it = this->Stamps.find(resection);
+  if (it != this->Stamps.end())
+    {
+    it->second.Products[product].Computed = false;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::SetProductUpToDate(vtkMRMLLiverResectionNode* resection, int product)
+{
+  if (!resection || product < 0 || product >= NumberOfProducts)
+    {
+    vtkErrorMacro("SetProductUpToDate: invalid resection or product.");
+    return;
+    }
+
+  ResectionStamps& stamps = this->Stamps[resection];
+  stamps.Products[product] = this->StampProduct(resection, stamps, product);
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::RemoveResection(vtkMRMLLiverResectionNode* resection)
+{
+  this->Stamps.erase(resection);
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::RemoveAllResections()
+{
+  this->Stamps.clear();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkLiverResectionDependencyGraph::GetNumberOfRecomputations(int product) const
+{
+  if (product < 0 || product >= NumberOfProducts)
+    {
+    return 0;
+    }
+  return this->NumberOfRecomputations[product];
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionDependencyGraph::ResetNumberOfRecomputations()
+{
+  std::fill(this->NumberOfRecomputations, this->NumberOfRecomputations + NumberOfProducts, 0);
+}
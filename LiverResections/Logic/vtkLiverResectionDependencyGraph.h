@@ -0,0 +1,178 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverResectionDependencyGraph_h
+#define __vtkLiverResectionDependencyGraph_h
+
+#include "vtkSlicerLiverResectionsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+//------------------------------------------------------------------------------
+class vtkMRMLLiverResectionNode;
+
+//------------------------------------------------------------------------------
+/// \brief Tracks which data derived from a resection is out of date.
+///
+/// A resection gathers several inputs (bezier surface, distance map, vascular
+/// segments, target organ, margins and display properties), and derived
+/// products (tessellation, textures) depend on a subset of them. For every
+/// resection the graph stamps each input with its modification time and a
+/// hash of its content. The hash is only recomputed when the modification
+/// time changes, and a product is stale when the hash of one of its inputs
+/// differs from the one it was computed with. A Modified() that does not
+/// change the content therefore does not invalidate anything.
+///
+/// Volumes are hashed by their geometry and voxels, and models by their
+/// points and polygons, once per modification.
+///
+/// Products are recomputed on demand by UpdateProduct(), which calls the
+/// update function of the product only if it is stale.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkLiverResectionDependencyGraph
+  : public vtkObject
+{
+public:
+  static vtkLiverResectionDependencyGraph* New();
+  vtkTypeMacro(vtkLiverResectionDependencyGraph, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum Input
+  {
+    BezierSurfaceInput = 0,
+    DistanceMapInput,
+    VascularSegmentsInput,
+    TargetOrganInput,
+    MarginsInput,
+    DisplayInput,
+    NumberOfInputs
+  };
+
+  enum Product
+  {
+    TessellationProduct = 0,
+    TextureProduct,
+    NumberOfProducts
+  };
+
+  using UpdateFunction = std::function<void(vtkMRMLLiverResectionNode*)>;
+
+  /// Inputs a product depends on, as a mask of (1 << input) bits
+  void SetProductDependencies(int product, unsigned int inputMask);
+  unsigned int GetProductDependencies(int product) const;
+
+  /// Function recomputing a product of a resection
+  void SetProductUpdateFunction(int product, UpdateFunction function);
+
+  /// Whether the product of the resection has never been computed or one of
+  /// its inputs changed since
+  bool IsProductStale(vtkMRMLLiverResectionNode* resection, int product);
+
+  /// Recomputes the product of the resection if stale. Returns true if it was
+  /// recomputed.
+  bool UpdateProduct(vtkMRMLLiverResectionNode* resection, int product);
+
+  /// Recomputes all the stale products of the resection. Returns the number
+  /// of recomputed products.
+  int UpdateProducts(vtkMRMLLiverResectionNode* resection);
+
+  /// Forces the recomputation of a product on the next update
+  void InvalidateProduct(vtkMRMLLiverResectionNode* resection, int product);
+
+  /// Stamps the product as computed from the current inputs without calling
+  /// its update function (e.g. when it was loaded along with them)
+  void SetProductUpToDate(vtkMRMLLiverResectionNode* resection, int product);
+
+  /// Forgets the stamps of a resection (to be called on node removal)
+  void RemoveResection(vtkMRMLLiverResectionNode* resection);
+  void RemoveAllResections();
+
+  /// Number of recomputations of a product since the last reset
+  vtkIdType GetNumberOfRecomputations(int product) const;
+  void ResetNumberOfRecomputations();
+
+protected:
+  vtkLiverResectionDependencyGraph();
+  ~vtkLiverResectionDependencyGraph() override;
+
+  struct InputStamp
+  {
+    const void* Object = nullptr;
+    vtkMTimeType MTime = 0;
+    uint64_t Hash = 0;
+  };
+
+  struct ProductStamp
+  {
+    bool Computed = false;
+    uint64_t InputHashes[NumberOfInputs] = {};
+  };
+
+  struct ResectionStamps
+  {
+    InputStamp Inputs[NumberOfInputs];
+    ProductStamp Products[NumberOfProducts];
+  };
+
+  /// Hash of the current content of an input, recomputed only if the input
+  /// object or its modification time changed
+  uint64_t GetInputHash(vtkMRMLLiverResectionNode* resection, ResectionStamps& stamps, int input) const;
+
+  bool IsProductStale(vtkMRMLLiverResectionNode* resection, ResectionStamps& stamps, int product) const;
+
+  /// Stamp of a product computed from the current inputs
+  ProductStamp StampProduct(vtkMRMLLiverResectionNode* resection, ResectionStamps& stamps, int product) const;
+
+protected:
+  unsigned int ProductDependencies[NumberOfProducts];
+  UpdateFunction ProductUpdateFunctions[NumberOfProducts];
+  vtkIdType NumberOfRecomputations[NumberOfProducts];
+  std::unordered_map<vtkMRMLLiverResectionNode*, ResectionStamps> Stamps;
+
+private:
+  vtkLiverResectionDependencyGraph(const vtkLiverResectionDependencyGraph&) = delete;
+  void operator=(const vtkLiverResectionDependencyGraph&) = delete;
+};
+
+#endif // __vtkLiverResectionDependencyGraph_h
@@ -0,0 +1,344 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkLiverResectionEditHistory.h"
+
+// LiverMarkups includes
+#include <vtkMRMLMarkupsBezierSurfaceNode.h>
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <cstring>
+#include <utility>
+
+namespace
+{
+//------------------------------------------------------------------------------
+uint64_t GetBits(double value)
+{
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+//------------------------------------------------------------------------------
+double GetDouble(uint64_t bits)
+{
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+//------------------------------------------------------------------------------
+// 64-bit FNV-1a step over the bit pattern of a coordinate
+const uint64_t InitialHash = 14695981039346656037ULL;
+uint64_t HashCoordinate(uint64_t hash, double value)
+{
+  return (hash ^ GetBits(value)) * 1099511628211ULL;
+}
+
+//------------------------------------------------------------------------------
+const int MaximumNumberOfTrackedPoints = 64;
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLiverResectionEditHistory);
+
+//----------------------------------------------------------------------------
+vtkLiverResectionEditHistory::vtkLiverResectionEditHistory()
+  : Capacity(1024)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkLiverResectionEditHistory::~vtkLiverResectionEditHistory() = default;
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionEditHistory::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Capacity: " << this->Capacity << "\n";
+  os << indent << "NumberOfNodes: " << this->Histories.size() << "\n";
+  os << indent << "MemorySize: " << this->GetMemorySize() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionEditHistory::SetCapacity(int capacity)
+{
+  capacity = capacity < 1 ? 1 : capacity;
+  if (this->Capacity == capacity)
+    {
+    return;
+    }
+  this->Capacity = capacity;
+  this->Histories.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionEditHistory::BeginEdit(vtkMRMLMarkupsBezierSurfaceNode* node)
+{
+  if (!node)
+    {
+    return;
+    }
+
+  NodeHistory& history = this->Histories[node];
+  const int numberOfControlPoints = node->GetNumberOfControlPoints();
+  history.Snapshot.resize(3 * numberOfControlPoints);
+  for (int i = 0; i < numberOfControlPoints; ++i)
+    {
+    node->GetNthControlPointPosition(i, &history.Snapshot[3 * i]);
+    }
+  history.Editing = true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionEditHistory::EndEdit(vtkMRMLMarkupsBezierSurfaceNode* node)
+{
+  auto it = this->Histories.find(node);
+  if (it == this->Histories.end() || !it->second.Editing)
+    {
+    return false;
+    }
+
+  NodeHistory& history = it->second;
+  history.Editing = false;
+
+  // Adding or removing control points cannot be expressed as an edit, and
+  // invalidates the previous edits
+  const int numberOfControlPoints = node->GetNumberOfControlPoints();
+  if (3 * numberOfControlPoints != static_cast<int>(history.Snapshot.size()) ||
+      numberOfControlPoints > MaximumNumberOfTrackedPoints)
+    {
+    this->Histories.erase(it);
+    return false;
+    }
+
+  Edit edit;
+  uint64_t beforeHash = InitialHash;
+  for (int i = 0; i < numberOfControlPoints; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      beforeHash = HashCoordinate(beforeHash, history.Snapshot[3 * i + j]);
+      }
+    double position[3];
+    node->GetNthControlPointPosition(i, position);
+    uint64_t delta[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      delta[j] = GetBits(history.Snapshot[3 * i + j]) ^ GetBits(position[j]);
+      }
+    if (delta[0] || delta[1] || delta[2])
+      {
+      edit.ChangedPoints |= uint64_t(1) << i;
+      edit.Deltas.insert(edit.Deltas.end(), delta, delta + 3);
+      }
+    }
+  history.Snapshot.clear();
+  history.Snapshot.shrink_to_fit();
+
+  if (!edit.ChangedPoints)
+    {
+    return false;
+    }
+  edit.BeforeHash = beforeHash;
+  edit.AfterHash = HashControlPoints(node);
+
+  // The new edit replaces the redo edits, and the oldest edit when full
+  int index;
+  history.NumberOfRedoEdits = 0;
+  if (history.NumberOfUndoEdits < this->Capacity)
+    {
+    index = (history.First + history.NumberOfUndoEdits) % this->Capacity;
+    ++history.NumberOfUndoEdits;
+    }
+  else
+    {
+    index = history.First;
+    history.First = (history.First + 1) % this->Capacity;
+    }
+  if (index >= static_cast<int>(history.Edits.size()))
+    {
+    history.Edits.resize(index + 1);
+    }
+  edit.Deltas.shrink_to_fit();
+  history.Edits[index] = std::move(edit);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+uint64_t vtkLiverResectionEditHistory::HashControlPoints(vtkMRMLMarkupsBezierSurfaceNode* node)
+{
+  uint64_t hash = InitialHash;
+  const int numberOfControlPoints = node->GetNumberOfControlPoints();
+  for (int i = 0; i < numberOfControlPoints; ++i)
+    {
+    double position[3];
+    node->GetNthControlPointPosition(i, position);
+    for (int j = 0; j < 3; ++j)
+      {
+      hash = HashCoordinate(hash, position[j]);
+      }
+    }
+  return hash;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionEditHistory::ApplyEdit(vtkMRMLMarkupsBezierSurfaceNode* node,
+                                             const Edit& edit,
+                                             uint64_t expectedHash)
+{
+  const int numberOfControlPoints = node->GetNumberOfControlPoints();
+  if (numberOfControlPoints > MaximumNumberOfTrackedPoints ||
+      (numberOfControlPoints < MaximumNumberOfTrackedPoints &&
+       (edit.ChangedPoints >> numberOfControlPoints) != 0) ||
+      HashControlPoints(node) != expectedHash)
+    {
+    return false;
+    }
+
+  MRMLNodeModifyBlocker blocker(node);
+  const uint64_t* delta = edit.Deltas.data();
+  for (int i = 0; i < numberOfControlPoints && i < MaximumNumberOfTrackedPoints; ++i)
+    {
+    if (!(edit.ChangedPoints & (uint64_t(1) << i)))
+      {
+      continue;
+      }
+    double position[3];
+    node->GetNthControlPointPosition(i, position);
+    node->SetNthControlPointPosition(i,
+                                     GetDouble(GetBits(position[0]) ^ delta[0]),
+                                     GetDouble(GetBits(position[1]) ^ delta[1]),
+                                     GetDouble(GetBits(position[2]) ^ delta[2]));
+    delta += 3;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionEditHistory::Undo(vtkMRMLMarkupsBezierSurfaceNode* node)
+{
+  auto it = this->Histories.find(node);
+  if (it == this->Histories.end() || it->second.NumberOfUndoEdits == 0)
+    {
+    return false;
+    }
+
+  NodeHistory& history = it->second;
+  int index = (history.First + history.NumberOfUndoEdits - 1) % this->Capacity;
+  if (!ApplyEdit(node, history.Edits[index], history.Edits[index].AfterHash))
+    {
+    vtkErrorMacro("Undo: the control points do not match the edit history.");
+    this->Histories.erase(it);
+    return false;
+    }
+  --history.NumberOfUndoEdits;
+  ++history.NumberOfRedoEdits;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionEditHistory::Redo(vtkMRMLMarkupsBezierSurfaceNode* node)
+{
+  auto it = this->Histories.find(node);
+  if (it == this->Histories.end() || it->second.NumberOfRedoEdits == 0)
+    {
+    return false;
+    }
+
+  NodeHistory& history = it->second;
+  int index = (history.First + history.NumberOfUndoEdits) % this->Capacity;
+  if (!ApplyEdit(node, history.Edits[index], history.Edits[index].BeforeHash))
+    {
+    vtkErrorMacro("Redo: the control points do not match the edit history.");
+    this->Histories.erase(it);
+    return false;
+    }
+  ++history.NumberOfUndoEdits;
+  --history.NumberOfRedoEdits;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverResectionEditHistory::GetNumberOfUndoEdits(vtkMRMLMarkupsBezierSurfaceNode* node) const
+{
+  auto it = this->Histories.find(node);
+  return it == this->Histories.end() ? 0 : it->second.NumberOfUndoEdits;
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverResectionEditHistory::GetNumberOfRedoEdits(vtkMRMLMarkupsBezierSurfaceNode* node) const
+{
+  auto it = this->Histories.find(node);
+  return it == this->Histories.end() ? 0 : it->second.NumberOfRedoEdits;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionEditHistory::RemoveNode(vtkMRMLMarkupsBezierSurfaceNode* node)
+{
+  this->Histories.erase(node);
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionEditHistory::RemoveAllNodes()
+{
+  this->Histories.clear();
+}
+
+//----------------------------------------------------------------------------
+size_t vtkLiverResectionEditHistory::GetMemorySize() const
+{
+  size_t memorySize = 0;
+  for (const auto& history : this->Histories)
+    {
+    memorySize += sizeof(NodeHistory) + history.second.Snapshot.capacity() * sizeof(double)
+      + history.second.Edits.capacity() * sizeof(Edit);
+    for (const Edit& edit : history.second.Edits)
+      {
+      memorySize += edit.Deltas.capacity() * sizeof(uint64_t);
+      }
+    }
+  return memorySize;
+}
@@ -0,0 +1,145 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverResectionEditHistory_h
+#define __vtkLiverResectionEditHistory_h
+
+#include "vtkSlicerLiverResectionsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkMRMLMarkupsBezierSurfaceNode;
+
+//------------------------------------------------------------------------------
+/// \brief Undo/redo history of the control points of bezier surfaces.
+///
+/// Each bezier surface has a ring buffer of edits, one per interaction. An
+/// edit stores a mask of the control points that changed and, for each of
+/// them, the XOR of the bit patterns of the coordinates before and after the
+/// edit. Applying the same XOR undoes or redoes the edit exactly, touching
+/// only the changed control points. The ring buffer keeps the last Capacity
+/// edits; older edits are dropped.
+///
+/// An edit also stores a hash of all the control points before and after it.
+/// An edit is only undone (redone) if the control points match the state
+/// after (before) it, so that control points changed outside the recorded
+/// interactions are never corrupted. The history of the node is then
+/// cleared. Non-interactive changes should call RemoveNode.
+///
+/// Only the first 64 control points are tracked (a bezier surface has 16).
+class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkLiverResectionEditHistory
+  : public vtkObject
+{
+public:
+  static vtkLiverResectionEditHistory* New();
+  vtkTypeMacro(vtkLiverResectionEditHistory, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Maximum number of edits kept for each bezier surface. Changing it
+  /// clears the history.
+  void SetCapacity(int capacity);
+  vtkGetMacro(Capacity, int);
+
+  /// Snapshot of the control points at the start of an interaction
+  void BeginEdit(vtkMRMLMarkupsBezierSurfaceNode* node);
+
+  /// Records the changes since BeginEdit as a new edit (discarding the edits
+  /// that could be redone). Returns false if nothing changed.
+  bool EndEdit(vtkMRMLMarkupsBezierSurfaceNode* node);
+
+  /// Undo/redo the last edit of the node. Return false if there is none.
+  bool Undo(vtkMRMLMarkupsBezierSurfaceNode* node);
+  bool Redo(vtkMRMLMarkupsBezierSurfaceNode* node);
+
+  int GetNumberOfUndoEdits(vtkMRMLMarkupsBezierSurfaceNode* node) const;
+  int GetNumberOfRedoEdits(vtkMRMLMarkupsBezierSurfaceNode* node) const;
+
+  /// Forgets the history of a node (to be called on node removal)
+  void RemoveNode(vtkMRMLMarkupsBezierSurfaceNode* node);
+  void RemoveAllNodes();
+
+  /// Memory used by the edits of all the nodes, in bytes
+  size_t GetMemorySize() const;
+
+protected:
+  vtkLiverResectionEditHistory();
+  ~vtkLiverResectionEditHistory() override;
+
+  struct Edit
+  {
+    uint64_t ChangedPoints = 0;
+    std::vector<uint64_t> Deltas; // 3 per changed control point
+    uint64_t BeforeHash = 0;
+    uint64_t AfterHash = 0;
+  };
+
+  struct NodeHistory
+  {
+    std::vector<double> Snapshot;
+    bool Editing = false;
+    std::vector<Edit> Edits; // ring buffer of up to Capacity edits
+    int First = 0;
+    int NumberOfUndoEdits = 0;
+    int NumberOfRedoEdits = 0;
+  };
+
+  /// Hash of the bit patterns of all the control points of a node
+  static uint64_t HashControlPoints(vtkMRMLMarkupsBezierSurfaceNode* node);
+
+  /// Applies (XOR) an edit to the control points of a node, if they match
+  /// the expected state
+  static bool ApplyEdit(vtkMRMLMarkupsBezierSurfaceNode* node, const Edit& edit, uint64_t expectedHash);
+
+protected:
+  int Capacity;
+  std::unordered_map<vtkMRMLMarkupsBezierSurfaceNode*, NodeHistory> Histories;
+
+private:
+  vtkLiverResectionEditHistory(const vtkLiverResectionEditHistory&) = delete;
+  void operator=(const vtkLiverResectionEditHistory&) = delete;
+};
+
+#endif // __vtkLiverResectionEditHistory_h
@@ -0,0 +1,246 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkLiverResectionRegistry.h"
+
+// MRML includes
+#include <vtkMRMLMarkupsNode.h>
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLiverResectionRegistry);
+
+//----------------------------------------------------------------------------
+vtkLiverResectionRegistry::vtkLiverResectionRegistry() = default;
+
+//----------------------------------------------------------------------------
+vtkLiverResectionRegistry::~vtkLiverResectionRegistry() = default;
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionRegistry::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfResections: " << this->GetNumberOfResections() << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverResectionRegistry::FindRecordIndex(vtkMRMLNode* node) const
+{
+  if (!node)
+    {
+    return -1;
+    }
+  auto it = this->RecordIndex.find(node);
+  return it == this->RecordIndex.end() ? -1 : it->second;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionRegistry::RemoveRecord(int index)
+{
+  Record& record = this->Records[index];
+  this->RecordIndex.erase(record.Resection.GetPointer());
+  if (record.Initialization)
+    {
+    this->RecordIndex.erase(record.Initialization.GetPointer());
+    }
+  if (record.BezierSurface)
+    {
+    this->RecordIndex.erase(record.BezierSurface.GetPointer());
+    }
+  record = Record();
+  this->FreeRecords.push_back(index);
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionRegistry::AddResection(vtkMRMLLiverResectionNode* resection,
+                                             vtkMRMLMarkupsNode* initialization,
+                                             vtkMRMLMarkupsBezierSurfaceNode* bezierSurface)
+{
+  if (!resection)
+    {
+    vtkErrorMacro("AddResection: invalid resection node.");
+    return;
+    }
+
+  {
+  std::lock_guard<std::mutex> lock(this->Mutex);
+
+  // A node belongs to one resection only
+  for (vtkMRMLNode* node : {static_cast<vtkMRMLNode*>(resection),
+                            static_cast<vtkMRMLNode*>(initialization),
+                            static_cast<vtkMRMLNode*>(bezierSurface)})
+    {
+    int index = this->FindRecordIndex(node);
+    if (index >= 0)
+      {
+      this->RemoveRecord(index);
+      }
+    }
+
+  int index;
+  if (this->FreeRecords.empty())
+    {
+    index = static_cast<int>(this->Records.size());
+    this->Records.emplace_back();
+    }
+  else
+    {
+    index = this->FreeRecords.back();
+    this->FreeRecords.pop_back();
+    }
+
+  Record& record = this->Records[index];
+  record.Resection = resection;
+  record.Initialization = initialization;
+  record.BezierSurface = bezierSurface;
+  this->RecordIndex[resection] = index;
+  if (initialization)
+    {
+    this->RecordIndex[initialization] = index;
+    }
+  if (bezierSurface)
+    {
+    this->RecordIndex[bezierSurface] = index;
+    }
+  }
+
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionRegistry::RemoveResection(vtkMRMLNode* node, Record* removed)
+{
+  {
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  int index = this->FindRecordIndex(node);
+  if (index < 0)
+    {
+    return false;
+    }
+  if (removed)
+    {
+    *removed = this->Records[index];
+    }
+  this->RemoveRecord(index);
+  }
+
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionRegistry::FindResection(vtkMRMLNode* node, Record& record) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  int index = this->FindRecordIndex(node);
+  if (index < 0)
+    {
+    return false;
+    }
+  record = this->Records[index];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionRegistry::Contains(vtkMRMLNode* node) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->FindRecordIndex(node) >= 0;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLLiverResectionNode* vtkLiverResectionRegistry::GetResection(vtkMRMLNode* node) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  int index = this->FindRecordIndex(node);
+  return index < 0 ? nullptr : this->Records[index].Resection.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLMarkupsNode* vtkLiverResectionRegistry::GetInitialization(vtkMRMLNode* node) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  int index = this->FindRecordIndex(node);
+  return index < 0 ? nullptr : this->Records[index].Initialization.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLMarkupsBezierSurfaceNode* vtkLiverResectionRegistry::GetBezierSurface(vtkMRMLNode* node) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  int index = this->FindRecordIndex(node);
+  return index < 0 ? nullptr : this->Records[index].BezierSurface.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+std::vector<vtkLiverResectionRegistry::Record> vtkLiverResectionRegistry::GetResections() const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  std::vector<Record> records;
+  records.reserve(this->Records.size() - this->FreeRecords.size());
+  for (const Record& record : this->Records)
+    {
+    if (record.Resection)
+      {
+      records.push_back(record);
+      }
+    }
+  return records;
+}
+
+//----------------------------------------------------------------------------
+std::size_t vtkLiverResectionRegistry::GetNumberOfResections() const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->Records.size() - this->FreeRecords.size();
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionRegistry::RemoveAllResections()
+{
+  {
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Records.clear();
+  this->FreeRecords.clear();
+  this->RecordIndex.clear();
+  }
+  this->Modified();
+}
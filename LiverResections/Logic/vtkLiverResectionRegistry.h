@@ -0,0 +1,141 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverResectionRegistry_h
+#define __vtkLiverResectionRegistry_h
+
+#include "vtkSlicerLiverResectionsModuleLogicExport.h"
+
+// MRML includes
+#include <vtkMRMLLiverResectionNode.h>
+#include <vtkMRMLMarkupsBezierSurfaceNode.h>
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <initializer_list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkMRMLMarkupsNode;
+class vtkMRMLNode;
+
+//------------------------------------------------------------------------------
+/// \brief Registry of the nodes making up each resection.
+///
+/// Every resection is stored as a single record holding the resection node,
+/// its initialization markup and its bezier surface markup. A hash index maps
+/// each of these nodes to its record, so that a resection can be found from
+/// any of its members with one lookup, and records are added and removed in a
+/// single place. The registry keeps references to the nodes it holds, so the
+/// node addresses used as keys stay valid while registered.
+///
+/// All methods are protected by a mutex, so the registry can be queried from
+/// batch processing or volumetry code running outside of the main thread.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkLiverResectionRegistry
+  : public vtkObject
+{
+public:
+  static vtkLiverResectionRegistry* New();
+  vtkTypeMacro(vtkLiverResectionRegistry, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Nodes of a resection
+  struct Record
+  {
+    vtkSmartPointer<vtkMRMLLiverResectionNode> Resection;
+    vtkSmartPointer<vtkMRMLMarkupsNode> Initialization;
+    vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode> BezierSurface;
+  };
+
+  /// Registers a resection (replacing any previous record of the resection
+  /// node). Initialization and bezier surface may be null.
+  void AddResection(vtkMRMLLiverResectionNode* resection,
+                    vtkMRMLMarkupsNode* initialization,
+                    vtkMRMLMarkupsBezierSurfaceNode* bezierSurface);
+
+  /// Removes the record containing node. The removed record is copied to
+  /// removed if given. Returns false if node is not registered.
+  bool RemoveResection(vtkMRMLNode* node, Record* removed = nullptr);
+
+  /// Copies the record containing node (any of its members). Returns false if
+  /// node is not registered.
+  bool FindResection(vtkMRMLNode* node, Record& record) const;
+
+  /// Whether node is a member of a registered resection
+  bool Contains(vtkMRMLNode* node) const;
+
+  /// Members of the resection containing node (nullptr if not registered)
+  vtkMRMLLiverResectionNode* GetResection(vtkMRMLNode* node) const;
+  vtkMRMLMarkupsNode* GetInitialization(vtkMRMLNode* node) const;
+  vtkMRMLMarkupsBezierSurfaceNode* GetBezierSurface(vtkMRMLNode* node) const;
+
+  /// Copies of all records
+  std::vector<Record> GetResections() const;
+  std::size_t GetNumberOfResections() const;
+
+  void RemoveAllResections();
+
+protected:
+  vtkLiverResectionRegistry();
+  ~vtkLiverResectionRegistry() override;
+
+  /// Index of the record of node in Records, -1 if not registered. Expects
+  /// the mutex to be locked.
+  int FindRecordIndex(vtkMRMLNode* node) const;
+
+  /// Removes a record and its index entries. Expects the mutex to be locked.
+  void RemoveRecord(int index);
+
+protected:
+  std::vector<Record> Records;
+  std::vector<int> FreeRecords;
+  std::unordered_map<vtkMRMLNode*, int> RecordIndex;
+  mutable std::mutex Mutex;
+
+private:
+  vtkLiverResectionRegistry(const vtkLiverResectionRegistry&) = delete;
+  void operator=(const vtkLiverResectionRegistry&) = delete;
+};
+
+#endif // __vtkLiverResectionRegistry_h
@@ -41,7 +41,16 @@
 
 #include "vtkSlicerLiverResectionsLogic.h"
 #include "vtkMRMLAbstractLogic.h"
+#include "vtkMRMLLiverResectionBinaryStorageNode.h"
 #include "vtkMRMLLiverResectionCSVStorageNode.h"
+#include "vtkLiverDistanceMapEngine.h"
+#include "vtkLiverMeshDistanceMapEngine.h"
+#include "vtkLiverProgressiveDistanceMapEngine.h"
+#include "vtkLiverResectionDependencyGraph.h"
+#include "vtkLiverResectionEditHistory.h"
+#include "vtkLiverResectionPlanner.h"
+#include "vtkLiverResectionRegistry.h"
+#include "vtkParenchymaSlicingIndex.h"
 
 #include <vtkCommand.h>
 #include <vtkMRMLMarkupsSlicingContourNode.h>
@@ -56,6 +65,7 @@
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSelectionNode.h>
 #include <vtkMRMLSegmentationNode.h>
+#include <vtkMRMLModelNode.h>
 
 // VTK includes
 #include <vtkObjectFactory.h>
@@ -63,25 +73,123 @@
 #include <vtkSetGet.h>
 #include <vtkSmartPointer.h>
 #include <vtkIntArray.h>
-#include <vtkPlane.h>
-#include <vtkCutter.h>
-#include <vtkDoubleArray.h>
-#include <vtkCenterOfMass.h>
-#include <vtkPCAStatistics.h>
-#include <vtkPlaneSource.h>
-#include <vtkTable.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+#include <vtkStringArray.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+#include <vtkVector.h>
 #include <vtkImageData.h>
 
 #include <vtkMRMLGlyphableVolumeDisplayNode.h>
 #include <itkLabelImageToLabelMapFilter.h>
 #include <vtkPath.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <locale>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// The image data of the volume nodes has unit spacing: the engine gets
+/// shallow copies with the spacing of the nodes, so that the distances are in mm
+vtkSmartPointer<vtkImageData> GetDistanceMapEngineLabelMap(vtkMRMLScalarVolumeNode* labelMapNode)
+{
+  auto labelMap = vtkSmartPointer<vtkImageData>::New();
+  labelMap->ShallowCopy(labelMapNode->GetImageData());
+  labelMap->SetSpacing(labelMapNode->GetSpacing());
+  labelMap->SetOrigin(0.0, 0.0, 0.0);
+  return labelMap;
+}
+
+//----------------------------------------------------------------------------
+/// Volume nodes index their image data from zero: a cropped distance map
+/// (sub-extent of the output of an engine) is moved to the origin of the
+/// index space, and its IJK to RAS matrix composes that offset with the
+/// mapping of the structured indices of the output to RAS. The scale and
+/// offset of quantized distances are stored as node attributes.
+void SetDistanceMapVolume(vtkImageData* distances, vtkMatrix4x4* indexToRAS, double scale, double offset,
+                          vtkMRMLScalarVolumeNode* outputNode)
+{
+  auto distanceMap = vtkSmartPointer<vtkImageData>::New();
+  distanceMap->ShallowCopy(distances);
+  distanceMap->SetSpacing(1.0, 1.0, 1.0);
+  distanceMap->SetOrigin(0.0, 0.0, 0.0);
+  int extent[6];
+  distanceMap->GetExtent(extent);
+  distanceMap->SetExtent(0, extent[1] - extent[0], 0, extent[3] - extent[2], 0, extent[5] - extent[4]);
+
+  vtkNew<vtkMatrix4x4> extentOffset;
+  for (int i = 0; i < 3; ++i)
+    {
+    extentOffset->SetElement(i, 3, extent[2 * i]);
+    }
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  vtkMatrix4x4::Multiply4x4(indexToRAS, extentOffset, ijkToRAS);
+  MRMLNodeModifyBlocker blocker(outputNode);
+  outputNode->SetIJKToRASMatrix(ijkToRAS);
+  auto toString = [](double value)
+    {
+    std::ostringstream stream;
+    stream.imbue(std::locale::classic());
+    stream.precision(17);
+    stream << value;
+    return stream.str();
+    };
+  outputNode->SetAttribute("DistanceMap.Scale", toString(scale).c_str());
+  outputNode->SetAttribute("DistanceMap.Offset", toString(offset).c_str());
+  outputNode->SetAndObserveImageData(distanceMap);
+}
+
+//----------------------------------------------------------------------------
+/// The output of the label map engine maps to the label maps (e.g. resampled
+/// ones), and these to RAS with the IJK to RAS matrix of the reference node
+void SetDistanceMapVolume(vtkLiverDistanceMapEngine* engine, vtkMRMLScalarVolumeNode* referenceNode,
+                          vtkMRMLScalarVolumeNode* outputNode)
+{
+  vtkNew<vtkMatrix4x4> indexToRAS;
+  referenceNode->GetIJKToRASMatrix(indexToRAS);
+  vtkNew<vtkMatrix4x4> outputToInput;
+  engine->GetOutputIndexToInputIndex(outputToInput);
+  vtkMatrix4x4::Multiply4x4(indexToRAS, outputToInput, indexToRAS);
+  SetDistanceMapVolume(engine->GetOutput(), indexToRAS, engine->GetOutputScale(), engine->GetOutputOffset(),
+                       outputNode);
+}
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerLiverResectionsLogic);
 
 //---------------------------------------------------------------------------
 vtkSlicerLiverResectionsLogic::vtkSlicerLiverResectionsLogic()
+  : LiveInitializationPreview(true)
+  , InitializationPreviewInterval(1.0 / 30.0)
+  , LastInitializationPreviewTime(0.0)
+  , DeferredPropertyPropagation(false)
+  , PropertyPropagationPending(false)
+  , TessellationResolution(20)
 {
+  this->ResectionRegistry = vtkSmartPointer<vtkLiverResectionRegistry>::New();
+  this->DependencyGraph = vtkSmartPointer<vtkLiverResectionDependencyGraph>::New();
+  this->DependencyGraph->SetProductUpdateFunction(vtkLiverResectionDependencyGraph::TessellationProduct,
+                                                  [this](vtkMRMLLiverResectionNode* resectionNode)
+                                                  {this->UpdateResectionTessellation(resectionNode);});
+  this->DependencyGraph->SetProductUpdateFunction(vtkLiverResectionDependencyGraph::TextureProduct,
+                                                  [this](vtkMRMLLiverResectionNode* resectionNode)
+                                                  {this->UpdateResectionTextures(resectionNode);});
+  this->EditHistory = vtkSmartPointer<vtkLiverResectionEditHistory>::New();
+  this->DistanceMapEngine = vtkSmartPointer<vtkLiverDistanceMapEngine>::New();
+  this->MeshDistanceMapEngine = vtkSmartPointer<vtkLiverMeshDistanceMapEngine>::New();
+  this->ProgressiveDistanceMapEngine = vtkSmartPointer<vtkLiverProgressiveDistanceMapEngine>::New();
+  std::fill_n(this->ProgressiveInputTimes, vtkLiverDistanceMapEngine::NumberOfStructures, 0);
+  vtkMatrix4x4::Identity(this->ProgressiveIJKToRAS);
   //auto node = vtkSmartPointer<vtkMRMLGlyphableVolumeDisplayNode>::New();
 }
 
@@ -103,6 +211,7 @@ void vtkSlicerLiverResectionsLogic::RegisterNodes()
   // Nodes
   scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLLiverResectionNode>::New());
   scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLLiverResectionCSVStorageNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLLiverResectionBinaryStorageNode>::New());
 }
 
 //---------------------------------------------------------------------------
@@ -126,18 +235,46 @@ void vtkSlicerLiverResectionsLogic::ProcessMRMLNodesEvents(vtkObject *caller,
                                                            unsigned long event,
                                                            void *vtkNotUsed(callData))
 {
-  // Process slicing initialization
-  auto slicingInitializationNode = vtkMRMLMarkupsSlicingContourNode::SafeDownCast(caller);
-  if (slicingInitializationNode)
+  // Process initialization (slicing contour for flat resections, distance
+  // contour for curved ones)
+  vtkMRMLMarkupsNode* initializationNode = nullptr;
+  if (vtkMRMLMarkupsSlicingContourNode::SafeDownCast(caller) ||
+      vtkMRMLMarkupsDistanceContourNode::SafeDownCast(caller))
+    {
+    initializationNode = vtkMRMLMarkupsNode::SafeDownCast(caller);
+    }
+  if (initializationNode)
     {
     switch(event)
       {
       case vtkCommand::StartInteractionEvent:
-        this->HideBezierSurfaceMarkup(slicingInitializationNode);
+        if (this->LiveInitializationPreview)
+          {
+          this->PreviewInitializationNode = initializationNode;
+          this->LastInitializationPreviewTime = 0.0;
+          }
+        else
+          {
+          this->HideBezierSurfaceMarkup(initializationNode);
+          }
+        break;
+
+      case vtkMRMLMarkupsNode::PointModifiedEvent:
+        // Live preview while dragging, throttled to the preview interval
+        if (this->PreviewInitializationNode == initializationNode)
+          {
+          double now = vtkTimerLog::GetUniversalTime();
+          if (now - this->LastInitializationPreviewTime >= this->InitializationPreviewInterval)
+            {
+            this->LastInitializationPreviewTime = now;
+            this->UpdateBezierWidgetOnInitialization(initializationNode);
+            }
+          }
         break;
 
       case vtkCommand::EndInteractionEvent:
-        this->UpdateBezierWidgetOnInitialization(slicingInitializationNode);
+        this->PreviewInitializationNode = nullptr;
+        this->UpdateBezierWidgetOnInitialization(initializationNode);
         break;
       }
     }
@@ -146,6 +283,7 @@ void vtkSlicerLiverResectionsLogic::ProcessMRMLNodesEvents(vtkObject *caller,
   auto bezierSurfaceNode = vtkMRMLMarkupsBezierSurfaceNode::SafeDownCast(caller);
   if (bezierSurfaceNode && event == vtkCommand::StartInteractionEvent)
     {
+    this->EditHistory->BeginEdit(bezierSurfaceNode);
     this->HideInitializationMarkup(bezierSurfaceNode);
     auto resectionNode = this->GetResectionFromBezier(bezierSurfaceNode);
     if (resectionNode)
@@ -155,59 +293,232 @@ void vtkSlicerLiverResectionsLogic::ProcessMRMLNodesEvents(vtkObject *caller,
       }
     }
 
+  if (bezierSurfaceNode && event == vtkCommand::EndInteractionEvent)
+    {
+    this->EditHistory->EndEdit(bezierSurfaceNode);
+    auto resectionNode = this->GetResectionFromBezier(bezierSurfaceNode);
+    if (resectionNode)
+      {
+      this->DependencyGraph->UpdateProducts(resectionNode);
+      }
+    }
+
   // Process resection node
   auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(caller);
   if (resectionNode && event == vtkCommand::ModifiedEvent)
     {
-    // Create the resection elements
-    if (this->ResectionToInitializationMap.find(resectionNode) == this->ResectionToInitializationMap.end())
+    // During batch processing the resection elements are created and the
+    // modified properties (which accumulate on the resection node) are
+    // propagated once, when the batch ends
+    if (this->GetMRMLScene() && this->GetMRMLScene()->IsBatchProcessing())
       {
-      this->CreateInitializationAndResectionMarkups(resectionNode);
+      return;
       }
 
-    // Update the polydata
-    auto initializationNode =  vtkMRMLMarkupsSlicingContourNode::SafeDownCast(this->GetInitializationFromResection(resectionNode));
-    if(initializationNode)
+    // Create the resection elements
+    if (!this->ResectionRegistry->Contains(resectionNode))
       {
-        initializationNode->SetTarget(resectionNode->GetTargetOrganModelNode());
+      this->CreateInitializationAndResectionMarkups(resectionNode);
       }
 
-    auto bezierSurfaceNode = this->GetBezierFromResection(resectionNode);
-    if (bezierSurfaceNode)
+    // Deferred properties accumulate on the resection node until the
+    // application propagates them (once per render or idle pass)
+    if (this->DeferredPropertyPropagation)
       {
-      bezierSurfaceNode->SetDistanceMapVolumeNode(resectionNode->GetDistanceMapVolumeNode());
-      bezierSurfaceNode->SetVascularSegmentsVolumeNode(resectionNode->GetVascularSegmentsVolumeNode());
-      bezierSurfaceNode->SetResectionMargin(resectionNode->GetResectionMargin());
-      bezierSurfaceNode->SetUncertaintyMargin(resectionNode->GetUncertaintyMargin());
-      bezierSurfaceNode->SetHepaticContourThickness(resectionNode->GetHepaticContourThickness());
-      bezierSurfaceNode->SetPortalContourThickness(resectionNode->GetPortalContourThickness());
-
-      auto bezierSurfaceDisplayNode =
-        vtkMRMLMarkupsBezierSurfaceDisplayNode::SafeDownCast(bezierSurfaceNode->GetDisplayNode());
-      if (bezierSurfaceDisplayNode)
+      if (resectionNode->GetModifiedProperties() != 0 && !this->PropertyPropagationPending)
         {
-        bezierSurfaceDisplayNode->SetShowResection2D(resectionNode->GetShowResection2D());
-        bezierSurfaceDisplayNode->SetMirrorDisplay(resectionNode->GetMirrorDisplay());
-        bezierSurfaceDisplayNode->SetEnableFlexibleBoundary(resectionNode->GetEnableFlexibleBoundary());
-        bezierSurfaceDisplayNode->SetGrid2DVisibility(resectionNode->GetGrid2DVisibility());
-        bezierSurfaceDisplayNode->SetTextureNumComps(resectionNode->GetTextureNumComps());
-        bezierSurfaceDisplayNode->SetClipOut(resectionNode->GetClipOut());
-        bezierSurfaceDisplayNode->SetWidgetVisibility(resectionNode->GetWidgetVisibility());
-        bezierSurfaceDisplayNode->SetInterpolatedMargins(resectionNode->GetInterpolatedMargins());
-        bezierSurfaceDisplayNode->SetResectionColor(resectionNode->GetResectionColor());
-        bezierSurfaceDisplayNode->SetResectionGridColor(resectionNode->GetResectionGridColor());
-        bezierSurfaceDisplayNode->SetResectionMarginColor(resectionNode->GetResectionMarginColor());
-        bezierSurfaceDisplayNode->SetUncertaintyMarginColor(resectionNode->GetUncertaintyMarginColor());
-        bezierSurfaceDisplayNode->SetResectionOpacity(resectionNode->GetResectionOpacity());
-        bezierSurfaceDisplayNode->SetGridDivisions(resectionNode->GetGridDivisions());
-        bezierSurfaceDisplayNode->SetGridThickness(resectionNode->GetGridThickness());
-        bezierSurfaceDisplayNode->SetGrid3DVisibility(resectionNode->GetGrid3DVisibility());
-        bezierSurfaceDisplayNode->SetHepaticContourColor(resectionNode->GetHepaticContourColor());
-        bezierSurfaceDisplayNode->SetPortalContourColor(resectionNode->GetPortalContourColor());
+        this->PropertyPropagationPending = true;
+        this->InvokeEvent(PropertyPropagationRequestedEvent);
         }
-      bezierSurfaceNode->SetLocked(!resectionNode->GetWidgetVisibility());
+      return;
       }
+
+    this->UpdateMarkupsFromResection(resectionNode);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::PropagatePendingProperties()
+{
+  this->PropertyPropagationPending = false;
+  for (const auto& record : this->ResectionRegistry->GetResections())
+    {
+    this->UpdateMarkupsFromResection(record.Resection);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::OnMRMLSceneEndBatchProcess()
+{
+  Superclass::OnMRMLSceneEndBatchProcess();
+
+  // Create the elements of the resections added or targeted during the batch
+  std::vector<vtkMRMLNode*> resectionNodes;
+  this->GetMRMLScene()->GetNodesByClass("vtkMRMLLiverResectionNode", resectionNodes);
+  for (auto node : resectionNodes)
+    {
+    auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(node);
+    if (resectionNode && resectionNode->GetTargetOrganModelNode() &&
+        !this->ResectionRegistry->Contains(resectionNode))
+      {
+      this->CreateInitializationAndResectionMarkups(resectionNode);
+      }
+    }
+
+  this->PropagatePendingProperties();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::UpdateMarkupsFromResection(vtkMRMLLiverResectionNode* resectionNode)
+{
+  if (!resectionNode || resectionNode->GetModifiedProperties() == 0)
+    {
+    return;
+    }
+
+  auto initializationNode =  vtkMRMLMarkupsSlicingContourNode::SafeDownCast(this->GetInitializationFromResection(resectionNode));
+  if (initializationNode && resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::TargetOrganModelNodeFlag))
+    {
+    initializationNode->SetTarget(resectionNode->GetTargetOrganModelNode());
+    }
+
+  auto bezierSurfaceNode = this->GetBezierFromResection(resectionNode);
+  if (!bezierSurfaceNode)
+    {
+    return;
+    }
+
+  auto bezierSurfaceDisplayNode =
+    vtkMRMLMarkupsBezierSurfaceDisplayNode::SafeDownCast(bezierSurfaceNode->GetDisplayNode());
+
+  // Only the modified properties are propagated, and each markups node invokes
+  // at most one modified event for all of them
+  {
+  MRMLNodeModifyBlocker bezierSurfaceBlocker(bezierSurfaceNode);
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::DistanceMapVolumeNodeFlag))
+    {
+    bezierSurfaceNode->SetDistanceMapVolumeNode(resectionNode->GetDistanceMapVolumeNode());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::VascularSegmentsVolumeNodeFlag))
+    {
+    bezierSurfaceNode->SetVascularSegmentsVolumeNode(resectionNode->GetVascularSegmentsVolumeNode());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::ResectionMarginFlag))
+    {
+    bezierSurfaceNode->SetResectionMargin(resectionNode->GetResectionMargin());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::UncertaintyMarginFlag))
+    {
+    bezierSurfaceNode->SetUncertaintyMargin(resectionNode->GetUncertaintyMargin());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::HepaticContourThicknessFlag))
+    {
+    bezierSurfaceNode->SetHepaticContourThickness(resectionNode->GetHepaticContourThickness());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::PortalContourThicknessFlag))
+    {
+    bezierSurfaceNode->SetPortalContourThickness(resectionNode->GetPortalContourThickness());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::WidgetVisibilityFlag))
+    {
+    bezierSurfaceNode->SetLocked(!resectionNode->GetWidgetVisibility());
+    }
+
+  // Textures of replaced volumes are transferred along with the properties
+  this->DependencyGraph->UpdateProducts(resectionNode);
+  }
+
+  if (!bezierSurfaceDisplayNode)
+    {
+    // Keep the display properties flagged until there is a display node
+    resectionNode->ClearModifiedProperties(
+      vtkMRMLLiverResectionNode::TargetOrganModelNodeFlag |
+      vtkMRMLLiverResectionNode::DistanceMapVolumeNodeFlag |
+      vtkMRMLLiverResectionNode::VascularSegmentsVolumeNodeFlag |
+      vtkMRMLLiverResectionNode::ResectionMarginFlag |
+      vtkMRMLLiverResectionNode::UncertaintyMarginFlag |
+      vtkMRMLLiverResectionNode::HepaticContourThicknessFlag |
+      vtkMRMLLiverResectionNode::PortalContourThicknessFlag);
+    return;
+    }
+
+  {
+  MRMLNodeModifyBlocker bezierSurfaceDisplayBlocker(bezierSurfaceDisplayNode);
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::ShowResection2DFlag))
+    {
+    bezierSurfaceDisplayNode->SetShowResection2D(resectionNode->GetShowResection2D());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::MirrorDisplayFlag))
+    {
+    bezierSurfaceDisplayNode->SetMirrorDisplay(resectionNode->GetMirrorDisplay());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::EnableFlexibleBoundaryFlag))
+    {
+    bezierSurfaceDisplayNode->SetEnableFlexibleBoundary(resectionNode->GetEnableFlexibleBoundary());
     }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::Grid2DVisibilityFlag))
+    {
+    bezierSurfaceDisplayNode->SetGrid2DVisibility(resectionNode->GetGrid2DVisibility());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::TextureNumCompsFlag))
+    {
+    bezierSurfaceDisplayNode->SetTextureNumComps(resectionNode->GetTextureNumComps());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::ClipOutFlag))
+    {
+    bezierSurfaceDisplayNode->SetClipOut(resectionNode->GetClipOut());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::WidgetVisibilityFlag))
+    {
+    bezierSurfaceDisplayNode->SetWidgetVisibility(resectionNode->GetWidgetVisibility());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::InterpolatedMarginsFlag))
+    {
+    bezierSurfaceDisplayNode->SetInterpolatedMargins(resectionNode->GetInterpolatedMargins());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::ResectionColorFlag))
+    {
+    bezierSurfaceDisplayNode->SetResectionColor(resectionNode->GetResectionColor());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::ResectionGridColorFlag))
+    {
+    bezierSurfaceDisplayNode->SetResectionGridColor(resectionNode->GetResectionGridColor());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::ResectionMarginColorFlag))
+    {
+    bezierSurfaceDisplayNode->SetResectionMarginColor(resectionNode->GetResectionMarginColor());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::UncertaintyMarginColorFlag))
+    {
+    bezierSurfaceDisplayNode->SetUncertaintyMarginColor(resectionNode->GetUncertaintyMarginColor());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::ResectionOpacityFlag))
+    {
+    bezierSurfaceDisplayNode->SetResectionOpacity(resectionNode->GetResectionOpacity());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::GridDivisionsFlag))
+    {
+    bezierSurfaceDisplayNode->SetGridDivisions(resectionNode->GetGridDivisions());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::GridThicknessFlag))
+    {
+    bezierSurfaceDisplayNode->SetGridThickness(resectionNode->GetGridThickness());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::Grid3DVisibilityFlag))
+    {
+    bezierSurfaceDisplayNode->SetGrid3DVisibility(resectionNode->GetGrid3DVisibility());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::HepaticContourColorFlag))
+    {
+    bezierSurfaceDisplayNode->SetHepaticContourColor(resectionNode->GetHepaticContourColor());
+    }
+  if (resectionNode->IsPropertyModified(vtkMRMLLiverResectionNode::PortalContourColorFlag))
+    {
+    bezierSurfaceDisplayNode->SetPortalContourColor(resectionNode->GetPortalContourColor());
+    }
+  }
+
+  resectionNode->ClearModifiedProperties();
 }
 
 //---------------------------------------------------------------------------
@@ -240,6 +551,13 @@ void vtkSlicerLiverResectionsLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
 //---------------------------------------------------------------------------
 void vtkSlicerLiverResectionsLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
 {
+  // Release the slicing index of a removed target organ
+  if (node && node->GetID())
+    {
+    this->ParenchymaSlicingIndices.erase(node->GetID());
+    this->ResectionTessellations.erase(node->GetID());
+    }
+
   auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(node);
 
   // check for nullptr and target organ
@@ -248,52 +566,19 @@ void vtkSlicerLiverResectionsLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
     return;
     }
 
-  vtkMRMLMarkupsNode* initializationNode = nullptr;
-  vtkMRMLMarkupsBezierSurfaceNode* bezierSurfaceNode = nullptr;
-
-  auto riMapIt = this->ResectionToInitializationMap.find(resectionNode);
-  if (riMapIt != this->ResectionToInitializationMap.end())
-    {
-    initializationNode = riMapIt->second.GetPointer();
-    this->ResectionToInitializationMap.erase(riMapIt);
-    }
-
-  auto irMapIt = this->InitializationToResectionMap.find(initializationNode);
-  if (irMapIt != this->InitializationToResectionMap.end())
-    {
-    this->InitializationToResectionMap.erase(irMapIt);
-    }
-
-  auto rbMapIt = this->ResectionToBezierMap.find(resectionNode);
-  if (rbMapIt != this->ResectionToBezierMap.end())
-    {
-    bezierSurfaceNode = rbMapIt->second.GetPointer();
-    this->ResectionToBezierMap.erase(rbMapIt);
-    }
-
-  auto brMapIt = this->BezierToResectionMap.find(bezierSurfaceNode);
-  if (brMapIt != this->BezierToResectionMap.end())
-    {
-    resectionNode = brMapIt->second.GetPointer();
-    this->BezierToResectionMap.erase(brMapIt);
-    }
-
-  auto ibMapIt = this->InitializationToBezierMap.find(initializationNode);
-  if (ibMapIt != this->InitializationToBezierMap.end())
-    {
-    this->InitializationToBezierMap.erase(ibMapIt);
-    }
-
-  auto biMapIt = this->BezierToInitializationMap.find(bezierSurfaceNode);
-  if (biMapIt != this->BezierToInitializationMap.end())
-    {
-    this->BezierToInitializationMap.erase(biMapIt);
-    }
+  vtkLiverResectionRegistry::Record record;
+  this->ResectionRegistry->FindResection(resectionNode, record);
+  vtkMRMLMarkupsNode* initializationNode = record.Initialization;
+  vtkMRMLMarkupsBezierSurfaceNode* bezierSurfaceNode = record.BezierSurface;
 
   // NOTE: This is a workaround to "delete" the contour from visualization.
   // A better option would be that the markup takes care of this.
   this->HideBezierSurfaceMarkup(initializationNode);
 
+  this->ResectionRegistry->RemoveResection(resectionNode);
+  this->DependencyGraph->RemoveResection(resectionNode);
+  this->EditHistory->RemoveNode(bezierSurfaceNode);
+
   vtkUnObserveMRMLNodeMacro(bezierSurfaceNode);
   vtkUnObserveMRMLNodeMacro(initializationNode);
 
@@ -459,71 +744,176 @@ vtkSlicerLiverResectionsLogic::AddBezierSurface(vtkMRMLLiverResectionNode *resec
 vtkMRMLLiverResectionNode* vtkSlicerLiverResectionsLogic
 ::GetResectionFromBezier(vtkMRMLMarkupsBezierSurfaceNode* markupsBezierNode) const
 {
-  auto bezierToResection = this->BezierToResectionMap.find(markupsBezierNode);
-  if (bezierToResection == this->BezierToResectionMap.end())
-    {
-    return nullptr;
-    }
-  return bezierToResection->second;
+  return this->ResectionRegistry->GetResection(markupsBezierNode);
 }
 
 //------------------------------------------------------------------------------
 vtkMRMLLiverResectionNode* vtkSlicerLiverResectionsLogic
 ::GetResectionFromInitialization(vtkMRMLMarkupsNode* initializationNode) const
 {
-  auto initializationToResection = this->InitializationToResectionMap.find(initializationNode);
-  if (initializationToResection == this->InitializationToResectionMap.end())
-    {
-    return nullptr;
-    }
-  return initializationToResection->second;
+  return this->ResectionRegistry->GetResection(initializationNode);
 }
 //------------------------------------------------------------------------------
 vtkMRMLMarkupsNode* vtkSlicerLiverResectionsLogic
 ::GetInitializationFromResection(vtkMRMLLiverResectionNode* resectionNode) const
 {
-  auto resectionToInitialization = this->ResectionToInitializationMap.find(resectionNode);
-  if (resectionToInitialization == this->ResectionToInitializationMap.end())
-    {
-    return nullptr;
-    }
-  return resectionToInitialization->second;
+  return this->ResectionRegistry->GetInitialization(resectionNode);
 }
 
 //------------------------------------------------------------------------------
 vtkMRMLMarkupsBezierSurfaceNode* vtkSlicerLiverResectionsLogic
 ::GetBezierFromResection(vtkMRMLLiverResectionNode* resectionNode) const
 {
-  auto resectionToBezier = this->ResectionToBezierMap.find(resectionNode);
-  if (resectionToBezier == this->ResectionToBezierMap.end())
+  return this->ResectionRegistry->GetBezierSurface(resectionNode);
+}
+
+//------------------------------------------------------------------------------
+vtkLiverResectionRegistry* vtkSlicerLiverResectionsLogic::GetResectionRegistry() const
+{
+  return this->ResectionRegistry;
+}
+
+//------------------------------------------------------------------------------
+vtkLiverResectionDependencyGraph* vtkSlicerLiverResectionsLogic::GetDependencyGraph() const
+{
+  return this->DependencyGraph;
+}
+
+//------------------------------------------------------------------------------
+vtkLiverResectionEditHistory* vtkSlicerLiverResectionsLogic::GetEditHistory() const
+{
+  return this->EditHistory;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::UndoResectionEdit(vtkMRMLLiverResectionNode* resectionNode)
+{
+  if (!this->EditHistory->Undo(this->ResectionRegistry->GetBezierSurface(resectionNode)))
     {
-    return nullptr;
+    return false;
     }
-  return resectionToBezier->second;
+
+  // Only the products depending on the bezier surface are recomputed
+  this->DependencyGraph->UpdateProducts(resectionNode);
+  return true;
 }
 
 //------------------------------------------------------------------------------
-vtkMRMLMarkupsBezierSurfaceNode* vtkSlicerLiverResectionsLogic
-::GetBezierFromInitialization(vtkMRMLMarkupsNode *initializationNode) const
+bool vtkSlicerLiverResectionsLogic::RedoResectionEdit(vtkMRMLLiverResectionNode* resectionNode)
 {
-  auto initializationToBezier = this->InitializationToBezierMap.find(initializationNode);
-  if (initializationToBezier == this->InitializationToBezierMap.end())
+  if (!this->EditHistory->Redo(this->ResectionRegistry->GetBezierSurface(resectionNode)))
     {
-    return nullptr;
+    return false;
     }
-  return initializationToBezier->second;
+
+  this->DependencyGraph->UpdateProducts(resectionNode);
+  return true;
 }
 
 //------------------------------------------------------------------------------
-vtkMRMLMarkupsNode * vtkSlicerLiverResectionsLogic
-::GetInitializationFromBezier(vtkMRMLMarkupsBezierSurfaceNode* markupsBezierNode) const
+vtkPolyData* vtkSlicerLiverResectionsLogic::GetResectionTessellation(vtkMRMLLiverResectionNode* resectionNode)
 {
-  auto BezierToInitialization = this->BezierToInitializationMap.find(markupsBezierNode);
-  if (BezierToInitialization == this->BezierToInitializationMap.end())
+  if (!resectionNode || !resectionNode->GetID())
     {
     return nullptr;
     }
-  return BezierToInitialization->second;
+
+  this->DependencyGraph->UpdateProduct(resectionNode, vtkLiverResectionDependencyGraph::TessellationProduct);
+  auto it = this->ResectionTessellations.find(resectionNode->GetID());
+  return it != this->ResectionTessellations.end() ? it->second.GetPointer() : nullptr;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::SetTessellationResolution(int resolution)
+{
+  resolution = std::max(2, std::min(resolution, 1024));
+  if (this->TessellationResolution == resolution)
+    {
+    return;
+    }
+  this->TessellationResolution = resolution;
+
+  // The tessellations are recomputed on the next request
+  auto scene = this->GetMRMLScene();
+  for (const auto& tessellation : this->ResectionTessellations)
+    {
+    auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(
+      scene ? scene->GetNodeByID(tessellation.first) : nullptr);
+    if (resectionNode)
+      {
+      this->DependencyGraph->InvalidateProduct(resectionNode, vtkLiverResectionDependencyGraph::TessellationProduct);
+      }
+    }
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::UpdateResectionTessellation(vtkMRMLLiverResectionNode* resectionNode)
+{
+  if (!resectionNode->GetID())
+    {
+    return;
+    }
+
+  auto bezierSurfaceNode = resectionNode->GetBezierSurfaceNode();
+  if (!bezierSurfaceNode || bezierSurfaceNode->GetNumberOfControlPoints() != 16)
+    {
+    this->ResectionTessellations.erase(resectionNode->GetID());
+    return;
+    }
+
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetNumberOfPoints(16);
+  for (int i = 0; i < 16; ++i)
+    {
+    double position[3];
+    bezierSurfaceNode->GetNthControlPointPosition(i, position);
+    controlPoints->SetPoint(i, position);
+    }
+
+  auto tessellation = vtkSmartPointer<vtkPolyData>::New();
+  vtkLiverResectionPlanner::ComputeTessellation(controlPoints, this->TessellationResolution, tessellation);
+  this->ResectionTessellations[resectionNode->GetID()] = tessellation;
+
+  auto binaryStorageNode = vtkMRMLLiverResectionBinaryStorageNode::SafeDownCast(resectionNode->GetStorageNode());
+  if (binaryStorageNode)
+    {
+    binaryStorageNode->SetTessellation(tessellation);
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::UpdateResectionTextures(vtkMRMLLiverResectionNode* resectionNode)
+{
+  auto bezierSurfaceNode = this->ResectionRegistry->GetBezierSurface(resectionNode);
+  if (bezierSurfaceNode &&
+      (resectionNode->GetDistanceMapVolumeNode() || resectionNode->GetVascularSegmentsVolumeNode()))
+    {
+    bezierSurfaceNode->TexturesModified();
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::UpdateResectionProducts()
+{
+  for (const auto& record : this->ResectionRegistry->GetResections())
+    {
+    this->DependencyGraph->UpdateProducts(record.Resection);
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLMarkupsBezierSurfaceNode* vtkSlicerLiverResectionsLogic
+::GetBezierFromInitialization(vtkMRMLMarkupsNode *initializationNode) const
+{
+  return this->ResectionRegistry->GetBezierSurface(initializationNode);
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLMarkupsNode * vtkSlicerLiverResectionsLogic
+::GetInitializationFromBezier(vtkMRMLMarkupsBezierSurfaceNode* markupsBezierNode) const
+{
+  return this->ResectionRegistry->GetInitialization(markupsBezierNode);
 }
 
 //------------------------------------------------------------------------------
@@ -680,23 +1070,15 @@ void vtkSlicerLiverResectionsLogic::UpdateBezierWidgetOnInitialization(vtkMRMLMa
     }
 
   // Check for resection node from initializatio node
-  auto initializationToResection =
-    this->InitializationToResectionMap.find(initializationNode);
-  if (initializationToResection == this->InitializationToResectionMap.end())
+  vtkLiverResectionRegistry::Record record;
+  if (!this->ResectionRegistry->FindResection(initializationNode, record))
     {
     vtkErrorMacro("Error in UpdateBezierWidgetOnInitialization: initialization node does not have a corresponding resection node.");
     return;
     }
 
-  // Check for resection node
-  if (!initializationToResection->second)
-    {
-    vtkErrorMacro("Error in UpdateBezierWidgetOnInitialization: initialization node does not have a valid corresponding resection node.");
-    return;
-    }
-
   // Check for target organ model node
-  auto parenchymaModelNode = initializationToResection->second->GetTargetOrganModelNode();
+  auto parenchymaModelNode = record.Resection->GetTargetOrganModelNode();
   if (!parenchymaModelNode)
     {
     vtkErrorMacro("Error in UpdateBezierWidgetOnInitialization: resection node does not have a valid target organ.");
@@ -710,151 +1092,75 @@ void vtkSlicerLiverResectionsLogic::UpdateBezierWidgetOnInitialization(vtkMRMLMa
     return;
     }
 
-  auto controlPoints =  initializationNode->GetControlPoints();
-
-  // This algorithm is based on NorMIT-Plan
-  // https://github.com/TheInterventionCentre/NorMIT-Plan
-
-  double point1[3] = {(*controlPoints)[0]->Position[0],
-                      (*controlPoints)[0]->Position[1],
-                      (*controlPoints)[0]->Position[2]};
-  double point2[3] = {(*controlPoints)[1]->Position[0],
-                      (*controlPoints)[1]->Position[1],
-                      (*controlPoints)[1]->Position[2]};
-  double midPoint[3];
-  double normal[3];
-
-  midPoint[0] = (point1[0] + point2[0]) / 2.0;
-  midPoint[1] = (point1[1] + point2[1]) / 2.0;
-  midPoint[2] = (point1[2] + point2[2]) / 2.0;
-
-  normal[0] = point2[0] - point1[0];
-  normal[1] = point2[1] - point1[1];
-  normal[2] = point2[2] - point1[2];
-
-  // Cut the parenchyma (generate contour).
-  vtkNew<vtkPlane> cuttingPlane;
-  cuttingPlane->SetOrigin(midPoint);
-  cuttingPlane->SetNormal(normal);
-  vtkNew<vtkCutter> cutter;
-  cutter->SetInputData(parenchymaModelNode->GetPolyData());
-  cutter->SetCutFunction(cuttingPlane.GetPointer());
-  cutter->Update();
-
-  vtkPolyData *contour = cutter->GetOutput();
-
-  // Perform Principal Component Analysis
-  vtkNew<vtkDoubleArray> xArray;
-  xArray->SetNumberOfComponents(1);
-  xArray->SetName("x");
-  vtkNew<vtkDoubleArray> yArray;
-  yArray->SetNumberOfComponents(1);
-  yArray->SetName("y");
-  vtkNew<vtkDoubleArray> zArray;
-  zArray->SetNumberOfComponents(1);
-  zArray->SetName("z");
-
-  vtkNew<vtkCenterOfMass> centerOfMass;
-  centerOfMass->SetInputData(contour);
-  centerOfMass->Update();
-  double com[3]={0};
-  centerOfMass->GetCenter(com);
-
-  for(unsigned int i=0; i<contour->GetNumberOfPoints(); i++)
-    {
-    double point[3];
-    contour->GetPoint(i, point);
-    xArray->InsertNextValue(point[0]);
-    yArray->InsertNextValue(point[1]);
-    zArray->InsertNextValue(point[2]);
-    }
-
-  vtkNew<vtkTable> dataTable;
-  dataTable->AddColumn(xArray.GetPointer());
-  dataTable->AddColumn(yArray.GetPointer());
-  dataTable->AddColumn(zArray.GetPointer());
-
-  vtkNew<vtkPCAStatistics> pcaStatistics;
-  pcaStatistics->SetInputData(vtkStatisticsAlgorithm::INPUT_DATA,
-                              dataTable.GetPointer());
-  pcaStatistics->SetColumnStatus("x", 1);
-  pcaStatistics->SetColumnStatus("y", 1);
-  pcaStatistics->SetColumnStatus("z", 1);
-  pcaStatistics->RequestSelectedColumns();
-  pcaStatistics->SetDeriveOption(true);
-  pcaStatistics->SetFixedBasisSize(3);
-  pcaStatistics->Update();
-
-  vtkNew<vtkDoubleArray> eigenvalues;
-  pcaStatistics->GetEigenvalues(eigenvalues.GetPointer());
-  vtkNew<vtkDoubleArray> eigenvector1;
-  pcaStatistics->GetEigenvector(0, eigenvector1.GetPointer());
-  vtkNew<vtkDoubleArray> eigenvector2;
-  pcaStatistics->GetEigenvector(1, eigenvector2.GetPointer());
-  vtkNew<vtkDoubleArray> eigenvector3;
-  pcaStatistics->GetEigenvector(2, eigenvector3.GetPointer());
-
-  double length1 = 4.0*sqrt(pcaStatistics->GetEigenvalue(0,0));
-  double length2 = 4.0*sqrt(pcaStatistics->GetEigenvalue(0,1));
-
-  double v1[3] =
-    {
-      eigenvector1->GetValue(0),
-      eigenvector1->GetValue(1),
-      eigenvector1->GetValue(2)
-    };
-
-  double v2[3] =
+  auto bezierSurfaceNode = record.BezierSurface;
+  if (!bezierSurfaceNode)
     {
-      eigenvector2->GetValue(0),
-      eigenvector2->GetValue(1),
-      eigenvector2->GetValue(2)
-    };
+    vtkErrorMacro("Error UpdateBezierWidgetOnInitialization: Initialization node does not have a valid corresponding bezier markups node.");
+    return;
+    }
 
-  double origin[3] =
+  // Orientation of the current surface grid. Updates are warm-started from it
+  // so that the surface does not flip between consecutive updates (the sign
+  // of the principal axes is arbitrary)
+  bool warmStart = bezierSurfaceNode->GetNumberOfControlPoints() == 16;
+  double uAxis[3] = {1.0, 0.0, 0.0};
+  double vAxis[3] = {0.0, 1.0, 0.0};
+  if (warmStart)
     {
-      com[0] - v1[0]*length1/2.0 - v2[0]*length2/2.0,
-      com[1] - v1[1]*length1/2.0 - v2[1]*length2/2.0,
-      com[2] - v1[2]*length1/2.0 - v2[2]*length2/2.0,
-    };
-
-  point1[0] = origin[0] + v1[0]*length1;
-  point1[1] = origin[1] + v1[1]*length1;
-  point1[2] = origin[2] + v1[2]*length1;
+    double corner0[3];
+    bezierSurfaceNode->GetNthControlPointPositionWorld(0, corner0);
+    bezierSurfaceNode->GetNthControlPointPositionWorld(3, uAxis);
+    bezierSurfaceNode->GetNthControlPointPositionWorld(12, vAxis);
+    vtkMath::Subtract(uAxis, corner0, uAxis);
+    vtkMath::Subtract(vAxis, corner0, vAxis);
+    }
 
-  point2[0] = origin[0] + v2[0]*length2;
-  point2[1] = origin[1] + v2[1]*length2;
-  point2[2] = origin[2] + v2[2]*length2;
+  auto slicingIndex = this->GetParenchymaSlicingIndex(parenchymaModelNode);
+  vtkNew<vtkPoints> surfaceControlPoints;
+  bool initialized = false;
+  switch (record.Resection->GetInitMode())
+    {
+    case vtkMRMLLiverResectionNode::Curved:
+      initialized = this->ComputeCurvedInitialization(initializationNode, slicingIndex,
+                                                      warmStart ? uAxis : nullptr,
+                                                      warmStart ? vAxis : nullptr,
+                                                      surfaceControlPoints);
+      break;
 
-  //Create bezier surface according to initial plane
-  vtkNew<vtkPlaneSource> planeSource;
-  planeSource->SetOrigin(origin);
-  planeSource->SetPoint1(point1);
-  planeSource->SetPoint2(point2);
-  planeSource->SetXResolution(3);
-  planeSource->SetYResolution(3);
-  planeSource->Update();
+    case vtkMRMLLiverResectionNode::Flat:
+      initialized = this->ComputeFlatInitialization(initializationNode, slicingIndex,
+                                                    warmStart ? uAxis : nullptr,
+                                                    warmStart ? vAxis : nullptr,
+                                                    surfaceControlPoints);
+      break;
+    }
 
-  auto initializationToBezier =
-    this->InitializationToBezierMap.find(initializationNode);
-  if (initializationToBezier == this->InitializationToBezierMap.end())
+  if (!initialized)
     {
-    vtkErrorMacro("Error UpdateBezierWidgetOnInitialization: Initialization node does not have a corresponding bezier markups node.");
+    // The initialization may leave the organ temporarily while it is being dragged
+    if (this->PreviewInitializationNode != initializationNode)
+      {
+      vtkWarningMacro("UpdateBezierWidgetOnInitialization: initialization markup does not cut the target organ.");
+      }
     return;
     }
 
-
-  auto bezierSurfaceNode = initializationToBezier->second;
-  if (!bezierSurfaceNode)
+  // Transfer the control points to the resection node (in place when the
+  // surface already has its 16 control points)
+  if (!warmStart)
     {
-    vtkErrorMacro("Error UpdateBezierWidgetOnInitialization: Initialization node does not have a valid corresponding bezier markups node.");
-    return;
+    bezierSurfaceNode->RemoveAllControlPoints();
     }
+  bezierSurfaceNode->SetControlPointPositionsWorld(surfaceControlPoints);
+
+  // The edits recorded before the initialization can not be undone anymore
+  this->EditHistory->RemoveNode(bezierSurfaceNode);
 
-  // Transfer the control points to the resection node
-  bezierSurfaceNode->RemoveAllControlPoints();
-  auto planeControlPoints = planeSource->GetOutput()->GetPoints();
-  bezierSurfaceNode->SetControlPointPositionsWorld(planeControlPoints);
+  // The derived data is updated once the live preview ends
+  if (this->PreviewInitializationNode != initializationNode)
+    {
+    this->DependencyGraph->UpdateProducts(record.Resection);
+    }
 
   auto bezierDisplayNode = bezierSurfaceNode->GetDisplayNode();
   if (!bezierDisplayNode)
@@ -866,6 +1172,435 @@ void vtkSlicerLiverResectionsLogic::UpdateBezierWidgetOnInitialization(vtkMRMLMa
   bezierDisplayNode->VisibilityOn();
 }
 
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::InitializeCurvedResection(vtkMRMLLiverResectionNode* resectionNode,
+                                                              vtkMRMLMarkupsNode* distanceContourNode)
+{
+  if (!resectionNode || !distanceContourNode)
+    {
+    vtkErrorMacro("InitializeCurvedResection: invalid resection or distance contour node.");
+    return false;
+    }
+
+  auto bezierSurfaceNode = resectionNode->GetBezierSurfaceNode();
+  if (!bezierSurfaceNode)
+    {
+    vtkErrorMacro("InitializeCurvedResection: resection node does not have a valid bezier surface node.");
+    return false;
+    }
+
+  auto slicingIndex = this->GetParenchymaSlicingIndex(resectionNode->GetTargetOrganModelNode());
+  if (!slicingIndex)
+    {
+    vtkErrorMacro("InitializeCurvedResection: resection node does not have a valid target organ.");
+    return false;
+    }
+
+  bool warmStart = bezierSurfaceNode->GetNumberOfControlPoints() == 16;
+  double uAxis[3] = {1.0, 0.0, 0.0};
+  double vAxis[3] = {0.0, 1.0, 0.0};
+  if (warmStart)
+    {
+    double corner0[3];
+    bezierSurfaceNode->GetNthControlPointPositionWorld(0, corner0);
+    bezierSurfaceNode->GetNthControlPointPositionWorld(3, uAxis);
+    bezierSurfaceNode->GetNthControlPointPositionWorld(12, vAxis);
+    vtkMath::Subtract(uAxis, corner0, uAxis);
+    vtkMath::Subtract(vAxis, corner0, vAxis);
+    }
+
+  vtkNew<vtkPoints> surfaceControlPoints;
+  if (!this->ComputeCurvedInitialization(distanceContourNode, slicingIndex,
+                                         warmStart ? uAxis : nullptr,
+                                         warmStart ? vAxis : nullptr,
+                                         surfaceControlPoints))
+    {
+    return false;
+    }
+
+  if (!warmStart)
+    {
+    bezierSurfaceNode->RemoveAllControlPoints();
+    }
+  bezierSurfaceNode->SetControlPointPositionsWorld(surfaceControlPoints);
+  this->EditHistory->RemoveNode(bezierSurfaceNode);
+  this->DependencyGraph->UpdateProducts(resectionNode);
+  if (bezierSurfaceNode->GetDisplayNode())
+    {
+    bezierSurfaceNode->GetDisplayNode()->VisibilityOn();
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::ComputeFlatInitialization(vtkMRMLMarkupsNode* initializationNode,
+                                                              vtkParenchymaSlicingIndex* slicingIndex,
+                                                              const double* uAxis,
+                                                              const double* vAxis,
+                                                              vtkPoints* controlPoints) const
+{
+  if (!slicingIndex || initializationNode->GetNumberOfControlPoints() < 2)
+    {
+    return false;
+    }
+
+  double point1[3];
+  double point2[3];
+  initializationNode->GetNthControlPointPosition(0, point1);
+  initializationNode->GetNthControlPointPosition(1, point2);
+  return vtkLiverResectionPlanner::ComputeFlatControlPoints(slicingIndex, point1, point2,
+                                                            uAxis, vAxis, controlPoints);
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::ComputeCurvedInitialization(vtkMRMLMarkupsNode* initializationNode,
+                                                                vtkParenchymaSlicingIndex* slicingIndex,
+                                                                const double* uAxis,
+                                                                const double* vAxis,
+                                                                vtkPoints* controlPoints) const
+{
+  if (!slicingIndex || initializationNode->GetNumberOfControlPoints() < 2)
+    {
+    return false;
+    }
+
+  double externalPoint[3];
+  double referencePoint[3];
+  initializationNode->GetNthControlPointPosition(0, externalPoint);
+  initializationNode->GetNthControlPointPosition(1, referencePoint);
+  return vtkLiverResectionPlanner::ComputeCurvedControlPoints(slicingIndex, externalPoint, referencePoint,
+                                                              uAxis, vAxis, controlPoints);
+}
+
+//------------------------------------------------------------------------------
+vtkParenchymaSlicingIndex* vtkSlicerLiverResectionsLogic::GetParenchymaSlicingIndex(vtkMRMLModelNode* modelNode)
+{
+  if (!modelNode || !modelNode->GetID() || !modelNode->GetPolyData())
+    {
+    return nullptr;
+    }
+
+  auto& slicingIndex = this->ParenchymaSlicingIndices[modelNode->GetID()];
+  if (!slicingIndex)
+    {
+    slicingIndex = vtkSmartPointer<vtkParenchymaSlicingIndex>::New();
+    }
+
+  // The index is only rebuilt when the poly data changes
+  slicingIndex->SetInputData(modelNode->GetPolyData());
+  slicingIndex->Update();
+  return slicingIndex;
+}
+
+//------------------------------------------------------------------------------
+vtkLiverDistanceMapEngine* vtkSlicerLiverResectionsLogic::GetDistanceMapEngine() const
+{
+  return this->DistanceMapEngine;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::ComputeDistanceMaps(vtkMRMLScalarVolumeNode* tumorNode,
+                                                        vtkMRMLScalarVolumeNode* parenchymaNode,
+                                                        vtkMRMLScalarVolumeNode* hepaticNode,
+                                                        vtkMRMLScalarVolumeNode* portalNode,
+                                                        vtkMRMLScalarVolumeNode* outputNode)
+{
+  // The last level of a running progressive computation would replace the
+  // state of the distance map engine
+  this->CancelProgressiveDistanceMaps();
+  if (!outputNode)
+    {
+    vtkErrorMacro("ComputeDistanceMaps: invalid output volume node.");
+    return false;
+    }
+
+  vtkMRMLScalarVolumeNode* labelMapNodes[vtkLiverDistanceMapEngine::NumberOfStructures] =
+    {tumorNode, parenchymaNode, hepaticNode, portalNode};
+  vtkMRMLScalarVolumeNode* referenceNode = nullptr;
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    vtkMRMLScalarVolumeNode* labelMapNode = labelMapNodes[structure];
+    if (!labelMapNode || !labelMapNode->GetImageData())
+      {
+      this->DistanceMapEngine->SetStructure(structure, nullptr);
+      continue;
+      }
+    this->DistanceMapEngine->SetStructure(structure, GetDistanceMapEngineLabelMap(labelMapNode));
+    referenceNode = referenceNode ? referenceNode : labelMapNode;
+    }
+
+  if (!referenceNode)
+    {
+    vtkErrorMacro("ComputeDistanceMaps: no label maps.");
+    return false;
+    }
+
+  // The label maps stay in the engine for UpdateDistanceMap
+  if (!this->DistanceMapEngine->Update())
+    {
+    this->DistanceMapEngine->RemoveAllStructures();
+    return false;
+    }
+
+  SetDistanceMapVolume(this->DistanceMapEngine, referenceNode, outputNode);
+  this->UpdateResectionProducts();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::UpdateDistanceMap(int structure,
+                                                      vtkMRMLScalarVolumeNode* labelMapNode,
+                                                      const int changedExtent[6],
+                                                      vtkMRMLScalarVolumeNode* outputNode)
+{
+  if (!labelMapNode || !labelMapNode->GetImageData() || !outputNode)
+    {
+    vtkErrorMacro("UpdateDistanceMap: invalid label map or output volume node.");
+    return false;
+    }
+
+  // The node may have new image data after the edit
+  this->DistanceMapEngine->SetStructure(structure, GetDistanceMapEngineLabelMap(labelMapNode));
+  if (!this->DistanceMapEngine->UpdateStructure(structure, changedExtent))
+    {
+    return false;
+    }
+
+  SetDistanceMapVolume(this->DistanceMapEngine, labelMapNode, outputNode);
+  this->UpdateResectionProducts();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+vtkLiverMeshDistanceMapEngine* vtkSlicerLiverResectionsLogic::GetMeshDistanceMapEngine() const
+{
+  return this->MeshDistanceMapEngine;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::ComputeMeshDistanceMaps(vtkPolyData* tumorSurface,
+                                                            vtkPolyData* parenchymaSurface,
+                                                            vtkPolyData* hepaticSurface,
+                                                            vtkPolyData* portalSurface,
+                                                            vtkMRMLScalarVolumeNode* referenceNode,
+                                                            const double spacing[3],
+                                                            vtkMRMLScalarVolumeNode* outputNode)
+{
+  // The next levels of a running progressive computation would replace the
+  // output
+  this->CancelProgressiveDistanceMaps();
+  if (!referenceNode || !referenceNode->GetImageData() || !outputNode)
+    {
+    vtkErrorMacro("ComputeMeshDistanceMaps: invalid reference or output volume node.");
+    return false;
+    }
+
+  // The grid follows the IJK axes of the reference volume from its first
+  // voxel, with the requested spacing, over the same region. The surfaces
+  // move rigidly into the frame of the grid, so distances stay in mm.
+  vtkNew<vtkMatrix4x4> gridToRAS;
+  double directions[3][3];
+  referenceNode->GetIJKToRASDirections(directions);
+  const double* origin = referenceNode->GetOrigin();
+  const double* referenceSpacing = referenceNode->GetSpacing();
+  int referenceDimensions[3];
+  referenceNode->GetImageData()->GetDimensions(referenceDimensions);
+  double gridSpacing[3];
+  int gridDimensions[3];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      gridToRAS->SetElement(i, axis, directions[i][axis]);
+      }
+    gridToRAS->SetElement(axis, 3, origin[axis]);
+    gridSpacing[axis] = spacing && spacing[axis] > 0.0 ? spacing[axis] : referenceSpacing[axis];
+    gridDimensions[axis] = static_cast<int>(std::floor((referenceDimensions[axis] - 1) * referenceSpacing[axis]
+                                                       / gridSpacing[axis] + 1e-6)) + 1;
+    }
+  vtkNew<vtkTransform> rasToGrid;
+  rasToGrid->SetMatrix(gridToRAS);
+  rasToGrid->Inverse();
+
+  vtkPolyData* surfaces[vtkLiverDistanceMapEngine::NumberOfStructures] =
+    {tumorSurface, parenchymaSurface, hepaticSurface, portalSurface};
+  bool hasSurface = false;
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    vtkPolyData* surface = surfaces[structure];
+    if (!surface || !surface->GetPoints())
+      {
+      this->MeshDistanceMapEngine->SetStructure(structure, nullptr);
+      continue;
+      }
+    auto gridSurface = vtkSmartPointer<vtkPolyData>::New();
+    gridSurface->ShallowCopy(surface);
+    vtkNew<vtkPoints> points;
+    points->SetDataTypeToDouble();
+    rasToGrid->TransformPoints(surface->GetPoints(), points);
+    gridSurface->SetPoints(points);
+    this->MeshDistanceMapEngine->SetStructure(structure, gridSurface);
+    hasSurface = true;
+    }
+
+  if (!hasSurface)
+    {
+    vtkErrorMacro("ComputeMeshDistanceMaps: no surfaces.");
+    return false;
+    }
+
+  this->MeshDistanceMapEngine->SetOutputOrigin(0.0, 0.0, 0.0);
+  this->MeshDistanceMapEngine->SetOutputSpacing(gridSpacing);
+  this->MeshDistanceMapEngine->SetOutputDimensions(gridDimensions);
+  const bool computed = this->MeshDistanceMapEngine->Update();
+  // The engine does not keep the transformed surfaces around
+  this->MeshDistanceMapEngine->RemoveAllStructures();
+  if (!computed)
+    {
+    return false;
+    }
+
+  vtkNew<vtkMatrix4x4> indexToGrid;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    indexToGrid->SetElement(axis, axis, gridSpacing[axis]);
+    }
+  vtkNew<vtkMatrix4x4> indexToRAS;
+  vtkMatrix4x4::Multiply4x4(gridToRAS, indexToGrid, indexToRAS);
+  SetDistanceMapVolume(this->MeshDistanceMapEngine->GetOutput(), indexToRAS,
+                       this->MeshDistanceMapEngine->GetOutputScale(),
+                       this->MeshDistanceMapEngine->GetOutputOffset(), outputNode);
+  this->UpdateResectionProducts();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+vtkLiverProgressiveDistanceMapEngine* vtkSlicerLiverResectionsLogic::GetProgressiveDistanceMapEngine() const
+{
+  return this->ProgressiveDistanceMapEngine;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::StartProgressiveDistanceMaps(vtkMRMLScalarVolumeNode* tumorNode,
+                                                                 vtkMRMLScalarVolumeNode* parenchymaNode,
+                                                                 vtkMRMLScalarVolumeNode* hepaticNode,
+                                                                 vtkMRMLScalarVolumeNode* portalNode,
+                                                                 vtkMRMLScalarVolumeNode* outputNode)
+{
+  this->CancelProgressiveDistanceMaps();
+  if (!outputNode)
+    {
+    vtkErrorMacro("StartProgressiveDistanceMaps: invalid output volume node.");
+    return false;
+    }
+
+  vtkMRMLScalarVolumeNode* labelMapNodes[vtkLiverDistanceMapEngine::NumberOfStructures] =
+    {tumorNode, parenchymaNode, hepaticNode, portalNode};
+  vtkMRMLScalarVolumeNode* referenceNode = nullptr;
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    vtkMRMLScalarVolumeNode* labelMapNode = labelMapNodes[structure];
+    if (!labelMapNode || !labelMapNode->GetImageData())
+      {
+      this->DistanceMapEngine->SetStructure(structure, nullptr);
+      continue;
+      }
+    this->DistanceMapEngine->SetStructure(structure, GetDistanceMapEngineLabelMap(labelMapNode));
+    this->ProgressiveInputNodes[structure] = labelMapNode;
+    this->ProgressiveInputImages[structure] = labelMapNode->GetImageData();
+    this->ProgressiveInputTimes[structure] = labelMapNode->GetImageData()->GetMTime();
+    referenceNode = referenceNode ? referenceNode : labelMapNode;
+    }
+
+  if (!referenceNode)
+    {
+    vtkErrorMacro("StartProgressiveDistanceMaps: no label maps.");
+    return false;
+    }
+
+  // The progressive engine computes from its own copies of the label maps,
+  // and gives them back with the last level
+  const bool started = this->ProgressiveDistanceMapEngine->Start(this->DistanceMapEngine);
+  this->DistanceMapEngine->RemoveAllStructures();
+  if (!started)
+    {
+    return false;
+    }
+
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  referenceNode->GetIJKToRASMatrix(ijkToRAS);
+  vtkMatrix4x4::DeepCopy(this->ProgressiveIJKToRAS, ijkToRAS);
+  this->ProgressiveOutputNode = outputNode;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int vtkSlicerLiverResectionsLogic::ProcessProgressiveDistanceMaps()
+{
+  if (!this->ProgressiveDistanceMapEngine->IsRunning())
+    {
+    return -1;
+    }
+
+  // Levels of outdated inputs are not published
+  bool inputsChanged = !this->ProgressiveOutputNode;
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    if (this->ProgressiveInputTimes[structure] == 0)
+      {
+      continue;
+      }
+    vtkMRMLScalarVolumeNode* labelMapNode = this->ProgressiveInputNodes[structure];
+    vtkImageData* labelMap = this->ProgressiveInputImages[structure];
+    inputsChanged = inputsChanged || !labelMapNode || !labelMap || labelMapNode->GetImageData() != labelMap
+      || labelMap->GetMTime() != this->ProgressiveInputTimes[structure];
+    }
+  if (inputsChanged)
+    {
+    this->CancelProgressiveDistanceMaps();
+    return -1;
+    }
+
+  if (!this->ProgressiveDistanceMapEngine->FetchLevel())
+    {
+    return -1;
+    }
+
+  vtkNew<vtkMatrix4x4> indexToRAS;
+  indexToRAS->DeepCopy(this->ProgressiveIJKToRAS);
+  vtkNew<vtkMatrix4x4> outputToInput;
+  this->ProgressiveDistanceMapEngine->GetOutputIndexToInputIndex(outputToInput);
+  vtkMatrix4x4::Multiply4x4(indexToRAS, outputToInput, indexToRAS);
+  SetDistanceMapVolume(this->ProgressiveDistanceMapEngine->GetOutput(), indexToRAS,
+                       this->ProgressiveDistanceMapEngine->GetOutputScale(),
+                       this->ProgressiveDistanceMapEngine->GetOutputOffset(), this->ProgressiveOutputNode);
+
+  // The last level leaves its label maps and state in the distance map
+  // engine, for UpdateDistanceMap
+  this->ProgressiveDistanceMapEngine->CopyLastLevelEngine(this->DistanceMapEngine);
+  this->UpdateResectionProducts();
+  return this->ProgressiveDistanceMapEngine->GetFetchedLevel();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::IsProgressiveDistanceMapsRunning() const
+{
+  return this->ProgressiveDistanceMapEngine->IsRunning();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::CancelProgressiveDistanceMaps()
+{
+  this->ProgressiveDistanceMapEngine->Cancel();
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    this->ProgressiveInputNodes[structure] = nullptr;
+    this->ProgressiveInputImages[structure] = nullptr;
+    this->ProgressiveInputTimes[structure] = 0;
+    }
+  this->ProgressiveOutputNode = nullptr;
+}
+
 //------------------------------------------------------------------------------
 vtkMRMLMarkupsNode* vtkSlicerLiverResectionsLogic::AddInitializationMarkupsNode(vtkMRMLLiverResectionNode* resectionNode) const
 {
@@ -899,14 +1634,11 @@ void vtkSlicerLiverResectionsLogic::CreateInitializationAndResectionMarkups(vtkM
   // Create the relevant initialization node
   vtkMRMLMarkupsNode *initializationMarkupsNode = this->AddInitializationMarkupsNode(resectionNode);
 
-  // Register the resection-initialization association
-  this->ResectionToInitializationMap[resectionNode] = initializationMarkupsNode;
-  this->InitializationToResectionMap[initializationMarkupsNode] = resectionNode;
-
   // Create the associated bezier surface
   vtkMRMLMarkupsBezierSurfaceNode* markupsBezierNode = this->AddBezierSurface(resectionNode);
-  this->ResectionToBezierMap[resectionNode] = markupsBezierNode;
-  this->BezierToResectionMap[markupsBezierNode] = resectionNode;
+
+  // Register the resection with its initialization and bezier surface
+  this->ResectionRegistry->AddResection(resectionNode, initializationMarkupsNode, markupsBezierNode);
 
   //Add callbacks dealing with the coordination of the resection representation,
   //this is, whether the resection is visualized as contour, contour + bezier or
@@ -914,13 +1646,11 @@ void vtkSlicerLiverResectionsLogic::CreateInitializationAndResectionMarkups(vtkM
   vtkNew<vtkIntArray> nodeEvents;
   nodeEvents->InsertNextValue(vtkCommand::StartInteractionEvent);
   nodeEvents->InsertNextValue(vtkCommand::EndInteractionEvent);
+  nodeEvents->InsertNextValue(vtkMRMLMarkupsNode::PointModifiedEvent);
   vtkUnObserveMRMLNodeMacro(markupsBezierNode);
   vtkUnObserveMRMLNodeMacro(initializationMarkupsNode);
   vtkObserveMRMLNodeEventsMacro(markupsBezierNode, nodeEvents.GetPointer());
   vtkObserveMRMLNodeEventsMacro(initializationMarkupsNode, nodeEvents.GetPointer());
-
-  this->InitializationToBezierMap[initializationMarkupsNode] = markupsBezierNode;
-  this->BezierToInitializationMap[markupsBezierNode] = initializationMarkupsNode;
 }
 
 //------------------------------------------------------------------------------
@@ -950,6 +1680,10 @@ char* vtkSlicerLiverResectionsLogic::LoadLiverResection(const std::string& fileN
     {
     return this->LoadLiverResectionFromFcsv(fileName, nodeName, userMessages);
     }
+  else if (extension == std::string(".lrpb"))
+    {
+    return this->LoadLiverResectionFromBinary(fileName, nodeName, userMessages);
+    }
   else
     {
     vtkErrorMacro("vtkSlicerLiverResectionsLogic::LoadResections failed: unrecognized file extension in " << fileName);
@@ -962,81 +1696,225 @@ char *vtkSlicerLiverResectionsLogic::LoadLiverResectionFromFcsv(const std::strin
                                                                  const std::string &nodeName /*=nullptr*/,
                                                                  vtkMRMLMessageCollection *userMessages /*=nullptr*/)
 {
+  return this->LoadLiverResectionWithStorageNode(fileName, nodeName,
+                                                 "vtkMRMLLiverResectionCSVStorageNode", userMessages);
+}
 
-  if (fileName == "") {
-    vtkErrorMacro(
-        "LoadLiverResections: null file or markups class name, cannot load");
-    return nullptr;
-  }
+//---------------------------------------------------------------------------
+char *vtkSlicerLiverResectionsLogic::LoadLiverResectionFromBinary(const std::string &fileName,
+                                                                   const std::string &nodeName /*=nullptr*/,
+                                                                   vtkMRMLMessageCollection *userMessages /*=nullptr*/)
+{
+  return this->LoadLiverResectionWithStorageNode(fileName, nodeName,
+                                                 "vtkMRMLLiverResectionBinaryStorageNode", userMessages);
+}
 
-  vtkDebugMacro("LoadLiverResections, file name = "
-                << fileName << ", nodeName = " << nodeName);
-  // make a storage node and fiducial node and set the file name
-  auto storageNode =
-      vtkMRMLStorageNode::SafeDownCast(this->GetMRMLScene()->AddNewNodeByClass(
-          "vtkMRMLLiverResectionCSVStorageNode"));
-  if (!storageNode) {
+//---------------------------------------------------------------------------
+vtkMRMLLiverResectionNode* vtkSlicerLiverResectionsLogic::AddLoadedResectionNodes(const std::string& fileName,
+                                                                                 const std::string& nodeName,
+                                                                                 const char* storageNodeClassName)
+{
+  auto scene = this->GetMRMLScene();
+  auto storageNode = vtkMRMLStorageNode::SafeDownCast(scene->AddNewNodeByClass(storageNodeClassName));
+  if (!storageNode)
+    {
     vtkErrorMacro("LoadLiverResections: failed to instantiate markups storage "
-                  "node by class vtkMRMLLiverResectionsFiducialNode");
+                  "node by class " << storageNodeClassName);
     return nullptr;
-  }
-
-  std::string newNodeName;
-  if (nodeName.length() > 0) {
-    newNodeName = nodeName;
-  } else {
-    newNodeName = this->GetMRMLScene()->GetUniqueNameByString(
-        storageNode->GetFileNameWithoutExtension(fileName.c_str()).c_str());
-  }
-  auto bezierNode = vtkMRMLMarkupsBezierSurfaceNode::SafeDownCast(
-      this->GetMRMLScene()->AddNewNodeByClass(
-          "vtkMRMLMarkupsBezierSurfaceNode"));
-  if (!bezierNode) {
-    vtkErrorMacro(
-        "LoadLiverResections: failed to instantiate markups bezier node by "
-        "class vtkMRMLLiverResectionFiducialNode");
-    if (userMessages) {
-      userMessages->AddMessages(storageNode->GetUserMessages());
     }
-  }
-  bezierNode->SetHideFromEditors(true);
 
-  auto markupsNode = vtkMRMLLiverResectionNode::SafeDownCast(
-      this->GetMRMLScene()->AddNewNodeByClass("vtkMRMLLiverResectionNode",
-                                              newNodeName));
-  if (!markupsNode) {
+  std::string newNodeName = nodeName;
+  if (newNodeName.empty())
+    {
+    newNodeName = scene->GetUniqueNameByString(
+      storageNode->GetFileNameWithoutExtension(fileName.c_str()).c_str());
+    }
+  auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLLiverResectionNode", newNodeName));
+  if (!resectionNode)
+    {
     vtkErrorMacro("LoadLiverResections: failed to instantiate liver "
                   "resection markups node by "
                   "class vtkMRMLLiverResectionsNode");
-    if (userMessages) {
-      userMessages->AddMessages(storageNode->GetUserMessages());
+    scene->RemoveNode(storageNode);
+    return nullptr;
+    }
+
+  // The resection elements are created here, also during batch processing
+  if (!this->ResectionRegistry->Contains(resectionNode))
+    {
+    this->CreateInitializationAndResectionMarkups(resectionNode);
+    }
+  if (!resectionNode->GetBezierSurfaceNode())
+    {
+    vtkErrorMacro("LoadLiverResections: failed to instantiate the bezier surface of " << fileName);
+    scene->RemoveNode(storageNode);
+    scene->RemoveNode(resectionNode);
+    return nullptr;
     }
-    this->GetMRMLScene()->RemoveNode(storageNode);
+
+  storageNode->SetFileName(fileName.c_str());
+  resectionNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  return resectionNode;
+}
+
+//---------------------------------------------------------------------------
+char *vtkSlicerLiverResectionsLogic::LoadLiverResectionWithStorageNode(const std::string &fileName,
+                                                                        const std::string &nodeName,
+                                                                        const char *storageNodeClassName,
+                                                                        vtkMRMLMessageCollection *userMessages)
+{
+  if (fileName == "" || !this->GetMRMLScene())
+    {
+    vtkErrorMacro("LoadLiverResections: null file or markups class name, cannot load");
     return nullptr;
     }
 
-    markupsNode->SetBezierSurfaceNode(bezierNode);
+  vtkDebugMacro("LoadLiverResections, file name = "
+                << fileName << ", nodeName = " << nodeName);
+
+  auto resectionNode = this->AddLoadedResectionNodes(fileName, nodeName, storageNodeClassName);
+  if (!resectionNode)
+    {
+    return nullptr;
+    }
 
-    storageNode->SetFileName(fileName.c_str());
-    // add the nodes to the scene and set up the observation on the storage node
-    markupsNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  // read the file
+  auto storageNode = resectionNode->GetStorageNode();
+  if (storageNode->ReadData(resectionNode))
+    {
+    this->EditHistory->RemoveNode(resectionNode->GetBezierSurfaceNode());
 
-    // read the file
-    char *nodeID = nullptr;
-    if (storageNode->ReadData(markupsNode))
+    // The tessellation stored with the resection is used as long as the
+    // control points do not change
+    auto binaryStorageNode = vtkMRMLLiverResectionBinaryStorageNode::SafeDownCast(storageNode);
+    vtkPolyData* tessellation = binaryStorageNode ? binaryStorageNode->GetTessellation() : nullptr;
+    if (tessellation && tessellation->GetNumberOfPoints() ==
+        static_cast<vtkIdType>(this->TessellationResolution) * this->TessellationResolution)
       {
-      nodeID = markupsNode->GetID();
+      this->ResectionTessellations[resectionNode->GetID()] = tessellation;
+      this->DependencyGraph->SetProductUpToDate(resectionNode, vtkLiverResectionDependencyGraph::TessellationProduct);
       }
-    else
+    return resectionNode->GetID();
+    }
+
+  if (userMessages)
+    {
+    userMessages->AddMessages(storageNode->GetUserMessages());
+    }
+  this->GetMRMLScene()->RemoveNode(storageNode);
+  this->GetMRMLScene()->RemoveNode(resectionNode);
+  return nullptr;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerLiverResectionsLogic::LoadLiverResections(vtkStringArray* fileNames,
+                                                       vtkStringArray* loadedNodeIDs /*=nullptr*/,
+                                                       vtkMRMLMessageCollection* userMessages /*=nullptr*/)
+{
+  auto scene = this->GetMRMLScene();
+  if (!scene)
+    {
+    vtkErrorMacro("LoadLiverResections: no valid MRML scene.");
+    return 0;
+    }
+
+  if (!fileNames || fileNames->GetNumberOfValues() == 0)
+    {
+    return 0;
+    }
+
+  // Parse the fcsv files in parallel with the CSV storage node reader, into
+  // nodes that are not in the scene
+  struct ParsedPlan
+  {
+    std::string FileName;
+    bool Fcsv = false;
+    bool Parsed = false;
+    vtkSmartPointer<vtkMRMLLiverResectionCSVStorageNode> StorageNode;
+    vtkSmartPointer<vtkMRMLLiverResectionNode> ResectionNode;
+    vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode> BezierSurfaceNode;
+  };
+  std::vector<ParsedPlan> plans(fileNames->GetNumberOfValues());
+  for (vtkIdType i = 0; i < fileNames->GetNumberOfValues(); ++i)
+    {
+    ParsedPlan& plan = plans[i];
+    plan.FileName = fileNames->GetValue(i);
+    plan.Fcsv = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(plan.FileName) == ".fcsv";
+    if (plan.Fcsv)
+      {
+      plan.StorageNode = vtkSmartPointer<vtkMRMLLiverResectionCSVStorageNode>::New();
+      plan.StorageNode->SetFileName(plan.FileName.c_str());
+      plan.ResectionNode = vtkSmartPointer<vtkMRMLLiverResectionNode>::New();
+      plan.BezierSurfaceNode = vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode>::New();
+      plan.ResectionNode->SetBezierSurfaceNode(plan.BezierSurfaceNode);
+      }
+    }
+  vtkSMPTools::For(0, static_cast<vtkIdType>(plans.size()),
+    [&plans](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType i = begin; i < end; ++i)
+      {
+      ParsedPlan& plan = plans[i];
+      plan.Parsed = plan.Fcsv && plan.StorageNode->ReadData(plan.ResectionNode) &&
+                    plan.BezierSurfaceNode->GetNumberOfControlPoints() == 16;
+      }
+    });
+
+  // Create all the nodes in a single scene transaction, with the same setup
+  // as a single resection plan
+  std::vector<vtkMRMLLiverResectionNode*> loadedResections;
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+
+  for (const ParsedPlan& plan : plans)
+    {
+    if (!plan.Fcsv)
       {
+      char* nodeID = this->LoadLiverResection(plan.FileName, std::string(), userMessages);
+      auto resectionNode = nodeID ? vtkMRMLLiverResectionNode::SafeDownCast(scene->GetNodeByID(nodeID)) : nullptr;
+      if (resectionNode)
+        {
+        loadedResections.push_back(resectionNode);
+        }
+      continue;
+      }
+
+    if (!plan.Parsed)
+      {
+      std::string message = "LoadLiverResections: failed to read " + plan.FileName +
+        ": expected 16 bezier surface control points";
+      vtkErrorMacro(<< message);
       if (userMessages)
         {
-        userMessages->AddMessages(storageNode->GetUserMessages());
+        userMessages->AddMessages(plan.StorageNode->GetUserMessages());
+        userMessages->AddMessage(vtkCommand::ErrorEvent, message);
         }
-      this->GetMRMLScene()->RemoveNode(storageNode);
-      this->GetMRMLScene()->RemoveNode(markupsNode);
+      continue;
+      }
+
+    auto resectionNode = this->AddLoadedResectionNodes(plan.FileName, std::string(),
+                                                       "vtkMRMLLiverResectionCSVStorageNode");
+    if (!resectionNode)
+      {
+      continue;
+      }
+
+    vtkNew<vtkPoints> controlPoints;
+    plan.BezierSurfaceNode->GetControlPointPositionsWorld(controlPoints);
+    resectionNode->GetBezierSurfaceNode()->SetControlPointPositionsWorld(controlPoints);
+    this->EditHistory->RemoveNode(resectionNode->GetBezierSurfaceNode());
+    loadedResections.push_back(resectionNode);
     }
 
-    return nodeID;
-  }
+  for (auto resectionNode : loadedResections)
+    {
+    if (loadedNodeIDs)
+      {
+      loadedNodeIDs->InsertNextValue(resectionNode->GetID());
+      }
+    }
+
+  scene->EndState(vtkMRMLScene::BatchProcessState);
 
+  return static_cast<int>(loadedResections.size());
+}
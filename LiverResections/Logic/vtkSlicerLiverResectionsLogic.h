@@ -46,6 +46,7 @@
 #include <vtkSlicerModuleLogic.h>
 
 // VTK includes
+#include <vtkCommand.h>
 #include <vtkWeakPointer.h>
 #include <vtkSmartPointer.h>
 #include <vtkMRMLMessageCollection.h>
@@ -66,6 +67,17 @@ class vtkMRMLMarkupsSlicingContourNode;
 class vtkMRMLMarkupsBezierSurfaceNode;
 class vtkMRMLMarkupsFiducialNode;
 class vtkBezierSurfaceSource;
+class vtkMRMLModelNode;
+class vtkImageData;
+class vtkLiverDistanceMapEngine;
+class vtkLiverMeshDistanceMapEngine;
+class vtkLiverProgressiveDistanceMapEngine;
+class vtkLiverResectionDependencyGraph;
+class vtkLiverResectionEditHistory;
+class vtkLiverResectionRegistry;
+class vtkParenchymaSlicingIndex;
+class vtkPoints;
+class vtkStringArray;
 
 //------------------------------------------------------------------------------
 class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkSlicerLiverResectionsLogic:
@@ -110,9 +122,167 @@ public:
   char* LoadLiverResectionFromFcsv(const std::string& fileName,
                                    const std::string& nodeName/*=nullptr*/,
                                    vtkMRMLMessageCollection* userMessages/*=nullptr*/);
+
+  /// Load a resection plan stored in the binary format (.lrpb)
+  char* LoadLiverResectionFromBinary(const std::string& fileName,
+                                     const std::string& nodeName/*=nullptr*/,
+                                     vtkMRMLMessageCollection* userMessages/*=nullptr*/);
+
+  /// Load several resection plans at once. The fcsv files are parsed in
+  /// parallel by the CSV storage node reader and all the nodes are created in
+  /// a single batch process of the scene. The IDs of the loaded resection nodes are appended to
+  /// loadedNodeIDs (optional). Returns the number of loaded resections.
+  int LoadLiverResections(vtkStringArray* fileNames,
+                          vtkStringArray* loadedNodeIDs = nullptr,
+                          vtkMRMLMessageCollection* userMessages = nullptr);
   /// This function returns a bezier surface node from a provided resection node
   vtkMRMLMarkupsBezierSurfaceNode* GetBezierFromResection(vtkMRMLLiverResectionNode* resectionNode) const;
 
+  /// Registry of the resections managed by the logic and their markups
+  vtkLiverResectionRegistry* GetResectionRegistry() const;
+
+  /// Staleness of the data derived from each resection (tessellation,
+  /// textures) with respect to its inputs. The logic updates the derived data
+  /// through it after bezier surface edits, resection changes and distance
+  /// map updates.
+  vtkLiverResectionDependencyGraph* GetDependencyGraph() const;
+
+  /// Undo/redo history of the bezier surface edits, recorded at the end of
+  /// each interaction
+  vtkLiverResectionEditHistory* GetEditHistory() const;
+
+  /// Undo/redo the last bezier surface edit of a resection. Return false if
+  /// there is no edit to undo/redo.
+  bool UndoResectionEdit(vtkMRMLLiverResectionNode* resectionNode);
+  bool RedoResectionEdit(vtkMRMLLiverResectionNode* resectionNode);
+
+  /// Tessellation of the bezier surface of a resection, with
+  /// TessellationResolution x TessellationResolution points. It is
+  /// recomputed through the dependency graph when the control points changed,
+  /// and taken from the file when the resection is loaded from a binary file
+  /// that contains it. The binary storage node of the resection gets the
+  /// recomputed tessellations, to write them along with the resection.
+  vtkPolyData* GetResectionTessellation(vtkMRMLLiverResectionNode* resectionNode);
+
+  /// Resolution of the resection tessellations (default 20, as the 3D
+  /// representation of the bezier surface)
+  void SetTessellationResolution(int resolution);
+  vtkGetMacro(TessellationResolution, int);
+
+  /// Returns the (cached) slicing index of a target organ model, up to date
+  /// with its current poly data
+  vtkParenchymaSlicingIndex* GetParenchymaSlicingIndex(vtkMRMLModelNode* modelNode);
+
+  /// Fits the bezier surface of a resection to the contour of its target
+  /// organ selected by a distance contour markup (curved initialization)
+  bool InitializeCurvedResection(vtkMRMLLiverResectionNode* resectionNode,
+                                 vtkMRMLMarkupsNode* distanceContourNode);
+
+  /// Update the bezier surface continuously while the slicing contour is
+  /// dragged (default on). When off, the surface is hidden during the drag and
+  /// updated when the interaction ends.
+  vtkSetMacro(LiveInitializationPreview, bool);
+  vtkGetMacro(LiveInitializationPreview, bool);
+  vtkBooleanMacro(LiveInitializationPreview, bool);
+
+  /// Minimum time (in seconds) between two live preview updates (default 1/30 s)
+  vtkSetMacro(InitializationPreviewInterval, double);
+  vtkGetMacro(InitializationPreviewInterval, double);
+
+  /// Invoked when a resection has properties pending propagation while the
+  /// propagation is deferred, once per burst of changes
+  enum
+  {
+    PropertyPropagationRequestedEvent = vtkCommand::UserEvent + 101
+  };
+
+  /// Defer the propagation of the modified resection properties to the
+  /// markups (default off). When on, the properties modified by a burst of
+  /// resection changes (e.g. a slider drag) accumulate on the resection nodes
+  /// and PropertyPropagationRequestedEvent is invoked once. The application
+  /// then calls PropagatePendingProperties once per render or idle pass.
+  vtkSetMacro(DeferredPropertyPropagation, bool);
+  vtkGetMacro(DeferredPropertyPropagation, bool);
+  vtkBooleanMacro(DeferredPropertyPropagation, bool);
+
+  /// Propagate the pending properties of all the resections to their markups
+  void PropagatePendingProperties();
+
+  /// Compute the signed distance maps (mm, negative inside) of the tumor,
+  /// parenchyma, hepatic and portal label maps in a single multithreaded
+  /// pass. Any of the label maps can be nullptr. The output volume gets one
+  /// float component per available label map, in that order, and the
+  /// geometry of the first available label map (restricted to the
+  /// parenchyma region if the engine crops to it). Running progressive
+  /// distance maps are cancelled.
+  bool ComputeDistanceMaps(vtkMRMLScalarVolumeNode* tumorNode,
+                           vtkMRMLScalarVolumeNode* parenchymaNode,
+                           vtkMRMLScalarVolumeNode* hepaticNode,
+                           vtkMRMLScalarVolumeNode* portalNode,
+                           vtkMRMLScalarVolumeNode* outputNode);
+
+  /// Update the distance map of one structure (a
+  /// vtkLiverDistanceMapEngine::Structure) computed by the last
+  /// ComputeDistanceMaps after its label map changed within changedExtent
+  /// (IJK), e.g. after a segmentation edit. Only the voxels whose closest
+  /// boundary may have changed are recomputed. The Liver module calls it from
+  /// LiverLogic.updateDistanceMaps for the edited structures, with the
+  /// bounding box of their voxels before and after the edit.
+  bool UpdateDistanceMap(int structure,
+                         vtkMRMLScalarVolumeNode* labelMapNode,
+                         const int changedExtent[6],
+                         vtkMRMLScalarVolumeNode* outputNode);
+
+  /// Engine used by ComputeDistanceMaps and UpdateDistanceMap
+  vtkLiverDistanceMapEngine* GetDistanceMapEngine() const;
+
+  /// Compute the signed distance maps (mm, negative inside) of the closed
+  /// surfaces (RAS) of the tumor, parenchyma, hepatic and portal structures
+  /// from their triangles, exact at every voxel (see
+  /// vtkLiverMeshDistanceMapEngine). Any of the surfaces can be nullptr. The
+  /// output volume covers the reference volume along its IJK axes, with the
+  /// given spacing (mm; nullptr or zero components keep the spacing of the
+  /// reference volume), and gets one component per available surface, in
+  /// that order. Running progressive distance maps are cancelled.
+  bool ComputeMeshDistanceMaps(vtkPolyData* tumorSurface,
+                               vtkPolyData* parenchymaSurface,
+                               vtkPolyData* hepaticSurface,
+                               vtkPolyData* portalSurface,
+                               vtkMRMLScalarVolumeNode* referenceNode,
+                               const double spacing[3],
+                               vtkMRMLScalarVolumeNode* outputNode);
+
+  /// Engine used by ComputeMeshDistanceMaps (band width and quantization)
+  vtkLiverMeshDistanceMapEngine* GetMeshDistanceMapEngine() const;
+
+  /// Start computing the distance maps of ComputeDistanceMaps coarse to fine
+  /// in the background (see vtkLiverProgressiveDistanceMapEngine), with the
+  /// settings of the distance map engine. The levels are published to the
+  /// output volume by ProcessProgressiveDistanceMaps. Once the last level is
+  /// published, the distance map engine holds its label maps and state, so
+  /// that UpdateDistanceMap can follow as after ComputeDistanceMaps.
+  bool StartProgressiveDistanceMaps(vtkMRMLScalarVolumeNode* tumorNode,
+                                    vtkMRMLScalarVolumeNode* parenchymaNode,
+                                    vtkMRMLScalarVolumeNode* hepaticNode,
+                                    vtkMRMLScalarVolumeNode* portalNode,
+                                    vtkMRMLScalarVolumeNode* outputNode);
+
+  /// Publish the latest completed level of the progressive distance maps to
+  /// the output volume, replacing its image data at once, and return its
+  /// index (-1 if there is no new one). The computation is cancelled if an
+  /// input label map was modified or removed since the start.
+  int ProcessProgressiveDistanceMaps();
+
+  /// Whether progressive distance maps are being computed or wait to be
+  /// published
+  bool IsProgressiveDistanceMapsRunning() const;
+
+  /// Cancel the progressive distance maps (published levels are kept)
+  void CancelProgressiveDistanceMaps();
+
+  /// Engine used by StartProgressiveDistanceMaps (coarsest factor, levels)
+  vtkLiverProgressiveDistanceMapEngine* GetProgressiveDistanceMapEngine() const;
+
 protected:
   vtkSlicerLiverResectionsLogic();
   ~vtkSlicerLiverResectionsLogic() override;
@@ -121,7 +291,57 @@ protected:
   void ObserveMRMLScene() override;
   void OnMRMLSceneNodeAdded(vtkMRMLNode* node) override;
   void OnMRMLSceneNodeRemoved(vtkMRMLNode* node) override;
+  void OnMRMLSceneEndBatchProcess() override;
   void UpdateBezierWidgetOnInitialization(vtkMRMLMarkupsNode* initializationNode);
+
+  /// Propagate the properties of a resection modified since its last update
+  /// to its initialization and bezier surface markups
+  void UpdateMarkupsFromResection(vtkMRMLLiverResectionNode* resectionNode);
+
+  /// Recompute the tessellation of a resection (update function of the
+  /// tessellation product of the dependency graph)
+  void UpdateResectionTessellation(vtkMRMLLiverResectionNode* resectionNode);
+
+  /// Transfer again the textures of the distance map and vascular segments
+  /// of a resection to its bezier surface (update function of the texture
+  /// product of the dependency graph)
+  void UpdateResectionTextures(vtkMRMLLiverResectionNode* resectionNode);
+
+  /// Update the stale derived data of all the resections, e.g. after
+  /// publishing a distance map
+  void UpdateResectionProducts();
+
+  /// Add a resection node loaded from fileName (named nodeName, or after the
+  /// file when empty) with a storage node of the given class, and set up its
+  /// initialization and bezier surface markups as for any new resection.
+  /// Shared by the single and multiple file loading.
+  vtkMRMLLiverResectionNode* AddLoadedResectionNodes(const std::string& fileName,
+                                                     const std::string& nodeName,
+                                                     const char* storageNodeClassName);
+
+  /// Create a resection node (and its markups) and read it from fileName with
+  /// a storage node of the given class
+  char* LoadLiverResectionWithStorageNode(const std::string& fileName,
+                                          const std::string& nodeName,
+                                          const char* storageNodeClassName,
+                                          vtkMRMLMessageCollection* userMessages);
+
+  /// Control points of a planar surface along the principal axes of the
+  /// contour of the parenchyma cut by the slicing contour plane. uAxis and
+  /// vAxis (optional) orient the axes of the grid.
+  bool ComputeFlatInitialization(vtkMRMLMarkupsNode* initializationNode,
+                                 vtkParenchymaSlicingIndex* slicingIndex,
+                                 const double* uAxis,
+                                 const double* vAxis,
+                                 vtkPoints* controlPoints) const;
+
+  /// Control points of a bicubic surface fitted to the contour of the
+  /// parenchyma selected by the distance contour
+  bool ComputeCurvedInitialization(vtkMRMLMarkupsNode* initializationNode,
+                                   vtkParenchymaSlicingIndex* slicingIndex,
+                                   const double* uAxis,
+                                   const double* vAxis,
+                                   vtkPoints* controlPoints) const;
   void CreateInitializationAndResectionMarkups(vtkMRMLLiverResectionNode* resectionNode);
 
   /// This function returns a bezier surface node from a provided resection node
@@ -150,25 +370,47 @@ protected:
 
 protected:
 
-  /// TODO: Too many maps here. We should try to improve the design to avoid this.
+  /// Resections and their initialization and bezier surface nodes
+  vtkSmartPointer<vtkLiverResectionRegistry> ResectionRegistry;
+
+  /// Input stamps of the data derived from the resections
+  vtkSmartPointer<vtkLiverResectionDependencyGraph> DependencyGraph;
+
+  /// Control point edits of the bezier surfaces
+  vtkSmartPointer<vtkLiverResectionEditHistory> EditHistory;
+
+  /// Signed distance maps of the liver structures
+  vtkSmartPointer<vtkLiverDistanceMapEngine> DistanceMapEngine;
 
-  std::map<vtkSmartPointer<vtkMRMLLiverResectionNode>,
-           vtkSmartPointer<vtkMRMLMarkupsNode>> ResectionToInitializationMap;
+  /// Signed distance maps of the surfaces of the liver structures
+  vtkSmartPointer<vtkLiverMeshDistanceMapEngine> MeshDistanceMapEngine;
 
-  std::map<vtkSmartPointer<vtkMRMLMarkupsNode>,
-           vtkSmartPointer<vtkMRMLLiverResectionNode>> InitializationToResectionMap;
+  /// Progressive distance maps, with the inputs they are computed from (one
+  /// per vtkLiverDistanceMapEngine::Structure) and their modification times
+  /// (0 for missing structures)
+  vtkSmartPointer<vtkLiverProgressiveDistanceMapEngine> ProgressiveDistanceMapEngine;
+  vtkWeakPointer<vtkMRMLScalarVolumeNode> ProgressiveInputNodes[4];
+  vtkWeakPointer<vtkImageData> ProgressiveInputImages[4];
+  vtkMTimeType ProgressiveInputTimes[4];
+  vtkWeakPointer<vtkMRMLScalarVolumeNode> ProgressiveOutputNode;
+  double ProgressiveIJKToRAS[16];
 
-  std::map<vtkSmartPointer<vtkMRMLLiverResectionNode>,
-           vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode>> ResectionToBezierMap;
+  /// Tessellations of the bezier surfaces, by resection node ID
+  int TessellationResolution;
+  std::map<std::string, vtkSmartPointer<vtkPolyData>> ResectionTessellations;
 
-  std::map<vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode>,
-           vtkSmartPointer<vtkMRMLLiverResectionNode>> BezierToResectionMap;
+  /// Slicing indices of the target organs, by model node ID
+  std::map<std::string, vtkSmartPointer<vtkParenchymaSlicingIndex>> ParenchymaSlicingIndices;
 
-  std::map<vtkWeakPointer<vtkMRMLMarkupsNode>,
-           vtkWeakPointer<vtkMRMLMarkupsBezierSurfaceNode>> InitializationToBezierMap;
+  /// Deferred property propagation
+  bool DeferredPropertyPropagation;
+  bool PropertyPropagationPending;
 
-  std::map<vtkWeakPointer<vtkMRMLMarkupsBezierSurfaceNode>,
-           vtkWeakPointer<vtkMRMLMarkupsNode>> BezierToInitializationMap;
+  /// Live preview of the initialization
+  bool LiveInitializationPreview;
+  double InitializationPreviewInterval;
+  double LastInitializationPreviewTime;
+  vtkWeakPointer<vtkMRMLMarkupsNode> PreviewInitializationNode;
 
 private:
   vtkSlicerLiverResectionsLogic(const vtkSlicerLiverResectionsLogic &) = delete;
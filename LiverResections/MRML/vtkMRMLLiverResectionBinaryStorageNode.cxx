@@ -0,0 +1,601 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkMRMLLiverResectionBinaryStorageNode.h"
+#include "vtkMRMLLiverResectionNode.h"
+#include "vtkMRMLMarkupsBezierSurfaceNode.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkStringArray.h>
+#include <vtkTypeInt64Array.h>
+#include <vtkVector.h>
+
+// STD includes
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <vtksys/Encoding.hxx>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+//------------------------------------------------------------------------------
+const char FileMagic[8] = {'L', 'I', 'V', 'E', 'R', 'R', 'P', 'B'};
+const uint32_t ByteOrderMark = 0x01020304;
+
+//------------------------------------------------------------------------------
+struct FileHeader
+{
+  char Magic[8];
+  uint32_t ByteOrder;
+  uint32_t Version;
+  uint64_t PayloadSize;
+  uint64_t Checksum; // 64-bit FNV-1a of the payload
+  uint32_t NumberOfControlPoints;
+  uint32_t NumberOfInitializationPoints;
+  uint64_t NumberOfTessellationPoints;
+  uint64_t NumberOfTessellationCells;
+  uint64_t TessellationConnectivitySize;
+};
+static_assert(sizeof(FileHeader) == 64, "unexpected binary resection header size");
+
+//------------------------------------------------------------------------------
+struct ResectionProperties
+{
+  double ResectionMargin;
+  double UncertaintyMargin;
+  double HepaticContourThickness;
+  double PortalContourThickness;
+  float ResectionColor[3];
+  float ResectionGridColor[3];
+  float ResectionMarginColor[3];
+  float UncertaintyMarginColor[3];
+  float HepaticContourColor[3];
+  float PortalContourColor[3];
+  float ResectionOpacity;
+  float GridDivisions;
+  float GridThickness;
+  int32_t TextureNumComps;
+  int32_t State;
+  int32_t InitMode;
+  uint8_t ClipOut;
+  uint8_t WidgetVisibility;
+  uint8_t InterpolatedMargins;
+  uint8_t GridVisibility;
+  uint8_t Grid3DVisibility;
+  uint8_t Grid2DVisibility;
+  uint8_t ShowResection2D;
+  uint8_t MirrorDisplay;
+  uint8_t EnableFlexibleBoundary;
+  uint8_t Padding[7];
+};
+static_assert(sizeof(ResectionProperties) == 144, "unexpected binary resection properties size");
+
+//------------------------------------------------------------------------------
+/// Offsets of the arrays in the payload. Every array starts 8-byte aligned.
+struct PayloadLayout
+{
+  explicit PayloadLayout(const FileHeader& header)
+  {
+    const uint64_t numberOfOffsets =
+      header.NumberOfTessellationCells > 0 ? header.NumberOfTessellationCells + 1 : 0;
+    this->ControlPoints = sizeof(ResectionProperties);
+    this->InitializationPoints = this->ControlPoints + 3 * sizeof(double) * header.NumberOfControlPoints;
+    this->TessellationPoints = this->InitializationPoints + 3 * sizeof(double) * header.NumberOfInitializationPoints;
+    this->TessellationOffsets = (this->TessellationPoints + 3 * sizeof(float) * header.NumberOfTessellationPoints + 7) & ~uint64_t(7);
+    this->TessellationConnectivity = this->TessellationOffsets + sizeof(int64_t) * numberOfOffsets;
+    this->Size = this->TessellationConnectivity + sizeof(int64_t) * header.TessellationConnectivitySize;
+  }
+
+  uint64_t ControlPoints;
+  uint64_t InitializationPoints;
+  uint64_t TessellationPoints;
+  uint64_t TessellationOffsets;
+  uint64_t TessellationConnectivity;
+  uint64_t Size;
+};
+
+//------------------------------------------------------------------------------
+uint64_t ComputeChecksum(const unsigned char* data, uint64_t size)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint64_t i = 0; i < size; ++i)
+    {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+    }
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+/// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string& fileName)
+  {
+#ifdef _WIN32
+    this->File = CreateFileW(vtksys::Encoding::ToWide(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (this->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->File, &size) || size.QuadPart == 0)
+      {
+      return;
+      }
+    this->Mapping = CreateFileMappingW(this->File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!this->Mapping)
+      {
+      return;
+      }
+    this->Data = MapViewOfFile(this->Mapping, FILE_MAP_READ, 0, 0, 0);
+    this->Size = this->Data ? static_cast<uint64_t>(size.QuadPart) : 0;
+#else
+    this->File = open(fileName.c_str(), O_RDONLY);
+    struct stat status;
+    if (this->File < 0 || fstat(this->File, &status) != 0 || status.st_size == 0)
+      {
+      return;
+      }
+    void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, this->File, 0);
+    if (data == MAP_FAILED)
+      {
+      return;
+      }
+    this->Data = data;
+    this->Size = static_cast<uint64_t>(status.st_size);
+#endif
+  }
+
+  ~MappedFile()
+  {
+#ifdef _WIN32
+    if (this->Data)
+      {
+      UnmapViewOfFile(this->Data);
+      }
+    if (this->Mapping)
+      {
+      CloseHandle(this->Mapping);
+      }
+    if (this->File != INVALID_HANDLE_VALUE)
+      {
+      CloseHandle(this->File);
+      }
+#else
+    if (this->Data)
+      {
+      munmap(this->Data, static_cast<size_t>(this->Size));
+      }
+    if (this->File >= 0)
+      {
+      close(this->File);
+      }
+#endif
+  }
+
+  const unsigned char* GetData() const
+  {return static_cast<const unsigned char*>(this->Data);}
+
+  uint64_t GetSize() const
+  {return this->Size;}
+
+private:
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+#ifdef _WIN32
+  HANDLE File = INVALID_HANDLE_VALUE;
+  HANDLE Mapping = nullptr;
+#else
+  int File = -1;
+#endif
+  void* Data = nullptr;
+  uint64_t Size = 0;
+};
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLNodeNewMacro(vtkMRMLLiverResectionBinaryStorageNode);
+
+//----------------------------------------------------------------------------
+vtkMRMLLiverResectionBinaryStorageNode::vtkMRMLLiverResectionBinaryStorageNode()
+{
+  this->DefaultWriteFileExtension = "lrpb";
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLLiverResectionBinaryStorageNode::~vtkMRMLLiverResectionBinaryStorageNode() = default;
+
+//----------------------------------------------------------------------------
+void vtkMRMLLiverResectionBinaryStorageNode::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os,indent);
+  os << indent << "Tessellation: " << this->Tessellation.GetPointer() << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLLiverResectionBinaryStorageNode::CanReadInReferenceNode(vtkMRMLNode *refNode)
+{
+  return refNode->IsA("vtkMRMLLiverResectionNode");
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLLiverResectionBinaryStorageNode::SetTessellation(vtkPolyData* tessellation)
+{
+  if (this->Tessellation == tessellation)
+    {
+    return;
+    }
+  this->Tessellation = tessellation;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkMRMLLiverResectionBinaryStorageNode::GetTessellation() const
+{
+  return this->Tessellation;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLLiverResectionBinaryStorageNode::InitializeSupportedReadFileTypes()
+{
+  this->SupportedReadFileTypes->InsertNextValue("Liver Resection Planning Binary (.lrpb)");
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLLiverResectionBinaryStorageNode::InitializeSupportedWriteFileTypes()
+{
+  this->SupportedWriteFileTypes->InsertNextValue("Liver Resection Planning Binary (.lrpb)");
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLLiverResectionBinaryStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
+{
+  auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(refNode);
+  if (resectionNode == nullptr)
+    {
+    vtkErrorMacro("WriteDataInternal: input node is not a vtkMRMLLiverResectionNode:" << refNode->GetID());
+    return 0;
+    }
+
+  auto bezierSurfaceNode = resectionNode->GetBezierSurfaceNode();
+  if (bezierSurfaceNode == nullptr)
+    {
+    vtkErrorMacro("WriteDataInternal: input node does not reference a valid bezier surface node" << refNode->GetID());
+    return 0;
+    }
+
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty())
+    {
+    vtkErrorMacro("WriteDataInternal: file name not specified");
+    return 0;
+    }
+
+  auto initializationPoints = const_cast<vtkPoints*>(resectionNode->GetInitializationPoints());
+
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+  header.ByteOrder = ByteOrderMark;
+  header.Version = FormatVersion;
+  header.NumberOfControlPoints = static_cast<uint32_t>(bezierSurfaceNode->GetNumberOfControlPoints());
+  header.NumberOfInitializationPoints =
+    initializationPoints ? static_cast<uint32_t>(initializationPoints->GetNumberOfPoints()) : 0;
+
+  vtkNew<vtkCellArray> tessellationCells;
+  vtkPoints* tessellationPoints = nullptr;
+  if (this->Tessellation && this->Tessellation->GetPoints() && this->Tessellation->GetNumberOfPolys() > 0)
+    {
+    tessellationPoints = this->Tessellation->GetPoints();
+    tessellationCells->DeepCopy(this->Tessellation->GetPolys());
+    tessellationCells->ConvertTo64BitStorage();
+    header.NumberOfTessellationPoints = static_cast<uint64_t>(tessellationPoints->GetNumberOfPoints());
+    header.NumberOfTessellationCells = static_cast<uint64_t>(tessellationCells->GetNumberOfCells());
+    header.TessellationConnectivitySize = static_cast<uint64_t>(tessellationCells->GetNumberOfConnectivityIds());
+    }
+
+  PayloadLayout layout(header);
+  header.PayloadSize = layout.Size;
+  std::vector<unsigned char> payload(layout.Size, 0);
+
+  ResectionProperties properties;
+  std::memset(&properties, 0, sizeof(properties));
+  properties.ResectionMargin = resectionNode->GetResectionMargin();
+  properties.UncertaintyMargin = resectionNode->GetUncertaintyMargin();
+  properties.HepaticContourThickness = resectionNode->GetHepaticContourThickness();
+  properties.PortalContourThickness = resectionNode->GetPortalContourThickness();
+  resectionNode->GetResectionColor(properties.ResectionColor);
+  resectionNode->GetResectionGridColor(properties.ResectionGridColor);
+  resectionNode->GetResectionMarginColor(properties.ResectionMarginColor);
+  resectionNode->GetUncertaintyMarginColor(properties.UncertaintyMarginColor);
+  resectionNode->GetHepaticContourColor(properties.HepaticContourColor);
+  resectionNode->GetPortalContourColor(properties.PortalContourColor);
+  properties.ResectionOpacity = resectionNode->GetResectionOpacity();
+  properties.GridDivisions = resectionNode->GetGridDivisions();
+  properties.GridThickness = resectionNode->GetGridThickness();
+  properties.TextureNumComps = resectionNode->GetTextureNumComps();
+  properties.State = resectionNode->GetState();
+  properties.InitMode = resectionNode->GetInitMode();
+  properties.ClipOut = resectionNode->GetClipOut();
+  properties.WidgetVisibility = resectionNode->GetWidgetVisibility();
+  properties.InterpolatedMargins = resectionNode->GetInterpolatedMargins();
+  properties.GridVisibility = resectionNode->GetGridVisibility();
+  properties.Grid3DVisibility = resectionNode->GetGrid3DVisibility();
+  properties.Grid2DVisibility = resectionNode->GetGrid2DVisibility();
+  properties.ShowResection2D = resectionNode->GetShowResection2D();
+  properties.MirrorDisplay = resectionNode->GetMirrorDisplay();
+  properties.EnableFlexibleBoundary = resectionNode->GetEnableFlexibleBoundary();
+  std::memcpy(payload.data(), &properties, sizeof(properties));
+
+  auto controlPoints = reinterpret_cast<double*>(payload.data() + layout.ControlPoints);
+  for (uint32_t i = 0; i < header.NumberOfControlPoints; ++i)
+    {
+    bezierSurfaceNode->GetNthControlPointPosition(static_cast<int>(i), controlPoints + 3 * i);
+    }
+
+  auto initializationCoordinates = reinterpret_cast<double*>(payload.data() + layout.InitializationPoints);
+  for (uint32_t i = 0; i < header.NumberOfInitializationPoints; ++i)
+    {
+    initializationPoints->GetPoint(i, initializationCoordinates + 3 * i);
+    }
+
+  if (tessellationPoints)
+    {
+    auto coordinates = reinterpret_cast<float*>(payload.data() + layout.TessellationPoints);
+    for (uint64_t i = 0; i < header.NumberOfTessellationPoints; ++i)
+      {
+      double point[3];
+      tessellationPoints->GetPoint(static_cast<vtkIdType>(i), point);
+      coordinates[3 * i] = static_cast<float>(point[0]);
+      coordinates[3 * i + 1] = static_cast<float>(point[1]);
+      coordinates[3 * i + 2] = static_cast<float>(point[2]);
+      }
+    std::memcpy(payload.data() + layout.TessellationOffsets,
+                tessellationCells->GetOffsetsArray64()->GetPointer(0),
+                sizeof(int64_t) * (header.NumberOfTessellationCells + 1));
+    std::memcpy(payload.data() + layout.TessellationConnectivity,
+                tessellationCells->GetConnectivityArray64()->GetPointer(0),
+                sizeof(int64_t) * header.TessellationConnectivitySize);
+    }
+
+  header.Checksum = ComputeChecksum(payload.data(), layout.Size);
+
+  std::ofstream file(fullName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+  if (!file)
+    {
+    vtkErrorMacro("WriteDataInternal: failed to write " << fullName);
+    return 0;
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLLiverResectionBinaryStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
+{
+  if (!refNode)
+    {
+    vtkErrorMacro("ReadDataInternal: null reference node!");
+    return 0;
+    }
+
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty())
+    {
+    vtkErrorMacro("ReadDataInternal: file name not specified");
+    return 0;
+    }
+
+  auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(refNode);
+  if (!resectionNode)
+    {
+    return 0;
+    }
+
+  auto bezierSurfaceNode = resectionNode->GetBezierSurfaceNode();
+  if (!bezierSurfaceNode)
+    {
+    vtkErrorMacro("ReadDataInternal: resection node does not have a valid bezier surface node associated.");
+    return 0;
+    }
+
+  MappedFile file(fullName);
+  if (!file.GetData() || file.GetSize() < sizeof(FileHeader))
+    {
+    vtkErrorMacro("ReadDataInternal: cannot map " << fullName);
+    return 0;
+    }
+
+  FileHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (std::memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0)
+    {
+    vtkErrorMacro("ReadDataInternal: " << fullName << " is not a liver resection binary file");
+    return 0;
+    }
+  if (header.ByteOrder != ByteOrderMark)
+    {
+    vtkErrorMacro("ReadDataInternal: " << fullName << " was written with a different byte order");
+    return 0;
+    }
+  if (header.Version > FormatVersion)
+    {
+    vtkErrorMacro("ReadDataInternal: " << fullName << " has an unsupported version (" << header.Version << ")");
+    return 0;
+    }
+
+  // Array sizes are bounded by the file size before computing the layout, so
+  // that the layout cannot overflow
+  const uint64_t payloadSize = file.GetSize() - sizeof(FileHeader);
+  if (header.PayloadSize != payloadSize
+      || header.NumberOfTessellationPoints > payloadSize
+      || header.NumberOfTessellationCells > payloadSize
+      || header.TessellationConnectivitySize > payloadSize
+      || PayloadLayout(header).Size != payloadSize)
+    {
+    vtkErrorMacro("ReadDataInternal: " << fullName << " is truncated or corrupted");
+    return 0;
+    }
+
+  const unsigned char* payload = file.GetData() + sizeof(FileHeader);
+  if (ComputeChecksum(payload, payloadSize) != header.Checksum)
+    {
+    vtkErrorMacro("ReadDataInternal: checksum mismatch in " << fullName);
+    return 0;
+    }
+  PayloadLayout layout(header);
+
+  // The tessellation is validated before modifying the resection
+  vtkSmartPointer<vtkPolyData> tessellation;
+  if (header.NumberOfTessellationCells > 0)
+    {
+    vtkNew<vtkPoints> tessellationPoints;
+    tessellationPoints->SetDataTypeToFloat();
+    tessellationPoints->SetNumberOfPoints(static_cast<vtkIdType>(header.NumberOfTessellationPoints));
+    std::memcpy(tessellationPoints->GetVoidPointer(0), payload + layout.TessellationPoints,
+                3 * sizeof(float) * header.NumberOfTessellationPoints);
+
+    vtkNew<vtkTypeInt64Array> offsets;
+    offsets->SetNumberOfValues(static_cast<vtkIdType>(header.NumberOfTessellationCells + 1));
+    std::memcpy(offsets->GetPointer(0), payload + layout.TessellationOffsets,
+                sizeof(int64_t) * (header.NumberOfTessellationCells + 1));
+    vtkNew<vtkTypeInt64Array> connectivity;
+    connectivity->SetNumberOfValues(static_cast<vtkIdType>(header.TessellationConnectivitySize));
+    std::memcpy(connectivity->GetPointer(0), payload + layout.TessellationConnectivity,
+                sizeof(int64_t) * header.TessellationConnectivitySize);
+
+    // The offsets must start at 0, be monotonic and end at the connectivity
+    // size, and the connectivity must only reference tessellation points
+    bool validTessellation = offsets->GetValue(0) == 0 &&
+      offsets->GetValue(static_cast<vtkIdType>(header.NumberOfTessellationCells)) ==
+      static_cast<int64_t>(header.TessellationConnectivitySize);
+    for (vtkIdType i = 0; validTessellation && i < offsets->GetNumberOfValues() - 1; ++i)
+      {
+      validTessellation = offsets->GetValue(i) <= offsets->GetValue(i + 1);
+      }
+    for (vtkIdType i = 0; validTessellation && i < connectivity->GetNumberOfValues(); ++i)
+      {
+      validTessellation = connectivity->GetValue(i) >= 0 &&
+        connectivity->GetValue(i) < static_cast<int64_t>(header.NumberOfTessellationPoints);
+      }
+    if (!validTessellation)
+      {
+      vtkErrorMacro("ReadDataInternal: invalid tessellation in " << fullName);
+      return 0;
+      }
+
+    vtkNew<vtkCellArray> polys;
+    polys->SetData(offsets, connectivity);
+
+    tessellation = vtkSmartPointer<vtkPolyData>::New();
+    tessellation->SetPoints(tessellationPoints);
+    tessellation->SetPolys(polys);
+    }
+
+  ResectionProperties properties;
+  std::memcpy(&properties, payload, sizeof(properties));
+
+  MRMLNodeModifyBlocker resectionBlocker(resectionNode);
+  resectionNode->SetResectionMargin(properties.ResectionMargin);
+  resectionNode->SetUncertaintyMargin(properties.UncertaintyMargin);
+  resectionNode->SetHepaticContourThickness(properties.HepaticContourThickness);
+  resectionNode->SetPortalContourThickness(properties.PortalContourThickness);
+  resectionNode->SetResectionColor(properties.ResectionColor);
+  resectionNode->SetResectionGridColor(properties.ResectionGridColor);
+  resectionNode->SetResectionMarginColor(properties.ResectionMarginColor);
+  resectionNode->SetUncertaintyMarginColor(properties.UncertaintyMarginColor);
+  resectionNode->SetHepaticContourColor(properties.HepaticContourColor);
+  resectionNode->SetPortalContourColor(properties.PortalContourColor);
+  resectionNode->SetResectionOpacity(properties.ResectionOpacity);
+  resectionNode->SetGridDivisions(properties.GridDivisions);
+  resectionNode->SetGridThickness(properties.GridThickness);
+  resectionNode->SetTextureNumComps(properties.TextureNumComps);
+  resectionNode->SetState(static_cast<vtkMRMLLiverResectionNode::ResectionState>(properties.State));
+  resectionNode->SetInitMode(static_cast<vtkMRMLLiverResectionNode::InitializationMode>(properties.InitMode));
+  resectionNode->SetClipOut(properties.ClipOut != 0);
+  resectionNode->SetWidgetVisibility(properties.WidgetVisibility != 0);
+  resectionNode->SetInterpolatedMargins(properties.InterpolatedMargins != 0);
+  resectionNode->SetGridVisibility(properties.GridVisibility);
+  resectionNode->SetGrid3DVisibility(properties.Grid3DVisibility != 0);
+  resectionNode->SetGrid2DVisibility(properties.Grid2DVisibility != 0);
+  resectionNode->SetShowResection2D(properties.ShowResection2D != 0);
+  resectionNode->SetMirrorDisplay(properties.MirrorDisplay != 0);
+  resectionNode->SetEnableFlexibleBoundary(properties.EnableFlexibleBoundary != 0);
+
+  {
+  MRMLNodeModifyBlocker bezierSurfaceBlocker(bezierSurfaceNode);
+  auto controlPoints = reinterpret_cast<const double*>(payload + layout.ControlPoints);
+  bezierSurfaceNode->RemoveAllControlPoints();
+  for (uint32_t i = 0; i < header.NumberOfControlPoints; ++i)
+    {
+    bezierSurfaceNode->AddControlPoint(vtkVector3d(controlPoints + 3 * i));
+    }
+  }
+
+  if (header.NumberOfInitializationPoints >= 2)
+    {
+    vtkNew<vtkPoints> initializationPoints;
+    initializationPoints->SetDataTypeToDouble();
+    initializationPoints->SetNumberOfPoints(header.NumberOfInitializationPoints);
+    std::memcpy(initializationPoints->GetVoidPointer(0), payload + layout.InitializationPoints,
+                3 * sizeof(double) * header.NumberOfInitializationPoints);
+    resectionNode->SetInitializationControlPoints(initializationPoints);
+    }
+
+  this->Tessellation = tessellation;
+
+  return 1;
+}
@@ -0,0 +1,105 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkmrmlliverresectionbinarystoragenode_h_
+#define __vtkmrmlliverresectionbinarystoragenode_h_
+
+#include "vtkSlicerLiverResectionsModuleMRMLExport.h"
+
+// MRML includes
+#include <vtkMRMLStorageNode.h>
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+class vtkPolyData;
+
+//------------------------------------------------------------------------------
+/// \brief Storage node for liver resection plans in a compact binary format.
+///
+/// A file holds a fixed size header (magic, byte order, version, payload size
+/// and checksum) followed by a payload of plain arrays: the resection
+/// properties (margins and display properties), the bezier surface control
+/// points, the initialization points and, optionally, a cached tessellation of
+/// the bezier surface. Reading maps the file in memory and copies the arrays
+/// directly into the nodes, without any parsing.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionBinaryStorageNode
+  : public vtkMRMLStorageNode
+{
+public:
+  static vtkMRMLLiverResectionBinaryStorageNode *New();
+  vtkTypeMacro(vtkMRMLLiverResectionBinaryStorageNode, vtkMRMLStorageNode);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  vtkMRMLNode* CreateNodeInstance() override;
+
+  /// Get node XML tag name (like Storage, Model)
+  const char* GetNodeTagName() override {return "LiverResectionBinaryStorage";}
+
+  bool CanReadInReferenceNode(vtkMRMLNode *refNode) override;
+
+  /// Version of the file format written by this storage node
+  static const unsigned int FormatVersion = 1;
+
+  /// Tessellation of the bezier surface written along with the resection
+  /// (optional), or read from the last file if it contained one
+  void SetTessellation(vtkPolyData* tessellation);
+  vtkPolyData* GetTessellation() const;
+
+protected:
+  /// Initialize all the supported read file types
+  void InitializeSupportedReadFileTypes() override;
+
+  /// Initialize all the supported write file types
+  void InitializeSupportedWriteFileTypes() override;
+
+  int WriteDataInternal(vtkMRMLNode *refNode) override;
+  int ReadDataInternal(vtkMRMLNode *refNode) override;
+
+protected:
+  vtkSmartPointer<vtkPolyData> Tessellation;
+
+protected:
+  vtkMRMLLiverResectionBinaryStorageNode();
+  ~vtkMRMLLiverResectionBinaryStorageNode() override;
+  vtkMRMLLiverResectionBinaryStorageNode(const vtkMRMLLiverResectionBinaryStorageNode&);
+  void operator=(const vtkMRMLLiverResectionBinaryStorageNode&);
+};
+
+#endif // __vtkmrmlliverresectionbinarystoragenode_h_
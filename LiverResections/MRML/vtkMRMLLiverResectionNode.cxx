@@ -61,7 +61,8 @@ vtkMRMLLiverResectionNode::vtkMRMLLiverResectionNode()
    ResectionMarginColor{1.0f, 0.0f, 0.0f}, UncertaintyMarginColor{1.0f, 1.0f, 0.0f},
    ResectionOpacity(1.0f), GridVisibility(false), GridThickness(0.0f), ShowResection2D(false), HepaticContourThickness(0.3f), PortalContourThickness(0.3f),
    HepaticContourColor{0.0f, 151.0/255.0f, 206.0/255.0f}, PortalContourColor{216.0/255.0f, 101.0/255.0f, 79.0/255.0f},
-   TextureNumComps(0), EnableFlexibleBoundary(false), MirrorDisplay(false), Grid3DVisibility(true), Grid2DVisibility(false)
+   TextureNumComps(0), EnableFlexibleBoundary(false), MirrorDisplay(false), Grid3DVisibility(true), Grid2DVisibility(false),
+   ModifiedProperties(AllPropertiesFlag)
 {
 }
 
@@ -95,6 +96,7 @@ bool vtkMRMLLiverResectionNode::SetInitializationControlPoints(vtkPoints* contro
     return false;
     }
 
+  this->InitializationControlPoints->SetNumberOfPoints(2);
   this->InitializationControlPoints->SetPoint(0, controlPoints->GetPoint(0));
   this->InitializationControlPoints->SetPoint(1, controlPoints->GetPoint(1));
   this->Modified();
@@ -58,6 +58,48 @@
 #include <set>
 #include <string>
 
+// Setters of the properties propagated to the resection markups. Besides the
+// usual vtkSetMacro behaviour, they record the property in ModifiedProperties
+#define vtkMRMLLiverResectionSetPropertyMacro(name, type, flag) \
+  virtual void Set##name(type _arg) \
+  { \
+    if (this->name != _arg) \
+      { \
+      this->name = _arg; \
+      this->ModifiedProperties |= flag; \
+      this->Modified(); \
+      } \
+  }
+
+#define vtkMRMLLiverResectionSetClampPropertyMacro(name, type, min, max, flag) \
+  virtual void Set##name(type _arg) \
+  { \
+    const type _value = (_arg < min ? min : (_arg > max ? max : _arg)); \
+    if (this->name != _value) \
+      { \
+      this->name = _value; \
+      this->ModifiedProperties |= flag; \
+      this->Modified(); \
+      } \
+  }
+
+#define vtkMRMLLiverResectionSetVector3PropertyMacro(name, type, flag) \
+  virtual void Set##name(type _arg1, type _arg2, type _arg3) \
+  { \
+    if (this->name[0] != _arg1 || this->name[1] != _arg2 || this->name[2] != _arg3) \
+      { \
+      this->name[0] = _arg1; \
+      this->name[1] = _arg2; \
+      this->name[2] = _arg3; \
+      this->ModifiedProperties |= flag; \
+      this->Modified(); \
+      } \
+  } \
+  virtual void Set##name(const type _arg[3]) \
+  { \
+    this->Set##name(_arg[0], _arg[1], _arg[2]); \
+  }
+
 //-----------------------------------------------------------------------------
 class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   : public vtkMRMLStorableNode
@@ -82,6 +124,38 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
     Curved,
   };
 
+  /// Properties propagated to the initialization and bezier surface markups.
+  /// Their setters record which of them changed since the last propagation.
+  enum PropertyFlags
+  {
+    TargetOrganModelNodeFlag = 1 << 0,
+    DistanceMapVolumeNodeFlag = 1 << 1,
+    VascularSegmentsVolumeNodeFlag = 1 << 2,
+    ResectionMarginFlag = 1 << 3,
+    UncertaintyMarginFlag = 1 << 4,
+    HepaticContourThicknessFlag = 1 << 5,
+    PortalContourThicknessFlag = 1 << 6,
+    ShowResection2DFlag = 1 << 7,
+    MirrorDisplayFlag = 1 << 8,
+    EnableFlexibleBoundaryFlag = 1 << 9,
+    Grid2DVisibilityFlag = 1 << 10,
+    TextureNumCompsFlag = 1 << 11,
+    ClipOutFlag = 1 << 12,
+    WidgetVisibilityFlag = 1 << 13,
+    InterpolatedMarginsFlag = 1 << 14,
+    ResectionColorFlag = 1 << 15,
+    ResectionGridColorFlag = 1 << 16,
+    ResectionMarginColorFlag = 1 << 17,
+    UncertaintyMarginColorFlag = 1 << 18,
+    ResectionOpacityFlag = 1 << 19,
+    GridDivisionsFlag = 1 << 20,
+    GridThicknessFlag = 1 << 21,
+    Grid3DVisibilityFlag = 1 << 22,
+    HepaticContourColorFlag = 1 << 23,
+    PortalContourColorFlag = 1 << 24,
+    AllPropertiesFlag = (1 << 25) - 1
+  };
+
   //--------------------------------------------------------------------------------
   // MRMLNode methods
   //--------------------------------------------------------------------------------
@@ -96,6 +170,19 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   /// Create default storage node or nullptr if does not have one
   vtkMRMLStorageNode* CreateDefaultStorageNode() override;
 
+  /// Get the properties (PropertyFlags) modified since they were last cleared.
+  /// All of them are flagged on a new node.
+  vtkGetMacro(ModifiedProperties, unsigned int);
+
+  /// Returns true if any of the given properties (PropertyFlags) is modified
+  bool IsPropertyModified(unsigned int flags) const
+  {return (this->ModifiedProperties & flags) != 0;}
+
+  /// Clear the modification flags of the given properties, once they have
+  /// been propagated. This does not invoke any event.
+  void ClearModifiedProperties(unsigned int flags = AllPropertiesFlag)
+  {this->ModifiedProperties &= ~flags;}
+
 
   // TODO: Review the need for this further down the road
   /// Get target lesions identifiers
@@ -115,12 +202,12 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   // Get resection margin
   vtkGetMacro(ResectionMargin, double);
   // Set resection margin
-  vtkSetClampMacro(ResectionMargin, double, 0.0, VTK_DOUBLE_MAX);
+  vtkMRMLLiverResectionSetClampPropertyMacro(ResectionMargin, double, 0.0, VTK_DOUBLE_MAX, ResectionMarginFlag);
 
   // Get resection margin
   vtkGetMacro(UncertaintyMargin, double);
   // Set resection margin
-  vtkSetClampMacro(UncertaintyMargin, double, 0.0, VTK_DOUBLE_MAX);
+  vtkMRMLLiverResectionSetClampPropertyMacro(UncertaintyMargin, double, 0.0, VTK_DOUBLE_MAX, UncertaintyMarginFlag);
 
   // Get resection status
   vtkGetMacro(State, ResectionState);
@@ -138,7 +225,7 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
 
   // Set Target Organ
   void SetTargetOrganModelNode(vtkMRMLModelNode *targetOrgan)
-  {this->TargetOrganModelNode = targetOrgan; this->Modified();}
+  {this->SetPropertyNode(this->TargetOrganModelNode, targetOrgan, TargetOrganModelNodeFlag);}
 
   // Get Distance Map
   vtkMRMLScalarVolumeNode*GetDistanceMapVolumeNode() const
@@ -146,7 +233,7 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
 
   // Set Distance Map
   void SetDistanceMapVolumeNode(vtkMRMLScalarVolumeNode* distanceMapVolumeNode)
-  {this->DistanceMapVolumeNode = distanceMapVolumeNode; this->Modified();}
+  {this->SetPropertyNode(this->DistanceMapVolumeNode, distanceMapVolumeNode, DistanceMapVolumeNodeFlag);}
 
   // Get Vascular Segments Volume
   vtkMRMLScalarVolumeNode *GetVascularSegmentsVolumeNode() const
@@ -154,7 +241,7 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
 
   // Set Vascular Segments Volume
   void SetVascularSegmentsVolumeNode(vtkMRMLScalarVolumeNode *vascularSegmentsVolumeNode)
-  {this->VascularSegmentsVolumeNode = vascularSegmentsVolumeNode; this->Modified();}
+  {this->SetPropertyNode(this->VascularSegmentsVolumeNode, vascularSegmentsVolumeNode, VascularSegmentsVolumeNodeFlag);}
 
   /// This is a function to set the initialization control points as vtkPoints.
   /// Since the expected number of points for the initialization is two, the
@@ -185,49 +272,51 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   {return const_cast<vtkPoints const*>(this->BezierSurfaceControlPoints.GetPointer());}
 
   // Set the clipout state variable
-  vtkSetMacro(ClipOut, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(ClipOut, bool, ClipOutFlag);
 
   // Get the clipout state variable
   vtkGetMacro(ClipOut, bool);
 
   // Set the clipout state variable
-  vtkSetMacro(ClipOut, int);
+  void SetClipOut(int value)
+  {this->SetClipOut(value != 0);}
 
   // Set the widget visibility variable
-  vtkSetMacro(WidgetVisibility, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(WidgetVisibility, bool, WidgetVisibilityFlag);
 
   // Get the widget visibility variable
   vtkGetMacro(WidgetVisibility, bool);
 
   // Set the widget visibility variable
-  vtkSetMacro(WidgetVisibility, int);
+  void SetWidgetVisibility(int value)
+  {this->SetWidgetVisibility(value != 0);}
 
   // Get interpolated margins property
   vtkGetMacro(InterpolatedMargins, bool);
 
   // Set interpolated margins property
-  vtkSetMacro(InterpolatedMargins, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(InterpolatedMargins, bool, InterpolatedMarginsFlag);
 
   // Set interpolated property
-  vtkSetVector3Macro(ResectionColor, float);
+  vtkMRMLLiverResectionSetVector3PropertyMacro(ResectionColor, float, ResectionColorFlag);
 
   // Get interpolated property
   vtkGetVector3Macro(ResectionColor, float);
 
   // Set interpolated property
-  vtkSetVector3Macro(ResectionGridColor, float);
+  vtkMRMLLiverResectionSetVector3PropertyMacro(ResectionGridColor, float, ResectionGridColorFlag);
 
   // Get interpolated property
   vtkGetVector3Macro(ResectionGridColor, float);
 
   // Set interpolated margins property
-  vtkSetVector3Macro(ResectionMarginColor, float);
+  vtkMRMLLiverResectionSetVector3PropertyMacro(ResectionMarginColor, float, ResectionMarginColorFlag);
 
   // Get interpolated margins property
   vtkGetVector3Macro(ResectionMarginColor, float);
 
   // Set interpolated margins property
-  vtkSetVector3Macro(UncertaintyMarginColor, float);
+  vtkMRMLLiverResectionSetVector3PropertyMacro(UncertaintyMarginColor, float, UncertaintyMarginColorFlag);
 
   // Get interpolated margins property
   vtkGetVector3Macro(UncertaintyMarginColor, float);
@@ -236,7 +325,7 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   vtkGetMacro(ResectionOpacity, float);
 
   // Set resection opacity property
-  vtkSetClampMacro(ResectionOpacity, float, 0.0f, 1.0f);
+  vtkMRMLLiverResectionSetClampPropertyMacro(ResectionOpacity, float, 0.0f, 1.0f, ResectionOpacityFlag);
 
   // Get the widget visibility variable
   vtkGetMacro(GridVisibility, bool);
@@ -248,79 +337,84 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   vtkGetMacro(GridDivisions, float);
 
   // Set the widget visibility variable
-  vtkSetMacro(GridDivisions, float);
+  vtkMRMLLiverResectionSetPropertyMacro(GridDivisions, float, GridDivisionsFlag);
 
   // Get the widget visibility variable
   vtkGetMacro(GridThickness, float);
 
   // Set the widget visibility variable
-  vtkSetMacro(GridThickness, float);
+  vtkMRMLLiverResectionSetPropertyMacro(GridThickness, float, GridThicknessFlag);
 
   // Set the Grid3DVisibility state variable
-  vtkSetMacro(Grid3DVisibility, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(Grid3DVisibility, bool, Grid3DVisibilityFlag);
 
   // Get the Grid3DVisibility state variable
   vtkGetMacro(Grid3DVisibility, bool);
 
   // Set the Grid3DVisibility state variable
-  vtkSetMacro(Grid3DVisibility, int);
+  void SetGrid3DVisibility(int value)
+  {this->SetGrid3DVisibility(value != 0);}
 
   // Set the ShowResection2D state variable
-  vtkSetMacro(ShowResection2D, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(ShowResection2D, bool, ShowResection2DFlag);
 
   // Get the ShowResection2D state variable
   vtkGetMacro(ShowResection2D, bool);
 
   // Set the ShowResection2D state variable
-  vtkSetMacro(ShowResection2D, int);
+  void SetShowResection2D(int value)
+  {this->SetShowResection2D(value != 0);}
 
   // Set the MirrorDisplay state variable
-  vtkSetMacro(MirrorDisplay, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(MirrorDisplay, bool, MirrorDisplayFlag);
 
   // Get the MirrorDisplay state variable
   vtkGetMacro(MirrorDisplay, bool);
 
   // Set the MirrorDisplay state variable
-  vtkSetMacro(MirrorDisplay, int);
+  void SetMirrorDisplay(int value)
+  {this->SetMirrorDisplay(value != 0);}
 
   // Set the EnableFlexibleBoundary state variable
-  vtkSetMacro(EnableFlexibleBoundary, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(EnableFlexibleBoundary, bool, EnableFlexibleBoundaryFlag);
 
   // Get the EnableFlexibleBoundary state variable
   vtkGetMacro(EnableFlexibleBoundary, bool);
 
   // Set the EnableFlexibleBoundary state variable
-  vtkSetMacro(EnableFlexibleBoundary, int);
+  void SetEnableFlexibleBoundary(int value)
+  {this->SetEnableFlexibleBoundary(value != 0);}
 
   // Set the Grid2DVisibility state variable
-  vtkSetMacro(Grid2DVisibility, bool);
+  vtkMRMLLiverResectionSetPropertyMacro(Grid2DVisibility, bool, Grid2DVisibilityFlag);
 
   // Get the Grid2DVisibility state variable
   vtkGetMacro(Grid2DVisibility, bool);
 
   // Set the Grid2DVisibility state variable
-  vtkSetMacro(Grid2DVisibility, int);
+  void SetGrid2DVisibility(int value)
+  {this->SetGrid2DVisibility(value != 0);}
 
   // Get HepaticContourThickness margin
   vtkGetMacro(HepaticContourThickness, double);
 
   // Set HepaticContourThickness margin
-  vtkSetClampMacro(HepaticContourThickness, double, 0.0, VTK_DOUBLE_MAX);
+  vtkMRMLLiverResectionSetClampPropertyMacro(HepaticContourThickness, double, 0.0, VTK_DOUBLE_MAX, HepaticContourThicknessFlag);
 
   // Get PortalContourThickness margin
   vtkGetMacro(PortalContourThickness, double);
 
   // Set PortalContourThickness margin
-  vtkSetClampMacro(PortalContourThickness, double, 0.0, VTK_DOUBLE_MAX);
+  vtkMRMLLiverResectionSetClampPropertyMacro(PortalContourThickness, double, 0.0, VTK_DOUBLE_MAX, PortalContourThicknessFlag);
 
   // Set HepaticContourColor
-  vtkSetVector3Macro(HepaticContourColor, float);
+  vtkMRMLLiverResectionSetVector3PropertyMacro(HepaticContourColor, float, HepaticContourColorFlag);
 
   // Get HepaticContourColor
   vtkGetVector3Macro(HepaticContourColor, float);
 
   // Set PortalContourColor
-  vtkSetVector3Macro(PortalContourColor, float);
+  vtkMRMLLiverResectionSetVector3PropertyMacro(PortalContourColor, float, PortalContourColorFlag);
 
   // Get PortalContourColor
   vtkGetVector3Macro(PortalContourColor, float);
@@ -329,7 +423,7 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   vtkGetMacro(TextureNumComps, int);
 
   // Set the TextureNumComps state variable
-  vtkSetMacro(TextureNumComps, int);
+  vtkMRMLLiverResectionSetPropertyMacro(TextureNumComps, int, TextureNumCompsFlag);
 
   // Get bezier surface
   vtkMRMLMarkupsBezierSurfaceNode *GetBezierSurfaceNode() const
@@ -344,6 +438,18 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   vtkMRMLLiverResectionNode();
   ~vtkMRMLLiverResectionNode() override;
 
+  /// Set a referenced node property and flag it if it changed
+  template <class T>
+  void SetPropertyNode(vtkWeakPointer<T>& property, T* node, unsigned int flag)
+  {
+    if (property != node)
+      {
+      property = node;
+      this->ModifiedProperties |= flag;
+      this->Modified();
+      }
+  }
+
  private:
 
   // TODO: Review the need of this further down the road
@@ -381,6 +487,7 @@ class VTK_SLICER_LIVERRESECTIONS_MODULE_MRML_EXPORT vtkMRMLLiverResectionNode
   bool MirrorDisplay;
   bool Grid3DVisibility;
   bool Grid2DVisibility;
+  unsigned int ModifiedProperties;
 
  private:
   vtkMRMLLiverResectionNode(const vtkMRMLLiverResectionNode&);
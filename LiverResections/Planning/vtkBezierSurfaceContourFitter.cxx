@@ -0,0 +1,326 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkBezierSurfaceContourFitter.h"
+#include "vtkParenchymaSlicingIndex.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+
+// STD includes
+#include <array>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkBezierSurfaceContourFitter);
+
+//----------------------------------------------------------------------------
+vtkBezierSurfaceContourFitter::vtkBezierSurfaceContourFitter()
+  : Smoothness(1e-4)
+  , ExtentFactor(4.0)
+  , UseReferenceAxes(false)
+  , ReferenceAxes{{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}}
+  , RMSError(0.0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkBezierSurfaceContourFitter::~vtkBezierSurfaceContourFitter() = default;
+
+//----------------------------------------------------------------------------
+void vtkBezierSurfaceContourFitter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Smoothness: " << this->Smoothness << "\n";
+  os << indent << "ExtentFactor: " << this->ExtentFactor << "\n";
+  os << indent << "UseReferenceAxes: " << this->UseReferenceAxes << "\n";
+  os << indent << "RMSError: " << this->RMSError << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkBezierSurfaceContourFitter::SetInputPoints(vtkPoints* points)
+{
+  if (this->InputPoints == points)
+    {
+    return;
+    }
+  this->InputPoints = points;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPoints* vtkBezierSurfaceContourFitter::GetInputPoints() const
+{
+  return this->InputPoints;
+}
+
+//----------------------------------------------------------------------------
+void vtkBezierSurfaceContourFitter::SetReferenceAxes(const double uAxis[3], const double vAxis[3])
+{
+  for (int c = 0; c < 3; ++c)
+    {
+    this->ReferenceAxes[0][c] = uAxis[c];
+    this->ReferenceAxes[1][c] = vAxis[c];
+    }
+  this->UseReferenceAxes = true;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkBezierSurfaceContourFitter::RemoveReferenceAxes()
+{
+  this->UseReferenceAxes = false;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkBezierSurfaceContourFitter::EvaluateBernstein(double t, double basis[4])
+{
+  double s = 1.0 - t;
+  basis[0] = s * s * s;
+  basis[1] = 3.0 * t * s * s;
+  basis[2] = 3.0 * t * t * s;
+  basis[3] = t * t * t;
+}
+
+//----------------------------------------------------------------------------
+bool vtkBezierSurfaceContourFitter::Fit(vtkPoints* controlPoints)
+{
+  this->RMSError = 0.0;
+  if (!controlPoints)
+    {
+    vtkErrorMacro("Fit: no output points.");
+    return false;
+    }
+
+  vtkIdType numberOfPoints = this->InputPoints ? this->InputPoints->GetNumberOfPoints() : 0;
+  if (numberOfPoints < 16)
+    {
+    return false;
+    }
+
+  // Principal plane of the contour
+  vtkParenchymaSlicingIndex::ContourSums sums;
+  for (vtkIdType n = 0; n < numberOfPoints; ++n)
+    {
+    double x[3];
+    this->InputPoints->GetPoint(n, x);
+    sums.Weight += 1.0;
+    sums.Sum[0] += x[0];
+    sums.Sum[1] += x[1];
+    sums.Sum[2] += x[2];
+    sums.SumOfProducts[0] += x[0] * x[0];
+    sums.SumOfProducts[1] += x[0] * x[1];
+    sums.SumOfProducts[2] += x[0] * x[2];
+    sums.SumOfProducts[3] += x[1] * x[1];
+    sums.SumOfProducts[4] += x[1] * x[2];
+    sums.SumOfProducts[5] += x[2] * x[2];
+    }
+
+  vtkParenchymaSlicingIndex::ContourPCA pca;
+  vtkParenchymaSlicingIndex::ComputePCAFromSums(sums, pca);
+  if (pca.Eigenvalues[1] <= 0.0)
+    {
+    return false;
+    }
+
+  double axes[3][3];
+  for (int k = 0; k < 3; ++k)
+    {
+    for (int c = 0; c < 3; ++c)
+      {
+      axes[k][c] = pca.Eigenvectors[k][c];
+      }
+    }
+  if (this->UseReferenceAxes)
+    {
+    for (int k = 0; k < 2; ++k)
+      {
+      if (vtkMath::Dot(axes[k], this->ReferenceAxes[k]) < 0.0)
+        {
+        vtkMath::MultiplyScalar(axes[k], -1.0);
+        }
+      }
+    }
+  vtkMath::Cross(axes[0], axes[1], axes[2]);
+
+  double lengths[2] = {this->ExtentFactor * std::sqrt(pca.Eigenvalues[0]),
+                       this->ExtentFactor * std::sqrt(pca.Eigenvalues[1])};
+
+  // Normal equations of the height of the control points: data term
+  const int size = 16;
+  double normalMatrix[size][size] = {};
+  double rightHandSide[size] = {};
+  std::vector<double> heights(numberOfPoints);
+  std::vector<std::array<double, 2>> parameters(numberOfPoints);
+  for (vtkIdType n = 0; n < numberOfPoints; ++n)
+    {
+    double x[3];
+    this->InputPoints->GetPoint(n, x);
+    vtkMath::Subtract(x, pca.Center, x);
+    double u = vtkMath::Dot(x, axes[0]) / lengths[0] + 0.5;
+    double v = vtkMath::Dot(x, axes[1]) / lengths[1] + 0.5;
+    double h = vtkMath::Dot(x, axes[2]);
+    parameters[n] = {u, v};
+    heights[n] = h;
+
+    double basisU[4];
+    double basisV[4];
+    vtkBezierSurfaceContourFitter::EvaluateBernstein(u, basisU);
+    vtkBezierSurfaceContourFitter::EvaluateBernstein(v, basisV);
+    double basis[size];
+    for (int j = 0; j < 4; ++j)
+      {
+      for (int i = 0; i < 4; ++i)
+        {
+        basis[i + 4 * j] = basisU[i] * basisV[j];
+        }
+      }
+    for (int r = 0; r < size; ++r)
+      {
+      rightHandSide[r] += basis[r] * h;
+      for (int c = 0; c < size; ++c)
+        {
+        normalMatrix[r][c] += basis[r] * basis[c];
+        }
+      }
+    }
+
+  // Thin-plate penalty on the control net: second differences along u and v
+  // and twists
+  std::vector<std::array<double, size>> penaltyRows;
+  for (int j = 0; j < 4; ++j)
+    {
+    for (int i = 1; i < 3; ++i)
+      {
+      std::array<double, size> uRow{};
+      uRow[(i - 1) + 4 * j] = 1.0;
+      uRow[i + 4 * j] = -2.0;
+      uRow[(i + 1) + 4 * j] = 1.0;
+      penaltyRows.push_back(uRow);
+
+      std::array<double, size> vRow{};
+      vRow[j + 4 * (i - 1)] = 1.0;
+      vRow[j + 4 * i] = -2.0;
+      vRow[j + 4 * (i + 1)] = 1.0;
+      penaltyRows.push_back(vRow);
+      }
+    }
+  for (int j = 0; j < 3; ++j)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      std::array<double, size> twistRow{};
+      twistRow[i + 4 * j] = std::sqrt(2.0);
+      twistRow[(i + 1) + 4 * j] = -std::sqrt(2.0);
+      twistRow[i + 4 * (j + 1)] = -std::sqrt(2.0);
+      twistRow[(i + 1) + 4 * (j + 1)] = std::sqrt(2.0);
+      penaltyRows.push_back(twistRow);
+      }
+    }
+
+  double lambda = this->Smoothness * static_cast<double>(numberOfPoints);
+  for (const auto& row : penaltyRows)
+    {
+    for (int r = 0; r < size; ++r)
+      {
+      if (row[r] == 0.0)
+        {
+        continue;
+        }
+      for (int c = 0; c < size; ++c)
+        {
+        normalMatrix[r][c] += lambda * row[r] * row[c];
+        }
+      }
+    }
+
+  double* rows[size];
+  for (int r = 0; r < size; ++r)
+    {
+    rows[r] = normalMatrix[r];
+    }
+  if (!vtkMath::SolveLinearSystem(rows, rightHandSide, size))
+    {
+    return false;
+    }
+
+  // Residual of the contour points
+  double squaredError = 0.0;
+  for (vtkIdType n = 0; n < numberOfPoints; ++n)
+    {
+    double basisU[4];
+    double basisV[4];
+    vtkBezierSurfaceContourFitter::EvaluateBernstein(parameters[n][0], basisU);
+    vtkBezierSurfaceContourFitter::EvaluateBernstein(parameters[n][1], basisV);
+    double h = 0.0;
+    for (int j = 0; j < 4; ++j)
+      {
+      for (int i = 0; i < 4; ++i)
+        {
+        h += basisU[i] * basisV[j] * rightHandSide[i + 4 * j];
+        }
+      }
+    squaredError += (h - heights[n]) * (h - heights[n]);
+    }
+  this->RMSError = std::sqrt(squaredError / numberOfPoints);
+
+  controlPoints->SetNumberOfPoints(size);
+  for (int j = 0; j < 4; ++j)
+    {
+    for (int i = 0; i < 4; ++i)
+      {
+      double s = (i / 3.0 - 0.5) * lengths[0];
+      double t = (j / 3.0 - 0.5) * lengths[1];
+      double h = rightHandSide[i + 4 * j];
+      double x[3];
+      for (int c = 0; c < 3; ++c)
+        {
+        x[c] = pca.Center[c] + s * axes[0][c] + t * axes[1][c] + h * axes[2][c];
+        }
+      controlPoints->SetPoint(i + 4 * j, x);
+      }
+    }
+  controlPoints->Modified();
+
+  return true;
+}
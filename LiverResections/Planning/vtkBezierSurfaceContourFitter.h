@@ -0,0 +1,120 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkBezierSurfaceContourFitter_h
+#define __vtkBezierSurfaceContourFitter_h
+
+#include "vtkSlicerLiverResectionsModulePlanningExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+//------------------------------------------------------------------------------
+class vtkPoints;
+
+//------------------------------------------------------------------------------
+/// \brief Fits a bicubic Bezier patch to a closed contour on the parenchyma.
+///
+/// The patch is laid out on the principal plane of the contour: the in-plane
+/// positions of its 4x4 control points form the same regular grid as the
+/// flat initialization (sides of ExtentFactor standard deviations along the
+/// two main axes), and only their offsets along the normal of that plane are
+/// fitted. Since the Bernstein basis reproduces linear functions, the
+/// parameters of every contour point follow directly from its projection on
+/// the plane, and the fit reduces to a 16x16 linear least-squares problem.
+/// A thin-plate penalty on the control net keeps the interior of the patch,
+/// which the contour does not constrain, smooth.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_PLANNING_EXPORT vtkBezierSurfaceContourFitter
+  : public vtkObject
+{
+public:
+  static vtkBezierSurfaceContourFitter* New();
+  vtkTypeMacro(vtkBezierSurfaceContourFitter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Contour points to fit
+  void SetInputPoints(vtkPoints* points);
+  vtkPoints* GetInputPoints() const;
+
+  /// Weight of the thin-plate penalty relative to the data term (default 1e-4)
+  vtkSetMacro(Smoothness, double);
+  vtkGetMacro(Smoothness, double);
+
+  /// Side lengths of the patch, in standard deviations of the contour along
+  /// its two main axes (default 4, as the flat initialization)
+  vtkSetMacro(ExtentFactor, double);
+  vtkGetMacro(ExtentFactor, double);
+
+  /// Optional directions of the first row and the first column of the
+  /// current control net. The main axes are oriented along them, so that
+  /// consecutive fits do not flip the patch.
+  void SetReferenceAxes(const double uAxis[3], const double vAxis[3]);
+  void RemoveReferenceAxes();
+
+  /// Computes the 16 control points (row by row, as vtkPlaneSource with
+  /// resolution 3). Returns false if the contour has too few points or is
+  /// degenerate.
+  bool Fit(vtkPoints* controlPoints);
+
+  /// Root mean square distance of the contour points to the fitted patch,
+  /// along the normal of the principal plane
+  vtkGetMacro(RMSError, double);
+
+  /// Bernstein polynomials of degree 3
+  static void EvaluateBernstein(double t, double basis[4]);
+
+protected:
+  vtkBezierSurfaceContourFitter();
+  ~vtkBezierSurfaceContourFitter() override;
+
+protected:
+  vtkSmartPointer<vtkPoints> InputPoints;
+  double Smoothness;
+  double ExtentFactor;
+  bool UseReferenceAxes;
+  double ReferenceAxes[2][3];
+  double RMSError;
+
+private:
+  vtkBezierSurfaceContourFitter(const vtkBezierSurfaceContourFitter&) = delete;
+  void operator=(const vtkBezierSurfaceContourFitter&) = delete;
+};
+
+#endif // __vtkBezierSurfaceContourFitter_h
@@ -0,0 +1,1204 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkLiverDistanceMapEngine.h"
+#include "vtkLiverDistanceMapQuantization.h"
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+using namespace vtkLiverDistanceMapQuantization;
+
+const double Unreached = std::numeric_limits<double>::infinity();
+
+//------------------------------------------------------------------------------
+/// Voxel box (inclusive index ranges), empty if a minimum exceeds its maximum
+struct VoxelBox
+{
+  int Extent[6] = {VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN};
+
+  bool IsEmpty() const
+  {
+    return this->Extent[0] > this->Extent[1];
+  }
+
+  void Add(const int ijk[3])
+  {
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      this->Extent[2 * axis] = std::min(this->Extent[2 * axis], ijk[axis]);
+      this->Extent[2 * axis + 1] = std::max(this->Extent[2 * axis + 1], ijk[axis]);
+      }
+  }
+
+  void Add(const VoxelBox& box)
+  {
+    if (!box.IsEmpty())
+      {
+      const int first[3] = {box.Extent[0], box.Extent[2], box.Extent[4]};
+      const int last[3] = {box.Extent[1], box.Extent[3], box.Extent[5]};
+      this->Add(first);
+      this->Add(last);
+      }
+  }
+};
+
+//------------------------------------------------------------------------------
+/// A voxel of a structure is on its boundary if a face neighbor within the
+/// image is out of the structure
+inline bool IsBoundary(const unsigned char* mask, const int dimensions[3], const vtkIdType steps[3],
+                       const int ijk[3], vtkIdType voxel)
+{
+  if (!mask[voxel])
+    {
+    return false;
+    }
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if ((ijk[axis] > 0 && !mask[voxel - steps[axis]])
+        || (ijk[axis] < dimensions[axis] - 1 && !mask[voxel + steps[axis]]))
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+/// Squared distance transform of the samples f along a line segment starting
+/// at index first: lower envelope of the parabolas rooted at the reached
+/// samples (Felzenszwalb and Huttenlocher). v and z hold the envelope (n and
+/// n + 1 elements). Positions are absolute, so that the result of a segment
+/// does not depend on where it starts.
+void SquaredDistance1D(const double* f, int n, int first, double spacing, double* d, int* v, double* z)
+{
+  int k = -1;
+  for (int q = 0; q < n; ++q)
+    {
+    if (f[q] == Unreached)
+      {
+      continue;
+      }
+    const double position = (first + q) * spacing;
+    if (k < 0)
+      {
+      k = 0;
+      v[0] = q;
+      z[0] = -Unreached;
+      z[1] = Unreached;
+      continue;
+      }
+    double s;
+    for (;;)
+      {
+      const double root = (first + v[k]) * spacing;
+      s = ((f[q] + position * position) - (f[v[k]] + root * root)) / (2.0 * (position - root));
+      if (s > z[k])
+        {
+        break;
+        }
+      --k;
+      }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = Unreached;
+    }
+
+  if (k < 0)
+    {
+    std::fill(d, d + n, Unreached);
+    return;
+    }
+
+  k = 0;
+  for (int q = 0; q < n; ++q)
+    {
+    const double position = (first + q) * spacing;
+    while (z[k + 1] < position)
+      {
+      ++k;
+      }
+    const double offset = position - (first + v[k]) * spacing;
+    d[q] = offset * offset + f[v[k]];
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Inside mask of the labels within a box (indices relative to the image)
+template <typename T>
+void ExtractMask(const T* labels, int labelComponents, const int dimensions[3], const VoxelBox& box,
+                 unsigned char* mask)
+{
+  const int* extent = box.Extent;
+  const vtkIdType rowLength = extent[1] - extent[0] + 1;
+  const vtkIdType rowsPerSlice = extent[3] - extent[2] + 1;
+  vtkSMPTools::For(extent[4], extent[5] + 1, [&](vtkIdType beginSlice, vtkIdType endSlice)
+    {
+    for (vtkIdType k = beginSlice; k < endSlice; ++k)
+      {
+      for (vtkIdType j = extent[2]; j <= extent[3]; ++j)
+        {
+        const T* label = labels
+          + ((k * dimensions[1] + j) * dimensions[0] + extent[0]) * labelComponents;
+        unsigned char* row = mask + ((k - extent[4]) * rowsPerSlice + (j - extent[2])) * rowLength;
+        for (vtkIdType i = 0; i < rowLength; ++i, label += labelComponents)
+          {
+          row[i] = *label != static_cast<T>(0);
+          }
+        }
+      }
+    });
+}
+
+//------------------------------------------------------------------------------
+/// Max pooling of the labels within a box of coarse voxels (indices relative
+/// to the coarse image): a coarse voxel is inside if any of the factors[0] x
+/// factors[1] x factors[2] voxels it covers is
+template <typename T>
+void PoolMask(const T* labels, int labelComponents, const int dimensions[3], const int factors[3],
+              const int box[6], unsigned char* mask, const int maskDimensions[3])
+{
+  vtkSMPTools::For(box[4], box[5] + 1, [&](vtkIdType beginSlice, vtkIdType endSlice)
+    {
+    for (vtkIdType k = beginSlice; k < endSlice; ++k)
+      {
+      const int lastK = std::min(static_cast<int>(k + 1) * factors[2], dimensions[2]);
+      for (int j = box[2]; j <= box[3]; ++j)
+        {
+        const int lastJ = std::min((j + 1) * factors[1], dimensions[1]);
+        for (int i = box[0]; i <= box[1]; ++i)
+          {
+          const int lastI = std::min((i + 1) * factors[0], dimensions[0]);
+          unsigned char inside = 0;
+          for (int z = static_cast<int>(k) * factors[2]; z < lastK && !inside; ++z)
+            {
+            for (int y = j * factors[1]; y < lastJ && !inside; ++y)
+              {
+              const T* label = labels
+                + ((static_cast<vtkIdType>(z) * dimensions[1] + y) * dimensions[0] + i * factors[0]) * labelComponents;
+              for (int x = i * factors[0]; x < lastI; ++x, label += labelComponents)
+                {
+                if (*label != static_cast<T>(0))
+                  {
+                  inside = 1;
+                  break;
+                  }
+                }
+              }
+            }
+          mask[(k * maskDimensions[1] + j) * maskDimensions[0] + i] = inside;
+          }
+        }
+      }
+    });
+}
+
+//------------------------------------------------------------------------------
+/// Integer downsampling factors closest to the target spacing (1 along the
+/// axes without target spacing)
+void ComputeResamplingFactors(const double targetSpacing[3], const double spacing[3], const int dimensions[3],
+                              int factors[3])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    factors[axis] = 1;
+    if (targetSpacing[axis] > 0.0 && spacing[axis] > 0.0)
+      {
+      const double factor = std::floor(targetSpacing[axis] / spacing[axis] + 0.5);
+      factors[axis] = static_cast<int>(std::max(1.0, std::min(factor, static_cast<double>(dimensions[axis]))));
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Signed distance of a voxel from its squared distance to the closest
+/// boundary voxel, lowered by the resampling bias and saturated
+inline float SignedDistance(float squaredDistance, bool inside, float saturation, double bias)
+{
+  double distance = std::isinf(squaredDistance) ? static_cast<double>(VTK_FLOAT_MAX) : std::sqrt(squaredDistance);
+  if (inside && distance > 0.0)
+    {
+    distance = -distance;
+    }
+  return static_cast<float>(std::max(std::min(distance - bias, static_cast<double>(saturation)),
+                                     -static_cast<double>(saturation)));
+}
+
+//------------------------------------------------------------------------------
+/// Bounding box of the voxels different from zero
+template <typename T>
+VoxelBox ComputeForegroundBox(const T* labels, int labelComponents, const int dimensions[3])
+{
+  std::vector<VoxelBox> sliceBoxes(dimensions[2]);
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType beginSlice, vtkIdType endSlice)
+    {
+    for (int k = static_cast<int>(beginSlice); k < endSlice; ++k)
+      {
+      const T* label = labels + static_cast<vtkIdType>(k) * dimensions[0] * dimensions[1] * labelComponents;
+      for (int j = 0; j < dimensions[1]; ++j)
+        {
+        for (int i = 0; i < dimensions[0]; ++i, label += labelComponents)
+          {
+          if (*label != static_cast<T>(0))
+            {
+            const int ijk[3] = {i, j, k};
+            sliceBoxes[k].Add(ijk);
+            }
+          }
+        }
+      }
+    });
+
+  VoxelBox box;
+  for (const VoxelBox& sliceBox : sliceBoxes)
+    {
+    box.Add(sliceBox);
+    }
+  return box;
+}
+
+//------------------------------------------------------------------------------
+/// Squared distances along one axis for all the components of the
+/// interleaved buffer, one scanline at a time. Each component is only swept
+/// within its box. Positions are offset by positionOffset voxels when the
+/// buffer is a block of a larger image.
+class AxisSweep
+{
+public:
+  AxisSweep(float* distances, const int dimensions[3], int numberOfComponents,
+            const std::vector<VoxelBox>& boxes, int axis, double spacing, int positionOffset = 0)
+    : Distances(distances)
+    , NumberOfComponents(numberOfComponents)
+    , Boxes(boxes)
+    , Axis(axis)
+    , Spacing(spacing)
+    , PositionOffset(positionOffset)
+  {
+    const vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+    this->Length = dimensions[axis];
+    this->Stride = axis == 0 ? 1 : (axis == 1 ? dimensions[0] : sliceSize);
+    // Lines are enumerated along the first of the other two axes
+    this->LineAxes[0] = axis == 0 ? 1 : 0;
+    this->LineAxes[1] = axis == 2 ? 1 : 2;
+    this->LineDimension = dimensions[this->LineAxes[0]];
+    this->LineStrides[0] = axis == 0 ? dimensions[0] : 1;
+    this->LineStrides[1] = axis == 2 ? dimensions[0] : sliceSize;
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    const int numberOfComponents = this->NumberOfComponents;
+    Scratch& scratch = this->LocalScratch.Local();
+    scratch.Samples.resize(this->Length);
+    scratch.Distances.resize(this->Length);
+    scratch.Roots.resize(this->Length);
+    scratch.Boundaries.resize(this->Length + 1);
+
+    for (vtkIdType line = begin; line < end; ++line)
+      {
+      const int a = static_cast<int>(line % this->LineDimension);
+      const int b = static_cast<int>(line / this->LineDimension);
+      float* lineStart = this->Distances
+        + (a * this->LineStrides[0] + b * this->LineStrides[1]) * numberOfComponents;
+
+      for (int c = 0; c < numberOfComponents; ++c)
+        {
+        const int* box = this->Boxes[c].Extent;
+        if (a < box[2 * this->LineAxes[0]] || a > box[2 * this->LineAxes[0] + 1]
+            || b < box[2 * this->LineAxes[1]] || b > box[2 * this->LineAxes[1] + 1])
+          {
+          continue;
+          }
+
+        const int first = box[2 * this->Axis];
+        const int n = box[2 * this->Axis + 1] - first + 1;
+        const vtkIdType step = this->Stride * numberOfComponents;
+        float* voxel = lineStart + first * step + c;
+        for (int q = 0; q < n; ++q, voxel += step)
+          {
+          scratch.Samples[q] = *voxel;
+          }
+
+        SquaredDistance1D(scratch.Samples.data(), n, this->PositionOffset + first, this->Spacing, scratch.Distances.data(),
+                          scratch.Roots.data(), scratch.Boundaries.data());
+
+        voxel = lineStart + first * step + c;
+        for (int q = 0; q < n; ++q, voxel += step)
+          {
+          *voxel = static_cast<float>(scratch.Distances[q]);
+          }
+        }
+      }
+  }
+
+protected:
+  struct Scratch
+  {
+    std::vector<double> Samples;
+    std::vector<double> Distances;
+    std::vector<int> Roots;
+    std::vector<double> Boundaries;
+  };
+
+  float* Distances;
+  int NumberOfComponents;
+  const std::vector<VoxelBox>& Boxes;
+  int Axis;
+  double Spacing;
+  int PositionOffset;
+  int Length;
+  vtkIdType Stride;
+  int LineAxes[2];
+  vtkIdType LineDimension;
+  vtkIdType LineStrides[2];
+  vtkSMPThreadLocal<Scratch> LocalScratch;
+};
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLiverDistanceMapEngine);
+
+//----------------------------------------------------------------------------
+vtkLiverDistanceMapEngine::vtkLiverDistanceMapEngine()
+  : BandWidth(0.0)
+  , CropToParenchyma(false)
+  , CropMargin(0.0)
+  , QuantizeOutput(false)
+  , QuantizationRange(100.0)
+  , TargetSpacing{0.0, 0.0, 0.0}
+  , AbortExecute(false)
+  , InputExtent{0, -1, 0, -1, 0, -1}
+  , StructureComponents{-1, -1, -1, -1}
+  , OutputBandWidth(0.0)
+  , OutputQuantizationRange(0.0)
+  , ResamplingFactors{1, 1, 1}
+  , OutputBias(0.0)
+{
+  this->Output = vtkSmartPointer<vtkImageData>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkLiverDistanceMapEngine::~vtkLiverDistanceMapEngine() = default;
+
+//----------------------------------------------------------------------------
+void vtkLiverDistanceMapEngine::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfComponents: " << this->GetNumberOfComponents() << "\n";
+  os << indent << "BandWidth: " << this->BandWidth << "\n";
+  os << indent << "CropToParenchyma: " << this->CropToParenchyma << "\n";
+  os << indent << "CropMargin: " << this->CropMargin << "\n";
+  os << indent << "QuantizeOutput: " << this->QuantizeOutput << "\n";
+  os << indent << "QuantizationRange: " << this->QuantizationRange << "\n";
+  os << indent << "TargetSpacing: " << this->TargetSpacing[0] << " " << this->TargetSpacing[1] << " "
+     << this->TargetSpacing[2] << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverDistanceMapEngine::SetStructure(int structure, vtkImageData* labelMap)
+{
+  if (structure < 0 || structure >= NumberOfStructures)
+    {
+    vtkErrorMacro("SetStructure: invalid structure " << structure << ".");
+    return;
+    }
+  if (this->Structures[structure] == labelMap)
+    {
+    return;
+    }
+  this->Structures[structure] = labelMap;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkLiverDistanceMapEngine::GetStructure(int structure) const
+{
+  if (structure < 0 || structure >= NumberOfStructures)
+    {
+    return nullptr;
+    }
+  return this->Structures[structure];
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverDistanceMapEngine::RemoveAllStructures()
+{
+  for (int structure = 0; structure < NumberOfStructures; ++structure)
+    {
+    this->Structures[structure] = nullptr;
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverDistanceMapEngine::GetNumberOfComponents() const
+{
+  int numberOfComponents = 0;
+  for (int structure = 0; structure < NumberOfStructures; ++structure)
+    {
+    numberOfComponents += this->Structures[structure] != nullptr;
+    }
+  return numberOfComponents;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverDistanceMapEngine::SetAbortExecute(bool abort)
+{
+  this->AbortExecute = abort;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverDistanceMapEngine::GetAbortExecute() const
+{
+  return this->AbortExecute;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverDistanceMapEngine::ShallowCopy(vtkLiverDistanceMapEngine* source)
+{
+  if (!source || source == this)
+    {
+    return;
+    }
+
+  for (int structure = 0; structure < NumberOfStructures; ++structure)
+    {
+    this->Structures[structure] = source->Structures[structure];
+    this->ResampledStructures[structure] = source->ResampledStructures[structure];
+    this->StructureComponents[structure] = source->StructureComponents[structure];
+    }
+  this->Output->ShallowCopy(source->Output);
+  this->BandWidth = source->BandWidth;
+  this->CropToParenchyma = source->CropToParenchyma;
+  this->CropMargin = source->CropMargin;
+  this->QuantizeOutput = source->QuantizeOutput;
+  this->QuantizationRange = source->QuantizationRange;
+  std::copy(source->TargetSpacing, source->TargetSpacing + 3, this->TargetSpacing);
+  std::copy(source->InputExtent, source->InputExtent + 6, this->InputExtent);
+  this->OutputBandWidth = source->OutputBandWidth;
+  this->OutputQuantizationRange = source->OutputQuantizationRange;
+  std::copy(source->ResamplingFactors, source->ResamplingFactors + 3, this->ResamplingFactors);
+  this->OutputBias = source->OutputBias;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkLiverDistanceMapEngine::GetOutput() const
+{
+  return this->Output;
+}
+
+//----------------------------------------------------------------------------
+double vtkLiverDistanceMapEngine::GetOutputScale() const
+{
+  return this->OutputQuantizationRange > 0.0 ? this->OutputQuantizationRange / QuantizationLevels : 1.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkLiverDistanceMapEngine::GetOutputOffset() const
+{
+  // Symmetric range: zero is exactly representable
+  return 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverDistanceMapEngine::GetOutputIndexToInputIndex(vtkMatrix4x4* matrix) const
+{
+  if (!matrix)
+    {
+    return;
+    }
+  matrix->Identity();
+  const bool resampled = this->ResamplingFactors[0] > 1 || this->ResamplingFactors[1] > 1
+    || this->ResamplingFactors[2] > 1;
+  if (!resampled)
+    {
+    return;
+    }
+  // Coarse voxel I is centered on the block of voxels from
+  // InputExtent + I * factor
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    matrix->SetElement(axis, axis, this->ResamplingFactors[axis]);
+    matrix->SetElement(axis, 3, this->InputExtent[2 * axis] + 0.5 * (this->ResamplingFactors[axis] - 1));
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverDistanceMapEngine::ResampleStructure(int structure, const int* box)
+{
+  vtkImageData* labelMap = this->Structures[structure];
+  int dimensions[3];
+  labelMap->GetDimensions(dimensions);
+  const int* factors = this->ResamplingFactors;
+  if (!box)
+    {
+    int extent[6];
+    labelMap->GetExtent(extent);
+    const double* origin = labelMap->GetOrigin();
+    const double* spacing = labelMap->GetSpacing();
+    auto resampled = vtkSmartPointer<vtkImageData>::New();
+    resampled->SetExtent(0, (dimensions[0] + factors[0] - 1) / factors[0] - 1,
+                         0, (dimensions[1] + factors[1] - 1) / factors[1] - 1,
+                         0, (dimensions[2] + factors[2] - 1) / factors[2] - 1);
+    resampled->SetOrigin(origin[0] + (extent[0] + 0.5 * (factors[0] - 1)) * spacing[0],
+                         origin[1] + (extent[2] + 0.5 * (factors[1] - 1)) * spacing[1],
+                         origin[2] + (extent[4] + 0.5 * (factors[2] - 1)) * spacing[2]);
+    resampled->SetSpacing(factors[0] * spacing[0], factors[1] * spacing[1], factors[2] * spacing[2]);
+    resampled->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    this->ResampledStructures[structure] = resampled;
+    }
+
+  vtkImageData* resampled = this->ResampledStructures[structure];
+  int resampledDimensions[3];
+  resampled->GetDimensions(resampledDimensions);
+  const int wholeBox[6] = {0, resampledDimensions[0] - 1, 0, resampledDimensions[1] - 1,
+                           0, resampledDimensions[2] - 1};
+  switch (labelMap->GetScalarType())
+    {
+    vtkTemplateMacro(PoolMask(static_cast<const VTK_TT*>(labelMap->GetScalarPointer()),
+                              labelMap->GetNumberOfScalarComponents(), dimensions, factors, box ? box : wholeBox,
+                              static_cast<unsigned char*>(resampled->GetScalarPointer()), resampledDimensions));
+    default:
+      return false;
+    }
+  resampled->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverDistanceMapEngine::Update()
+{
+  std::vector<vtkImageData*> labelMaps;
+  for (int structure = 0; structure < NumberOfStructures; ++structure)
+    {
+    if (this->Structures[structure])
+      {
+      labelMaps.push_back(this->Structures[structure]);
+      }
+    }
+  if (labelMaps.empty())
+    {
+    vtkErrorMacro("Update: no structures.");
+    return false;
+    }
+
+  vtkImageData* reference = labelMaps.front();
+  int extent[6];
+  reference->GetExtent(extent);
+  double spacing[3];
+  reference->GetSpacing(spacing);
+  for (vtkImageData* labelMap : labelMaps)
+    {
+    int labelExtent[6];
+    labelMap->GetExtent(labelExtent);
+    if (!std::equal(extent, extent + 6, labelExtent)
+        || !labelMap->GetPointData()->GetScalars())
+      {
+      vtkErrorMacro("Update: structures must be non-empty and have the same extent.");
+      return false;
+      }
+    }
+
+  // Resampled label maps replace the structures from here on; incremental
+  // updates need a successful Update() again
+  std::fill(this->StructureComponents, this->StructureComponents + NumberOfStructures, -1);
+  std::copy(extent, extent + 6, this->InputExtent);
+  int inputDimensions[3];
+  reference->GetDimensions(inputDimensions);
+  ComputeResamplingFactors(this->TargetSpacing, spacing, inputDimensions, this->ResamplingFactors);
+  const bool resampled = this->ResamplingFactors[0] > 1 || this->ResamplingFactors[1] > 1
+    || this->ResamplingFactors[2] > 1;
+  vtkImageData* parenchyma = this->Structures[Parenchyma];
+  double bias = 0.0;
+  if (resampled)
+    {
+    labelMaps.clear();
+    for (int structure = 0; structure < NumberOfStructures; ++structure)
+      {
+      this->ResampledStructures[structure] = nullptr;
+      if (this->Structures[structure])
+        {
+        if (!this->ResampleStructure(structure, nullptr))
+          {
+          vtkErrorMacro("Update: unsupported label map scalar type.");
+          return false;
+          }
+        labelMaps.push_back(this->ResampledStructures[structure]);
+        }
+      }
+    parenchyma = this->ResampledStructures[Parenchyma];
+    reference = labelMaps.front();
+    reference->GetExtent(extent);
+    reference->GetDimensions(inputDimensions);
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      const double pooled = (this->ResamplingFactors[axis] - 1) * spacing[axis];
+      bias += pooled * pooled;
+      }
+    bias = 0.5 * std::sqrt(bias);
+    reference->GetSpacing(spacing);
+    }
+  else
+    {
+    for (int structure = 0; structure < NumberOfStructures; ++structure)
+      {
+      this->ResampledStructures[structure] = nullptr;
+      }
+    }
+
+  // Aborts are checked between the passes over the image
+  if (this->AbortExecute)
+    {
+    return false;
+    }
+
+  // Computation box: the whole image or the parenchyma grown by the margin
+  VoxelBox box;
+  box.Extent[0] = 0;
+  box.Extent[1] = inputDimensions[0] - 1;
+  box.Extent[2] = 0;
+  box.Extent[3] = inputDimensions[1] - 1;
+  box.Extent[4] = 0;
+  box.Extent[5] = inputDimensions[2] - 1;
+  if (this->CropToParenchyma)
+    {
+    if (!parenchyma)
+      {
+      vtkErrorMacro("Update: cropping to the parenchyma requires a parenchyma label map.");
+      return false;
+      }
+    VoxelBox parenchymaBox;
+    switch (parenchyma->GetScalarType())
+      {
+      vtkTemplateMacro(parenchymaBox = ComputeForegroundBox(static_cast<const VTK_TT*>(parenchyma->GetScalarPointer()),
+                                                            parenchyma->GetNumberOfScalarComponents(),
+                                                            inputDimensions));
+      default:
+        vtkErrorMacro("Update: unsupported label map scalar type.");
+        return false;
+      }
+    if (parenchymaBox.IsEmpty())
+      {
+      vtkErrorMacro("Update: the parenchyma label map is empty.");
+      return false;
+      }
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      const int margin = static_cast<int>(std::min(std::ceil(this->CropMargin / spacing[axis]),
+                                                   static_cast<double>(inputDimensions[axis])));
+      box.Extent[2 * axis] = std::max(0, parenchymaBox.Extent[2 * axis] - margin);
+      box.Extent[2 * axis + 1] = std::min(inputDimensions[axis] - 1, parenchymaBox.Extent[2 * axis + 1] + margin);
+      }
+    }
+
+  const int dimensions[3] = {box.Extent[1] - box.Extent[0] + 1,
+                             box.Extent[3] - box.Extent[2] + 1,
+                             box.Extent[5] - box.Extent[4] + 1};
+  const vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  const int numberOfComponents = static_cast<int>(labelMaps.size());
+
+  std::vector<std::vector<unsigned char>> masks(numberOfComponents);
+  for (int c = 0; c < numberOfComponents; ++c)
+    {
+    masks[c].resize(numberOfVoxels);
+    vtkImageData* labelMap = labelMaps[c];
+    switch (labelMap->GetScalarType())
+      {
+      vtkTemplateMacro(ExtractMask(static_cast<const VTK_TT*>(labelMap->GetScalarPointer()),
+                                   labelMap->GetNumberOfScalarComponents(), inputDimensions, box,
+                                   masks[c].data()));
+      default:
+        vtkErrorMacro("Update: unsupported label map scalar type.");
+        return false;
+      }
+    }
+
+  // The output keeps the indexing of the input: a cropped output has the
+  // sub-extent of the box, so its world placement does not change
+  this->Output->Initialize();
+  this->Output->SetExtent(extent[0] + box.Extent[0], extent[0] + box.Extent[1],
+                          extent[2] + box.Extent[2], extent[2] + box.Extent[3],
+                          extent[4] + box.Extent[4], extent[4] + box.Extent[5]);
+  this->Output->SetOrigin(reference->GetOrigin());
+  this->Output->SetSpacing(spacing);
+  this->Output->AllocateScalars(this->QuantizeOutput ? VTK_SHORT : VTK_FLOAT, numberOfComponents);
+  this->Output->GetPointData()->GetScalars()->SetName("DistanceMap");
+
+  // Quantized distances are computed in a float buffer first
+  const double quantizationRange = this->QuantizeOutput ? this->QuantizationRange : 0.0;
+  std::vector<float> floatDistances(this->QuantizeOutput ? numberOfVoxels * numberOfComponents : 0);
+  float* distances = this->QuantizeOutput
+    ? floatDistances.data() : static_cast<float*>(this->Output->GetScalarPointer());
+
+  if (this->AbortExecute)
+    {
+    return false;
+    }
+
+  // Boundary voxels are the roots of the distance transform. Their bounding
+  // boxes are gathered slice by slice.
+  const vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  std::vector<VoxelBox> sliceBoxes(static_cast<size_t>(dimensions[2]) * numberOfComponents);
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType beginSlice, vtkIdType endSlice)
+    {
+    const vtkIdType steps[3] = {1, dimensions[0], sliceSize};
+    for (int k = static_cast<int>(beginSlice); k < endSlice; ++k)
+      {
+      for (int j = 0; j < dimensions[1]; ++j)
+        {
+        for (int i = 0; i < dimensions[0]; ++i)
+          {
+          const int ijk[3] = {i, j, k};
+          const vtkIdType voxel = i + j * steps[1] + k * steps[2];
+          for (int c = 0; c < numberOfComponents; ++c)
+            {
+            const bool boundary = IsBoundary(masks[c].data(), dimensions, steps, ijk, voxel);
+            distances[voxel * numberOfComponents + c] =
+              boundary ? 0.0f : std::numeric_limits<float>::infinity();
+            if (boundary)
+              {
+              sliceBoxes[k * numberOfComponents + c].Add(ijk);
+              }
+            }
+          }
+        }
+      }
+    });
+
+  // Sweep boxes: the whole image, or the boundary box grown by the band
+  // (voxels out of it are farther than the band along at least one axis,
+  // and saturate even after lowering by the resampling bias)
+  std::vector<VoxelBox> boxes(numberOfComponents);
+  for (int c = 0; c < numberOfComponents; ++c)
+    {
+    for (int k = 0; k < dimensions[2]; ++k)
+      {
+      boxes[c].Add(sliceBoxes[k * numberOfComponents + c]);
+      }
+    if (boxes[c].IsEmpty())
+      {
+      continue;
+      }
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      const int margin = this->BandWidth > 0.0
+        ? static_cast<int>(std::min(std::ceil((this->BandWidth + bias) / spacing[axis]),
+                                    static_cast<double>(dimensions[axis])))
+        : dimensions[axis];
+      boxes[c].Extent[2 * axis] = std::max(0, boxes[c].Extent[2 * axis] - margin);
+      boxes[c].Extent[2 * axis + 1] = std::min(dimensions[axis] - 1, boxes[c].Extent[2 * axis + 1] + margin);
+      }
+    }
+
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if (this->AbortExecute)
+      {
+      return false;
+      }
+    if (dimensions[axis] < 2)
+      {
+      continue;
+      }
+    AxisSweep sweep(distances, dimensions, numberOfComponents, boxes, axis, spacing[axis]);
+    vtkSMPTools::For(0, numberOfVoxels / dimensions[axis], sweep);
+    }
+
+  if (this->AbortExecute)
+    {
+    return false;
+    }
+
+  // Signed distances, saturated out of the band or the quantization range
+  // (or for structures without boundary), lowered by the resampling bias
+  const float saturation = GetSaturation(this->BandWidth, quantizationRange);
+  const double scale = quantizationRange / QuantizationLevels;
+  short* quantizedDistances = static_cast<short*>(this->Output->GetScalarPointer());
+  vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType voxel = begin; voxel < end; ++voxel)
+      {
+      for (int c = 0; c < numberOfComponents; ++c)
+        {
+        float& distance = distances[voxel * numberOfComponents + c];
+        distance = SignedDistance(distance, masks[c][voxel] != 0, saturation, bias);
+        if (this->QuantizeOutput)
+          {
+          quantizedDistances[voxel * numberOfComponents + c] = QuantizeDistance(distance, scale);
+          }
+        }
+      }
+    });
+
+  for (int structure = 0, c = 0; structure < NumberOfStructures; ++structure)
+    {
+    this->StructureComponents[structure] = this->Structures[structure] ? c++ : -1;
+    }
+  this->OutputBandWidth = this->BandWidth;
+  this->OutputQuantizationRange = quantizationRange;
+  this->OutputBias = bias;
+
+  this->Output->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverDistanceMapEngine::UpdateStructure(int structure, const int changedExtent[6])
+{
+  if (structure < 0 || structure >= NumberOfStructures || !this->Structures[structure]
+      || this->StructureComponents[structure] < 0 || this->OutputBandWidth != this->BandWidth
+      || this->OutputQuantizationRange != (this->QuantizeOutput ? this->QuantizationRange : 0.0))
+    {
+    vtkErrorMacro("UpdateStructure: the distance maps of structure " << structure
+                  << " must be computed with the current settings first.");
+    return false;
+    }
+  vtkImageData* labelMap = this->Structures[structure];
+  int labelExtent[6];
+  labelMap->GetExtent(labelExtent);
+  if (!std::equal(labelExtent, labelExtent + 6, this->InputExtent) || !labelMap->GetScalarPointer())
+    {
+    vtkErrorMacro("UpdateStructure: the label map of structure " << structure << " changed its extent.");
+    return false;
+    }
+  int factors[3];
+  ComputeResamplingFactors(this->TargetSpacing, labelMap->GetSpacing(), labelMap->GetDimensions(), factors);
+  if (!std::equal(factors, factors + 3, this->ResamplingFactors))
+    {
+    vtkErrorMacro("UpdateStructure: the distance maps of structure " << structure
+                  << " must be computed with the current settings first.");
+    return false;
+    }
+
+  // Extent of the grid of the distance transform and changed voxels in it:
+  // the label maps, or the resampled label map after pooling the changed
+  // coarse voxels again
+  int gridExtent[6];
+  std::copy(this->InputExtent, this->InputExtent + 6, gridExtent);
+  int gridChangedExtent[6];
+  std::copy(changedExtent, changedExtent + 6, gridChangedExtent);
+  if (this->ResampledStructures[structure])
+    {
+    labelMap = this->ResampledStructures[structure];
+    labelMap->GetExtent(gridExtent);
+    int pooledBox[6];
+    bool empty = false;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      const int first = changedExtent[2 * axis] - this->InputExtent[2 * axis];
+      const int last = changedExtent[2 * axis + 1] - this->InputExtent[2 * axis];
+      pooledBox[2 * axis] = std::max(0, first >= 0 ? first / factors[axis] : -1);
+      pooledBox[2 * axis + 1] = std::min(gridExtent[2 * axis + 1], last >= 0 ? last / factors[axis] : -1);
+      empty = empty || pooledBox[2 * axis] > pooledBox[2 * axis + 1];
+      gridChangedExtent[2 * axis] = pooledBox[2 * axis];
+      gridChangedExtent[2 * axis + 1] = pooledBox[2 * axis + 1];
+      }
+    if (empty)
+      {
+      return true;
+      }
+    if (!this->ResampleStructure(structure, pooledBox))
+      {
+      vtkErrorMacro("UpdateStructure: unsupported label map scalar type.");
+      return false;
+      }
+    }
+
+  const int component = this->StructureComponents[structure];
+  const int numberOfComponents = this->Output->GetNumberOfScalarComponents();
+  const double scale = this->GetOutputScale();
+  const bool quantized = this->OutputQuantizationRange > 0.0;
+  float* distances = static_cast<float*>(this->Output->GetScalarPointer());
+  short* quantizedDistances = static_cast<short*>(this->Output->GetScalarPointer());
+  auto outputDistance = [&](vtkIdType voxel)
+    {
+    const vtkIdType index = voxel * numberOfComponents + component;
+    return quantized ? static_cast<float>(quantizedDistances[index] * scale) : distances[index];
+    };
+  int inputDimensions[3];
+  labelMap->GetDimensions(inputDimensions);
+  int dimensions[3];
+  this->Output->GetDimensions(dimensions);
+  double spacing[3];
+  this->Output->GetSpacing(spacing);
+  const int* outputExtent = this->Output->GetExtent();
+  const int offset[3] = {outputExtent[0] - gridExtent[0],
+                         outputExtent[2] - gridExtent[2],
+                         outputExtent[4] - gridExtent[4]};
+  const vtkIdType steps[3] = {1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1]};
+
+  // Region whose boundary voxels may have changed: the changed voxels and
+  // their face neighbors (output indices)
+  VoxelBox changed;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    changed.Extent[2 * axis] = std::max(0, gridChangedExtent[2 * axis] - gridExtent[2 * axis] - offset[axis] - 1);
+    changed.Extent[2 * axis + 1] = std::min(dimensions[axis] - 1,
+                                            gridChangedExtent[2 * axis + 1] - gridExtent[2 * axis] - offset[axis] + 1);
+    if (changed.Extent[2 * axis] > changed.Extent[2 * axis + 1])
+      {
+      // Out of the output region, which does not see the change
+      return true;
+      }
+    }
+
+  // Wavefront from the changed region over the voxels that may be closer to
+  // it than to their current closest boundary voxel. Distances are
+  // 1-Lipschitz, so these voxels are connected to the changed region through
+  // voxels meeting the same condition, up to two voxel diagonals (and the
+  // quantization error and the resampling bias).
+  const double slack = 2.0 * std::sqrt(spacing[0] * spacing[0] + spacing[1] * spacing[1] + spacing[2] * spacing[2])
+    + (quantized ? scale : 0.0) + this->OutputBias;
+  auto distanceToChanged = [&](const int ijk[3])
+    {
+    double distance2 = 0.0;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      const int gap = std::max({0, changed.Extent[2 * axis] - ijk[axis], ijk[axis] - changed.Extent[2 * axis + 1]});
+      distance2 += gap * spacing[axis] * gap * spacing[axis];
+      }
+    return std::sqrt(distance2);
+    };
+
+  const vtkIdType numberOfVoxels = steps[2] * dimensions[2];
+  std::vector<bool> reached(numberOfVoxels, false);
+  std::vector<vtkIdType> front;
+  for (int k = changed.Extent[4]; k <= changed.Extent[5]; ++k)
+    {
+    for (int j = changed.Extent[2]; j <= changed.Extent[3]; ++j)
+      {
+      for (int i = changed.Extent[0]; i <= changed.Extent[1]; ++i)
+        {
+        const vtkIdType voxel = i + j * steps[1] + k * steps[2];
+        reached[voxel] = true;
+        front.push_back(voxel);
+        }
+      }
+    }
+  VoxelBox affected = changed;
+  double maximumDistance = 0.0;
+  for (size_t next = 0; next < front.size(); ++next)
+    {
+    const vtkIdType voxel = front[next];
+    maximumDistance = std::max(maximumDistance, static_cast<double>(std::fabs(outputDistance(voxel))));
+    const int ijk[3] = {static_cast<int>(voxel % dimensions[0]),
+                        static_cast<int>((voxel / dimensions[0]) % dimensions[1]),
+                        static_cast<int>(voxel / steps[2])};
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      for (int direction = -1; direction <= 1; direction += 2)
+        {
+        int neighborIjk[3] = {ijk[0], ijk[1], ijk[2]};
+        neighborIjk[axis] += direction;
+        if (neighborIjk[axis] < 0 || neighborIjk[axis] >= dimensions[axis])
+          {
+          continue;
+          }
+        const vtkIdType neighbor = voxel + direction * steps[axis];
+        if (reached[neighbor]
+            || distanceToChanged(neighborIjk) > std::fabs(outputDistance(neighbor)) + slack)
+          {
+          continue;
+          }
+        reached[neighbor] = true;
+        front.push_back(neighbor);
+        affected.Add(neighborIjk);
+        }
+      }
+    }
+
+  // Distances of the reached voxels from the boundary voxels of a block
+  // around them. The block grows until no boundary voxel out of it can be
+  // closer than the computed distances (or it covers the output region).
+  const float saturation = GetSaturation(this->OutputBandWidth, this->OutputQuantizationRange);
+  double blockMargin = std::min(maximumDistance, static_cast<double>(VTK_FLOAT_MAX)) + distanceToChanged(affected.Extent);
+  for (;;)
+    {
+    VoxelBox block;
+    bool wholeOutput = true;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      const int margin = static_cast<int>(std::min(std::ceil(blockMargin / spacing[axis]), static_cast<double>(dimensions[axis])));
+      block.Extent[2 * axis] = std::max(0, affected.Extent[2 * axis] - margin);
+      block.Extent[2 * axis + 1] = std::min(dimensions[axis] - 1, affected.Extent[2 * axis + 1] + margin);
+      wholeOutput = wholeOutput && block.Extent[2 * axis] == 0 && block.Extent[2 * axis + 1] == dimensions[axis] - 1;
+      }
+    const int blockDimensions[3] = {block.Extent[1] - block.Extent[0] + 1,
+                                    block.Extent[3] - block.Extent[2] + 1,
+                                    block.Extent[5] - block.Extent[4] + 1};
+    const vtkIdType blockSteps[3] = {1, blockDimensions[0], static_cast<vtkIdType>(blockDimensions[0]) * blockDimensions[1]};
+
+    // Mask of the block and its neighbors within the output region
+    VoxelBox maskBox;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      maskBox.Extent[2 * axis] = std::max(0, block.Extent[2 * axis] - 1) + offset[axis];
+      maskBox.Extent[2 * axis + 1] = std::min(dimensions[axis] - 1, block.Extent[2 * axis + 1] + 1) + offset[axis];
+      }
+    const int maskDimensions[3] = {maskBox.Extent[1] - maskBox.Extent[0] + 1,
+                                   maskBox.Extent[3] - maskBox.Extent[2] + 1,
+                                   maskBox.Extent[5] - maskBox.Extent[4] + 1};
+    const vtkIdType maskSteps[3] = {1, maskDimensions[0], static_cast<vtkIdType>(maskDimensions[0]) * maskDimensions[1]};
+    std::vector<unsigned char> mask(maskSteps[2] * maskDimensions[2]);
+    switch (labelMap->GetScalarType())
+      {
+      vtkTemplateMacro(ExtractMask(static_cast<const VTK_TT*>(labelMap->GetScalarPointer()),
+                                   labelMap->GetNumberOfScalarComponents(), inputDimensions, maskBox,
+                                   mask.data()));
+      default:
+        vtkErrorMacro("UpdateStructure: unsupported label map scalar type.");
+        return false;
+      }
+    const int maskOffset[3] = {block.Extent[0] + offset[0] - maskBox.Extent[0],
+                               block.Extent[2] + offset[1] - maskBox.Extent[2],
+                               block.Extent[4] + offset[2] - maskBox.Extent[4]};
+    auto maskVoxel = [&](const int blockIjk[3])
+      {
+      return (blockIjk[0] + maskOffset[0]) + (blockIjk[1] + maskOffset[1]) * maskSteps[1]
+        + (blockIjk[2] + maskOffset[2]) * maskSteps[2];
+      };
+
+    std::vector<float> blockDistances(blockSteps[2] * blockDimensions[2]);
+    vtkSMPTools::For(0, blockDimensions[2], [&](vtkIdType beginSlice, vtkIdType endSlice)
+      {
+      for (int k = static_cast<int>(beginSlice); k < endSlice; ++k)
+        {
+        for (int j = 0; j < blockDimensions[1]; ++j)
+          {
+          for (int i = 0; i < blockDimensions[0]; ++i)
+            {
+            const int blockIjk[3] = {i, j, k};
+            const int maskIjk[3] = {i + maskOffset[0], j + maskOffset[1], k + maskOffset[2]};
+            blockDistances[i + j * blockSteps[1] + k * blockSteps[2]] =
+              IsBoundary(mask.data(), maskDimensions, maskSteps, maskIjk, maskVoxel(blockIjk))
+              ? 0.0f : std::numeric_limits<float>::infinity();
+            }
+          }
+        }
+      });
+
+    const std::vector<VoxelBox> blockBoxes(1, VoxelBox{{0, blockDimensions[0] - 1, 0, blockDimensions[1] - 1,
+                                                        0, blockDimensions[2] - 1}});
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      if (blockDimensions[axis] < 2)
+        {
+        continue;
+        }
+      AxisSweep sweep(blockDistances.data(), blockDimensions, 1, blockBoxes, axis, spacing[axis],
+                      block.Extent[2 * axis]);
+      vtkSMPTools::For(0, blockSteps[2] * blockDimensions[2] / blockDimensions[axis], sweep);
+      }
+
+    // A reached voxel is resolved if the boundary voxels out of the block
+    // are farther than its distance (or beyond the band)
+    bool resolved = true;
+    for (size_t next = 0; next < front.size() && resolved && !wholeOutput; ++next)
+      {
+      const vtkIdType voxel = front[next];
+      const int ijk[3] = {static_cast<int>(voxel % dimensions[0]),
+                          static_cast<int>((voxel / dimensions[0]) % dimensions[1]),
+                          static_cast<int>(voxel / steps[2])};
+      double distanceToOutside = VTK_DOUBLE_MAX;
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        if (block.Extent[2 * axis] > 0)
+          {
+          distanceToOutside = std::min(distanceToOutside, (ijk[axis] - block.Extent[2 * axis] + 1) * spacing[axis]);
+          }
+        if (block.Extent[2 * axis + 1] < dimensions[axis] - 1)
+          {
+          distanceToOutside = std::min(distanceToOutside, (block.Extent[2 * axis + 1] - ijk[axis] + 1) * spacing[axis]);
+          }
+        }
+      const double blockDistance = std::sqrt(static_cast<double>(
+        blockDistances[(ijk[0] - block.Extent[0]) + (ijk[1] - block.Extent[2]) * blockSteps[1]
+                       + (ijk[2] - block.Extent[4]) * blockSteps[2]]));
+      resolved = blockDistance <= distanceToOutside || distanceToOutside >= saturation + this->OutputBias;
+      }
+    if (!resolved)
+      {
+      blockMargin *= 2.0;
+      continue;
+      }
+
+    vtkSMPTools::For(0, static_cast<vtkIdType>(front.size()), [&](vtkIdType begin, vtkIdType end)
+      {
+      for (vtkIdType next = begin; next < end; ++next)
+        {
+        const vtkIdType voxel = front[next];
+        const int blockIjk[3] = {static_cast<int>(voxel % dimensions[0]) - block.Extent[0],
+                                 static_cast<int>((voxel / dimensions[0]) % dimensions[1]) - block.Extent[2],
+                                 static_cast<int>(voxel / steps[2]) - block.Extent[4]};
+        const float distance = SignedDistance(
+          blockDistances[blockIjk[0] + blockIjk[1] * blockSteps[1] + blockIjk[2] * blockSteps[2]],
+          mask[maskVoxel(blockIjk)] != 0, saturation, this->OutputBias);
+        if (quantized)
+          {
+          quantizedDistances[voxel * numberOfComponents + component] = QuantizeDistance(distance, scale);
+          }
+        else
+          {
+          distances[voxel * numberOfComponents + component] = distance;
+          }
+        }
+      });
+    break;
+    }
+
+  this->Output->Modified();
+  return true;
+}
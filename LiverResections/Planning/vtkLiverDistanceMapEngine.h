@@ -0,0 +1,231 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverDistanceMapEngine_h
+#define __vtkLiverDistanceMapEngine_h
+
+#include "vtkSlicerLiverResectionsModulePlanningExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <atomic>
+
+//------------------------------------------------------------------------------
+class vtkImageData;
+class vtkMatrix4x4;
+
+//------------------------------------------------------------------------------
+/// \brief Signed distance maps of the liver structures in a single pass.
+///
+/// Computes the signed euclidean distance (in mm, negative inside) to the
+/// boundary of up to four label maps (tumor, parenchyma, hepatic and portal
+/// veins) sharing the same geometry. The result is a float image with one
+/// component per available structure, interleaved in structure order, which
+/// is the layout of the distance map textures of the bezier surface
+/// representation.
+///
+/// The distance transform is the separable algorithm of Felzenszwalb and
+/// Huttenlocher (squared distances by lower envelopes of parabolas along each
+/// axis). Every scanline is swept once per axis for all the structures, and
+/// the scanlines are processed in parallel with vtkSMPTools. Distances are
+/// measured to the centers of the boundary voxels (foreground voxels with a
+/// background face neighbor), as SimpleITK's SignedMaurerDistanceMap.
+///
+/// With a band width, distances are only computed within the bounding box of
+/// each boundary grown by the band, and saturate to +/- the band width out of
+/// the band. Values within the band are identical to the unbanded ones.
+///
+/// With CropToParenchyma, the output only covers the bounding box of the
+/// parenchyma grown by CropMargin. Its extent is the corresponding sub-extent
+/// of the input, so the world placement of the voxels does not change.
+/// Distances up to CropMargin are exact within the bounding box of the
+/// parenchyma, since every structure voxel out of the output is farther.
+///
+/// With QuantizeOutput, the output is a short image of the distances
+/// clamped to +/- QuantizationRange in 16-bit fixed point, which halves the
+/// memory of the volume and of its texture (signed normalized, so that it is
+/// still linearly interpolated). Distances are value * GetOutputScale() +
+/// GetOutputOffset(), with an error of at most half the scale (1.5 um for the
+/// default range of 100 mm).
+///
+/// With a TargetSpacing, the distance maps are computed on a coarser grid:
+/// each axis is downsampled by the integer factor closest to the target
+/// spacing over the spacing of the label maps. A coarse voxel is inside a
+/// structure if any of its voxels is (max pooling), so structures never
+/// shrink, and the distances are lowered by half the diagonal of the pooled
+/// voxels (the farthest a voxel is from the center of its coarse voxel): out
+/// of the structures, the coarse distances never exceed the distances of the
+/// label maps, so margins stay conservative. The work drops by the product of
+/// the factors. The output covers the coarse grid, whose voxel centers are the
+/// centers of the pooled blocks (see GetOutputIndexToInputIndex()).
+class VTK_SLICER_LIVERRESECTIONS_MODULE_PLANNING_EXPORT vtkLiverDistanceMapEngine
+  : public vtkObject
+{
+public:
+  static vtkLiverDistanceMapEngine* New();
+  vtkTypeMacro(vtkLiverDistanceMapEngine, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum Structure
+  {
+    Tumor = 0,
+    Parenchyma,
+    HepaticVein,
+    PortalVein,
+    NumberOfStructures
+  };
+
+  /// Label map of a structure (voxels different from zero are inside).
+  /// Origin and spacing of the image data are used; all the structures must
+  /// have the same extent. Set to nullptr to skip the structure.
+  void SetStructure(int structure, vtkImageData* labelMap);
+  vtkImageData* GetStructure(int structure) const;
+  void RemoveAllStructures();
+
+  /// Number of structures set (components of the output)
+  int GetNumberOfComponents() const;
+
+  /// Distances (mm) beyond which the output saturates (0, the default,
+  /// computes the distances over the whole image)
+  vtkSetClampMacro(BandWidth, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(BandWidth, double);
+
+  /// Crop the output to the parenchyma grown by CropMargin (mm)
+  vtkSetMacro(CropToParenchyma, bool);
+  vtkGetMacro(CropToParenchyma, bool);
+  vtkBooleanMacro(CropToParenchyma, bool);
+  vtkSetClampMacro(CropMargin, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(CropMargin, double);
+
+  /// Store the distances as 16-bit fixed point, clamped to
+  /// +/- QuantizationRange (mm)
+  vtkSetMacro(QuantizeOutput, bool);
+  vtkGetMacro(QuantizeOutput, bool);
+  vtkBooleanMacro(QuantizeOutput, bool);
+  vtkSetClampMacro(QuantizationRange, double, 1e-3, VTK_FLOAT_MAX);
+  vtkGetMacro(QuantizationRange, double);
+
+  /// Spacing (mm) of the grid the distance maps are computed on. Zero (the
+  /// default) keeps the spacing of the label maps along that axis.
+  vtkSetVector3Macro(TargetSpacing, double);
+  vtkGetVector3Macro(TargetSpacing, double);
+
+  /// Computes the distance maps. Returns false if no structure is set or the
+  /// structures do not share the same geometry.
+  bool Update();
+
+  /// Makes a running Update() stop and return false, e.g. from another
+  /// thread (as vtkAlgorithm::AbortExecute). Update() does not reset it, and
+  /// the output of an aborted Update() is undefined.
+  void SetAbortExecute(bool abort);
+  bool GetAbortExecute() const;
+
+  /// Updates the distance map of a structure after its label map changed
+  /// within changedExtent (voxel indices of the label map), e.g. after a
+  /// segmentation edit. Only the voxels that may be closer to the changed
+  /// region than to their closest boundary voxel are recomputed, from the
+  /// boundary voxels of a block around them. The result is the one of a full
+  /// Update(). Requires a previous Update() with the same structures and
+  /// settings.
+  bool UpdateStructure(int structure, const int changedExtent[6]);
+
+  /// Takes the structures, settings, output and state of the last Update()
+  /// of another engine, sharing their images, so that UpdateStructure()
+  /// continues from the distance maps computed by that engine (e.g. the last
+  /// level of a vtkLiverProgressiveDistanceMapEngine).
+  void ShallowCopy(vtkLiverDistanceMapEngine* source);
+
+  /// Distance maps of the last Update()
+  vtkImageData* GetOutput() const;
+
+  /// Distance (mm) of an output value: value * scale + offset. The scale is
+  /// 1 and the offset 0 for float outputs.
+  double GetOutputScale() const;
+  double GetOutputOffset() const;
+
+  /// Resampling factors of the last Update() along each axis (1 without
+  /// TargetSpacing)
+  const int* GetResamplingFactors() const { return this->ResamplingFactors; }
+
+  /// Maps the structured indices of the output to the continuous indices of
+  /// the label maps (identity without TargetSpacing)
+  void GetOutputIndexToInputIndex(vtkMatrix4x4* matrix) const;
+
+protected:
+  vtkLiverDistanceMapEngine();
+  ~vtkLiverDistanceMapEngine() override;
+
+protected:
+  vtkSmartPointer<vtkImageData> Structures[NumberOfStructures];
+  vtkSmartPointer<vtkImageData> Output;
+  double BandWidth;
+  bool CropToParenchyma;
+  double CropMargin;
+  bool QuantizeOutput;
+  double QuantizationRange;
+  double TargetSpacing[3];
+  std::atomic<bool> AbortExecute;
+
+  /// Max pooled label maps of the last Update() with TargetSpacing
+  vtkSmartPointer<vtkImageData> ResampledStructures[NumberOfStructures];
+
+  /// State of the last Update(), for UpdateStructure(). The quantization
+  /// range is 0 for float outputs.
+  int InputExtent[6];
+  int StructureComponents[NumberOfStructures];
+  double OutputBandWidth;
+  double OutputQuantizationRange;
+  int ResamplingFactors[3];
+  /// Lowering of the distances of a resampled output
+  double OutputBias;
+
+  /// Max pools the label map of a structure into its resampled label map
+  /// within the coarse voxel box (allocating it if box is nullptr). Returns
+  /// false for unsupported scalar types.
+  bool ResampleStructure(int structure, const int* box);
+
+private:
+  vtkLiverDistanceMapEngine(const vtkLiverDistanceMapEngine&) = delete;
+  void operator=(const vtkLiverDistanceMapEngine&) = delete;
+};
+
+#endif // __vtkLiverDistanceMapEngine_h
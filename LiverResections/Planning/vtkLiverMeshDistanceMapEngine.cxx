@@ -0,0 +1,782 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkLiverMeshDistanceMapEngine.h"
+#include "vtkLiverDistanceMapQuantization.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+using namespace vtkLiverDistanceMapQuantization;
+
+// Triangles per leaf of the hierarchy
+const vtkIdType LeafSize = 4;
+
+// Grid points without triangles within the search radius
+const float Unresolved = std::numeric_limits<float>::infinity();
+
+// Features of a triangle holding the closest point: the face, the edges
+// (ab, bc, ca) and the vertices (a, b, c)
+const int FaceFeature = 0;
+const int EdgeFeature = 1;
+const int VertexFeature = 4;
+
+//------------------------------------------------------------------------------
+/// Closest point of the triangle (a, b, c) to p and the feature holding it,
+/// by the Voronoi regions of the triangle (Ericson, Real-Time Collision
+/// Detection, 5.1.5)
+int ClosestPointOnTriangle(const double p[3], const double a[3], const double b[3], const double c[3],
+                           double closest[3])
+{
+  double ab[3];
+  double ac[3];
+  double ap[3];
+  vtkMath::Subtract(b, a, ab);
+  vtkMath::Subtract(c, a, ac);
+  vtkMath::Subtract(p, a, ap);
+  const double d1 = vtkMath::Dot(ab, ap);
+  const double d2 = vtkMath::Dot(ac, ap);
+  if (d1 <= 0.0 && d2 <= 0.0)
+    {
+    std::copy(a, a + 3, closest);
+    return VertexFeature;
+    }
+
+  double bp[3];
+  vtkMath::Subtract(p, b, bp);
+  const double d3 = vtkMath::Dot(ab, bp);
+  const double d4 = vtkMath::Dot(ac, bp);
+  if (d3 >= 0.0 && d4 <= d3)
+    {
+    std::copy(b, b + 3, closest);
+    return VertexFeature + 1;
+    }
+
+  const double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+    const double v = d1 / (d1 - d3);
+    for (int i = 0; i < 3; ++i)
+      {
+      closest[i] = a[i] + v * ab[i];
+      }
+    return EdgeFeature;
+    }
+
+  double cp[3];
+  vtkMath::Subtract(p, c, cp);
+  const double d5 = vtkMath::Dot(ab, cp);
+  const double d6 = vtkMath::Dot(ac, cp);
+  if (d6 >= 0.0 && d5 <= d6)
+    {
+    std::copy(c, c + 3, closest);
+    return VertexFeature + 2;
+    }
+
+  const double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+    const double w = d2 / (d2 - d6);
+    for (int i = 0; i < 3; ++i)
+      {
+      closest[i] = a[i] + w * ac[i];
+      }
+    return EdgeFeature + 2;
+    }
+
+  const double va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+    {
+    const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    for (int i = 0; i < 3; ++i)
+      {
+      closest[i] = b[i] + w * (c[i] - b[i]);
+      }
+    return EdgeFeature + 1;
+    }
+
+  const double denominator = 1.0 / (va + vb + vc);
+  const double v = vb * denominator;
+  const double w = vc * denominator;
+  for (int i = 0; i < 3; ++i)
+    {
+    closest[i] = a[i] + v * ab[i] + w * ac[i];
+    }
+  return FaceFeature;
+}
+
+//------------------------------------------------------------------------------
+inline double SquaredDistanceToBounds(const double p[3], const double bounds[6])
+{
+  double squaredDistance = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const double below = bounds[2 * axis] - p[axis];
+    const double above = p[axis] - bounds[2 * axis + 1];
+    const double d = std::max(0.0, std::max(below, above));
+    squaredDistance += d * d;
+    }
+  return squaredDistance;
+}
+
+//------------------------------------------------------------------------------
+/// Bounding volume hierarchy of the triangles of a closed surface, with the
+/// angle weighted pseudo normals of its faces, edges and vertices (Baerentzen
+/// and Aanaes, Signed distance computation using the angle weighted pseudo
+/// normal, 2005): the closest point is inside if the vector to it points
+/// along the pseudo normal of its feature.
+class SurfaceHierarchy
+{
+public:
+  /// Builds the hierarchy of the triangles of a surface. Returns false if it
+  /// has none.
+  bool Build(vtkPolyData* surface);
+
+  bool IsEmpty() const
+  {
+    return this->Triangles.empty();
+  }
+
+  /// Closest point of the surface to p, among the ones closer than the
+  /// square root of maximumSquaredDistance. Returns false if there is none.
+  bool FindClosestPoint(const double p[3], double maximumSquaredDistance,
+                        double& squaredDistance, bool& inside) const;
+
+private:
+  struct Triangle
+  {
+    vtkIdType Points[3];
+    vtkIdType Edges[3];   ///< Edge pseudo normals of ab, bc and ca
+    double Normal[3];
+  };
+
+  struct Node
+  {
+    double Bounds[6];
+    vtkIdType Begin;   ///< Triangles of the node
+    vtkIdType End;
+    vtkIdType Left;    ///< Children, -1 for leaves
+    vtkIdType Right;
+  };
+
+  vtkIdType BuildNode(vtkIdType begin, vtkIdType end, std::vector<vtkIdType>& order,
+                      const std::vector<std::array<double, 3>>& centroids);
+
+  std::vector<std::array<double, 3>> Points;
+  std::vector<std::array<double, 3>> VertexNormals;
+  std::vector<std::array<double, 3>> EdgeNormals;
+  std::vector<Triangle> Triangles;
+  std::vector<Node> Nodes;
+};
+
+//------------------------------------------------------------------------------
+bool SurfaceHierarchy::Build(vtkPolyData* surface)
+{
+  this->Points.clear();
+  this->VertexNormals.clear();
+  this->EdgeNormals.clear();
+  this->Triangles.clear();
+  this->Nodes.clear();
+  if (!surface || !surface->GetPoints() || !surface->GetPolys())
+    {
+    return false;
+    }
+
+  const vtkIdType numberOfPoints = surface->GetNumberOfPoints();
+  this->Points.resize(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    surface->GetPoint(i, this->Points[i].data());
+    }
+  this->VertexNormals.assign(numberOfPoints, {0.0, 0.0, 0.0});
+
+  // Edges are shared by the triangles on both sides
+  std::unordered_map<std::uint64_t, vtkIdType> edges;
+  auto edgeIndex = [&](vtkIdType p0, vtkIdType p1)
+    {
+    const std::uint64_t key = (static_cast<std::uint64_t>(std::min(p0, p1)) << 32)
+      | static_cast<std::uint64_t>(std::max(p0, p1));
+    auto inserted = edges.emplace(key, static_cast<vtkIdType>(this->EdgeNormals.size()));
+    if (inserted.second)
+      {
+      this->EdgeNormals.push_back({0.0, 0.0, 0.0});
+      }
+    return inserted.first->second;
+    };
+
+  // Six times the signed volume, to orient the pseudo normals outwards
+  double volume = 0.0;
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto iter = vtk::TakeSmartPointer(surface->GetPolys()->NewIterator());
+  for (iter->GoToFirstCell(); !iter->IsDoneWithTraversal(); iter->GoToNextCell())
+    {
+    iter->GetCurrentCell(npts, pts);
+    for (vtkIdType n = 1; n + 1 < npts; ++n)
+      {
+      Triangle triangle;
+      triangle.Points[0] = pts[0];
+      triangle.Points[1] = pts[n];
+      triangle.Points[2] = pts[n + 1];
+      const double* corners[3] = {this->Points[triangle.Points[0]].data(),
+                                  this->Points[triangle.Points[1]].data(),
+                                  this->Points[triangle.Points[2]].data()};
+      double ab[3];
+      double ac[3];
+      vtkMath::Subtract(corners[1], corners[0], ab);
+      vtkMath::Subtract(corners[2], corners[0], ac);
+      vtkMath::Cross(ab, ac, triangle.Normal);
+      if (vtkMath::Normalize(triangle.Normal) == 0.0)
+        {
+        // Degenerate triangles are covered by their neighbors
+        continue;
+        }
+      double cross[3];
+      vtkMath::Cross(corners[1], corners[2], cross);
+      volume += vtkMath::Dot(corners[0], cross);
+
+      for (int v = 0; v < 3; ++v)
+        {
+        double toNext[3];
+        double toPrevious[3];
+        vtkMath::Subtract(corners[(v + 1) % 3], corners[v], toNext);
+        vtkMath::Subtract(corners[(v + 2) % 3], corners[v], toPrevious);
+        const double angle = vtkMath::AngleBetweenVectors(toNext, toPrevious);
+        std::array<double, 3>& vertexNormal = this->VertexNormals[triangle.Points[v]];
+        std::array<double, 3>& edgeNormal =
+          this->EdgeNormals[triangle.Edges[v] = edgeIndex(triangle.Points[v], triangle.Points[(v + 1) % 3])];
+        for (int i = 0; i < 3; ++i)
+          {
+          vertexNormal[i] += angle * triangle.Normal[i];
+          edgeNormal[i] += triangle.Normal[i];
+          }
+        }
+      this->Triangles.push_back(triangle);
+      }
+    }
+
+  const vtkIdType numberOfTriangles = static_cast<vtkIdType>(this->Triangles.size());
+  if (numberOfTriangles == 0)
+    {
+    return false;
+    }
+
+  if (volume < 0.0)
+    {
+    for (Triangle& triangle : this->Triangles)
+      {
+      vtkMath::MultiplyScalar(triangle.Normal, -1.0);
+      }
+    for (std::array<double, 3>& normal : this->VertexNormals)
+      {
+      vtkMath::MultiplyScalar(normal.data(), -1.0);
+      }
+    for (std::array<double, 3>& normal : this->EdgeNormals)
+      {
+      vtkMath::MultiplyScalar(normal.data(), -1.0);
+      }
+    }
+
+  std::vector<std::array<double, 3>> centroids(numberOfTriangles);
+  std::vector<vtkIdType> order(numberOfTriangles);
+  for (vtkIdType t = 0; t < numberOfTriangles; ++t)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      centroids[t][i] = (this->Points[this->Triangles[t].Points[0]][i] + this->Points[this->Triangles[t].Points[1]][i]
+                         + this->Points[this->Triangles[t].Points[2]][i]) / 3.0;
+      }
+    order[t] = t;
+    }
+  this->Nodes.reserve(2 * (numberOfTriangles / LeafSize + 1));
+  this->BuildNode(0, numberOfTriangles, order, centroids);
+
+  // Triangles in the order of the leaves
+  std::vector<Triangle> triangles(numberOfTriangles);
+  for (vtkIdType t = 0; t < numberOfTriangles; ++t)
+    {
+    triangles[t] = this->Triangles[order[t]];
+    }
+  this->Triangles.swap(triangles);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+vtkIdType SurfaceHierarchy::BuildNode(vtkIdType begin, vtkIdType end, std::vector<vtkIdType>& order,
+                                      const std::vector<std::array<double, 3>>& centroids)
+{
+  Node node;
+  node.Begin = begin;
+  node.End = end;
+  node.Left = -1;
+  node.Right = -1;
+  node.Bounds[0] = node.Bounds[2] = node.Bounds[4] = VTK_DOUBLE_MAX;
+  node.Bounds[1] = node.Bounds[3] = node.Bounds[5] = VTK_DOUBLE_MIN;
+  double centroidBounds[6] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN};
+  for (vtkIdType n = begin; n < end; ++n)
+    {
+    const vtkIdType triangle = order[n];
+    for (vtkIdType point : this->Triangles[triangle].Points)
+      {
+      for (int c = 0; c < 3; ++c)
+        {
+        node.Bounds[2 * c] = std::min(node.Bounds[2 * c], this->Points[point][c]);
+        node.Bounds[2 * c + 1] = std::max(node.Bounds[2 * c + 1], this->Points[point][c]);
+        }
+      }
+    for (int c = 0; c < 3; ++c)
+      {
+      centroidBounds[2 * c] = std::min(centroidBounds[2 * c], centroids[triangle][c]);
+      centroidBounds[2 * c + 1] = std::max(centroidBounds[2 * c + 1], centroids[triangle][c]);
+      }
+    }
+
+  const vtkIdType index = static_cast<vtkIdType>(this->Nodes.size());
+  this->Nodes.push_back(node);
+  if (end - begin <= LeafSize)
+    {
+    return index;
+    }
+
+  // Median split of the centroids along their longest extent
+  int axis = 0;
+  for (int c = 1; c < 3; ++c)
+    {
+    if (centroidBounds[2 * c + 1] - centroidBounds[2 * c] > centroidBounds[2 * axis + 1] - centroidBounds[2 * axis])
+      {
+      axis = c;
+      }
+    }
+  const vtkIdType middle = begin + (end - begin) / 2;
+  std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                   [&](vtkIdType a, vtkIdType b) { return centroids[a][axis] < centroids[b][axis]; });
+
+  const vtkIdType left = this->BuildNode(begin, middle, order, centroids);
+  const vtkIdType right = this->BuildNode(middle, end, order, centroids);
+  this->Nodes[index].Left = left;
+  this->Nodes[index].Right = right;
+  return index;
+}
+
+//------------------------------------------------------------------------------
+bool SurfaceHierarchy::FindClosestPoint(const double p[3], double maximumSquaredDistance,
+                                        double& squaredDistance, bool& inside) const
+{
+  if (this->Nodes.empty())
+    {
+    return false;
+    }
+
+  // Depth first, nearest child first, pruning the nodes farther than the
+  // closest point so far. Median splits keep the depth logarithmic.
+  squaredDistance = maximumSquaredDistance;
+  const Triangle* closestTriangle = nullptr;
+  int closestFeature = FaceFeature;
+  double closest[3] = {0.0, 0.0, 0.0};
+  vtkIdType stack[128];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0)
+    {
+    const Node& node = this->Nodes[stack[--stackSize]];
+    if (SquaredDistanceToBounds(p, node.Bounds) >= squaredDistance)
+      {
+      continue;
+      }
+    if (node.Left < 0)
+      {
+      for (vtkIdType t = node.Begin; t < node.End; ++t)
+        {
+        const Triangle& triangle = this->Triangles[t];
+        double point[3];
+        const int feature = ClosestPointOnTriangle(p, this->Points[triangle.Points[0]].data(),
+                                                   this->Points[triangle.Points[1]].data(),
+                                                   this->Points[triangle.Points[2]].data(), point);
+        const double d = vtkMath::Distance2BetweenPoints(p, point);
+        if (d < squaredDistance)
+          {
+          squaredDistance = d;
+          closestTriangle = &triangle;
+          closestFeature = feature;
+          std::copy(point, point + 3, closest);
+          }
+        }
+      continue;
+      }
+    const double leftDistance = SquaredDistanceToBounds(p, this->Nodes[node.Left].Bounds);
+    const double rightDistance = SquaredDistanceToBounds(p, this->Nodes[node.Right].Bounds);
+    const bool leftFirst = leftDistance <= rightDistance;
+    const vtkIdType nearest = leftFirst ? node.Left : node.Right;
+    const vtkIdType farthest = leftFirst ? node.Right : node.Left;
+    if (std::max(leftDistance, rightDistance) < squaredDistance)
+      {
+      stack[stackSize++] = farthest;
+      }
+    if (std::min(leftDistance, rightDistance) < squaredDistance)
+      {
+      stack[stackSize++] = nearest;
+      }
+    }
+
+  if (!closestTriangle)
+    {
+    return false;
+    }
+
+  const double* normal = closestTriangle->Normal;
+  if (closestFeature >= VertexFeature)
+    {
+    normal = this->VertexNormals[closestTriangle->Points[closestFeature - VertexFeature]].data();
+    }
+  else if (closestFeature >= EdgeFeature)
+    {
+    normal = this->EdgeNormals[closestTriangle->Edges[closestFeature - EdgeFeature]].data();
+    }
+  double direction[3];
+  vtkMath::Subtract(p, closest, direction);
+  inside = vtkMath::Dot(direction, normal) < 0.0;
+  return true;
+}
+}
+
+//------------------------------------------------------------------------------
+class vtkLiverMeshDistanceMapEngine::vtkInternal
+{
+public:
+  /// Hierarchies of the structures of the last Update()
+  SurfaceHierarchy Surfaces[vtkLiverDistanceMapEngine::NumberOfStructures];
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLiverMeshDistanceMapEngine);
+
+//----------------------------------------------------------------------------
+vtkLiverMeshDistanceMapEngine::vtkLiverMeshDistanceMapEngine()
+  : Internal(new vtkInternal)
+  , OutputOrigin{0.0, 0.0, 0.0}
+  , OutputSpacing{1.0, 1.0, 1.0}
+  , OutputDimensions{0, 0, 0}
+  , BandWidth(0.0)
+  , QuantizeOutput(false)
+  , QuantizationRange(100.0)
+  , OutputQuantizationRange(0.0)
+{
+  this->Output = vtkSmartPointer<vtkImageData>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkLiverMeshDistanceMapEngine::~vtkLiverMeshDistanceMapEngine() = default;
+
+//----------------------------------------------------------------------------
+void vtkLiverMeshDistanceMapEngine::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfComponents: " << this->GetNumberOfComponents() << "\n";
+  os << indent << "OutputOrigin: " << this->OutputOrigin[0] << " " << this->OutputOrigin[1] << " "
+     << this->OutputOrigin[2] << "\n";
+  os << indent << "OutputSpacing: " << this->OutputSpacing[0] << " " << this->OutputSpacing[1] << " "
+     << this->OutputSpacing[2] << "\n";
+  os << indent << "OutputDimensions: " << this->OutputDimensions[0] << " " << this->OutputDimensions[1] << " "
+     << this->OutputDimensions[2] << "\n";
+  os << indent << "BandWidth: " << this->BandWidth << "\n";
+  os << indent << "QuantizeOutput: " << this->QuantizeOutput << "\n";
+  os << indent << "QuantizationRange: " << this->QuantizationRange << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverMeshDistanceMapEngine::SetStructure(int structure, vtkPolyData* surface)
+{
+  if (structure < 0 || structure >= vtkLiverDistanceMapEngine::NumberOfStructures)
+    {
+    vtkErrorMacro("SetStructure: invalid structure " << structure << ".");
+    return;
+    }
+  if (this->Structures[structure] == surface)
+    {
+    return;
+    }
+  this->Structures[structure] = surface;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkLiverMeshDistanceMapEngine::GetStructure(int structure) const
+{
+  if (structure < 0 || structure >= vtkLiverDistanceMapEngine::NumberOfStructures)
+    {
+    return nullptr;
+    }
+  return this->Structures[structure];
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverMeshDistanceMapEngine::RemoveAllStructures()
+{
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    this->Structures[structure] = nullptr;
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverMeshDistanceMapEngine::GetNumberOfComponents() const
+{
+  int numberOfComponents = 0;
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    numberOfComponents += this->Structures[structure] != nullptr;
+    }
+  return numberOfComponents;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkLiverMeshDistanceMapEngine::GetOutput() const
+{
+  return this->Output;
+}
+
+//----------------------------------------------------------------------------
+double vtkLiverMeshDistanceMapEngine::GetOutputScale() const
+{
+  return this->OutputQuantizationRange > 0.0 ? this->OutputQuantizationRange / QuantizationLevels : 1.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkLiverMeshDistanceMapEngine::GetOutputOffset() const
+{
+  return 0.0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverMeshDistanceMapEngine::EvaluateDistance(int structure, const double point[3], double& distance) const
+{
+  if (structure < 0 || structure >= vtkLiverDistanceMapEngine::NumberOfStructures
+      || this->Internal->Surfaces[structure].IsEmpty())
+    {
+    return false;
+    }
+  double squaredDistance;
+  bool inside;
+  this->Internal->Surfaces[structure].FindClosestPoint(point, VTK_DOUBLE_MAX, squaredDistance, inside);
+  distance = inside ? -std::sqrt(squaredDistance) : std::sqrt(squaredDistance);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverMeshDistanceMapEngine::Update()
+{
+  const int numberOfComponents = this->GetNumberOfComponents();
+  if (numberOfComponents == 0)
+    {
+    vtkErrorMacro("Update: no structures to compute distance maps of.");
+    return false;
+    }
+  const int* dimensions = this->OutputDimensions;
+  const double* spacing = this->OutputSpacing;
+  if (dimensions[0] < 1 || dimensions[1] < 1 || dimensions[2] < 1
+      || spacing[0] <= 0.0 || spacing[1] <= 0.0 || spacing[2] <= 0.0)
+    {
+    vtkErrorMacro("Update: invalid output grid.");
+    return false;
+    }
+
+  const double quantizationRange = this->QuantizeOutput ? this->QuantizationRange : 0.0;
+  this->Output->Initialize();
+  this->Output->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  this->Output->SetOrigin(this->OutputOrigin);
+  this->Output->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  this->Output->AllocateScalars(this->QuantizeOutput ? VTK_SHORT : VTK_FLOAT, numberOfComponents);
+
+  // Out of the saturation, only the sign matters: the search stops at the
+  // saturation, but not closer than a grid step, so that a grid point
+  // without triangles within the search radius has the sign of its face
+  // neighbors without triangles within it either (the surface is farther
+  // than the step between them)
+  const float saturation = GetSaturation(this->BandWidth, quantizationRange);
+  const double maximumSpacing = std::max(spacing[0], std::max(spacing[1], spacing[2]));
+  const double searchRadius = saturation < VTK_FLOAT_MAX
+    ? std::max(static_cast<double>(saturation), maximumSpacing) : VTK_DOUBLE_MAX;
+  const double maximumSquaredDistance = searchRadius < VTK_DOUBLE_MAX ? searchRadius * searchRadius : VTK_DOUBLE_MAX;
+
+  const vtkIdType numberOfPoints = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  const vtkIdType numberOfRows = static_cast<vtkIdType>(dimensions[1]) * dimensions[2];
+  const double scale = quantizationRange / QuantizationLevels;
+  float* floatDistances = static_cast<float*>(this->Output->GetScalarPointer());
+  short* quantizedDistances = static_cast<short*>(this->Output->GetScalarPointer());
+  std::vector<float> distances(numberOfPoints);
+  for (int structure = 0, c = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    if (!this->Structures[structure])
+      {
+      this->Internal->Surfaces[structure].Build(nullptr);
+      continue;
+      }
+    const SurfaceHierarchy& surface = this->Internal->Surfaces[structure];
+    if (!this->Internal->Surfaces[structure].Build(this->Structures[structure]))
+      {
+      // Structures without triangles saturate, as label maps without boundary
+      std::fill(distances.begin(), distances.end(), saturation);
+      }
+    else
+      {
+      // Along a row, the distance grows at most by the step: the previous
+      // distance bounds the search of the next point
+      vtkSMPTools::For(0, numberOfRows, [&](vtkIdType begin, vtkIdType end)
+        {
+        for (vtkIdType row = begin; row < end; ++row)
+          {
+          double point[3] = {this->OutputOrigin[0],
+                             this->OutputOrigin[1] + (row % dimensions[1]) * spacing[1],
+                             this->OutputOrigin[2] + (row / dimensions[1]) * spacing[2]};
+          double bound = -1.0;
+          for (int i = 0; i < dimensions[0]; ++i)
+            {
+            point[0] = this->OutputOrigin[0] + i * spacing[0];
+            double maximum = maximumSquaredDistance;
+            if (bound >= 0.0)
+              {
+              const double next = bound + spacing[0];
+              maximum = std::min(maximum, next * next * (1.0 + 1e-9) + 1e-12);
+              }
+            double squaredDistance;
+            bool inside;
+            float& distance = distances[row * dimensions[0] + i];
+            if (!surface.FindClosestPoint(point, maximum, squaredDistance, inside))
+              {
+              distance = Unresolved;
+              bound = -1.0;
+              continue;
+              }
+            bound = std::sqrt(squaredDistance);
+            distance = static_cast<float>(std::min(bound, static_cast<double>(saturation)));
+            distance = inside ? -distance : distance;
+            }
+          }
+        });
+      this->ResolveSigns(structure, distances.data(), saturation);
+      }
+
+    for (vtkIdType point = 0; point < numberOfPoints; ++point)
+      {
+      if (this->QuantizeOutput)
+        {
+        quantizedDistances[point * numberOfComponents + c] = QuantizeDistance(distances[point], scale);
+        }
+      else
+        {
+        floatDistances[point * numberOfComponents + c] = distances[point];
+        }
+      }
+    ++c;
+    }
+  this->OutputQuantizationRange = quantizationRange;
+
+  this->Output->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverMeshDistanceMapEngine::ResolveSigns(int structure, float* distances, float saturation) const
+{
+  const int* dimensions = this->OutputDimensions;
+  const vtkIdType steps[3] = {1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1]};
+  const vtkIdType numberOfPoints = steps[2] * dimensions[2];
+  std::vector<vtkIdType> region;
+  for (vtkIdType seed = 0; seed < numberOfPoints; ++seed)
+    {
+    if (distances[seed] != Unresolved)
+      {
+      continue;
+      }
+    int ijk[3] = {static_cast<int>(seed % dimensions[0]), static_cast<int>((seed / dimensions[0]) % dimensions[1]),
+                  static_cast<int>(seed / steps[2])};
+    double point[3];
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      point[axis] = this->OutputOrigin[axis] + ijk[axis] * this->OutputSpacing[axis];
+      }
+    double distance = 0.0;
+    this->EvaluateDistance(structure, point, distance);
+    const float value = distance < 0.0 ? -saturation : saturation;
+
+    distances[seed] = value;
+    region.assign(1, seed);
+    while (!region.empty())
+      {
+      const vtkIdType current = region.back();
+      region.pop_back();
+      ijk[0] = static_cast<int>(current % dimensions[0]);
+      ijk[1] = static_cast<int>((current / dimensions[0]) % dimensions[1]);
+      ijk[2] = static_cast<int>(current / steps[2]);
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        for (int step = -1; step <= 1; step += 2)
+          {
+          const int neighbor = ijk[axis] + step;
+          const vtkIdType neighborPoint = current + step * steps[axis];
+          if (neighbor >= 0 && neighbor < dimensions[axis] && distances[neighborPoint] == Unresolved)
+            {
+            distances[neighborPoint] = value;
+            region.push_back(neighborPoint);
+            }
+          }
+        }
+      }
+    }
+}
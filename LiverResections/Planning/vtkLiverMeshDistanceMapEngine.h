@@ -0,0 +1,166 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverMeshDistanceMapEngine_h
+#define __vtkLiverMeshDistanceMapEngine_h
+
+#include "vtkSlicerLiverResectionsModulePlanningExport.h"
+
+#include "vtkLiverDistanceMapEngine.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <memory>
+
+//------------------------------------------------------------------------------
+class vtkImageData;
+class vtkPolyData;
+
+//------------------------------------------------------------------------------
+/// \brief Signed distance maps of the liver structures from their surfaces.
+///
+/// Computes the signed euclidean distance (in mm, negative inside) to the
+/// closed surface meshes of up to four structures (tumor, parenchyma, hepatic
+/// and portal veins, with the indices of vtkLiverDistanceMapEngine::Structure)
+/// on a regular output grid. The output has the layout of the one of
+/// vtkLiverDistanceMapEngine (a float image with one component per available
+/// structure, in structure order), but the distances are exact at every grid
+/// point instead of being limited by the voxels of label maps: thin vessels
+/// keep their size and coarser grids keep sub-voxel accurate margins.
+///
+/// The triangles of each surface are stored in a bounding volume hierarchy,
+/// and the closest triangle of every grid point is queried in parallel. The
+/// sign comes from the angle weighted pseudo normal of the closest feature
+/// (face, edge or vertex), which is exact for closed meshes with shared
+/// points. The orientation of the meshes does not matter.
+///
+/// With a BandWidth, only the triangles closer than the band are searched
+/// and farther grid points saturate; their sign spreads from a single full
+/// query per connected region of saturated grid points.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_PLANNING_EXPORT vtkLiverMeshDistanceMapEngine
+  : public vtkObject
+{
+public:
+  static vtkLiverMeshDistanceMapEngine* New();
+  vtkTypeMacro(vtkLiverMeshDistanceMapEngine, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Closed surface of a structure (a vtkLiverDistanceMapEngine::Structure),
+  /// in the coordinates of the output grid. Polygons are triangulated as
+  /// fans. Set to nullptr to skip the structure.
+  void SetStructure(int structure, vtkPolyData* surface);
+  vtkPolyData* GetStructure(int structure) const;
+  void RemoveAllStructures();
+
+  /// Number of structures set (components of the output)
+  int GetNumberOfComponents() const;
+
+  /// Output grid: point (i, j, k) is at OutputOrigin + (i, j, k) *
+  /// OutputSpacing, for indices from zero to OutputDimensions - 1
+  vtkSetVector3Macro(OutputOrigin, double);
+  vtkGetVector3Macro(OutputOrigin, double);
+  vtkSetVector3Macro(OutputSpacing, double);
+  vtkGetVector3Macro(OutputSpacing, double);
+  vtkSetVector3Macro(OutputDimensions, int);
+  vtkGetVector3Macro(OutputDimensions, int);
+
+  /// Distances (mm) beyond which the output saturates (0, the default,
+  /// computes the distances over the whole grid)
+  vtkSetClampMacro(BandWidth, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(BandWidth, double);
+
+  /// Store the distances as 16-bit fixed point, clamped to
+  /// +/- QuantizationRange (mm)
+  vtkSetMacro(QuantizeOutput, bool);
+  vtkGetMacro(QuantizeOutput, bool);
+  vtkBooleanMacro(QuantizeOutput, bool);
+  vtkSetClampMacro(QuantizationRange, double, 1e-3, VTK_FLOAT_MAX);
+  vtkGetMacro(QuantizationRange, double);
+
+  /// Computes the distance maps. Returns false if no structure is set or the
+  /// output grid is empty.
+  bool Update();
+
+  /// Distance maps of the last Update()
+  vtkImageData* GetOutput() const;
+
+  /// Distance (mm) of an output value: value * scale + offset. The scale is
+  /// 1 and the offset 0 for float outputs.
+  double GetOutputScale() const;
+  double GetOutputOffset() const;
+
+  /// Signed distance (mm) of a point to the surface of a structure as of the
+  /// last Update(), without saturation. Returns false if the structure had no
+  /// triangles.
+  bool EvaluateDistance(int structure, const double point[3], double& distance) const;
+
+protected:
+  vtkLiverMeshDistanceMapEngine();
+  ~vtkLiverMeshDistanceMapEngine() override;
+
+protected:
+  class vtkInternal;
+  std::unique_ptr<vtkInternal> Internal;
+
+  vtkSmartPointer<vtkPolyData> Structures[vtkLiverDistanceMapEngine::NumberOfStructures];
+  vtkSmartPointer<vtkImageData> Output;
+  double OutputOrigin[3];
+  double OutputSpacing[3];
+  int OutputDimensions[3];
+  double BandWidth;
+  bool QuantizeOutput;
+  double QuantizationRange;
+
+  /// Quantization range of the last Update() (0 for float outputs)
+  double OutputQuantizationRange;
+
+  /// Saturates the grid points of a structure without triangles within the
+  /// search radius, with the sign of a full query at one point of each of
+  /// their face connected regions
+  void ResolveSigns(int structure, float* distances, float saturation) const;
+
+private:
+  vtkLiverMeshDistanceMapEngine(const vtkLiverMeshDistanceMapEngine&) = delete;
+  void operator=(const vtkLiverMeshDistanceMapEngine&) = delete;
+};
+
+#endif // __vtkLiverMeshDistanceMapEngine_h
@@ -0,0 +1,318 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkLiverProgressiveDistanceMapEngine.h"
+#include "vtkLiverDistanceMapEngine.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkLiverProgressiveDistanceMapEngine::vtkInternal
+{
+public:
+  struct Level
+  {
+    int Index = -1;
+    vtkSmartPointer<vtkImageData> Output;
+    double Scale = 1.0;
+    double Offset = 0.0;
+    double OutputIndexToInputIndex[16] = {1.0, 0.0, 0.0, 0.0,
+                                          0.0, 1.0, 0.0, 0.0,
+                                          0.0, 0.0, 1.0, 0.0,
+                                          0.0, 0.0, 0.0, 1.0};
+  };
+
+  /// Engine of the worker, with the snapshots of the label maps and settings
+  vtkSmartPointer<vtkLiverDistanceMapEngine> Engine;
+  /// Target spacing of every level
+  std::vector<std::array<double, 3>> LevelSpacings;
+
+  std::thread Worker;
+  std::atomic<bool> Cancelled{false};
+  std::atomic<bool> Finished{true};
+  std::atomic<bool> Failed{false};
+
+  /// Latest completed level, shared with the worker
+  mutable std::mutex Mutex;
+  Level Completed;
+
+  Level Fetched;
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLiverProgressiveDistanceMapEngine);
+
+//----------------------------------------------------------------------------
+vtkLiverProgressiveDistanceMapEngine::vtkLiverProgressiveDistanceMapEngine()
+  : Internal(new vtkInternal)
+  , CoarsestFactor(4)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkLiverProgressiveDistanceMapEngine::~vtkLiverProgressiveDistanceMapEngine()
+{
+  this->Cancel();
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverProgressiveDistanceMapEngine::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "CoarsestFactor: " << this->CoarsestFactor << "\n";
+  os << indent << "NumberOfLevels: " << this->GetNumberOfLevels() << "\n";
+  os << indent << "FetchedLevel: " << this->GetFetchedLevel() << "\n";
+  os << indent << "Running: " << this->IsRunning() << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverProgressiveDistanceMapEngine::Start(vtkLiverDistanceMapEngine* engine)
+{
+  this->Cancel();
+  if (!engine || engine->GetNumberOfComponents() == 0)
+    {
+    vtkErrorMacro("Start: no structures to compute distance maps of.");
+    return false;
+    }
+
+  auto snapshot = vtkSmartPointer<vtkLiverDistanceMapEngine>::New();
+  snapshot->SetBandWidth(engine->GetBandWidth());
+  snapshot->SetCropToParenchyma(engine->GetCropToParenchyma());
+  snapshot->SetCropMargin(engine->GetCropMargin());
+  snapshot->SetQuantizeOutput(engine->GetQuantizeOutput());
+  snapshot->SetQuantizationRange(engine->GetQuantizationRange());
+  double spacing[3] = {1.0, 1.0, 1.0};
+  bool hasSpacing = false;
+  for (int structure = 0; structure < vtkLiverDistanceMapEngine::NumberOfStructures; ++structure)
+    {
+    vtkImageData* labelMap = engine->GetStructure(structure);
+    if (!labelMap)
+      {
+      continue;
+      }
+    auto copy = vtkSmartPointer<vtkImageData>::New();
+    copy->DeepCopy(labelMap);
+    snapshot->SetStructure(structure, copy);
+    if (!hasSpacing)
+      {
+      labelMap->GetSpacing(spacing);
+      hasSpacing = true;
+      }
+    }
+
+  // Coarse levels resample the grid of the last one
+  const double* targetSpacing = engine->GetTargetSpacing();
+  this->Internal->LevelSpacings.clear();
+  for (int factor = this->CoarsestFactor; factor > 1; factor /= 2)
+    {
+    std::array<double, 3> levelSpacing;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      levelSpacing[axis] = factor * (targetSpacing[axis] > 0.0 ? targetSpacing[axis] : spacing[axis]);
+      }
+    this->Internal->LevelSpacings.push_back(levelSpacing);
+    }
+  this->Internal->LevelSpacings.push_back({targetSpacing[0], targetSpacing[1], targetSpacing[2]});
+
+  this->Internal->Engine = snapshot;
+  this->Internal->Cancelled = false;
+  this->Internal->Failed = false;
+  this->Internal->Finished = false;
+  this->Internal->Fetched = vtkInternal::Level();
+  this->Internal->Worker = std::thread(&vtkLiverProgressiveDistanceMapEngine::ComputeLevels, this);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverProgressiveDistanceMapEngine::Cancel()
+{
+  this->Internal->Cancelled = true;
+  if (this->Internal->Engine)
+    {
+    this->Internal->Engine->SetAbortExecute(true);
+    }
+  if (this->Internal->Worker.joinable())
+    {
+    this->Internal->Worker.join();
+    }
+  this->Internal->Finished = true;
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->Completed = vtkInternal::Level();
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverProgressiveDistanceMapEngine::IsRunning() const
+{
+  if (!this->Internal->Finished)
+    {
+    return true;
+    }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->Completed.Index > this->Internal->Fetched.Index;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverProgressiveDistanceMapEngine::GetFailed() const
+{
+  return this->Internal->Failed;
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverProgressiveDistanceMapEngine::GetNumberOfLevels() const
+{
+  return static_cast<int>(this->Internal->LevelSpacings.size());
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverProgressiveDistanceMapEngine::FetchLevel()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  if (this->Internal->Completed.Index <= this->Internal->Fetched.Index)
+    {
+    return false;
+    }
+  this->Internal->Fetched = this->Internal->Completed;
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkLiverProgressiveDistanceMapEngine::GetFetchedLevel() const
+{
+  return this->Internal->Fetched.Index;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkLiverProgressiveDistanceMapEngine::GetOutput() const
+{
+  return this->Internal->Fetched.Output;
+}
+
+//----------------------------------------------------------------------------
+double vtkLiverProgressiveDistanceMapEngine::GetOutputScale() const
+{
+  return this->Internal->Fetched.Scale;
+}
+
+//----------------------------------------------------------------------------
+double vtkLiverProgressiveDistanceMapEngine::GetOutputOffset() const
+{
+  return this->Internal->Fetched.Offset;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverProgressiveDistanceMapEngine::GetOutputIndexToInputIndex(vtkMatrix4x4* matrix) const
+{
+  if (matrix)
+    {
+    matrix->DeepCopy(this->Internal->Fetched.OutputIndexToInputIndex);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverProgressiveDistanceMapEngine::CopyLastLevelEngine(vtkLiverDistanceMapEngine* engine)
+{
+  if (!engine || !this->Internal->Engine || this->Internal->Fetched.Index != this->GetNumberOfLevels() - 1)
+    {
+    return false;
+    }
+
+  // The worker is done with its engine once the last level completed
+  if (this->Internal->Worker.joinable())
+    {
+    this->Internal->Worker.join();
+    }
+  engine->ShallowCopy(this->Internal->Engine);
+  this->Internal->Engine = nullptr;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverProgressiveDistanceMapEngine::ComputeLevels()
+{
+  vtkLiverDistanceMapEngine* engine = this->Internal->Engine;
+  const int numberOfLevels = this->GetNumberOfLevels();
+  bool lastLevelCompleted = false;
+  for (int level = 0; level < numberOfLevels && !this->Internal->Cancelled; ++level)
+    {
+    const std::array<double, 3>& spacing = this->Internal->LevelSpacings[level];
+    engine->SetTargetSpacing(spacing[0], spacing[1], spacing[2]);
+    if (!engine->Update())
+      {
+      // Aborted updates are not failures
+      this->Internal->Failed = !this->Internal->Cancelled;
+      break;
+      }
+
+    // Every level gets its own image, as the engine reuses its output
+    vtkInternal::Level completed;
+    completed.Index = level;
+    completed.Output = vtkSmartPointer<vtkImageData>::New();
+    completed.Output->ShallowCopy(engine->GetOutput());
+    completed.Scale = engine->GetOutputScale();
+    completed.Offset = engine->GetOutputOffset();
+    vtkNew<vtkMatrix4x4> outputIndexToInputIndex;
+    engine->GetOutputIndexToInputIndex(outputIndexToInputIndex);
+    vtkMatrix4x4::DeepCopy(completed.OutputIndexToInputIndex, outputIndexToInputIndex);
+
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    this->Internal->Completed = completed;
+    lastLevelCompleted = level == numberOfLevels - 1;
+    }
+
+  // The snapshots of an interrupted computation are not needed anymore; the
+  // ones of the last level are kept for CopyLastLevelEngine()
+  if (!lastLevelCompleted)
+    {
+    engine->RemoveAllStructures();
+    }
+  this->Internal->Finished = true;
+}
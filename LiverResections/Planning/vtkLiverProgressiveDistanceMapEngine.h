@@ -0,0 +1,138 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverProgressiveDistanceMapEngine_h
+#define __vtkLiverProgressiveDistanceMapEngine_h
+
+#include "vtkSlicerLiverResectionsModulePlanningExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <memory>
+
+//------------------------------------------------------------------------------
+class vtkImageData;
+class vtkLiverDistanceMapEngine;
+class vtkMatrix4x4;
+
+//------------------------------------------------------------------------------
+/// \brief Coarse to fine distance maps computed in the background.
+///
+/// Computes the distance maps of a vtkLiverDistanceMapEngine as a sequence
+/// of levels in a worker thread: the first level is resampled by
+/// CoarsestFactor (64 times fewer voxels for the default of 4), every next
+/// level halves the factor, and the last level has the settings of the
+/// engine. The caller fetches the completed levels from its own thread, so
+/// a coarse result can be shown while the finer ones are computed.
+///
+/// The worker computes from snapshots of the label maps and settings taken
+/// by Start(), so the engine and its label maps can change meanwhile; a new
+/// Start() or Cancel() aborts the running level. The snapshots are kept
+/// after the last level for CopyLastLevelEngine().
+class VTK_SLICER_LIVERRESECTIONS_MODULE_PLANNING_EXPORT vtkLiverProgressiveDistanceMapEngine
+  : public vtkObject
+{
+public:
+  static vtkLiverProgressiveDistanceMapEngine* New();
+  vtkTypeMacro(vtkLiverProgressiveDistanceMapEngine, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Resampling factor of the first level (1 computes the last level only)
+  vtkSetClampMacro(CoarsestFactor, int, 1, 64);
+  vtkGetMacro(CoarsestFactor, int);
+
+  /// Starts computing the levels of the structures and settings of the
+  /// engine, cancelling a running computation first. Returns false if the
+  /// engine has no structure.
+  bool Start(vtkLiverDistanceMapEngine* engine);
+
+  /// Aborts the running computation and waits for the worker. Completed
+  /// levels not fetched yet are dropped.
+  void Cancel();
+
+  /// Whether levels are being computed or wait to be fetched
+  bool IsRunning() const;
+
+  /// Whether a level of the last Start() failed to compute
+  bool GetFailed() const;
+
+  /// Number of levels of the last Start()
+  int GetNumberOfLevels() const;
+
+  /// Takes the latest completed level (intermediate ones completed since the
+  /// last fetch are skipped). Returns false if there is no new one.
+  bool FetchLevel();
+
+  /// Index of the fetched level (-1 if none since the last Start())
+  int GetFetchedLevel() const;
+
+  /// Distance maps of the fetched level, with the conventions of the outputs
+  /// of vtkLiverDistanceMapEngine
+  vtkImageData* GetOutput() const;
+  double GetOutputScale() const;
+  double GetOutputOffset() const;
+  void GetOutputIndexToInputIndex(vtkMatrix4x4* matrix) const;
+
+  /// Gives the label maps, settings and state of the last level to an engine
+  /// (see vtkLiverDistanceMapEngine::ShallowCopy()) once it was fetched, so
+  /// that the engine can update the distance maps of edited structures.
+  /// Returns false if the last level was not fetched or was already given.
+  bool CopyLastLevelEngine(vtkLiverDistanceMapEngine* engine);
+
+protected:
+  vtkLiverProgressiveDistanceMapEngine();
+  ~vtkLiverProgressiveDistanceMapEngine() override;
+
+  /// Computes the levels (worker thread)
+  void ComputeLevels();
+
+protected:
+  class vtkInternal;
+  std::unique_ptr<vtkInternal> Internal;
+
+  int CoarsestFactor;
+
+private:
+  vtkLiverProgressiveDistanceMapEngine(const vtkLiverProgressiveDistanceMapEngine&) = delete;
+  void operator=(const vtkLiverProgressiveDistanceMapEngine&) = delete;
+};
+
+#endif // __vtkLiverProgressiveDistanceMapEngine_h
@@ -0,0 +1,477 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkLiverResectionPlanner.h"
+#include "vtkBezierSurfaceContourFitter.h"
+#include "vtkParenchymaSlicingIndex.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkGenericCell.h>
+#include <vtkIdList.h>
+#include <vtkImplicitPolyDataDistance.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPlaneSource.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
+#include <vtkStaticCellLocator.h>
+#include <vtkTriangle.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+//------------------------------------------------------------------------------
+void CubicBernstein(double t, double basis[4])
+{
+  const double s = 1.0 - t;
+  basis[0] = s * s * s;
+  basis[1] = 3.0 * t * s * s;
+  basis[2] = 3.0 * t * t * s;
+  basis[3] = t * t * t;
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLiverResectionPlanner);
+
+//----------------------------------------------------------------------------
+vtkLiverResectionPlanner::vtkLiverResectionPlanner()
+  : InitializationMode(Flat)
+  , InitializationPoints{{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}}
+  , UseReferenceAxes(false)
+  , ReferenceAxes{{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}}
+  , ResectionMargin(0.0)
+  , UncertaintyMargin(0.0)
+  , Resolution(20)
+{
+  this->SlicingIndex = vtkSmartPointer<vtkParenchymaSlicingIndex>::New();
+  this->ControlPoints = vtkSmartPointer<vtkPoints>::New();
+  this->Tessellation = vtkSmartPointer<vtkPolyData>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkLiverResectionPlanner::~vtkLiverResectionPlanner() = default;
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionPlanner::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "InitializationMode: " << this->InitializationMode << "\n";
+  os << indent << "ResectionMargin: " << this->ResectionMargin << "\n";
+  os << indent << "UncertaintyMargin: " << this->UncertaintyMargin << "\n";
+  os << indent << "Resolution: " << this->Resolution << "\n";
+  os << indent << "SurfaceArea: " << this->ResultMetrics.SurfaceArea << "\n";
+  os << indent << "CutArea: " << this->ResultMetrics.CutArea << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionPlanner::SetTargetOrgan(vtkPolyData* targetOrgan)
+{
+  if (this->SlicingIndex->GetInputData() == targetOrgan)
+    {
+    return;
+    }
+  this->SlicingIndex->SetInputData(targetOrgan);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkLiverResectionPlanner::GetTargetOrgan() const
+{
+  return this->SlicingIndex->GetInputData();
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionPlanner::SetInitializationPoints(const double point1[3], const double point2[3])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    this->InitializationPoints[0][i] = point1[i];
+    this->InitializationPoints[1][i] = point2[i];
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionPlanner::SetReferenceAxes(const double uAxis[3], const double vAxis[3])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    this->ReferenceAxes[0][i] = uAxis[i];
+    this->ReferenceAxes[1][i] = vAxis[i];
+    }
+  this->UseReferenceAxes = true;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionPlanner::RemoveReferenceAxes()
+{
+  this->UseReferenceAxes = false;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPoints* vtkLiverResectionPlanner::GetControlPoints() const
+{
+  return this->ControlPoints;
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkLiverResectionPlanner::GetTessellation() const
+{
+  return this->Tessellation;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionPlanner::Update()
+{
+  vtkPolyData* targetOrgan = this->GetTargetOrgan();
+  if (!targetOrgan)
+    {
+    vtkErrorMacro("Update: no target organ.");
+    return false;
+    }
+  this->SlicingIndex->Update();
+
+  const double* uAxis = this->UseReferenceAxes ? this->ReferenceAxes[0] : nullptr;
+  const double* vAxis = this->UseReferenceAxes ? this->ReferenceAxes[1] : nullptr;
+  vtkNew<vtkPoints> controlPoints;
+  bool planned = this->InitializationMode == Curved
+    ? ComputeCurvedControlPoints(this->SlicingIndex, this->InitializationPoints[0],
+                                 this->InitializationPoints[1], uAxis, vAxis, controlPoints)
+    : ComputeFlatControlPoints(this->SlicingIndex, this->InitializationPoints[0],
+                               this->InitializationPoints[1], uAxis, vAxis, controlPoints);
+  if (!planned)
+    {
+    return false;
+    }
+
+  this->ControlPoints->DeepCopy(controlPoints);
+  ComputeTessellation(this->ControlPoints, this->Resolution, this->Tessellation);
+  this->ResultMetrics = ComputeMetrics(this->Tessellation, targetOrgan,
+                                       this->ResectionMargin, this->UncertaintyMargin);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionPlanner::ComputeFlatControlPoints(vtkParenchymaSlicingIndex* slicingIndex,
+                                                        const double point1[3],
+                                                        const double point2[3],
+                                                        const double* uAxis,
+                                                        const double* vAxis,
+                                                        vtkPoints* controlPoints)
+{
+  if (!slicingIndex || !controlPoints)
+    {
+    return false;
+    }
+
+  // This algorithm is based on NorMIT-Plan
+  // https://github.com/TheInterventionCentre/NorMIT-Plan
+
+  double midPoint[3];
+  double normal[3];
+
+  midPoint[0] = (point1[0] + point2[0]) / 2.0;
+  midPoint[1] = (point1[1] + point2[1]) / 2.0;
+  midPoint[2] = (point1[2] + point2[2]) / 2.0;
+
+  normal[0] = point2[0] - point1[0];
+  normal[1] = point2[1] - point1[1];
+  normal[2] = point2[2] - point1[2];
+
+  // Principal components of the contour of the parenchyma cut by the plane
+  vtkParenchymaSlicingIndex::ContourPCA pca;
+  if (!slicingIndex->ComputeContourPCA(midPoint, normal, pca))
+    {
+    return false;
+    }
+
+  double length1 = 4.0*sqrt(pca.Eigenvalues[0]);
+  double length2 = 4.0*sqrt(pca.Eigenvalues[1]);
+
+  const double *com = pca.Center;
+  double v1[3] = {pca.Eigenvectors[0][0], pca.Eigenvectors[0][1], pca.Eigenvectors[0][2]};
+  double v2[3] = {pca.Eigenvectors[1][0], pca.Eigenvectors[1][1], pca.Eigenvectors[1][2]};
+
+  if (uAxis && vtkMath::Dot(v1, uAxis) < 0.0)
+    {
+    vtkMath::MultiplyScalar(v1, -1.0);
+    }
+  if (vAxis && vtkMath::Dot(v2, vAxis) < 0.0)
+    {
+    vtkMath::MultiplyScalar(v2, -1.0);
+    }
+
+  double origin[3] =
+    {
+      com[0] - v1[0]*length1/2.0 - v2[0]*length2/2.0,
+      com[1] - v1[1]*length1/2.0 - v2[1]*length2/2.0,
+      com[2] - v1[2]*length1/2.0 - v2[2]*length2/2.0,
+    };
+
+  double corner1[3] =
+    {
+      origin[0] + v1[0]*length1,
+      origin[1] + v1[1]*length1,
+      origin[2] + v1[2]*length1,
+    };
+
+  double corner2[3] =
+    {
+      origin[0] + v2[0]*length2,
+      origin[1] + v2[1]*length2,
+      origin[2] + v2[2]*length2,
+    };
+
+  //Create bezier surface according to initial plane
+  vtkNew<vtkPlaneSource> planeSource;
+  planeSource->SetOrigin(origin);
+  planeSource->SetPoint1(corner1);
+  planeSource->SetPoint2(corner2);
+  planeSource->SetXResolution(3);
+  planeSource->SetYResolution(3);
+  planeSource->Update();
+
+  controlPoints->DeepCopy(planeSource->GetOutput()->GetPoints());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLiverResectionPlanner::ComputeCurvedControlPoints(vtkParenchymaSlicingIndex* slicingIndex,
+                                                          const double point1[3],
+                                                          const double point2[3],
+                                                          const double* uAxis,
+                                                          const double* vAxis,
+                                                          vtkPoints* controlPoints)
+{
+  if (!slicingIndex || !controlPoints)
+    {
+    return false;
+    }
+
+  // The distance contour is the intersection of the parenchyma with the
+  // sphere centered at the second point and passing through the first
+  double radius = std::sqrt(vtkMath::Distance2BetweenPoints(point1, point2));
+
+  vtkNew<vtkPoints> contourPoints;
+  if (slicingIndex->ComputeSphereContour(point2, radius, contourPoints) == 0)
+    {
+    return false;
+    }
+
+  vtkNew<vtkBezierSurfaceContourFitter> fitter;
+  fitter->SetInputPoints(contourPoints);
+  if (uAxis && vAxis)
+    {
+    fitter->SetReferenceAxes(uAxis, vAxis);
+    }
+  return fitter->Fit(controlPoints);
+}
+
+//----------------------------------------------------------------------------
+void vtkLiverResectionPlanner::ComputeTessellation(vtkPoints* controlPoints,
+                                                   int resolution,
+                                                   vtkPolyData* tessellation)
+{
+  if (!controlPoints || controlPoints->GetNumberOfPoints() != 16 || !tessellation || resolution < 2)
+    {
+    return;
+    }
+
+  double grid[16][3];
+  for (vtkIdType i = 0; i < 16; ++i)
+    {
+    controlPoints->GetPoint(i, grid[i]);
+    }
+
+  // Same parametrization and point order as vtkBezierSurfaceSource: control
+  // point i*4+j is weighted by B_i(u)B_j(v), and point i*resolution+j is at
+  // (u_i, v_j)
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(static_cast<vtkIdType>(resolution) * resolution);
+  for (int i = 0; i < resolution; ++i)
+    {
+    double basisU[4];
+    CubicBernstein(i / static_cast<double>(resolution - 1), basisU);
+    for (int j = 0; j < resolution; ++j)
+      {
+      double basisV[4];
+      CubicBernstein(j / static_cast<double>(resolution - 1), basisV);
+      double point[3] = {0.0, 0.0, 0.0};
+      for (int ci = 0; ci < 4; ++ci)
+        {
+        for (int cj = 0; cj < 4; ++cj)
+          {
+          const double weight = basisU[ci] * basisV[cj];
+          point[0] += weight * grid[ci * 4 + cj][0];
+          point[1] += weight * grid[ci * 4 + cj][1];
+          point[2] += weight * grid[ci * 4 + cj][2];
+          }
+        }
+      points->SetPoint(static_cast<vtkIdType>(i) * resolution + j, point);
+      }
+    }
+
+  vtkNew<vtkCellArray> triangles;
+  triangles->AllocateExact(2 * (resolution - 1) * (resolution - 1), 6 * (resolution - 1) * (resolution - 1));
+  for (int i = 0; i < resolution - 1; ++i)
+    {
+    for (int j = 0; j < resolution - 1; ++j)
+      {
+      const vtkIdType a = static_cast<vtkIdType>(i) * resolution + j;
+      const vtkIdType b = a + 1;
+      const vtkIdType c = a + resolution + 1;
+      const vtkIdType d = a + resolution;
+      const vtkIdType triangle1[3] = {c, b, a};
+      const vtkIdType triangle2[3] = {d, c, a};
+      triangles->InsertNextCell(3, triangle1);
+      triangles->InsertNextCell(3, triangle2);
+      }
+    }
+
+  tessellation->Initialize();
+  tessellation->SetPoints(points);
+  tessellation->SetPolys(triangles);
+}
+
+//----------------------------------------------------------------------------
+vtkLiverResectionPlanner::Metrics vtkLiverResectionPlanner::ComputeMetrics(vtkPolyData* tessellation,
+                                                                          vtkPolyData* targetOrgan,
+                                                                          double resectionMargin,
+                                                                          double uncertaintyMargin)
+{
+  Metrics metrics;
+  if (!tessellation || tessellation->GetNumberOfPolys() == 0)
+    {
+    return metrics;
+    }
+
+  // Surface area, and area inside the target organ (by triangle centroid)
+  vtkNew<vtkImplicitPolyDataDistance> targetOrganDistance;
+  bool hasTargetOrgan = targetOrgan && targetOrgan->GetNumberOfPolys() > 0;
+  if (hasTargetOrgan)
+    {
+    targetOrganDistance->SetInput(targetOrgan);
+    }
+
+  vtkNew<vtkIdList> triangle;
+  vtkCellArray* polys = tessellation->GetPolys();
+  for (vtkIdType cellId = 0; cellId < polys->GetNumberOfCells(); ++cellId)
+    {
+    polys->GetCellAtId(cellId, triangle);
+    if (triangle->GetNumberOfIds() != 3)
+      {
+      continue;
+      }
+    double p0[3], p1[3], p2[3];
+    tessellation->GetPoint(triangle->GetId(0), p0);
+    tessellation->GetPoint(triangle->GetId(1), p1);
+    tessellation->GetPoint(triangle->GetId(2), p2);
+    const double area = vtkTriangle::TriangleArea(p0, p1, p2);
+    metrics.SurfaceArea += area;
+
+    double centroid[3] = {(p0[0] + p1[0] + p2[0]) / 3.0,
+                          (p0[1] + p1[1] + p2[1]) / 3.0,
+                          (p0[2] + p1[2] + p2[2]) / 3.0};
+    if (hasTargetOrgan && targetOrganDistance->EvaluateFunction(centroid) < 0.0)
+      {
+      metrics.CutArea += area;
+      }
+    }
+
+  if (!hasTargetOrgan || targetOrgan->GetNumberOfPoints() == 0)
+    {
+    return metrics;
+    }
+
+  // Fraction of the target organ points close to the resection, in parallel
+  vtkNew<vtkStaticCellLocator> locator;
+  locator->SetDataSet(tessellation);
+  locator->BuildLocator();
+
+  const double margin2 = resectionMargin * resectionMargin;
+  const double uncertainty2 = (resectionMargin + uncertaintyMargin) * (resectionMargin + uncertaintyMargin);
+  vtkSMPThreadLocalObject<vtkGenericCell> cells;
+  vtkSMPThreadLocal<vtkIdType> withinMargin(0);
+  vtkSMPThreadLocal<vtkIdType> withinUncertainty(0);
+  vtkPoints* targetOrganPoints = targetOrgan->GetPoints();
+  vtkSMPTools::For(0, targetOrgan->GetNumberOfPoints(), [&](vtkIdType begin, vtkIdType end)
+    {
+    vtkGenericCell* cell = cells.Local();
+    vtkIdType& localWithinMargin = withinMargin.Local();
+    vtkIdType& localWithinUncertainty = withinUncertainty.Local();
+    for (vtkIdType pointId = begin; pointId < end; ++pointId)
+      {
+      double point[3];
+      double closestPoint[3];
+      vtkIdType cellId;
+      int subId;
+      double distance2;
+      targetOrganPoints->GetPoint(pointId, point);
+      locator->FindClosestPoint(point, closestPoint, cell, cellId, subId, distance2);
+      localWithinMargin += distance2 <= margin2 ? 1 : 0;
+      localWithinUncertainty += distance2 <= uncertainty2 ? 1 : 0;
+      }
+    });
+
+  vtkIdType numberWithinMargin = 0;
+  vtkIdType numberWithinUncertainty = 0;
+  for (vtkIdType count : withinMargin)
+    {
+    numberWithinMargin += count;
+    }
+  for (vtkIdType count : withinUncertainty)
+    {
+    numberWithinUncertainty += count;
+    }
+  const double numberOfPoints = static_cast<double>(targetOrgan->GetNumberOfPoints());
+  metrics.TargetOrganWithinMargin = numberWithinMargin / numberOfPoints;
+  metrics.TargetOrganWithinUncertainty = numberWithinUncertainty / numberOfPoints;
+
+  return metrics;
+}
@@ -0,0 +1,185 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverResectionPlanner_h
+#define __vtkLiverResectionPlanner_h
+
+#include "vtkSlicerLiverResectionsModulePlanningExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+//------------------------------------------------------------------------------
+class vtkParenchymaSlicingIndex;
+class vtkPoints;
+class vtkPolyData;
+
+//------------------------------------------------------------------------------
+/// \brief Headless planning of a resection.
+///
+/// From a target organ mesh, two initialization points and the margins, the
+/// planner computes the control points of the bezier surface (flat or curved
+/// initialization, as in the resections logic), a triangulated tessellation of
+/// the surface and a few metrics. It only depends on VTK data objects: no
+/// MRML scene, display node or render window is involved, so it can be run
+/// from batch jobs.
+///
+/// \code
+/// vtkNew<vtkLiverResectionPlanner> planner;
+/// planner->SetTargetOrgan(liver);
+/// planner->SetInitializationPoints(point1, point2);
+/// planner->SetResectionMargin(10.0);
+/// if (planner->Update())
+///   {
+///   planner->GetControlPoints(); planner->GetTessellation(); planner->GetMetrics();
+///   }
+/// \endcode
+class VTK_SLICER_LIVERRESECTIONS_MODULE_PLANNING_EXPORT vtkLiverResectionPlanner
+  : public vtkObject
+{
+public:
+  static vtkLiverResectionPlanner* New();
+  vtkTypeMacro(vtkLiverResectionPlanner, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Initialization modes (same values as vtkMRMLLiverResectionNode)
+  enum InitializationMode
+  {
+    Flat = 0, ///< Plane through the midpoint of the points, normal to them
+    Curved    ///< Distance contour: sphere centered at the second point,
+              ///< passing through the first
+  };
+
+  struct Metrics
+  {
+    double SurfaceArea = 0.0;                  ///< Area of the tessellation
+    double CutArea = 0.0;                      ///< Area of the tessellation inside the target organ
+    double TargetOrganWithinMargin = 0.0;      ///< Fraction of the target organ points within the resection margin
+    double TargetOrganWithinUncertainty = 0.0; ///< Same, within the resection and uncertainty margins
+  };
+
+  /// Target organ (closed surface mesh)
+  void SetTargetOrgan(vtkPolyData* targetOrgan);
+  vtkPolyData* GetTargetOrgan() const;
+
+  vtkSetClampMacro(InitializationMode, int, Flat, Curved);
+  vtkGetMacro(InitializationMode, int);
+
+  void SetInitializationPoints(const double point1[3], const double point2[3]);
+
+  /// Orientation of the control point grid (optional), so that successive
+  /// plans of the same resection do not flip
+  void SetReferenceAxes(const double uAxis[3], const double vAxis[3]);
+  void RemoveReferenceAxes();
+
+  vtkSetClampMacro(ResectionMargin, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(ResectionMargin, double);
+
+  vtkSetClampMacro(UncertaintyMargin, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(UncertaintyMargin, double);
+
+  /// Number of tessellation points along each parametric direction
+  vtkSetClampMacro(Resolution, int, 2, 1024);
+  vtkGetMacro(Resolution, int);
+
+  /// Computes the control points, the tessellation and the metrics. Returns
+  /// false if the initialization does not cut the target organ.
+  bool Update();
+
+  /// Results of the last Update()
+  vtkPoints* GetControlPoints() const;
+  vtkPolyData* GetTessellation() const;
+  const Metrics& GetMetrics() const
+  {return this->ResultMetrics;}
+
+  /// Control points (4x4 grid) of a flat initialization, from the plane
+  /// through the midpoint of point1 and point2 with normal point2 - point1.
+  /// uAxis and vAxis (optional) orient the grid.
+  static bool ComputeFlatControlPoints(vtkParenchymaSlicingIndex* slicingIndex,
+                                       const double point1[3],
+                                       const double point2[3],
+                                       const double* uAxis,
+                                       const double* vAxis,
+                                       vtkPoints* controlPoints);
+
+  /// Control points (4x4 grid) of a curved initialization, fitted to the
+  /// contour of the target organ cut by the sphere centered at point2 and
+  /// passing through point1
+  static bool ComputeCurvedControlPoints(vtkParenchymaSlicingIndex* slicingIndex,
+                                         const double point1[3],
+                                         const double point2[3],
+                                         const double* uAxis,
+                                         const double* vAxis,
+                                         vtkPoints* controlPoints);
+
+  /// Triangulated tessellation of the bicubic bezier surface of the 4x4
+  /// control points, with resolution x resolution points
+  static void ComputeTessellation(vtkPoints* controlPoints, int resolution, vtkPolyData* tessellation);
+
+  /// Metrics of a tessellation with respect to a target organ
+  static Metrics ComputeMetrics(vtkPolyData* tessellation,
+                                vtkPolyData* targetOrgan,
+                                double resectionMargin,
+                                double uncertaintyMargin);
+
+protected:
+  vtkLiverResectionPlanner();
+  ~vtkLiverResectionPlanner() override;
+
+protected:
+  vtkSmartPointer<vtkParenchymaSlicingIndex> SlicingIndex;
+  int InitializationMode;
+  double InitializationPoints[2][3];
+  bool UseReferenceAxes;
+  double ReferenceAxes[2][3];
+  double ResectionMargin;
+  double UncertaintyMargin;
+  int Resolution;
+
+  vtkSmartPointer<vtkPoints> ControlPoints;
+  vtkSmartPointer<vtkPolyData> Tessellation;
+  Metrics ResultMetrics;
+
+private:
+  vtkLiverResectionPlanner(const vtkLiverResectionPlanner&) = delete;
+  void operator=(const vtkLiverResectionPlanner&) = delete;
+};
+
+#endif // __vtkLiverResectionPlanner_h
@@ -0,0 +1,571 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkParenchymaSlicingIndex.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Polygons per leaf of the hierarchy
+const vtkIdType LeafSize = 8;
+
+//------------------------------------------------------------------------------
+// Unit eigenvector of a symmetric matrix for an eigenvalue of multiplicity one:
+// the largest cross product of two rows of (A - lambda I)
+void EigenVector(const double a[3][3], double lambda, double v[3])
+{
+  double rows[3][3];
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      rows[i][j] = a[i][j] - (i == j ? lambda : 0.0);
+      }
+    }
+
+  double best = -1.0;
+  const int pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+  for (const auto& pair : pairs)
+    {
+    double c[3];
+    vtkMath::Cross(rows[pair[0]], rows[pair[1]], c);
+    double norm2 = vtkMath::Dot(c, c);
+    if (norm2 > best)
+      {
+      best = norm2;
+      std::copy(c, c + 3, v);
+      }
+    }
+
+  if (vtkMath::Normalize(v) == 0.0)
+    {
+    v[0] = 1.0; v[1] = 0.0; v[2] = 0.0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Eigenvectors of a symmetric matrix restricted to the plane orthogonal to the
+// unit vector n. larger and smaller are unit vectors in that plane, ordered
+// by the corresponding eigenvalue.
+void EigenVectorsInPlane(const double a[3][3], const double n[3], double larger[3], double smaller[3])
+{
+  double u[3];
+  double w[3];
+  vtkMath::Perpendiculars(n, u, w, 0.0);
+
+  double au[3];
+  double aw[3];
+  vtkMath::Multiply3x3(a, u, au);
+  vtkMath::Multiply3x3(a, w, aw);
+  double uu = vtkMath::Dot(u, au);
+  double uw = vtkMath::Dot(u, aw);
+  double ww = vtkMath::Dot(w, aw);
+
+  double theta = 0.5 * std::atan2(2.0 * uw, uu - ww);
+  double c = std::cos(theta);
+  double s = std::sin(theta);
+  for (int i = 0; i < 3; ++i)
+    {
+    larger[i] = c * u[i] + s * w[i];
+    smaller[i] = -s * u[i] + c * w[i];
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkParenchymaSlicingIndex);
+
+//----------------------------------------------------------------------------
+vtkParenchymaSlicingIndex::vtkParenchymaSlicingIndex()
+  : NumberOfVisitedCells(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkParenchymaSlicingIndex::~vtkParenchymaSlicingIndex() = default;
+
+//----------------------------------------------------------------------------
+void vtkParenchymaSlicingIndex::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfCells: " << this->GetNumberOfCells() << "\n";
+  os << indent << "NumberOfNodes: " << this->Nodes.size() << "\n";
+  os << indent << "NumberOfVisitedCells: " << this->NumberOfVisitedCells << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkParenchymaSlicingIndex::SetInputData(vtkPolyData* polyData)
+{
+  if (this->InputData == polyData)
+    {
+    return;
+    }
+  this->InputData = polyData;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkParenchymaSlicingIndex::GetInputData() const
+{
+  return this->InputData;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkParenchymaSlicingIndex::GetNumberOfCells() const
+{
+  return static_cast<vtkIdType>(this->CellOrder.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkParenchymaSlicingIndex::Update()
+{
+  if (this->InputData
+      && this->BuildTime > this->GetMTime()
+      && this->BuildTime > this->InputData->GetMTime())
+    {
+    return;
+    }
+  this->Build();
+}
+
+//----------------------------------------------------------------------------
+void vtkParenchymaSlicingIndex::Build()
+{
+  this->Points.clear();
+  this->CellOffsets.assign(1, 0);
+  this->CellPoints.clear();
+  this->CellOrder.clear();
+  this->Nodes.clear();
+  this->BuildTime.Modified();
+
+  vtkPolyData* polyData = this->InputData;
+  if (!polyData || !polyData->GetPoints() || !polyData->GetPolys())
+    {
+    return;
+    }
+
+  vtkIdType numberOfPoints = polyData->GetNumberOfPoints();
+  this->Points.resize(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    polyData->GetPoint(i, this->Points[i].data());
+    }
+
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto iter = vtk::TakeSmartPointer(polyData->GetPolys()->NewIterator());
+  for (iter->GoToFirstCell(); !iter->IsDoneWithTraversal(); iter->GoToNextCell())
+    {
+    iter->GetCurrentCell(npts, pts);
+    if (npts < 3)
+      {
+      continue;
+      }
+    this->CellPoints.insert(this->CellPoints.end(), pts, pts + npts);
+    this->CellOffsets.push_back(static_cast<vtkIdType>(this->CellPoints.size()));
+    }
+
+  vtkIdType numberOfCells = static_cast<vtkIdType>(this->CellOffsets.size()) - 1;
+  if (numberOfCells == 0)
+    {
+    return;
+    }
+
+  std::vector<std::array<double, 3>> centroids(numberOfCells);
+  for (vtkIdType cell = 0; cell < numberOfCells; ++cell)
+    {
+    std::array<double, 3>& centroid = centroids[cell];
+    centroid.fill(0.0);
+    for (vtkIdType n = this->CellOffsets[cell]; n < this->CellOffsets[cell + 1]; ++n)
+      {
+      const std::array<double, 3>& point = this->Points[this->CellPoints[n]];
+      centroid[0] += point[0];
+      centroid[1] += point[1];
+      centroid[2] += point[2];
+      }
+    double count = static_cast<double>(this->CellOffsets[cell + 1] - this->CellOffsets[cell]);
+    centroid[0] /= count;
+    centroid[1] /= count;
+    centroid[2] /= count;
+    }
+
+  this->CellOrder.resize(numberOfCells);
+  for (vtkIdType cell = 0; cell < numberOfCells; ++cell)
+    {
+    this->CellOrder[cell] = cell;
+    }
+  this->Nodes.reserve(2 * (numberOfCells / LeafSize + 1));
+  this->BuildNode(0, numberOfCells, centroids);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkParenchymaSlicingIndex::BuildNode(vtkIdType begin, vtkIdType end,
+                                               std::vector<std::array<double, 3>>& centroids)
+{
+  Node node;
+  node.Begin = begin;
+  node.End = end;
+  node.Left = -1;
+  node.Right = -1;
+  node.Bounds[0] = node.Bounds[2] = node.Bounds[4] = VTK_DOUBLE_MAX;
+  node.Bounds[1] = node.Bounds[3] = node.Bounds[5] = VTK_DOUBLE_MIN;
+  double centroidBounds[6] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN};
+  for (vtkIdType n = begin; n < end; ++n)
+    {
+    vtkIdType cell = this->CellOrder[n];
+    for (vtkIdType p = this->CellOffsets[cell]; p < this->CellOffsets[cell + 1]; ++p)
+      {
+      const std::array<double, 3>& point = this->Points[this->CellPoints[p]];
+      for (int c = 0; c < 3; ++c)
+        {
+        node.Bounds[2 * c] = std::min(node.Bounds[2 * c], point[c]);
+        node.Bounds[2 * c + 1] = std::max(node.Bounds[2 * c + 1], point[c]);
+        }
+      }
+    for (int c = 0; c < 3; ++c)
+      {
+      centroidBounds[2 * c] = std::min(centroidBounds[2 * c], centroids[cell][c]);
+      centroidBounds[2 * c + 1] = std::max(centroidBounds[2 * c + 1], centroids[cell][c]);
+      }
+    }
+
+  vtkIdType index = static_cast<vtkIdType>(this->Nodes.size());
+  this->Nodes.push_back(node);
+  if (end - begin <= LeafSize)
+    {
+    return index;
+    }
+
+  // Median split of the centroids along their longest extent
+  int axis = 0;
+  for (int c = 1; c < 3; ++c)
+    {
+    if (centroidBounds[2 * c + 1] - centroidBounds[2 * c] > centroidBounds[2 * axis + 1] - centroidBounds[2 * axis])
+      {
+      axis = c;
+      }
+    }
+  vtkIdType middle = begin + (end - begin) / 2;
+  std::nth_element(this->CellOrder.begin() + begin, this->CellOrder.begin() + middle, this->CellOrder.begin() + end,
+                   [&](vtkIdType a, vtkIdType b) { return centroids[a][axis] < centroids[b][axis]; });
+
+  vtkIdType left = this->BuildNode(begin, middle, centroids);
+  vtkIdType right = this->BuildNode(middle, end, centroids);
+  this->Nodes[index].Left = left;
+  this->Nodes[index].Right = right;
+  return index;
+}
+
+//----------------------------------------------------------------------------
+void vtkParenchymaSlicingIndex::AccumulateCell(vtkIdType cell, const double normal[3], double offset,
+                                               ContourSums& sums) const
+{
+  vtkIdType first = this->CellOffsets[cell];
+  vtkIdType count = this->CellOffsets[cell + 1] - first;
+  for (vtkIdType n = 0; n < count; ++n)
+    {
+    const double* p0 = this->Points[this->CellPoints[first + n]].data();
+    const double* p1 = this->Points[this->CellPoints[first + (n + 1) % count]].data();
+    double d0 = vtkMath::Dot(normal, p0) - offset;
+    double d1 = vtkMath::Dot(normal, p1) - offset;
+    if ((d0 >= 0.0) == (d1 >= 0.0))
+      {
+      continue;
+      }
+    double t = d0 / (d0 - d1);
+    double x[3] = {p0[0] + t * (p1[0] - p0[0]),
+                   p0[1] + t * (p1[1] - p0[1]),
+                   p0[2] + t * (p1[2] - p0[2])};
+    sums.Weight += 0.5;
+    sums.Sum[0] += 0.5 * x[0];
+    sums.Sum[1] += 0.5 * x[1];
+    sums.Sum[2] += 0.5 * x[2];
+    sums.SumOfProducts[0] += 0.5 * x[0] * x[0];
+    sums.SumOfProducts[1] += 0.5 * x[0] * x[1];
+    sums.SumOfProducts[2] += 0.5 * x[0] * x[2];
+    sums.SumOfProducts[3] += 0.5 * x[1] * x[1];
+    sums.SumOfProducts[4] += 0.5 * x[1] * x[2];
+    sums.SumOfProducts[5] += 0.5 * x[2] * x[2];
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkParenchymaSlicingIndex::ComputeContourSums(const double origin[3], const double normal[3],
+                                                   ContourSums& sums)
+{
+  sums = ContourSums();
+  this->NumberOfVisitedCells = 0;
+  this->Update();
+  if (this->Nodes.empty())
+    {
+    return false;
+    }
+
+  double absoluteNormal[3] = {std::fabs(normal[0]), std::fabs(normal[1]), std::fabs(normal[2])};
+  double offset = vtkMath::Dot(normal, origin);
+
+  std::vector<vtkIdType> stack(1, 0);
+  while (!stack.empty())
+    {
+    const Node& node = this->Nodes[stack.back()];
+    stack.pop_back();
+
+    // Signed distance interval of the box along the normal
+    double center[3] = {0.5 * (node.Bounds[0] + node.Bounds[1]),
+                        0.5 * (node.Bounds[2] + node.Bounds[3]),
+                        0.5 * (node.Bounds[4] + node.Bounds[5])};
+    double halfSize[3] = {0.5 * (node.Bounds[1] - node.Bounds[0]),
+                          0.5 * (node.Bounds[3] - node.Bounds[2]),
+                          0.5 * (node.Bounds[5] - node.Bounds[4])};
+    double distance = vtkMath::Dot(normal, center) - offset;
+    double radius = vtkMath::Dot(absoluteNormal, halfSize);
+    if (std::fabs(distance) > radius)
+      {
+      continue;
+      }
+
+    if (node.Left < 0)
+      {
+      for (vtkIdType n = node.Begin; n < node.End; ++n)
+        {
+        this->AccumulateCell(this->CellOrder[n], normal, offset, sums);
+        }
+      this->NumberOfVisitedCells += node.End - node.Begin;
+      continue;
+      }
+    stack.push_back(node.Left);
+    stack.push_back(node.Right);
+    }
+
+  return sums.Weight > 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkParenchymaSlicingIndex::ComputeSphereContour(const double center[3], double radius,
+                                                          vtkPoints* points)
+{
+  this->NumberOfVisitedCells = 0;
+  this->Update();
+  if (!points || this->Nodes.empty())
+    {
+    return 0;
+    }
+
+  double squaredRadius = radius * radius;
+  vtkIdType numberOfInsertedPoints = 0;
+
+  std::vector<vtkIdType> stack(1, 0);
+  while (!stack.empty())
+    {
+    const Node& node = this->Nodes[stack.back()];
+    stack.pop_back();
+
+    // The sphere crosses the box if the box is neither inside nor outside it
+    double nearest = 0.0;
+    double farthest = 0.0;
+    for (int c = 0; c < 3; ++c)
+      {
+      double below = center[c] - node.Bounds[2 * c];
+      double above = node.Bounds[2 * c + 1] - center[c];
+      double outside = std::max(0.0, std::max(-below, -above));
+      double extent = std::max(below, above);
+      nearest += outside * outside;
+      farthest += extent * extent;
+      }
+    if (nearest > squaredRadius || farthest < squaredRadius)
+      {
+      continue;
+      }
+
+    if (node.Left >= 0)
+      {
+      stack.push_back(node.Left);
+      stack.push_back(node.Right);
+      continue;
+      }
+
+    this->NumberOfVisitedCells += node.End - node.Begin;
+    for (vtkIdType n = node.Begin; n < node.End; ++n)
+      {
+      vtkIdType cell = this->CellOrder[n];
+      vtkIdType first = this->CellOffsets[cell];
+      vtkIdType count = this->CellOffsets[cell + 1] - first;
+      for (vtkIdType k = 0; k < count; ++k)
+        {
+        // Every edge is shared by two polygons, each traversing it in a
+        // different direction: only the increasing one is kept
+        vtkIdType id0 = this->CellPoints[first + k];
+        vtkIdType id1 = this->CellPoints[first + (k + 1) % count];
+        if (id0 > id1)
+          {
+          continue;
+          }
+        const double* p0 = this->Points[id0].data();
+        const double* p1 = this->Points[id1].data();
+        double f0 = vtkMath::Distance2BetweenPoints(p0, center) - squaredRadius;
+        double f1 = vtkMath::Distance2BetweenPoints(p1, center) - squaredRadius;
+        if ((f0 >= 0.0) == (f1 >= 0.0))
+          {
+          continue;
+          }
+        double t = f0 / (f0 - f1);
+        points->InsertNextPoint(p0[0] + t * (p1[0] - p0[0]),
+                                p0[1] + t * (p1[1] - p0[1]),
+                                p0[2] + t * (p1[2] - p0[2]));
+        ++numberOfInsertedPoints;
+        }
+      }
+    }
+
+  return numberOfInsertedPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vtkParenchymaSlicingIndex::ComputeContourPCA(const double origin[3], const double normal[3],
+                                                  ContourPCA& pca)
+{
+  ContourSums sums;
+  if (!this->ComputeContourSums(origin, normal, sums))
+    {
+    pca = ContourPCA();
+    return false;
+    }
+  return vtkParenchymaSlicingIndex::ComputePCAFromSums(sums, pca);
+}
+
+//----------------------------------------------------------------------------
+bool vtkParenchymaSlicingIndex::ComputePCAFromSums(const ContourSums& sums, ContourPCA& pca)
+{
+  pca = ContourPCA();
+  if (sums.Weight <= 0.0)
+    {
+    return false;
+    }
+
+  double n = sums.Weight;
+  pca.NumberOfPoints = n;
+  for (int i = 0; i < 3; ++i)
+    {
+    pca.Center[i] = sums.Sum[i] / n;
+    }
+
+  // Sample covariance, as computed by vtkPCAStatistics
+  double denominator = n > 1.0 ? n - 1.0 : 1.0;
+  const int index[3][3] = {{0, 1, 2}, {1, 3, 4}, {2, 4, 5}};
+  double covariance[3][3];
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      covariance[i][j] = (sums.SumOfProducts[index[i][j]] - n * pca.Center[i] * pca.Center[j]) / denominator;
+      }
+    }
+
+  vtkParenchymaSlicingIndex::SymmetricEigenSystem(covariance, pca.Eigenvalues, pca.Eigenvectors);
+  for (double& eigenvalue : pca.Eigenvalues)
+    {
+    eigenvalue = std::max(0.0, eigenvalue);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkParenchymaSlicingIndex::SymmetricEigenSystem(const double a[3][3], double eigenvalues[3],
+                                                     double eigenvectors[3][3])
+{
+  // Eigenvalues from the trigonometric solution of the characteristic cubic
+  double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+  double q = (a[0][0] + a[1][1] + a[2][2]) / 3.0;
+  double p2 = (a[0][0] - q) * (a[0][0] - q) + (a[1][1] - q) * (a[1][1] - q)
+              + (a[2][2] - q) * (a[2][2] - q) + 2.0 * offDiagonal;
+  double p = std::sqrt(p2 / 6.0);
+
+  if (p == 0.0)
+    {
+    // Multiple of the identity
+    for (int i = 0; i < 3; ++i)
+      {
+      eigenvalues[i] = q;
+      for (int j = 0; j < 3; ++j)
+        {
+        eigenvectors[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+      }
+    return;
+    }
+
+  double b[3][3];
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      b[i][j] = (a[i][j] - (i == j ? q : 0.0)) / p;
+      }
+    }
+  double r = std::max(-1.0, std::min(1.0, vtkMath::Determinant3x3(b) / 2.0));
+  double phi = std::acos(r) / 3.0;
+  eigenvalues[0] = q + 2.0 * p * std::cos(phi);
+  eigenvalues[2] = q + 2.0 * p * std::cos(phi + 2.0 * vtkMath::Pi() / 3.0);
+  eigenvalues[1] = 3.0 * q - eigenvalues[0] - eigenvalues[2];
+
+  // The eigenvector of the best separated eigenvalue is computed directly,
+  // the other two are found in the plane orthogonal to it, which remains
+  // well defined when they are (close to) equal
+  if (eigenvalues[0] - eigenvalues[1] >= eigenvalues[1] - eigenvalues[2])
+    {
+    EigenVector(a, eigenvalues[0], eigenvectors[0]);
+    EigenVectorsInPlane(a, eigenvectors[0], eigenvectors[1], eigenvectors[2]);
+    }
+  else
+    {
+    EigenVector(a, eigenvalues[2], eigenvectors[2]);
+    EigenVectorsInPlane(a, eigenvectors[2], eigenvectors[0], eigenvectors[1]);
+    }
+}
@@ -0,0 +1,167 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkParenchymaSlicingIndex_h
+#define __vtkParenchymaSlicingIndex_h
+
+#include "vtkSlicerLiverResectionsModulePlanningExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkTimeStamp.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <array>
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkPoints;
+class vtkPolyData;
+
+//------------------------------------------------------------------------------
+/// \brief Acceleration structure to slice a parenchyma model with planes.
+///
+/// A bounding volume hierarchy over the polygons of the model is built once
+/// and rebuilt only when the model changes. Cutting the model with a plane
+/// then only visits the polygons straddling the plane, and the centroid and
+/// covariance of the contour points are accumulated in a single pass without
+/// building the contour polydata. The principal axes of the contour are
+/// obtained from a closed-form solution of the 3x3 eigenproblem.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_PLANNING_EXPORT vtkParenchymaSlicingIndex
+  : public vtkObject
+{
+public:
+  static vtkParenchymaSlicingIndex* New();
+  vtkTypeMacro(vtkParenchymaSlicingIndex, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Sums of the contour points produced by a plane cut. Every contour point
+  /// is found from the two polygons sharing its edge, so the sums are
+  /// accumulated with weight 0.5.
+  struct ContourSums
+  {
+    double Weight = 0.0;
+    double Sum[3] = {0.0, 0.0, 0.0};
+    double SumOfProducts[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0}; // xx xy xz yy yz zz
+  };
+
+  /// Principal component analysis of a contour
+  struct ContourPCA
+  {
+    double NumberOfPoints = 0.0;
+    double Center[3] = {0.0, 0.0, 0.0};
+    double Eigenvalues[3] = {0.0, 0.0, 0.0};      ///< Sample variances, decreasing
+    double Eigenvectors[3][3] = {{1.0, 0.0, 0.0}, ///< One unit vector per row
+                                 {0.0, 1.0, 0.0},
+                                 {0.0, 0.0, 1.0}};
+  };
+
+  /// Model to slice
+  void SetInputData(vtkPolyData* polyData);
+  vtkPolyData* GetInputData() const;
+
+  /// Rebuilds the hierarchy if the model (or its points) changed since the
+  /// last build
+  void Update();
+
+  /// Accumulates the contour points of the cut of the model with the plane
+  /// through origin with the given normal (it does not need to be unit
+  /// length). Returns false if the plane does not cut the model.
+  bool ComputeContourSums(const double origin[3], const double normal[3], ContourSums& sums);
+
+  /// PCA of the contour of the cut of the model with a plane. Returns false if
+  /// the plane does not cut the model.
+  bool ComputeContourPCA(const double origin[3], const double normal[3], ContourPCA& pca);
+
+  /// Inserts in points the contour of the cut of the model with the sphere of
+  /// the given center and radius (one point per crossed edge). Returns the
+  /// number of inserted points.
+  vtkIdType ComputeSphereContour(const double center[3], double radius, vtkPoints* points);
+
+  /// PCA from accumulated contour sums
+  static bool ComputePCAFromSums(const ContourSums& sums, ContourPCA& pca);
+
+  /// Eigenvalues (decreasing) and unit eigenvectors (rows) of a symmetric 3x3
+  /// matrix, in closed form
+  static void SymmetricEigenSystem(const double a[3][3], double eigenvalues[3], double eigenvectors[3][3]);
+
+  /// Number of polygons tested in the last query
+  vtkGetMacro(NumberOfVisitedCells, vtkIdType);
+
+  /// Number of polygons in the hierarchy
+  vtkIdType GetNumberOfCells() const;
+
+protected:
+  vtkParenchymaSlicingIndex();
+  ~vtkParenchymaSlicingIndex() override;
+
+  struct Node
+  {
+    double Bounds[6];
+    vtkIdType Begin;   ///< Polygons of the node (range of CellOrder)
+    vtkIdType End;
+    vtkIdType Left;    ///< Children, -1 for leaves
+    vtkIdType Right;
+  };
+
+  void Build();
+  vtkIdType BuildNode(vtkIdType begin, vtkIdType end, std::vector<std::array<double, 3>>& centroids);
+
+  /// Adds the points where the edges of a polygon cross the plane
+  void AccumulateCell(vtkIdType cell, const double normal[3], double offset, ContourSums& sums) const;
+
+protected:
+  vtkWeakPointer<vtkPolyData> InputData;
+  vtkTimeStamp BuildTime;
+
+  std::vector<std::array<double, 3>> Points;
+  std::vector<vtkIdType> CellOffsets;
+  std::vector<vtkIdType> CellPoints;
+  std::vector<vtkIdType> CellOrder;
+  std::vector<Node> Nodes;
+
+  vtkIdType NumberOfVisitedCells;
+
+private:
+  vtkParenchymaSlicingIndex(const vtkParenchymaSlicingIndex&) = delete;
+  void operator=(const vtkParenchymaSlicingIndex&) = delete;
+};
+
+#endif // __vtkParenchymaSlicingIndex_h
@@ -0,0 +1,244 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// LiverMarkups includes
+#include "vtkBrickedDistanceMap.h"
+
+// Planning includes
+#include "vtkLiverDistanceMapEngine.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace
+{
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateSphere(const int extent[6], const double center[3], double radius)
+{
+  auto labelMap = vtkSmartPointer<vtkImageData>::New();
+  labelMap->SetExtent(extent[0], extent[1], extent[2], extent[3], extent[4], extent[5]);
+  labelMap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        const double d[3] = {i - center[0], j - center[1], k - center[2]};
+        *static_cast<unsigned char*>(labelMap->GetScalarPointer(i, j, k)) =
+          d[0] * d[0] + d[1] * d[1] + d[2] * d[2] < radius * radius ? 1 : 0;
+        }
+      }
+    }
+  return labelMap;
+}
+
+//------------------------------------------------------------------------------
+/// Trilinear interpolation of the dense volume at continuous structured indices
+double InterpolateDense(vtkImageData* volume, const double ijk[3], int component)
+{
+  const int* extent = volume->GetExtent();
+  int first[3];
+  double weights[3];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    first[axis] = std::min(static_cast<int>(std::floor(ijk[axis])), extent[2 * axis + 1] - 1);
+    weights[axis] = ijk[axis] - first[axis];
+    }
+  vtkDataArray* scalars = volume->GetPointData()->GetScalars();
+  double value = 0.0;
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    const int ijkCorner[3] = {first[0] + (corner & 1 ? 1 : 0), first[1] + (corner & 2 ? 1 : 0),
+                              first[2] + (corner & 4 ? 1 : 0)};
+    const double weight = (corner & 1 ? weights[0] : 1.0 - weights[0])
+      * (corner & 2 ? weights[1] : 1.0 - weights[1]) * (corner & 4 ? weights[2] : 1.0 - weights[2]);
+    if (weight != 0.0)
+      {
+      const vtkIdType tuple = (ijkCorner[0] - extent[0]) + (extent[1] - extent[0] + 1)
+        * ((ijkCorner[1] - extent[2]) + static_cast<vtkIdType>(extent[3] - extent[2] + 1) * (ijkCorner[2] - extent[4]));
+      value += weight * scalars->GetComponent(tuple, component);
+      }
+    }
+  return value;
+}
+}
+
+//------------------------------------------------------------------------------
+int vtkBrickedDistanceMapTest1(int, char *[])
+{
+  // Extent not starting at zero nor multiple of the brick size
+  const int extent[6] = {3, 52, -4, 36, 10, 43};
+  const double tumorCenter[3] = {14.0, 8.0, 20.0};
+  const double parenchymaCenter[3] = {20.0, 12.0, 25.0};
+
+  vtkNew<vtkLiverDistanceMapEngine> engine;
+  engine->SetStructure(vtkLiverDistanceMapEngine::Tumor, CreateSphere(extent, tumorCenter, 4.0));
+  engine->SetStructure(vtkLiverDistanceMapEngine::Parenchyma, CreateSphere(extent, parenchymaCenter, 9.0));
+  engine->SetBandWidth(3.0);
+
+  std::mt19937 generator(311393);
+  for (int quantized = 0; quantized < 2; ++quantized)
+    {
+    engine->SetQuantizeOutput(quantized != 0);
+    CHECK_BOOL(engine->Update(), true);
+    vtkImageData* dense = engine->GetOutput();
+    vtkDataArray* denseScalars = dense->GetPointData()->GetScalars();
+    const double scale = engine->GetOutputScale();
+    const double offset = engine->GetOutputOffset();
+
+    vtkNew<vtkBrickedDistanceMap> bricks;
+    CHECK_BOOL(bricks->Build(dense, scale, offset), true);
+    CHECK_INT(bricks->GetScalarType(), dense->GetScalarType());
+    CHECK_INT(bricks->GetNumberOfComponents(), 2);
+    CHECK_INT(bricks->GetBrickDimensions()[0], 4);
+    CHECK_INT(bricks->GetBrickDimensions()[1], 3);
+    CHECK_INT(bricks->GetBrickDimensions()[2], 3);
+    CHECK_INT(static_cast<int>(bricks->GetNumberOfBricks()), 36);
+
+    // Saturated bricks far from the structures are elided, the ones around
+    // them are stored
+    if (bricks->GetNumberOfStoredBricks() < 1 || bricks->GetNumberOfStoredBricks() >= bricks->GetNumberOfBricks())
+      {
+      std::cerr << "Some bricks should be elided: " << bricks->GetNumberOfStoredBricks() << " of "
+                << bricks->GetNumberOfBricks() << " stored" << std::endl;
+      return EXIT_FAILURE;
+      }
+    CHECK_BOOL(bricks->IsBrickStored(0, 0, 0), true);
+    CHECK_BOOL(bricks->IsBrickStored(3, 2, 2), false);
+    if (bricks->GetMemorySize() >= bricks->GetDenseMemorySize())
+      {
+      std::cerr << "Bricks should take less memory than the dense volume: " << bricks->GetMemorySize()
+                << " >= " << bricks->GetDenseMemorySize() << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // Lossless reconstruction
+    vtkNew<vtkImageData> reconstructed;
+    bricks->ToImageData(reconstructed);
+    CHECK_INT(reconstructed->GetScalarType(), dense->GetScalarType());
+    CHECK_INT(reconstructed->GetNumberOfScalarComponents(), 2);
+    for (int axis = 0; axis < 6; ++axis)
+      {
+      CHECK_INT(reconstructed->GetExtent()[axis], extent[axis]);
+      }
+    vtkDataArray* reconstructedScalars = reconstructed->GetPointData()->GetScalars();
+    CHECK_INT(static_cast<int>(reconstructedScalars->GetNumberOfValues()),
+              static_cast<int>(denseScalars->GetNumberOfValues()));
+    if (std::memcmp(reconstructedScalars->GetVoidPointer(0), denseScalars->GetVoidPointer(0),
+                    denseScalars->GetNumberOfValues() * denseScalars->GetDataTypeSize()) != 0)
+      {
+      std::cerr << "Reconstructed volume differs from the dense one (quantized " << quantized << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // Voxel distances and trilinear interpolation match the dense volume
+    for (int k = extent[4]; k <= extent[5]; k += 3)
+      {
+      for (int j = extent[2]; j <= extent[3]; j += 2)
+        {
+        for (int i = extent[0]; i <= extent[1]; ++i)
+          {
+          const vtkIdType tuple = (i - extent[0]) + (extent[1] - extent[0] + 1)
+            * ((j - extent[2]) + static_cast<vtkIdType>(extent[3] - extent[2] + 1) * (k - extent[4]));
+          for (int c = 0; c < 2; ++c)
+            {
+            CHECK_DOUBLE_TOLERANCE(bricks->GetDistance(i, j, k, c),
+                                   denseScalars->GetComponent(tuple, c) * scale + offset, 1e-9);
+            }
+          }
+        }
+      }
+    for (int sample = 0; sample < 5000; ++sample)
+      {
+      double ijk[3];
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        ijk[axis] = std::uniform_real_distribution<double>(extent[2 * axis], extent[2 * axis + 1])(generator);
+        }
+      // Exercise the brick and volume borders
+      if (sample % 4 == 0)
+        {
+        const int axis = sample % 3;
+        ijk[axis] = sample % 8 == 0 ? extent[2 * axis + 1]
+          : std::round((ijk[axis] - extent[2 * axis]) / vtkBrickedDistanceMap::BrickSize)
+            * vtkBrickedDistanceMap::BrickSize + extent[2 * axis];
+        ijk[axis] = std::min<double>(ijk[axis], extent[2 * axis + 1]);
+        }
+      double distances[2];
+      CHECK_BOOL(bricks->InterpolateDistance(ijk, distances), true);
+      for (int c = 0; c < 2; ++c)
+        {
+        const double expected = InterpolateDense(dense, ijk, c) * scale + offset;
+        if (std::fabs(distances[c] - expected) > 1e-6)
+          {
+          std::cerr << "Wrong interpolated distance at (" << ijk[0] << ", " << ijk[1] << ", " << ijk[2]
+                    << ") of structure " << c << ": " << distances[c] << " (expected " << expected << ")"
+                    << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    const double outside[3] = {extent[0] - 0.5, static_cast<double>(extent[2]), static_cast<double>(extent[4])};
+    double distances[2];
+    CHECK_BOOL(bricks->InterpolateDistance(outside, distances), false);
+    }
+
+  // Only float and short volumes can be bricked
+  vtkSmartPointer<vtkImageData> labelMap = CreateSphere(extent, tumorCenter, 4.0);
+  vtkNew<vtkBrickedDistanceMap> bricks;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(bricks->Build(labelMap), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(static_cast<int>(bricks->GetNumberOfBricks()), 0);
+
+  std::cout << "Success." << std::endl;
+  return EXIT_SUCCESS;
+}
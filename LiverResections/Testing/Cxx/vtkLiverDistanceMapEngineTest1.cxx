@@ -0,0 +1,454 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Planning includes
+#include "vtkLiverDistanceMapEngine.h"
+
+// Testing includes
+#include "vtkLiverDistanceMapTestingUtilities.h"
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkShortArray.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace
+{
+using vtkLiverDistanceMapTestingUtilities::CreateLabelMap;
+
+//------------------------------------------------------------------------------
+bool IsBoundary(vtkImageData* labelMap, int i, int j, int k)
+{
+  int dimensions[3];
+  labelMap->GetDimensions(dimensions);
+  auto inside = [&](int x, int y, int z)
+    {
+    return *static_cast<unsigned char*>(labelMap->GetScalarPointer(x, y, z)) != 0;
+    };
+  if (!inside(i, j, k))
+    {
+    return false;
+    }
+  const int ijk[3] = {i, j, k};
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    for (int step = -1; step <= 1; step += 2)
+      {
+      int neighbor[3] = {ijk[0], ijk[1], ijk[2]};
+      neighbor[axis] += step;
+      if (neighbor[axis] >= 0 && neighbor[axis] < dimensions[axis]
+          && !inside(neighbor[0], neighbor[1], neighbor[2]))
+        {
+        return true;
+        }
+      }
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+/// Signed distance to the closest boundary voxel, by exhaustive search
+double BruteForceDistance(vtkImageData* labelMap, int i, int j, int k)
+{
+  int dimensions[3];
+  labelMap->GetDimensions(dimensions);
+  const double* spacing = labelMap->GetSpacing();
+  double minimum = std::numeric_limits<double>::max();
+  for (int z = 0; z < dimensions[2]; ++z)
+    {
+    for (int y = 0; y < dimensions[1]; ++y)
+      {
+      for (int x = 0; x < dimensions[0]; ++x)
+        {
+        if (IsBoundary(labelMap, x, y, z))
+          {
+          const double d[3] = {(x - i) * spacing[0], (y - j) * spacing[1], (z - k) * spacing[2]};
+          minimum = std::min(minimum, std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]));
+          }
+        }
+      }
+    }
+  const bool inside = *static_cast<unsigned char*>(labelMap->GetScalarPointer(i, j, k)) != 0;
+  return inside ? -minimum : minimum;
+}
+}
+
+//------------------------------------------------------------------------------
+int vtkLiverDistanceMapEngineTest1(int, char *[])
+{
+  const int dimensions[3] = {17, 13, 11};
+  const double spacing[3] = {0.7, 0.9, 1.6};
+  const double tumorCenter[3] = {4.0, 5.0, 7.0};
+  const double parenchymaCenter[3] = {6.0, 6.0, 8.0};
+  vtkSmartPointer<vtkImageData> tumor = CreateLabelMap(dimensions, spacing, tumorCenter, 2.5);
+  vtkSmartPointer<vtkImageData> parenchyma = CreateLabelMap(dimensions, spacing, parenchymaCenter, 5.0);
+
+  vtkNew<vtkLiverDistanceMapEngine> engine;
+  engine->SetStructure(vtkLiverDistanceMapEngine::Tumor, tumor);
+  engine->SetStructure(vtkLiverDistanceMapEngine::Parenchyma, parenchyma);
+  CHECK_INT(engine->GetNumberOfComponents(), 2);
+  CHECK_BOOL(engine->Update(), true);
+
+  vtkImageData* output = engine->GetOutput();
+  CHECK_INT(output->GetNumberOfScalarComponents(), 2);
+  CHECK_INT(output->GetScalarType(), VTK_FLOAT);
+
+  vtkImageData* structures[2] = {tumor, parenchyma};
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        const float* distances = static_cast<float*>(output->GetScalarPointer(i, j, k));
+        for (int c = 0; c < 2; ++c)
+          {
+          const double expected = BruteForceDistance(structures[c], i, j, k);
+          if (std::fabs(distances[c] - expected) > 1e-4)
+            {
+            std::cerr << "Wrong distance at (" << i << ", " << j << ", " << k << ") of structure "
+                      << c << ": " << distances[c] << " (expected " << expected << ")" << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+
+  // Within the band, the banded distances are bit-identical to the full ones
+  vtkNew<vtkFloatArray> fullDistances;
+  fullDistances->DeepCopy(output->GetPointData()->GetScalars());
+  const double bandWidth = 2.0;
+  engine->SetBandWidth(bandWidth);
+  CHECK_BOOL(engine->Update(), true);
+  vtkFloatArray* bandDistances = vtkFloatArray::SafeDownCast(engine->GetOutput()->GetPointData()->GetScalars());
+  CHECK_NOT_NULL(bandDistances);
+  CHECK_INT(bandDistances->GetNumberOfValues(), fullDistances->GetNumberOfValues());
+  int valuesInBand = 0;
+  for (vtkIdType i = 0; i < fullDistances->GetNumberOfValues(); ++i)
+    {
+    const float full = fullDistances->GetValue(i);
+    const float band = bandDistances->GetValue(i);
+    const float expected = std::fabs(full) <= bandWidth
+      ? full : static_cast<float>(full < 0.0f ? -bandWidth : bandWidth);
+    if (std::memcmp(&band, &expected, sizeof(float)) != 0)
+      {
+      std::cerr << "Wrong banded distance at value " << i << ": " << band
+                << " (expected " << expected << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    valuesInBand += std::fabs(full) <= bandWidth;
+    }
+  if (valuesInBand == 0 || valuesInBand == fullDistances->GetNumberOfValues())
+    {
+    std::cerr << "The band should cover part of the image: " << valuesInBand << std::endl;
+    return EXIT_FAILURE;
+    }
+  engine->SetBandWidth(0.0);
+
+  // Cropped to the parenchyma grown by the margin: sub-extent of the input,
+  // same distances up to the margin within the parenchyma
+  const double cropMargin = 1.0;
+  engine->SetCropToParenchyma(true);
+  engine->SetCropMargin(cropMargin);
+  CHECK_BOOL(engine->Update(), true);
+  vtkImageData* cropped = engine->GetOutput();
+  int parenchymaBox[6] = {VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN};
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        if (*static_cast<unsigned char*>(parenchyma->GetScalarPointer(i, j, k)))
+          {
+          const int ijk[3] = {i, j, k};
+          for (int axis = 0; axis < 3; ++axis)
+            {
+            parenchymaBox[2 * axis] = std::min(parenchymaBox[2 * axis], ijk[axis]);
+            parenchymaBox[2 * axis + 1] = std::max(parenchymaBox[2 * axis + 1], ijk[axis]);
+            }
+          }
+        }
+      }
+    }
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const int margin = static_cast<int>(std::ceil(cropMargin / spacing[axis]));
+    CHECK_INT(cropped->GetExtent()[2 * axis], std::max(0, parenchymaBox[2 * axis] - margin));
+    CHECK_INT(cropped->GetExtent()[2 * axis + 1], std::min(dimensions[axis] - 1, parenchymaBox[2 * axis + 1] + margin));
+    CHECK_DOUBLE(cropped->GetOrigin()[axis], output->GetOrigin()[axis]);
+    }
+  for (int k = parenchymaBox[4]; k <= parenchymaBox[5]; ++k)
+    {
+    for (int j = parenchymaBox[2]; j <= parenchymaBox[3]; ++j)
+      {
+      for (int i = parenchymaBox[0]; i <= parenchymaBox[1]; ++i)
+        {
+        const float* croppedDistances = static_cast<float*>(cropped->GetScalarPointer(i, j, k));
+        for (int c = 0; c < 2; ++c)
+          {
+          const double expected = BruteForceDistance(structures[c], i, j, k);
+          if (std::fabs(expected) <= cropMargin && std::fabs(croppedDistances[c] - expected) > 1e-4)
+            {
+            std::cerr << "Wrong cropped distance at (" << i << ", " << j << ", " << k << ") of structure "
+                      << c << ": " << croppedDistances[c] << " (expected " << expected << ")" << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+  engine->SetCropToParenchyma(false);
+
+  // Quantized distances are within half the scale of the float ones: the
+  // margin thresholds of the resection shaders (a 10 mm margin with 2 mm of
+  // uncertainty, and the parenchyma clip out) only classify them differently
+  // that close to a threshold
+  engine->QuantizeOutputOn();
+  CHECK_BOOL(engine->Update(), true);
+  CHECK_INT(engine->GetOutput()->GetScalarType(), VTK_SHORT);
+  CHECK_DOUBLE(engine->GetOutputScale(), engine->GetQuantizationRange() / VTK_SHORT_MAX);
+  CHECK_DOUBLE(engine->GetOutputOffset(), 0.0);
+  vtkShortArray* quantizedDistances = vtkShortArray::SafeDownCast(engine->GetOutput()->GetPointData()->GetScalars());
+  CHECK_NOT_NULL(quantizedDistances);
+  CHECK_INT(quantizedDistances->GetNumberOfValues(), fullDistances->GetNumberOfValues());
+  const double quantizationError = 0.5 * engine->GetOutputScale() + 1e-6;
+  const double thresholds[] = {2.0, 8.0, 11.6, 12.0};
+  for (vtkIdType i = 0; i < fullDistances->GetNumberOfValues(); ++i)
+    {
+    const double full = fullDistances->GetValue(i);
+    const double quantized = quantizedDistances->GetValue(i) * engine->GetOutputScale() + engine->GetOutputOffset();
+    if (std::fabs(quantized - full) > quantizationError)
+      {
+      std::cerr << "Wrong quantized distance at value " << i << ": " << quantized
+                << " (expected " << full << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (double threshold : thresholds)
+      {
+      if ((quantized < threshold) != (full < threshold) && std::fabs(full - threshold) > quantizationError)
+        {
+        std::cerr << "Quantized distance " << quantized << " crosses the threshold " << threshold << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  engine->QuantizeOutputOff();
+
+  // Resampled distance maps: structures max pooled onto a coarse grid centered
+  // on the pooled blocks, with distances that never exceed the ones of the
+  // label maps out of the structures
+  const double targetSpacing[3] = {2.1, 2.7, 1.0};
+  engine->SetTargetSpacing(targetSpacing[0], targetSpacing[1], targetSpacing[2]);
+  CHECK_BOOL(engine->Update(), true);
+  const int expectedFactors[3] = {3, 3, 1};
+  vtkImageData* resampled = engine->GetOutput();
+  vtkNew<vtkMatrix4x4> outputToInput;
+  engine->GetOutputIndexToInputIndex(outputToInput);
+  double bias = 0.0;
+  double coarseDiagonal = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const int factor = expectedFactors[axis];
+    CHECK_INT(engine->GetResamplingFactors()[axis], factor);
+    CHECK_INT(resampled->GetDimensions()[axis], (dimensions[axis] + factor - 1) / factor);
+    CHECK_DOUBLE_TOLERANCE(resampled->GetSpacing()[axis], factor * spacing[axis], 1e-9);
+    CHECK_DOUBLE_TOLERANCE(resampled->GetOrigin()[axis], 0.5 * (factor - 1) * spacing[axis], 1e-9);
+    CHECK_DOUBLE_TOLERANCE(outputToInput->GetElement(axis, axis), factor, 1e-9);
+    CHECK_DOUBLE_TOLERANCE(outputToInput->GetElement(axis, 3), 0.5 * (factor - 1), 1e-9);
+    bias += std::pow((factor - 1) * spacing[axis], 2);
+    coarseDiagonal += std::pow(factor * spacing[axis], 2);
+    }
+  bias = 0.5 * std::sqrt(bias);
+  coarseDiagonal = std::sqrt(coarseDiagonal);
+  const int* resampledDimensions = resampled->GetDimensions();
+  for (int k = 0; k < resampledDimensions[2]; ++k)
+    {
+    for (int j = 0; j < resampledDimensions[1]; ++j)
+      {
+      for (int i = 0; i < resampledDimensions[0]; ++i)
+        {
+        const float* distances = static_cast<float*>(resampled->GetScalarPointer(i, j, k));
+        const int center[3] = {3 * i + 1, 3 * j + 1, k};
+        for (int c = 0; c < 2; ++c)
+          {
+          // Any voxel inside the structure makes the coarse voxel inside
+          bool pooledInside = false;
+          for (int y = 3 * j; y < std::min(3 * j + 3, dimensions[1]); ++y)
+            {
+            for (int x = 3 * i; x < std::min(3 * i + 3, dimensions[0]); ++x)
+              {
+              pooledInside |= *static_cast<unsigned char*>(structures[c]->GetScalarPointer(x, y, k)) != 0;
+              }
+            }
+          if (pooledInside && distances[c] >= 0.0f)
+            {
+            std::cerr << "Pooled voxel (" << i << ", " << j << ", " << k << ") of structure " << c
+                      << " is not inside: " << distances[c] << std::endl;
+            return EXIT_FAILURE;
+            }
+          if (center[0] >= dimensions[0] || center[1] >= dimensions[1])
+            {
+            continue;
+            }
+          const double expected = BruteForceDistance(structures[c], center[0], center[1], center[2]);
+          if ((expected > 0.0 && distances[c] > expected + 1e-4)
+              || std::fabs(distances[c] - expected) > 2.0 * bias + coarseDiagonal)
+            {
+            std::cerr << "Wrong resampled distance at (" << i << ", " << j << ", " << k << ") of structure "
+                      << c << ": " << distances[c] << " (expected " << expected << ")" << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+  engine->SetTargetSpacing(0.0, 0.0, 0.0);
+
+  // Incremental updates after random edits match a full update, with full,
+  // banded, cropped, quantized and resampled distance maps
+  std::mt19937 generator(311393);
+  vtkNew<vtkLiverDistanceMapEngine> reference;
+  reference->SetStructure(vtkLiverDistanceMapEngine::Tumor, tumor);
+  reference->SetStructure(vtkLiverDistanceMapEngine::Parenchyma, parenchyma);
+  for (int mode = 0; mode < 5; ++mode)
+    {
+    for (vtkLiverDistanceMapEngine* e : {engine.GetPointer(), reference.GetPointer()})
+      {
+      e->SetBandWidth(mode == 1 ? bandWidth : 0.0);
+      e->SetCropToParenchyma(mode == 2);
+      e->SetQuantizeOutput(mode == 3);
+      e->SetCropMargin(cropMargin);
+      const double modeSpacing = mode == 4 ? 1.0 : 0.0;
+      e->SetTargetSpacing(modeSpacing * targetSpacing[0], modeSpacing * targetSpacing[1],
+                          modeSpacing * targetSpacing[2]);
+      }
+    CHECK_BOOL(engine->Update(), true);
+    for (int edit = 0; edit < 20; ++edit)
+      {
+      // The crop region follows the parenchyma, only edit the tumor then
+      const int structure = mode == 2 ? vtkLiverDistanceMapEngine::Tumor : static_cast<int>(generator() % 2);
+      vtkImageData* labelMap = structure == vtkLiverDistanceMapEngine::Tumor ? tumor : parenchyma;
+      int changedExtent[6];
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        changedExtent[2 * axis] = static_cast<int>(generator() % dimensions[axis]);
+        changedExtent[2 * axis + 1] = std::min(dimensions[axis] - 1,
+                                               changedExtent[2 * axis] + static_cast<int>(generator() % 4));
+        }
+      const unsigned char value = static_cast<unsigned char>(generator() % 2);
+      for (int k = changedExtent[4]; k <= changedExtent[5]; ++k)
+        {
+        for (int j = changedExtent[2]; j <= changedExtent[3]; ++j)
+          {
+          for (int i = changedExtent[0]; i <= changedExtent[1]; ++i)
+            {
+            *static_cast<unsigned char*>(labelMap->GetScalarPointer(i, j, k)) = value;
+            }
+          }
+        }
+      labelMap->Modified();
+
+      CHECK_BOOL(engine->UpdateStructure(structure, changedExtent), true);
+      CHECK_BOOL(reference->Update(), true);
+      vtkImageData* updated = engine->GetOutput();
+      vtkImageData* expected = reference->GetOutput();
+      for (int axis = 0; axis < 6; ++axis)
+        {
+        CHECK_INT(updated->GetExtent()[axis], expected->GetExtent()[axis]);
+        }
+      // Float roundings may differ by a quantization level
+      const double scale = reference->GetOutputScale();
+      const double tolerance = mode == 3 ? 1.5 * scale : 1e-5;
+      vtkDataArray* updatedDistances = updated->GetPointData()->GetScalars();
+      vtkDataArray* expectedDistances = expected->GetPointData()->GetScalars();
+      CHECK_INT(updatedDistances->GetNumberOfValues(), expectedDistances->GetNumberOfValues());
+      const int numberOfComponents = expectedDistances->GetNumberOfComponents();
+      for (vtkIdType i = 0; i < expectedDistances->GetNumberOfValues(); ++i)
+        {
+        const double updatedDistance = updatedDistances->GetComponent(i / numberOfComponents, i % numberOfComponents) * scale;
+        const double expectedDistance = expectedDistances->GetComponent(i / numberOfComponents, i % numberOfComponents) * scale;
+        if (std::fabs(updatedDistance - expectedDistance) > tolerance)
+          {
+          std::cerr << "Wrong updated distance at value " << i << " after edit " << edit << " in mode "
+                    << mode << ": " << updatedDistance << " (expected " << expectedDistance << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  engine->SetBandWidth(0.0);
+  engine->SetCropToParenchyma(false);
+  engine->QuantizeOutputOff();
+  engine->SetTargetSpacing(0.0, 0.0, 0.0);
+
+  // Updating a structure without distance maps is rejected
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  const int anyExtent[6] = {0, 0, 0, 0, 0, 0};
+  CHECK_BOOL(engine->UpdateStructure(vtkLiverDistanceMapEngine::HepaticVein, anyExtent), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // Structures with different geometries are rejected
+  const int otherDimensions[3] = {17, 13, 10};
+  engine->SetStructure(vtkLiverDistanceMapEngine::PortalVein,
+                       CreateLabelMap(otherDimensions, spacing, tumorCenter, 2.5));
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(engine->Update(), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  engine->RemoveAllStructures();
+  CHECK_INT(engine->GetNumberOfComponents(), 0);
+
+  std::cout << "Success." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkLiverDistanceMapTestingUtilities_h
+#define __vtkLiverDistanceMapTestingUtilities_h
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+namespace vtkLiverDistanceMapTestingUtilities
+{
+//------------------------------------------------------------------------------
+/// Label map of a sphere (1 inside, 0 outside) with origin at zero
+inline vtkSmartPointer<vtkImageData> CreateLabelMap(const int dimensions[3], const double spacing[3],
+                                                    const double center[3], double radius)
+{
+  auto labelMap = vtkSmartPointer<vtkImageData>::New();
+  labelMap->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  labelMap->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  labelMap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        const double d[3] = {i * spacing[0] - center[0], j * spacing[1] - center[1], k * spacing[2] - center[2]};
+        *static_cast<unsigned char*>(labelMap->GetScalarPointer(i, j, k)) =
+          d[0] * d[0] + d[1] * d[1] + d[2] * d[2] < radius * radius ? 1 : 0;
+        }
+      }
+    }
+  return labelMap;
+}
+}
+
+#endif // __vtkLiverDistanceMapTestingUtilities_h
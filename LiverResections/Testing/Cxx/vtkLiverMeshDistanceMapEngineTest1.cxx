@@ -0,0 +1,250 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Planning includes
+#include "vtkLiverMeshDistanceMapEngine.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkShortArray.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+//------------------------------------------------------------------------------
+/// Axis aligned box surface, with quads or triangles, oriented outwards or
+/// inwards
+vtkSmartPointer<vtkPolyData> CreateBox(const double center[3], const double halfSize[3], bool triangles, bool inwards)
+{
+  vtkNew<vtkPoints> points;
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    points->InsertNextPoint(center[0] + ((corner & 1) ? halfSize[0] : -halfSize[0]),
+                            center[1] + ((corner & 2) ? halfSize[1] : -halfSize[1]),
+                            center[2] + ((corner & 4) ? halfSize[2] : -halfSize[2]));
+    }
+  // Counterclockwise seen from outside
+  const vtkIdType faces[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+  vtkNew<vtkCellArray> polys;
+  for (const auto& face : faces)
+    {
+    vtkIdType ids[4] = {face[0], face[1], face[2], face[3]};
+    if (inwards)
+      {
+      std::reverse(ids, ids + 4);
+      }
+    if (triangles)
+      {
+      const vtkIdType first[3] = {ids[0], ids[1], ids[2]};
+      const vtkIdType second[3] = {ids[0], ids[2], ids[3]};
+      polys->InsertNextCell(3, first);
+      polys->InsertNextCell(3, second);
+      }
+    else
+      {
+      polys->InsertNextCell(4, ids);
+      }
+    }
+  auto box = vtkSmartPointer<vtkPolyData>::New();
+  box->SetPoints(points);
+  box->SetPolys(polys);
+  return box;
+}
+
+//------------------------------------------------------------------------------
+/// Exact signed distance to an axis aligned box
+double BoxDistance(const double point[3], const double center[3], const double halfSize[3])
+{
+  double outside = 0.0;
+  double inside = -VTK_DOUBLE_MAX;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const double q = std::fabs(point[axis] - center[axis]) - halfSize[axis];
+    outside += std::max(q, 0.0) * std::max(q, 0.0);
+    inside = std::max(inside, q);
+    }
+  return std::sqrt(outside) + std::min(inside, 0.0);
+}
+}
+
+//------------------------------------------------------------------------------
+int vtkLiverMeshDistanceMapEngineTest1(int, char *[])
+{
+  // A thin vessel (0.2 mm) is far below the grid spacing
+  const double centers[3][3] = {{5.0, 5.0, 5.0}, {6.0, 5.0, 6.0}, {3.1, 5.0, 7.3}};
+  const double halfSizes[3][3] = {{2.0, 1.5, 2.5}, {4.0, 3.5, 4.0}, {0.1, 4.0, 0.1}};
+  const double origin[3] = {0.25, 0.5, 0.0};
+  const double spacing[3] = {0.9, 0.8, 1.1};
+  const int dimensions[3] = {14, 13, 12};
+
+  vtkNew<vtkLiverMeshDistanceMapEngine> engine;
+  engine->SetStructure(vtkLiverDistanceMapEngine::Tumor, CreateBox(centers[0], halfSizes[0], false, false));
+  engine->SetStructure(vtkLiverDistanceMapEngine::Parenchyma, CreateBox(centers[1], halfSizes[1], true, true));
+  engine->SetStructure(vtkLiverDistanceMapEngine::HepaticVein, CreateBox(centers[2], halfSizes[2], true, false));
+  engine->SetOutputOrigin(origin[0], origin[1], origin[2]);
+  engine->SetOutputSpacing(spacing[0], spacing[1], spacing[2]);
+  engine->SetOutputDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  CHECK_INT(engine->GetNumberOfComponents(), 3);
+  CHECK_BOOL(engine->Update(), true);
+
+  // Exact distances at every grid point, whatever the polygons and their
+  // orientation
+  vtkImageData* output = engine->GetOutput();
+  CHECK_INT(output->GetNumberOfScalarComponents(), 3);
+  CHECK_INT(output->GetScalarType(), VTK_FLOAT);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    CHECK_INT(output->GetDimensions()[axis], dimensions[axis]);
+    CHECK_DOUBLE_TOLERANCE(output->GetOrigin()[axis], origin[axis], 1e-12);
+    CHECK_DOUBLE_TOLERANCE(output->GetSpacing()[axis], spacing[axis], 1e-12);
+    }
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        const double point[3] = {origin[0] + i * spacing[0], origin[1] + j * spacing[1], origin[2] + k * spacing[2]};
+        const float* distances = static_cast<float*>(output->GetScalarPointer(i, j, k));
+        for (int c = 0; c < 3; ++c)
+          {
+          const double expected = BoxDistance(point, centers[c], halfSizes[c]);
+          if (std::fabs(distances[c] - expected) > 1e-5)
+            {
+            std::cerr << "Wrong distance at (" << i << ", " << j << ", " << k << ") of structure "
+                      << c << ": " << distances[c] << " (expected " << expected << ")" << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+
+  // Off the grid too
+  const double point[3] = {3.17, 4.4, 7.21};
+  double distance = 0.0;
+  CHECK_BOOL(engine->EvaluateDistance(vtkLiverDistanceMapEngine::HepaticVein, point, distance), true);
+  CHECK_DOUBLE_TOLERANCE(distance, BoxDistance(point, centers[2], halfSizes[2]), 1e-12);
+  CHECK_BOOL(engine->EvaluateDistance(vtkLiverDistanceMapEngine::PortalVein, point, distance), false);
+
+  // Within the band, the banded distances are bit-identical to the full
+  // ones; out of it they saturate with the right sign, also for bands
+  // narrower than the grid spacing
+  vtkNew<vtkFloatArray> fullDistances;
+  fullDistances->DeepCopy(output->GetPointData()->GetScalars());
+  for (double bandWidth : {1.5, 0.3})
+    {
+    engine->SetBandWidth(bandWidth);
+    CHECK_BOOL(engine->Update(), true);
+    vtkFloatArray* bandDistances = vtkFloatArray::SafeDownCast(engine->GetOutput()->GetPointData()->GetScalars());
+    CHECK_NOT_NULL(bandDistances);
+    CHECK_INT(bandDistances->GetNumberOfValues(), fullDistances->GetNumberOfValues());
+    for (vtkIdType i = 0; i < fullDistances->GetNumberOfValues(); ++i)
+      {
+      const float full = fullDistances->GetValue(i);
+      const float band = bandDistances->GetValue(i);
+      const float expected = std::fabs(full) <= bandWidth
+        ? full : static_cast<float>(full < 0.0f ? -bandWidth : bandWidth);
+      if (std::memcmp(&band, &expected, sizeof(float)) != 0)
+        {
+        std::cerr << "Wrong banded distance at value " << i << " for a band of " << bandWidth << ": "
+                  << band << " (expected " << expected << ")" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  engine->SetBandWidth(0.0);
+
+  // Quantized distances are within half a quantization level
+  engine->QuantizeOutputOn();
+  engine->SetQuantizationRange(5.0);
+  CHECK_BOOL(engine->Update(), true);
+  CHECK_INT(engine->GetOutput()->GetScalarType(), VTK_SHORT);
+  CHECK_DOUBLE_TOLERANCE(engine->GetOutputScale(), 5.0 / VTK_SHORT_MAX, 1e-12);
+  vtkShortArray* quantizedDistances = vtkShortArray::SafeDownCast(engine->GetOutput()->GetPointData()->GetScalars());
+  CHECK_NOT_NULL(quantizedDistances);
+  for (vtkIdType i = 0; i < fullDistances->GetNumberOfValues(); ++i)
+    {
+    const double full = std::max(-5.0, std::min(5.0, static_cast<double>(fullDistances->GetValue(i))));
+    const double quantized = quantizedDistances->GetValue(i) * engine->GetOutputScale() + engine->GetOutputOffset();
+    if (std::fabs(quantized - full) > 0.5 * engine->GetOutputScale() + 1e-6)
+      {
+      std::cerr << "Wrong quantized distance at value " << i << ": " << quantized
+                << " (expected " << full << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  engine->QuantizeOutputOff();
+
+  // Structures without triangles saturate
+  vtkNew<vtkPolyData> empty;
+  engine->SetStructure(vtkLiverDistanceMapEngine::PortalVein, empty);
+  CHECK_BOOL(engine->Update(), true);
+  CHECK_INT(engine->GetOutput()->GetNumberOfScalarComponents(), 4);
+  CHECK_DOUBLE_TOLERANCE(static_cast<float*>(engine->GetOutput()->GetScalarPointer())[3], VTK_FLOAT_MAX, 0.0);
+
+  // Invalid grids and missing structures are rejected
+  engine->SetOutputDimensions(0, dimensions[1], dimensions[2]);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(engine->Update(), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  engine->SetOutputDimensions(dimensions[0], dimensions[1], dimensions[2]);
+
+  engine->RemoveAllStructures();
+  CHECK_INT(engine->GetNumberOfComponents(), 0);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(engine->Update(), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  std::cout << "Success." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,260 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Planning includes
+#include "vtkLiverDistanceMapEngine.h"
+#include "vtkLiverProgressiveDistanceMapEngine.h"
+
+// Testing includes
+#include "vtkLiverDistanceMapTestingUtilities.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using vtkLiverDistanceMapTestingUtilities::CreateLabelMap;
+
+//------------------------------------------------------------------------------
+/// Whether the fetched level has the output of the engine, bit for bit
+bool SameOutput(vtkLiverProgressiveDistanceMapEngine* progressiveEngine, vtkLiverDistanceMapEngine* engine)
+{
+  vtkImageData* fetched = progressiveEngine->GetOutput();
+  vtkImageData* expected = engine->GetOutput();
+  int fetchedExtent[6], expectedExtent[6];
+  fetched->GetExtent(fetchedExtent);
+  expected->GetExtent(expectedExtent);
+  if (std::memcmp(fetchedExtent, expectedExtent, sizeof(fetchedExtent)) != 0
+      || fetched->GetScalarType() != expected->GetScalarType()
+      || fetched->GetNumberOfScalarComponents() != expected->GetNumberOfScalarComponents()
+      || progressiveEngine->GetOutputScale() != engine->GetOutputScale()
+      || progressiveEngine->GetOutputOffset() != engine->GetOutputOffset())
+    {
+    std::cerr << "Different output geometry or type at level " << progressiveEngine->GetFetchedLevel() << std::endl;
+    return false;
+    }
+
+  vtkNew<vtkMatrix4x4> fetchedMatrix, expectedMatrix;
+  progressiveEngine->GetOutputIndexToInputIndex(fetchedMatrix);
+  engine->GetOutputIndexToInputIndex(expectedMatrix);
+  for (int element = 0; element < 16; ++element)
+    {
+    if (fetchedMatrix->GetElement(element / 4, element % 4) != expectedMatrix->GetElement(element / 4, element % 4))
+      {
+      std::cerr << "Different output to input matrix at level " << progressiveEngine->GetFetchedLevel() << std::endl;
+      return false;
+      }
+    }
+
+  vtkDataArray* fetchedScalars = fetched->GetPointData()->GetScalars();
+  vtkDataArray* expectedScalars = expected->GetPointData()->GetScalars();
+  const size_t size = static_cast<size_t>(expectedScalars->GetNumberOfValues()) * expectedScalars->GetDataTypeSize();
+  if (fetchedScalars->GetNumberOfValues() != expectedScalars->GetNumberOfValues()
+      || std::memcmp(fetchedScalars->GetVoidPointer(0), expectedScalars->GetVoidPointer(0), size) != 0)
+    {
+    std::cerr << "Different distances at level " << progressiveEngine->GetFetchedLevel() << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+//------------------------------------------------------------------------------
+int vtkLiverProgressiveDistanceMapEngineTest1(int, char *[])
+{
+  const int dimensions[3] = {41, 37, 23};
+  const double spacing[3] = {0.7, 0.9, 1.6};
+  const double tumorCenter[3] = {10.0, 12.0, 15.0};
+  const double parenchymaCenter[3] = {14.0, 16.0, 18.0};
+  vtkSmartPointer<vtkImageData> tumor = CreateLabelMap(dimensions, spacing, tumorCenter, 4.0);
+  vtkSmartPointer<vtkImageData> parenchyma = CreateLabelMap(dimensions, spacing, parenchymaCenter, 10.0);
+
+  vtkNew<vtkLiverDistanceMapEngine> engine;
+  vtkNew<vtkLiverProgressiveDistanceMapEngine> progressiveEngine;
+  CHECK_INT(progressiveEngine->GetCoarsestFactor(), 4);
+  CHECK_BOOL(progressiveEngine->IsRunning(), false);
+  CHECK_INT(progressiveEngine->GetFetchedLevel(), -1);
+
+  // Nothing to compute
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(progressiveEngine->Start(engine), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  engine->SetStructure(vtkLiverDistanceMapEngine::Tumor, tumor);
+  engine->SetStructure(vtkLiverDistanceMapEngine::Parenchyma, parenchyma);
+  engine->SetBandWidth(6.0);
+  engine->QuantizeOutputOn();
+  engine->SetQuantizationRange(20.0);
+
+  // Every fetched level has the distance maps of its resampling factor (4, 2
+  // and 1), computed from the label maps at the time of the start
+  for (int coarsestFactor : {4, 3, 1})
+    {
+    progressiveEngine->SetCoarsestFactor(coarsestFactor);
+    CHECK_BOOL(progressiveEngine->Start(engine), true);
+    const int numberOfLevels = coarsestFactor == 4 ? 3 : coarsestFactor == 3 ? 2 : 1;
+    CHECK_INT(progressiveEngine->GetNumberOfLevels(), numberOfLevels);
+
+    // The engine and its label maps can change meanwhile
+    vtkSmartPointer<vtkImageData> originalTumor = tumor;
+    auto emptyTumor = vtkSmartPointer<vtkImageData>::New();
+    emptyTumor->DeepCopy(tumor);
+    emptyTumor->GetPointData()->GetScalars()->Fill(0.0);
+    engine->SetStructure(vtkLiverDistanceMapEngine::Tumor, emptyTumor);
+    engine->SetBandWidth(1.0);
+
+    vtkNew<vtkLiverDistanceMapEngine> expectedEngine;
+    expectedEngine->SetStructure(vtkLiverDistanceMapEngine::Tumor, originalTumor);
+    expectedEngine->SetStructure(vtkLiverDistanceMapEngine::Parenchyma, parenchyma);
+    expectedEngine->SetBandWidth(6.0);
+    expectedEngine->QuantizeOutputOn();
+    expectedEngine->SetQuantizationRange(20.0);
+
+    std::vector<int> fetchedLevels;
+    while (progressiveEngine->IsRunning())
+      {
+      if (!progressiveEngine->FetchLevel())
+        {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+        }
+      const int level = progressiveEngine->GetFetchedLevel();
+      if (!fetchedLevels.empty() && level <= fetchedLevels.back())
+        {
+        std::cerr << "Level " << level << " fetched after level " << fetchedLevels.back() << std::endl;
+        return EXIT_FAILURE;
+        }
+      fetchedLevels.push_back(level);
+
+      int factor = coarsestFactor;
+      for (int finerLevel = 0; finerLevel < level; ++finerLevel)
+        {
+        factor /= 2;
+        }
+      factor = level == numberOfLevels - 1 ? 1 : factor;
+      expectedEngine->SetTargetSpacing(factor > 1 ? factor * spacing[0] : 0.0,
+                                       factor > 1 ? factor * spacing[1] : 0.0,
+                                       factor > 1 ? factor * spacing[2] : 0.0);
+      CHECK_BOOL(expectedEngine->Update(), true);
+      if (!SameOutput(progressiveEngine, expectedEngine))
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    CHECK_BOOL(progressiveEngine->GetFailed(), false);
+    CHECK_BOOL(fetchedLevels.empty(), false);
+    CHECK_INT(fetchedLevels.back(), numberOfLevels - 1);
+    CHECK_BOOL(progressiveEngine->FetchLevel(), false);
+
+    engine->SetStructure(vtkLiverDistanceMapEngine::Tumor, originalTumor);
+    engine->SetBandWidth(6.0);
+    }
+
+  // Cancelled computations stop without publishing levels
+  progressiveEngine->SetCoarsestFactor(4);
+  CHECK_BOOL(progressiveEngine->Start(engine), true);
+  progressiveEngine->Cancel();
+  CHECK_BOOL(progressiveEngine->IsRunning(), false);
+  CHECK_BOOL(progressiveEngine->FetchLevel(), false);
+  CHECK_INT(progressiveEngine->GetFetchedLevel(), -1);
+  CHECK_BOOL(progressiveEngine->GetFailed(), false);
+
+  // A new start cancels the running computation
+  CHECK_BOOL(progressiveEngine->Start(engine), true);
+  CHECK_INT(progressiveEngine->GetFetchedLevel(), -1);
+  CHECK_BOOL(progressiveEngine->Start(engine), true);
+  while (progressiveEngine->IsRunning())
+    {
+    progressiveEngine->FetchLevel();
+    }
+  CHECK_INT(progressiveEngine->GetFetchedLevel(), 2);
+
+  // The last level gives its label maps and state to an engine, which then
+  // updates an edited structure as after its own Update()
+  vtkNew<vtkLiverDistanceMapEngine> updatedEngine;
+  CHECK_BOOL(progressiveEngine->CopyLastLevelEngine(updatedEngine), true);
+  CHECK_BOOL(progressiveEngine->CopyLastLevelEngine(updatedEngine), false);
+  CHECK_INT(updatedEngine->GetNumberOfComponents(), 2);
+  CHECK_DOUBLE(updatedEngine->GetBandWidth(), 6.0);
+  const double editedTumorCenter[3] = {11.0, 12.0, 15.0};
+  vtkSmartPointer<vtkImageData> editedTumor = CreateLabelMap(dimensions, spacing, editedTumorCenter, 5.0);
+  const int changedExtent[6] = {0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1};
+  updatedEngine->SetStructure(vtkLiverDistanceMapEngine::Tumor, editedTumor);
+  CHECK_BOOL(updatedEngine->UpdateStructure(vtkLiverDistanceMapEngine::Tumor, changedExtent), true);
+
+  vtkNew<vtkLiverDistanceMapEngine> editedEngine;
+  editedEngine->SetStructure(vtkLiverDistanceMapEngine::Tumor, editedTumor);
+  editedEngine->SetStructure(vtkLiverDistanceMapEngine::Parenchyma, parenchyma);
+  editedEngine->SetBandWidth(6.0);
+  editedEngine->QuantizeOutputOn();
+  editedEngine->SetQuantizationRange(20.0);
+  CHECK_BOOL(editedEngine->Update(), true);
+  vtkDataArray* updatedScalars = updatedEngine->GetOutput()->GetPointData()->GetScalars();
+  vtkDataArray* editedScalars = editedEngine->GetOutput()->GetPointData()->GetScalars();
+  if (updatedScalars->GetNumberOfValues() != editedScalars->GetNumberOfValues()
+      || std::memcmp(updatedScalars->GetVoidPointer(0), editedScalars->GetVoidPointer(0),
+                     static_cast<size_t>(editedScalars->GetNumberOfValues()) * editedScalars->GetDataTypeSize()) != 0)
+    {
+    std::cerr << "Different distances after updating the engine of the last level" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Aborted updates of the engine return without distance maps or errors
+  engine->SetAbortExecute(true);
+  CHECK_BOOL(engine->GetAbortExecute(), true);
+  CHECK_BOOL(engine->Update(), false);
+  engine->SetAbortExecute(false);
+  CHECK_BOOL(engine->Update(), true);
+
+  std::cout << "Success." << std::endl;
+  return EXIT_SUCCESS;
+}
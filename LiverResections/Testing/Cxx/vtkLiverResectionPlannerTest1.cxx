@@ -0,0 +1,124 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Planning includes
+#include "vtkLiverResectionPlanner.h"
+
+// VTK includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+//------------------------------------------------------------------------------
+int vtkLiverResectionPlannerTest1(int, char *[])
+{
+  // Target organ: sphere of radius 50 at the origin
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(50.0);
+  sphere->SetThetaResolution(64);
+  sphere->SetPhiResolution(64);
+  sphere->Update();
+
+  vtkNew<vtkLiverResectionPlanner> planner;
+  planner->SetTargetOrgan(sphere->GetOutput());
+  planner->SetResectionMargin(10.0);
+  planner->SetUncertaintyMargin(5.0);
+
+  // Flat initialization cutting the sphere through its equator
+  const double point1[3] = {0.0, 0.0, -10.0};
+  const double point2[3] = {0.0, 0.0, 10.0};
+  planner->SetInitializationPoints(point1, point2);
+  CHECK_BOOL(planner->Update(), true);
+  CHECK_INT(planner->GetControlPoints()->GetNumberOfPoints(), 16);
+  CHECK_INT(planner->GetTessellation()->GetNumberOfPoints(), 20 * 20);
+  CHECK_INT(planner->GetTessellation()->GetNumberOfPolys(), 2 * 19 * 19);
+  for (vtkIdType i = 0; i < planner->GetTessellation()->GetNumberOfPoints(); ++i)
+    {
+    if (std::fabs(planner->GetTessellation()->GetPoint(i)[2]) > 1e-6)
+      {
+      std::cerr << "Flat resection tessellation is not planar" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The cut is the equatorial disc, the surface is a square of side four
+  // standard deviations of the contour (radius / sqrt(2))
+  const vtkLiverResectionPlanner::Metrics& metrics = planner->GetMetrics();
+  const double discArea = vtkMath::Pi() * 50.0 * 50.0;
+  const double squareArea = 8.0 * 50.0 * 50.0;
+  if (std::fabs(metrics.CutArea - discArea) > 0.05 * discArea
+      || std::fabs(metrics.SurfaceArea - squareArea) > 0.05 * squareArea)
+    {
+    std::cerr << "Wrong areas: cut " << metrics.CutArea << " (expected " << discArea << "), surface "
+              << metrics.SurfaceArea << " (expected " << squareArea << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (metrics.TargetOrganWithinMargin <= 0.0 || metrics.TargetOrganWithinMargin >= 1.0
+      || metrics.TargetOrganWithinUncertainty < metrics.TargetOrganWithinMargin)
+    {
+    std::cerr << "Wrong margin fractions: " << metrics.TargetOrganWithinMargin << ", "
+              << metrics.TargetOrganWithinUncertainty << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Curved initialization: sphere of radius 30 centered on the surface
+  const double externalPoint[3] = {0.0, 0.0, 20.0};
+  const double referencePoint[3] = {0.0, 0.0, 50.0};
+  planner->SetInitializationMode(vtkLiverResectionPlanner::Curved);
+  planner->SetInitializationPoints(externalPoint, referencePoint);
+  CHECK_BOOL(planner->Update(), true);
+  CHECK_INT(planner->GetControlPoints()->GetNumberOfPoints(), 16);
+
+  // Initialization away from the target organ
+  const double farPoint1[3] = {0.0, 0.0, 190.0};
+  const double farPoint2[3] = {0.0, 0.0, 210.0};
+  planner->SetInitializationMode(vtkLiverResectionPlanner::Flat);
+  planner->SetInitializationPoints(farPoint1, farPoint2);
+  CHECK_BOOL(planner->Update(), false);
+
+  std::cout << "Success." << std::endl;
+  return EXIT_SUCCESS;
+}
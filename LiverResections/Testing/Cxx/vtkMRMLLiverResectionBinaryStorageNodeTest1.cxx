@@ -0,0 +1,181 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (Oslo University
+  Hospital and NTNU) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLiverResectionBinaryStorageNode.h"
+#include "vtkMRMLLiverResectionNode.h"
+#include "vtkMRMLMarkupsBezierSurfaceNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkVector.h>
+
+// STD includes
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+//------------------------------------------------------------------------------
+int vtkMRMLLiverResectionBinaryStorageNodeTest1(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string fileName = std::string(argv[1]) + "/vtkMRMLLiverResectionBinaryStorageNodeTest1.lrpb";
+
+  vtkNew<vtkMRMLScene> scene;
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode>::New());
+
+  vtkNew<vtkMRMLLiverResectionBinaryStorageNode> node1;
+  EXERCISE_ALL_BASIC_MRML_METHODS(node1.GetPointer());
+
+  // Resection to write
+  vtkNew<vtkMRMLMarkupsBezierSurfaceNode> bezierSurfaceNode;
+  scene->AddNode(bezierSurfaceNode);
+  for (int i = 0; i < 16; ++i)
+    {
+    bezierSurfaceNode->AddControlPoint(vtkVector3d(10.0 * (i % 4), 10.0 * (i / 4), 0.5 * i));
+    }
+  vtkNew<vtkMRMLLiverResectionNode> resectionNode;
+  scene->AddNode(resectionNode);
+  resectionNode->SetBezierSurfaceNode(bezierSurfaceNode);
+  resectionNode->SetResectionMargin(12.5);
+  resectionNode->SetResectionOpacity(0.25f);
+  resectionNode->SetResectionColor(0.1f, 0.2f, 0.3f);
+  resectionNode->SetGridDivisions(7.0f);
+  resectionNode->SetClipOut(true);
+  resectionNode->SetState(vtkMRMLLiverResectionNode::Deformation);
+  resectionNode->SetInitMode(vtkMRMLLiverResectionNode::Curved);
+  vtkNew<vtkPoints> initializationPoints;
+  initializationPoints->InsertNextPoint(0.0, 0.0, 0.0);
+  initializationPoints->InsertNextPoint(0.0, 30.0, 7.5);
+  resectionNode->SetInitializationControlPoints(initializationPoints);
+
+  // Tessellation of two triangles
+  vtkNew<vtkPoints> tessellationPoints;
+  tessellationPoints->InsertNextPoint(0.0, 0.0, 0.0);
+  tessellationPoints->InsertNextPoint(30.0, 0.0, 0.0);
+  tessellationPoints->InsertNextPoint(30.0, 30.0, 0.0);
+  tessellationPoints->InsertNextPoint(0.0, 30.0, 0.0);
+  vtkNew<vtkCellArray> tessellationCells;
+  const vtkIdType triangles[2][3] = {{0, 1, 2}, {0, 2, 3}};
+  tessellationCells->InsertNextCell(3, triangles[0]);
+  tessellationCells->InsertNextCell(3, triangles[1]);
+  vtkNew<vtkPolyData> tessellation;
+  tessellation->SetPoints(tessellationPoints);
+  tessellation->SetPolys(tessellationCells);
+
+  vtkNew<vtkMRMLLiverResectionBinaryStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetTessellation(tessellation);
+  CHECK_INT(storageNode->WriteData(resectionNode), 1);
+
+  // Read it back into a new resection
+  vtkNew<vtkMRMLMarkupsBezierSurfaceNode> readBezierSurfaceNode;
+  scene->AddNode(readBezierSurfaceNode);
+  vtkNew<vtkMRMLLiverResectionNode> readResectionNode;
+  scene->AddNode(readResectionNode);
+  readResectionNode->SetBezierSurfaceNode(readBezierSurfaceNode);
+  vtkNew<vtkMRMLLiverResectionBinaryStorageNode> readStorageNode;
+  scene->AddNode(readStorageNode);
+  readStorageNode->SetFileName(fileName.c_str());
+  CHECK_INT(readStorageNode->ReadData(readResectionNode), 1);
+
+  CHECK_DOUBLE(readResectionNode->GetResectionMargin(), 12.5);
+  CHECK_DOUBLE(readResectionNode->GetResectionOpacity(), 0.25);
+  CHECK_DOUBLE(readResectionNode->GetResectionColor()[2], 0.3f);
+  CHECK_DOUBLE(readResectionNode->GetGridDivisions(), 7.0);
+  CHECK_BOOL(readResectionNode->GetClipOut(), true);
+  CHECK_INT(readResectionNode->GetState(), vtkMRMLLiverResectionNode::Deformation);
+  CHECK_INT(readResectionNode->GetInitMode(), vtkMRMLLiverResectionNode::Curved);
+  CHECK_INT(readResectionNode->GetInitializationPoints()->GetNumberOfPoints(), 2);
+  CHECK_INT(readBezierSurfaceNode->GetNumberOfControlPoints(), 16);
+  for (int i = 0; i < 16; ++i)
+    {
+    double expected[3];
+    double position[3];
+    bezierSurfaceNode->GetNthControlPointPosition(i, expected);
+    readBezierSurfaceNode->GetNthControlPointPosition(i, position);
+    if (std::sqrt(vtkMath::Distance2BetweenPoints(expected, position)) > 1e-12)
+      {
+      std::cerr << "Control point " << i << " does not match after reading" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  CHECK_NOT_NULL(readStorageNode->GetTessellation());
+  CHECK_INT(readStorageNode->GetTessellation()->GetNumberOfPoints(), 4);
+  CHECK_INT(readStorageNode->GetTessellation()->GetNumberOfPolys(), 2);
+
+  // A corrupted payload is detected by the checksum
+  {
+  std::fstream file(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(64 + 8);
+  file.put(static_cast<char>(0x7f));
+  }
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_INT(readStorageNode->ReadData(readResectionNode), 0);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // A tessellation referencing missing points is rejected before the
+  // resection is modified
+  const vtkIdType invalidTriangle[3] = {0, 2, 4};
+  tessellationCells->InsertNextCell(3, invalidTriangle);
+  storageNode->SetTessellation(tessellation);
+  CHECK_INT(storageNode->WriteData(resectionNode), 1);
+  readResectionNode->SetResectionMargin(0.0);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_INT(readStorageNode->ReadData(readResectionNode), 0);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_DOUBLE(readResectionNode->GetResectionMargin(), 0.0);
+
+  std::remove(fileName.c_str());
+
+  std::cout << "Success." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -100,6 +100,18 @@ int vtkMRMLLiverResectionNodeTest1(int, char *[])
   TEST_SET_GET_VALUE(node1, InterpolatedMargins, 1);
   TEST_SET_GET_VALUE(node1, InterpolatedMargins, 0);
 
+  // Test the modified properties flags
+  node1->ClearModifiedProperties();
+  node1->SetResectionMargin(node1->GetResectionMargin());
+  CHECK_INT(node1->GetModifiedProperties(), 0);
+  node1->SetResectionMargin(node1->GetResectionMargin() + 1.0);
+  node1->SetResectionColor(0.5f, 0.5f, 0.5f);
+  CHECK_BOOL(node1->IsPropertyModified(vtkMRMLLiverResectionNode::ResectionMarginFlag), true);
+  CHECK_BOOL(node1->IsPropertyModified(vtkMRMLLiverResectionNode::ResectionColorFlag), true);
+  CHECK_BOOL(node1->IsPropertyModified(vtkMRMLLiverResectionNode::UncertaintyMarginFlag), false);
+  node1->ClearModifiedProperties(vtkMRMLLiverResectionNode::ResectionMarginFlag);
+  CHECK_INT(node1->GetModifiedProperties(), vtkMRMLLiverResectionNode::ResectionColorFlag);
+
   // TODO: Uncomment when VECTOR3_FLOAT is added to testing macros
   // // Test value setting/getting for resection margin color
   // TEST_SET_GET_VECTOR3_FLOAT_RANGE(node1, ResectionMarginColor, 0.0, 1.0);
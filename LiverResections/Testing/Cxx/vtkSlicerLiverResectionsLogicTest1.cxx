@@ -45,15 +45,44 @@
 
 // VTKSlicer includes
 #include "vtkSlicerLiverResectionsLogic.h"
+#include "vtkBezierSurfaceContourFitter.h"
+#include "vtkLiverResectionDependencyGraph.h"
+#include "vtkLiverResectionEditHistory.h"
+#include "vtkLiverResectionRegistry.h"
+#include "vtkParenchymaSlicingIndex.h"
+#include <vtkMRMLLiverResectionBinaryStorageNode.h>
 #include <vtkMRMLLiverResectionNode.h>
+#include <vtkMRMLMarkupsBezierSurfaceDisplayNode.h>
+#include <vtkMRMLMarkupsBezierSurfaceNode.h>
+#include <vtkMRMLMarkupsSlicingContourNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
 
 // VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCutter.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
 #include <vtkNew.h>
+#include <vtkPlane.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
+#include <vtkStringArray.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+#include <vtkVector.h>
 
 // STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
 
 namespace
 {
@@ -72,10 +101,819 @@ namespace
         assert(node2 != nullptr);
         assert(node == node2);
     }
+
+    void countEvents(vtkObject*, unsigned long, void* clientData, void*)
+    {
+        ++(*static_cast<int*>(clientData));
+    }
+
+    // A slider drag on the resection opacity only touches the opacity of the
+    // bezier surface display node, once per propagation of the deferred
+    // properties, and a batch of changes touches it once
+    int checkCoalescedPropertyPropagation(vtkMRMLScene* scene, vtkSlicerLiverResectionsLogic* logic)
+    {
+        vtkNew<vtkMRMLLiverResectionNode> resectionNode;
+        vtkNew<vtkMRMLMarkupsBezierSurfaceNode> bezierSurfaceNode;
+        vtkNew<vtkMRMLMarkupsBezierSurfaceDisplayNode> bezierSurfaceDisplayNode;
+        scene->AddNode(bezierSurfaceDisplayNode);
+        scene->AddNode(bezierSurfaceNode);
+        bezierSurfaceNode->SetAndObserveDisplayNodeID(bezierSurfaceDisplayNode->GetID());
+        logic->GetResectionRegistry()->AddResection(resectionNode, nullptr, bezierSurfaceNode);
+        scene->AddNode(resectionNode);
+
+        // Initial propagation of all the properties
+        resectionNode->Modified();
+        if (resectionNode->GetModifiedProperties() != 0)
+            {
+            std::cerr << "Property propagation: properties not propagated" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        int bezierSurfaceModifiedCount = 0;
+        int bezierSurfaceDisplayModifiedCount = 0;
+        vtkNew<vtkCallbackCommand> bezierSurfaceCallback;
+        bezierSurfaceCallback->SetCallback(countEvents);
+        bezierSurfaceCallback->SetClientData(&bezierSurfaceModifiedCount);
+        bezierSurfaceNode->AddObserver(vtkCommand::ModifiedEvent, bezierSurfaceCallback);
+        vtkNew<vtkCallbackCommand> bezierSurfaceDisplayCallback;
+        bezierSurfaceDisplayCallback->SetCallback(countEvents);
+        bezierSurfaceDisplayCallback->SetClientData(&bezierSurfaceDisplayModifiedCount);
+        bezierSurfaceDisplayNode->AddObserver(vtkCommand::ModifiedEvent, bezierSurfaceDisplayCallback);
+
+        int propagationRequestedCount = 0;
+        vtkNew<vtkCallbackCommand> propagationRequestedCallback;
+        propagationRequestedCallback->SetCallback(countEvents);
+        propagationRequestedCallback->SetClientData(&propagationRequestedCount);
+        logic->AddObserver(vtkSlicerLiverResectionsLogic::PropertyPropagationRequestedEvent,
+                           propagationRequestedCallback);
+        logic->DeferredPropertyPropagationOn();
+
+        const int steps = 20;
+        for (int i = 1; i <= steps; ++i)
+            {
+            resectionNode->SetResectionOpacity(1.0f - 0.02f * i);
+            resectionNode->SetResectionOpacity(1.0f - 0.02f * i); // unchanged value
+            }
+        if (propagationRequestedCount != 1 || bezierSurfaceDisplayModifiedCount != 0)
+            {
+            std::cerr << "Property propagation: slider drag requested " << propagationRequestedCount
+                      << " propagations and invoked " << bezierSurfaceDisplayModifiedCount
+                      << " display modified events before the propagation, expected 1 and 0" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // Propagation once per render: one display modified event per burst
+        logic->PropagatePendingProperties();
+        logic->PropagatePendingProperties(); // nothing pending
+        if (bezierSurfaceModifiedCount != 0 || bezierSurfaceDisplayModifiedCount != 1
+            || bezierSurfaceDisplayNode->GetResectionOpacity() != resectionNode->GetResectionOpacity())
+            {
+            std::cerr << "Property propagation: slider drag invoked " << bezierSurfaceModifiedCount
+                      << " bezier surface and " << bezierSurfaceDisplayModifiedCount
+                      << " display modified events, expected 0 and 1" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // The next burst requests a new propagation
+        resectionNode->SetResectionOpacity(0.25f);
+        logic->PropagatePendingProperties();
+        logic->RemoveObserver(propagationRequestedCallback);
+        logic->DeferredPropertyPropagationOff();
+        if (propagationRequestedCount != 2 || bezierSurfaceDisplayModifiedCount != 2)
+            {
+            std::cerr << "Property propagation: second burst requested " << propagationRequestedCount
+                      << " propagations and invoked " << bezierSurfaceDisplayModifiedCount
+                      << " display modified events, expected 2 and 2" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        bezierSurfaceDisplayModifiedCount = 0;
+        scene->StartState(vtkMRMLScene::BatchProcessState);
+        for (int i = 1; i <= steps; ++i)
+            {
+            resectionNode->SetResectionOpacity(0.5f + 0.02f * i);
+            resectionNode->SetGridThickness(0.1f * i);
+            }
+        scene->EndState(vtkMRMLScene::BatchProcessState);
+        if (bezierSurfaceModifiedCount != 0 || bezierSurfaceDisplayModifiedCount != 1
+            || bezierSurfaceDisplayNode->GetResectionOpacity() != resectionNode->GetResectionOpacity()
+            || bezierSurfaceDisplayNode->GetGridThickness() != resectionNode->GetGridThickness())
+            {
+            std::cerr << "Property propagation: batched changes invoked " << bezierSurfaceModifiedCount
+                      << " bezier surface and " << bezierSurfaceDisplayModifiedCount
+                      << " display modified events, expected 0 and 1" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        logic->GetResectionRegistry()->RemoveResection(resectionNode);
+        return EXIT_SUCCESS;
+    }
+
+    // Several resection plans are loaded in a single batch process, with their
+    // bezier surfaces registered as the resection surfaces
+    int checkBatchLoading(vtkMRMLScene* scene, vtkSlicerLiverResectionsLogic* logic,
+                          const std::string& temporaryDirectory)
+    {
+        scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode>::New());
+        scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceDisplayNode>::New());
+
+        // Two valid plans (LPS) and a plan with missing control points
+        vtkNew<vtkStringArray> fileNames;
+        const int numberOfPoints[3] = {16, 16, 4};
+        for (int f = 0; f < 3; ++f)
+            {
+            std::string fileName = temporaryDirectory + "/vtkSlicerLiverResectionsLogicTest1_"
+                + std::to_string(f) + ".lrp.fcsv";
+            std::ofstream file(fileName.c_str());
+            file << "# Markups fiducial file version = 4.11\n"
+                 << "# CoordinateSystem = LPS\n"
+                 << "# columns = id,x,y,z,ow,ox,oy,oz,vis,sel,lock,label,desc,associatedNodeID\n";
+            for (int i = 0; i < numberOfPoints[f]; ++i)
+                {
+                file << "BS_" << i << "," << 10.0 * (i % 4) << "," << 10.0 * (i / 4) << "," << f
+                     << ",0,0,0,1,1,1,0,BS-" << i << ",,\n";
+                }
+            fileNames->InsertNextValue(fileName);
+            }
+
+        int endBatchProcessCount = 0;
+        vtkNew<vtkCallbackCommand> endBatchProcessCallback;
+        endBatchProcessCallback->SetCallback(countEvents);
+        endBatchProcessCallback->SetClientData(&endBatchProcessCount);
+        scene->AddObserver(vtkMRMLScene::EndBatchProcessEvent, endBatchProcessCallback);
+
+        vtkNew<vtkStringArray> loadedNodeIDs;
+        TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+        int numberOfLoadedResections = logic->LoadLiverResections(fileNames, loadedNodeIDs);
+        TESTING_OUTPUT_ASSERT_ERRORS_END();
+        scene->RemoveObserver(endBatchProcessCallback);
+
+        for (int f = 0; f < 3; ++f)
+            {
+            std::remove(fileNames->GetValue(f).c_str());
+            }
+
+        if (numberOfLoadedResections != 2 || loadedNodeIDs->GetNumberOfValues() != 2
+            || endBatchProcessCount != 1)
+            {
+            std::cerr << "Batch loading: loaded " << numberOfLoadedResections << " resections in "
+                      << endBatchProcessCount << " batch processes, expected 2 in 1" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        for (int r = 0; r < 2; ++r)
+            {
+            auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(
+                scene->GetNodeByID(loadedNodeIDs->GetValue(r)));
+            auto bezierSurfaceNode = resectionNode ? resectionNode->GetBezierSurfaceNode() : nullptr;
+            if (!bezierSurfaceNode || bezierSurfaceNode->GetNumberOfControlPoints() != 16
+                || !bezierSurfaceNode->GetDisplayNode() || !resectionNode->GetStorageNode()
+                || logic->GetResectionRegistry()->GetBezierSurface(resectionNode) != bezierSurfaceNode
+                || resectionNode->GetModifiedProperties() != 0)
+                {
+                std::cerr << "Batch loading: resection " << r << " not set up" << std::endl;
+                return EXIT_FAILURE;
+                }
+
+            // Control points are converted from LPS to RAS
+            double position[3];
+            bezierSurfaceNode->GetNthControlPointPositionWorld(5, position);
+            if (std::fabs(position[0] + 10.0) > 1e-6 || std::fabs(position[1] + 10.0) > 1e-6
+                || std::fabs(position[2] - r) > 1e-6)
+                {
+                std::cerr << "Batch loading: wrong control point position in resection " << r << std::endl;
+                return EXIT_FAILURE;
+                }
+            }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Every member of a resection finds the whole record, and removing the
+    // record through any member removes all of them
+    int checkResectionRegistry()
+    {
+        vtkNew<vtkLiverResectionRegistry> registry;
+        vtkNew<vtkMRMLLiverResectionNode> resections[3];
+        vtkNew<vtkMRMLMarkupsSlicingContourNode> initializations[3];
+        vtkNew<vtkMRMLMarkupsBezierSurfaceNode> bezierSurfaces[3];
+        for (int i = 0; i < 3; ++i)
+            {
+            registry->AddResection(resections[i], initializations[i], bezierSurfaces[i]);
+            }
+
+        for (int i = 0; i < 3; ++i)
+            {
+            if (registry->GetResection(bezierSurfaces[i]) != resections[i].GetPointer()
+                || registry->GetBezierSurface(initializations[i]) != bezierSurfaces[i].GetPointer()
+                || registry->GetInitialization(resections[i]) != initializations[i].GetPointer())
+                {
+                std::cerr << "Resection registry: wrong record for resection " << i << std::endl;
+                return EXIT_FAILURE;
+                }
+            }
+
+        vtkLiverResectionRegistry::Record record;
+        if (!registry->RemoveResection(bezierSurfaces[1], &record)
+            || record.Initialization != initializations[1].GetPointer()
+            || registry->Contains(resections[1]) || registry->Contains(initializations[1])
+            || registry->GetNumberOfResections() != 2)
+            {
+            std::cerr << "Resection registry: record not removed" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // Reusing a member moves it to the new record
+        registry->AddResection(resections[1], initializations[2], nullptr);
+        if (registry->Contains(resections[2]) || registry->GetNumberOfResections() != 2
+            || registry->GetResection(initializations[2]) != resections[1].GetPointer())
+            {
+            std::cerr << "Resection registry: member registered twice" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        registry->RemoveAllResections();
+        if (registry->GetNumberOfResections() != 0 || registry->Contains(resections[0]))
+            {
+            std::cerr << "Resection registry: records not cleared" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Each kind of edit recomputes only the derived products depending on the
+    // edited input
+    int checkDependencyGraph()
+    {
+        vtkNew<vtkLiverResectionDependencyGraph> graph;
+        vtkNew<vtkMRMLLiverResectionNode> resectionNode;
+        vtkNew<vtkMRMLMarkupsBezierSurfaceNode> bezierSurfaceNode;
+        for (int i = 0; i < 16; ++i)
+            {
+            bezierSurfaceNode->AddControlPoint(vtkVector3d(10.0 * (i % 4), 10.0 * (i / 4), 0.0));
+            }
+        resectionNode->SetBezierSurfaceNode(bezierSurfaceNode);
+
+        vtkNew<vtkSphereSource> sphere;
+        sphere->Update();
+        vtkNew<vtkPolyData> targetOrganPolyData;
+        targetOrganPolyData->DeepCopy(sphere->GetOutput());
+        vtkNew<vtkMRMLModelNode> targetOrganNode;
+        targetOrganNode->SetAndObservePolyData(targetOrganPolyData);
+        resectionNode->SetTargetOrganModelNode(targetOrganNode);
+
+        vtkNew<vtkImageData> distanceMap;
+        distanceMap->SetDimensions(4, 4, 4);
+        distanceMap->AllocateScalars(VTK_FLOAT, 1);
+        std::fill_n(static_cast<float*>(distanceMap->GetScalarPointer()), 4 * 4 * 4, 0.0f);
+        vtkNew<vtkMRMLScalarVolumeNode> distanceMapNode;
+        distanceMapNode->SetAndObserveImageData(distanceMap);
+        resectionNode->SetDistanceMapVolumeNode(distanceMapNode);
+        vtkNew<vtkMRMLScalarVolumeNode> otherDistanceMapNode;
+        otherDistanceMapNode->SetAndObserveImageData(distanceMap);
+
+        struct Edit
+        {
+            const char* Name;
+            std::function<void()> Apply;
+            int ExpectedRecomputations[vtkLiverResectionDependencyGraph::NumberOfProducts];
+        };
+        const Edit edits[] = {
+            {"initial update", []() {}, {1, 1}},
+            {"no edit", []() {}, {0, 0}},
+            {"modified without change", [&]() { bezierSurfaceNode->Modified(); resectionNode->Modified(); }, {0, 0}},
+            {"control point moved", [&]() { bezierSurfaceNode->SetNthControlPointPosition(5, 10.0, 10.0, 5.0); }, {1, 0}},
+            {"opacity changed", [&]() { resectionNode->SetResectionOpacity(0.5f); }, {0, 0}},
+            {"margin changed", [&]() { resectionNode->SetResectionMargin(5.0); }, {0, 0}},
+            {"distance map touched", [&]() { distanceMap->Modified(); }, {0, 0}},
+            {"distance map voxel changed", [&]() {
+                distanceMap->SetScalarComponentFromFloat(1, 2, 3, 0, 7.0f);
+                distanceMap->Modified(); }, {0, 1}},
+            {"distance map replaced", [&]() { resectionNode->SetDistanceMapVolumeNode(otherDistanceMapNode); }, {0, 1}},
+            {"target organ deformed", [&]() {
+                targetOrganPolyData->GetPoints()->SetPoint(0, 0.0, 0.0, 1.0);
+                targetOrganPolyData->GetPoints()->Modified(); }, {0, 0}},
+        };
+
+        for (const Edit& edit : edits)
+            {
+            graph->ResetNumberOfRecomputations();
+            edit.Apply();
+            graph->UpdateProducts(resectionNode);
+            for (int product = 0; product < vtkLiverResectionDependencyGraph::NumberOfProducts; ++product)
+                {
+                if (graph->GetNumberOfRecomputations(product) != edit.ExpectedRecomputations[product])
+                    {
+                    std::cerr << "Dependency graph: " << edit.Name << " recomputed product " << product << " "
+                              << graph->GetNumberOfRecomputations(product) << " times, expected "
+                              << edit.ExpectedRecomputations[product] << std::endl;
+                    return EXIT_FAILURE;
+                    }
+                }
+            }
+
+        // Products are recomputed through their update functions, on demand
+        int numberOfTessellations = 0;
+        graph->SetProductUpdateFunction(vtkLiverResectionDependencyGraph::TessellationProduct,
+                                        [&](vtkMRMLLiverResectionNode*) { ++numberOfTessellations; });
+        graph->InvalidateProduct(resectionNode, vtkLiverResectionDependencyGraph::TessellationProduct);
+        if (!graph->IsProductStale(resectionNode, vtkLiverResectionDependencyGraph::TessellationProduct)
+            || !graph->UpdateProduct(resectionNode, vtkLiverResectionDependencyGraph::TessellationProduct)
+            || graph->UpdateProduct(resectionNode, vtkLiverResectionDependencyGraph::TessellationProduct)
+            || numberOfTessellations != 1)
+            {
+            std::cerr << "Dependency graph: invalidated product not recomputed once" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Edits are undone and redone exactly, the history is bounded by its
+    // capacity and stays small
+    int checkEditHistory(vtkSlicerLiverResectionsLogic* logic)
+    {
+        vtkNew<vtkMRMLLiverResectionNode> resectionNode;
+        vtkNew<vtkMRMLMarkupsBezierSurfaceNode> bezierSurfaceNode;
+        for (int i = 0; i < 16; ++i)
+            {
+            bezierSurfaceNode->AddControlPoint(vtkVector3d(10.0 * (i % 4), 10.0 * (i / 4), 0.0));
+            }
+        logic->GetResectionRegistry()->AddResection(resectionNode, nullptr, bezierSurfaceNode);
+
+        vtkLiverResectionEditHistory* history = logic->GetEditHistory();
+        history->SetCapacity(1000);
+
+        // Drag a control point in 2000 interactions
+        double initialPosition[3];
+        bezierSurfaceNode->GetNthControlPointPosition(5, initialPosition);
+        for (int edit = 0; edit < 2000; ++edit)
+            {
+            history->BeginEdit(bezierSurfaceNode);
+            bezierSurfaceNode->SetNthControlPointPosition(5, 10.0, 10.0, 0.1 * (edit + 1));
+            history->EndEdit(bezierSurfaceNode);
+            }
+        if (history->GetNumberOfUndoEdits(bezierSurfaceNode) != 1000
+            || history->GetMemorySize() > 128 * 1024)
+            {
+            std::cerr << "Edit history: " << history->GetNumberOfUndoEdits(bezierSurfaceNode) << " edits in "
+                      << history->GetMemorySize() << " bytes, expected 1000 edits in less than 128 KB" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // An interaction without changes is not recorded
+        history->BeginEdit(bezierSurfaceNode);
+        if (history->EndEdit(bezierSurfaceNode))
+            {
+            std::cerr << "Edit history: empty edit recorded" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // Undoing all the edits restores the position before the oldest kept edit
+        while (logic->UndoResectionEdit(resectionNode))
+            {
+            }
+        double position[3];
+        bezierSurfaceNode->GetNthControlPointPosition(5, position);
+        if (position[2] != 0.1 * 1000 || history->GetNumberOfRedoEdits(bezierSurfaceNode) != 1000)
+            {
+            std::cerr << "Edit history: wrong position after undo: " << position[2] << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // Redo, then a new edit discards the remaining redo edits
+        logic->RedoResectionEdit(resectionNode);
+        bezierSurfaceNode->GetNthControlPointPosition(5, position);
+        if (position[2] != 0.1 * 1001)
+            {
+            std::cerr << "Edit history: wrong position after redo: " << position[2] << std::endl;
+            return EXIT_FAILURE;
+            }
+        history->BeginEdit(bezierSurfaceNode);
+        bezierSurfaceNode->SetNthControlPointPosition(0, -1.0, -1.0, -1.0);
+        history->EndEdit(bezierSurfaceNode);
+        if (history->GetNumberOfRedoEdits(bezierSurfaceNode) != 0
+            || history->GetNumberOfUndoEdits(bezierSurfaceNode) != 2
+            || logic->RedoResectionEdit(resectionNode))
+            {
+            std::cerr << "Edit history: redo edits not discarded" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // Control points moved outside an interaction are not overwritten by
+        // an undo, and the history is cleared
+        bezierSurfaceNode->SetNthControlPointPosition(5, 20.0, 20.0, 20.0);
+        TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+        bool undone = logic->UndoResectionEdit(resectionNode);
+        TESTING_OUTPUT_ASSERT_ERRORS_END();
+        bezierSurfaceNode->GetNthControlPointPosition(5, position);
+        if (undone || position[0] != 20.0 || position[1] != 20.0 || position[2] != 20.0
+            || history->GetNumberOfUndoEdits(bezierSurfaceNode) != 0)
+            {
+            std::cerr << "Edit history: undo applied to control points changed outside an interaction" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        logic->GetResectionRegistry()->RemoveResection(resectionNode);
+        history->RemoveNode(bezierSurfaceNode);
+        return EXIT_SUCCESS;
+    }
+
+    // Compares the contour PCA of the slicing index with the PCA of the
+    // contour generated by vtkCutter
+    int checkParenchymaSlicingIndex()
+    {
+        vtkNew<vtkSphereSource> sphere;
+        sphere->SetRadius(100.0);
+        sphere->SetThetaResolution(600);
+        sphere->SetPhiResolution(600);
+
+        vtkNew<vtkTransform> scale;
+        scale->Scale(1.0, 0.6, 0.8);
+        vtkNew<vtkTransformPolyDataFilter> ellipsoid;
+        ellipsoid->SetInputConnection(sphere->GetOutputPort());
+        ellipsoid->SetTransform(scale);
+        ellipsoid->Update();
+        vtkPolyData* parenchyma = ellipsoid->GetOutput();
+
+        double origin[3] = {10.0, 5.0, 20.0};
+        double normal[3] = {0.3, 0.2, 1.0};
+
+        vtkNew<vtkParenchymaSlicingIndex> slicingIndex;
+        slicingIndex->SetInputData(parenchyma);
+        slicingIndex->Update();
+
+        vtkParenchymaSlicingIndex::ContourPCA pca;
+        bool cut = slicingIndex->ComputeContourPCA(origin, normal, pca);
+
+        if (!cut)
+            {
+            std::cerr << "Slicing index: plane does not cut the model" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // Reference: contour from vtkCutter and its sample covariance
+        vtkNew<vtkPlane> plane;
+        plane->SetOrigin(origin);
+        plane->SetNormal(normal);
+        vtkNew<vtkCutter> cutter;
+        cutter->SetInputData(parenchyma);
+        cutter->SetCutFunction(plane);
+        cutter->Update();
+
+        vtkPolyData* contour = cutter->GetOutput();
+        vtkIdType numberOfPoints = contour->GetNumberOfPoints();
+        double center[3] = {0.0, 0.0, 0.0};
+        for (vtkIdType i = 0; i < numberOfPoints; ++i)
+            {
+            double point[3];
+            contour->GetPoint(i, point);
+            vtkMath::Add(center, point, center);
+            }
+        vtkMath::MultiplyScalar(center, 1.0 / numberOfPoints);
+
+        double covariance[3][3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+        for (vtkIdType i = 0; i < numberOfPoints; ++i)
+            {
+            double point[3];
+            contour->GetPoint(i, point);
+            vtkMath::Subtract(point, center, point);
+            for (int r = 0; r < 3; ++r)
+                {
+                for (int c = 0; c < 3; ++c)
+                    {
+                    covariance[r][c] += point[r] * point[c] / (numberOfPoints - 1);
+                    }
+                }
+            }
+
+        if (std::fabs(pca.NumberOfPoints - numberOfPoints) > 0.5
+            || std::sqrt(vtkMath::Distance2BetweenPoints(pca.Center, center)) > 1e-6)
+            {
+            std::cerr << "Slicing index: contour points differ from vtkCutter" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // The eigenpairs of the index must be eigenpairs of the reference covariance
+        for (int k = 0; k < 3; ++k)
+            {
+            double product[3];
+            vtkMath::Multiply3x3(covariance, pca.Eigenvectors[k], product);
+            for (int c = 0; c < 3; ++c)
+                {
+                if (std::fabs(product[c] - pca.Eigenvalues[k] * pca.Eigenvectors[k][c]) > 1e-6 * pca.Eigenvalues[0])
+                    {
+                    std::cerr << "Slicing index: eigenpair " << k << " differs from vtkCutter" << std::endl;
+                    return EXIT_FAILURE;
+                    }
+                }
+            }
+
+        if (slicingIndex->GetNumberOfVisitedCells() * 10 > slicingIndex->GetNumberOfCells())
+            {
+            std::cerr << "Slicing index: too many cells visited" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // A plane missing the model does not produce a contour
+        double farOrigin[3] = {0.0, 0.0, 1000.0};
+        if (slicingIndex->ComputeContourPCA(farOrigin, normal, pca))
+            {
+            std::cerr << "Slicing index: plane outside the model produced a contour" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        return EXIT_SUCCESS;
+    }
+
+    // The tessellation of a resection is recomputed only when its control
+    // points change, written to binary files and reused when loading them
+    int checkResectionTessellation(vtkMRMLScene* scene, vtkSlicerLiverResectionsLogic* logic,
+                                   const std::string& temporaryDirectory)
+    {
+        vtkMRMLLiverResectionNode* resectionNode = nullptr;
+        for (int i = 0; !resectionNode && i < scene->GetNumberOfNodesByClass("vtkMRMLLiverResectionNode"); ++i)
+            {
+            auto node = vtkMRMLLiverResectionNode::SafeDownCast(
+                scene->GetNthNodeByClass(i, "vtkMRMLLiverResectionNode"));
+            if (node->GetBezierSurfaceNode() && node->GetBezierSurfaceNode()->GetNumberOfControlPoints() == 16)
+                {
+                resectionNode = node;
+                }
+            }
+        if (!resectionNode)
+            {
+            std::cerr << "Resection tessellation: no resection with a bezier surface" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        vtkPolyData* tessellation = logic->GetResectionTessellation(resectionNode);
+        const int resolution = logic->GetTessellationResolution();
+        if (!tessellation || tessellation->GetNumberOfPoints() != resolution * resolution
+            || logic->GetResectionTessellation(resectionNode) != tessellation)
+            {
+            std::cerr << "Resection tessellation: not computed once" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        auto maximumHeight = [](vtkPolyData* polyData)
+            {
+            double height = VTK_DOUBLE_MIN;
+            for (vtkIdType i = 0; polyData && i < polyData->GetNumberOfPoints(); ++i)
+                {
+                height = std::max(height, polyData->GetPoint(i)[2]);
+                }
+            return height;
+            };
+        const double initialHeight = maximumHeight(tessellation);
+
+        vtkMRMLMarkupsBezierSurfaceNode* bezierSurfaceNode = resectionNode->GetBezierSurfaceNode();
+        double position[3];
+        bezierSurfaceNode->GetNthControlPointPosition(5, position);
+        position[2] += 10.0;
+        bezierSurfaceNode->SetNthControlPointPosition(5, position);
+        tessellation = logic->GetResectionTessellation(resectionNode);
+        if (maximumHeight(tessellation) < initialHeight + 1.0)
+            {
+            std::cerr << "Resection tessellation: not recomputed after a control point change" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // Written along with the resection and reused when loading it
+        const std::string fileName = temporaryDirectory + "/vtkSlicerLiverResectionsLogicTest1.lrpb";
+        vtkNew<vtkMRMLLiverResectionBinaryStorageNode> storageNode;
+        scene->AddNode(storageNode);
+        storageNode->SetFileName(fileName.c_str());
+        storageNode->SetTessellation(tessellation);
+        if (!storageNode->WriteData(resectionNode))
+            {
+            std::cerr << "Resection tessellation: binary file not written" << std::endl;
+            return EXIT_FAILURE;
+            }
+        char* loadedNodeID = logic->LoadLiverResectionFromBinary(fileName, "", nullptr);
+        std::remove(fileName.c_str());
+
+        auto loadedResectionNode = vtkMRMLLiverResectionNode::SafeDownCast(
+            loadedNodeID ? scene->GetNodeByID(loadedNodeID) : nullptr);
+        auto loadedStorageNode = vtkMRMLLiverResectionBinaryStorageNode::SafeDownCast(
+            loadedResectionNode ? loadedResectionNode->GetStorageNode() : nullptr);
+        if (!loadedStorageNode || !loadedStorageNode->GetTessellation()
+            || logic->GetResectionTessellation(loadedResectionNode) != loadedStorageNode->GetTessellation())
+            {
+            std::cerr << "Resection tessellation: loaded tessellation not reused" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        return EXIT_SUCCESS;
+    }
+
+    // The textures of a resection are transferred again when the content of
+    // its distance map changes, and only then
+    int checkTextureRefresh(vtkMRMLScene* scene, vtkSlicerLiverResectionsLogic* logic)
+    {
+        vtkMRMLLiverResectionNode* resectionNode = nullptr;
+        vtkMRMLMarkupsBezierSurfaceNode* bezierSurfaceNode = nullptr;
+        for (const auto& record : logic->GetResectionRegistry()->GetResections())
+            {
+            if (record.BezierSurface && record.BezierSurface->GetDisplayNode())
+                {
+                resectionNode = record.Resection;
+                bezierSurfaceNode = record.BezierSurface;
+                break;
+                }
+            }
+        if (!bezierSurfaceNode)
+            {
+            std::cerr << "Texture refresh: no registered resection" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        vtkNew<vtkImageData> referenceImage;
+        referenceImage->SetDimensions(10, 10, 10);
+        referenceImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+        vtkNew<vtkMRMLScalarVolumeNode> referenceNode;
+        referenceNode->SetAndObserveImageData(referenceImage);
+        referenceNode->SetOrigin(-9.0, -9.0, -9.0);
+        referenceNode->SetSpacing(2.0, 2.0, 2.0);
+        vtkNew<vtkMRMLScalarVolumeNode> distanceMapNode;
+        scene->AddNode(distanceMapNode);
+
+        // Setting the distance map transfers the textures once
+        const unsigned int initialRevision = bezierSurfaceNode->GetTexturesRevision();
+        resectionNode->SetDistanceMapVolumeNode(distanceMapNode);
+        if (bezierSurfaceNode->GetDistanceMapVolumeNode() != distanceMapNode
+            || bezierSurfaceNode->GetTexturesRevision() != initialRevision + 1)
+            {
+            std::cerr << "Texture refresh: distance map not transferred" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        vtkNew<vtkSphereSource> sphere;
+        sphere->SetRadius(5.0);
+        sphere->Update();
+        const unsigned int expectedRevisions[2] = {initialRevision + 2, initialRevision + 2};
+        for (int i = 0; i < 2; ++i)
+            {
+            // The same distances a second time do not transfer anything
+            if (!logic->ComputeMeshDistanceMaps(nullptr, sphere->GetOutput(), nullptr, nullptr,
+                                                referenceNode, nullptr, distanceMapNode)
+                || bezierSurfaceNode->GetTexturesRevision() != expectedRevisions[i])
+                {
+                std::cerr << "Texture refresh: computation " << i << " transferred the textures "
+                          << bezierSurfaceNode->GetTexturesRevision() - initialRevision
+                          << " times" << std::endl;
+                return EXIT_FAILURE;
+                }
+            }
+
+        resectionNode->SetDistanceMapVolumeNode(nullptr);
+        scene->RemoveNode(distanceMapNode);
+        return EXIT_SUCCESS;
+    }
+
+    // Mesh distance maps cancel a progressive computation into the same
+    // output, whose levels would replace them
+    int checkMeshDistanceMapsCancelProgressive(vtkMRMLScene* scene, vtkSlicerLiverResectionsLogic* logic)
+    {
+        vtkNew<vtkImageData> labelMap;
+        labelMap->SetDimensions(21, 21, 21);
+        labelMap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+        for (int k = 0; k < 21; ++k)
+            {
+            for (int j = 0; j < 21; ++j)
+                {
+                for (int i = 0; i < 21; ++i)
+                    {
+                    int r2 = (i - 10) * (i - 10) + (j - 10) * (j - 10) + (k - 10) * (k - 10);
+                    labelMap->SetScalarComponentFromDouble(i, j, k, 0, r2 <= 81 ? 1.0 : 0.0);
+                    }
+                }
+            }
+        vtkNew<vtkMRMLScalarVolumeNode> labelMapNode;
+        labelMapNode->SetAndObserveImageData(labelMap);
+        labelMapNode->SetOrigin(-10.0, -10.0, -10.0);
+        vtkNew<vtkMRMLScalarVolumeNode> distanceMapNode;
+        scene->AddNode(distanceMapNode);
+
+        if (!logic->StartProgressiveDistanceMaps(nullptr, labelMapNode, nullptr, nullptr, distanceMapNode))
+            {
+            std::cerr << "Mesh distance maps: progressive distance maps not started" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        vtkNew<vtkSphereSource> sphere;
+        sphere->SetRadius(5.0);
+        sphere->SetThetaResolution(32);
+        sphere->SetPhiResolution(32);
+        sphere->Update();
+        if (!logic->ComputeMeshDistanceMaps(nullptr, sphere->GetOutput(), nullptr, nullptr,
+                                            labelMapNode, nullptr, distanceMapNode))
+            {
+            std::cerr << "Mesh distance maps: computation failed" << std::endl;
+            return EXIT_FAILURE;
+            }
+        vtkImageData* meshDistances = distanceMapNode->GetImageData();
+        const vtkMTimeType meshTime = meshDistances ? meshDistances->GetMTime() : 0;
+
+        if (logic->IsProgressiveDistanceMapsRunning() || logic->ProcessProgressiveDistanceMaps() >= 0)
+            {
+            std::cerr << "Mesh distance maps: progressive distance maps still running" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // The center is 5 mm inside the sphere, and 10 mm inside the label map
+        if (!meshDistances || distanceMapNode->GetImageData() != meshDistances
+            || meshDistances->GetMTime() != meshTime
+            || std::fabs(meshDistances->GetScalarComponentAsDouble(10, 10, 10, 0) + 5.0) > 0.5)
+            {
+            std::cerr << "Mesh distance maps: replaced by the progressive distance maps" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        scene->RemoveNode(distanceMapNode);
+        return EXIT_SUCCESS;
+    }
+
+    // Fits the curved initialization to the contour selected by a sphere
+    int checkBezierSurfaceContourFitter()
+    {
+        vtkNew<vtkSphereSource> sphere;
+        sphere->SetRadius(100.0);
+        sphere->SetThetaResolution(400);
+        sphere->SetPhiResolution(400);
+
+        vtkNew<vtkTransform> scale;
+        scale->Scale(1.0, 0.6, 0.8);
+        vtkNew<vtkTransformPolyDataFilter> ellipsoid;
+        ellipsoid->SetInputConnection(sphere->GetOutputPort());
+        ellipsoid->SetTransform(scale);
+        ellipsoid->Update();
+
+        vtkNew<vtkParenchymaSlicingIndex> slicingIndex;
+        slicingIndex->SetInputData(ellipsoid->GetOutput());
+
+        double center[3] = {60.0, 40.0, 30.0};
+        double radius = 50.0;
+        vtkNew<vtkPoints> contour;
+        vtkIdType numberOfPoints = slicingIndex->ComputeSphereContour(center, radius, contour);
+        for (vtkIdType i = 0; i < numberOfPoints; ++i)
+            {
+            double point[3];
+            contour->GetPoint(i, point);
+            if (std::fabs(std::sqrt(vtkMath::Distance2BetweenPoints(point, center)) - radius) > 0.1)
+                {
+                std::cerr << "Contour fitter: contour point off the sphere" << std::endl;
+                return EXIT_FAILURE;
+                }
+            }
+
+        vtkNew<vtkBezierSurfaceContourFitter> fitter;
+        fitter->SetInputPoints(contour);
+        vtkNew<vtkPoints> controlPoints;
+        bool fitted = fitter->Fit(controlPoints);
+
+        if (!fitted || controlPoints->GetNumberOfPoints() != 16 || fitter->GetRMSError() > 0.01 * radius)
+            {
+            std::cerr << "Contour fitter: the surface does not fit the contour" << std::endl;
+            return EXIT_FAILURE;
+            }
+
+        // A planar contour gives a planar surface
+        vtkNew<vtkPoints> circle;
+        for (int i = 0; i < 100; ++i)
+            {
+            double angle = 2.0 * vtkMath::Pi() * i / 100.0;
+            circle->InsertNextPoint(10.0 * std::cos(angle), 10.0 * std::sin(angle), 3.0);
+            }
+        fitter->SetInputPoints(circle);
+        if (!fitter->Fit(controlPoints))
+            {
+            std::cerr << "Contour fitter: planar contour not fitted" << std::endl;
+            return EXIT_FAILURE;
+            }
+        for (vtkIdType i = 0; i < controlPoints->GetNumberOfPoints(); ++i)
+            {
+            if (std::fabs(controlPoints->GetPoint(i)[2] - 3.0) > 1e-6)
+                {
+                std::cerr << "Contour fitter: planar contour gives a curved surface" << std::endl;
+                return EXIT_FAILURE;
+                }
+            }
+
+        return EXIT_SUCCESS;
+    }
 }
 
-int vtkSlicerLiverResectionsLogicTest1(int, char * [])
+int vtkSlicerLiverResectionsLogicTest1(int argc, char * argv[])
 {
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string temporaryDirectory = argv[1];
+
   auto scene = vtkSmartPointer<vtkMRMLScene>::New();
 
   vtkNew<vtkSlicerLiverResectionsLogic> logic1;
@@ -90,6 +928,46 @@ int vtkSlicerLiverResectionsLogicTest1(int, char * [])
   vtkNew<vtkSphereSource> source;
   targetOrgan->SetPolyDataConnection(source->GetOutputPort());
 
+  if (checkResectionRegistry() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkDependencyGraph() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkEditHistory(logic1) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkCoalescedPropertyPropagation(scene, logic1) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkBatchLoading(scene, logic1, temporaryDirectory) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkResectionTessellation(scene, logic1, temporaryDirectory) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkTextureRefresh(scene, logic1) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkMeshDistanceMapsCancelProgressive(scene, logic1) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkParenchymaSlicingIndex() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  if (checkBezierSurfaceContourFitter() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
 
   return EXIT_SUCCESS;
 }
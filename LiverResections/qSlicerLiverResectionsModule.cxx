@@ -41,6 +41,7 @@
 
 // Qt includes
 #include <QDebug>
+#include <QTimer>
 
 // Liver Resections Logic includes
 #include "vtkSlicerLiverResectionsLogic.h"
@@ -57,6 +58,11 @@
 #include <vtkMRMLSliceViewDisplayableManagerFactory.h>
 #include <vtkMRMLThreeDViewDisplayableManagerFactory.h>
 
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkWeakPointer.h>
+
 // DisplayableManager initialization
 #include <vtkAutoInit.h>
 VTK_MODULE_INIT(vtkSlicerLiverResectionsModuleMRMLDisplayableManager)
@@ -137,6 +143,24 @@ QStringList qSlicerLiverResectionsModule::dependencies() const
   return QStringList() << "LiverMarkups" << "Markups";
 }
 
+//-----------------------------------------------------------------------------
+namespace
+{
+void onPropertyPropagationRequested(vtkObject* caller, unsigned long, void*, void*)
+{
+  // Resection properties modified during a burst of changes are propagated
+  // once, in the next event loop pass (before the views are rendered)
+  vtkWeakPointer<vtkSlicerLiverResectionsLogic> logic = vtkSlicerLiverResectionsLogic::SafeDownCast(caller);
+  QTimer::singleShot(0, [logic]()
+    {
+    if (logic)
+      {
+      logic->PropagatePendingProperties();
+      }
+    });
+}
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerLiverResectionsModule::setup()
 {
@@ -148,13 +172,18 @@ void qSlicerLiverResectionsModule::setup()
     qCritical() << Q_FUNC_INFO << ": cannot get Markups logic.";
     return;
     }
+  vtkNew<vtkCallbackCommand> propertyPropagationCallback;
+  propertyPropagationCallback->SetCallback(onPropertyPropagationRequested);
+  logic->AddObserver(vtkSlicerLiverResectionsLogic::PropertyPropagationRequestedEvent, propertyPropagationCallback);
+  logic->DeferredPropertyPropagationOn();
+
   // Register displayable managers (same displayable manager handles both slice and 3D views)
   vtkMRMLSliceViewDisplayableManagerFactory::GetInstance()->RegisterDisplayableManager("vtkMRMLLiverResectionsDisplayableManager2D");
   // Register IO
   qSlicerIOManager* ioManager = qSlicerApplication::application()->ioManager();
   qSlicerLiverResectionsReader *markupsReader = new qSlicerLiverResectionsReader(logic, this);
   ioManager->registerIO(markupsReader);
-  ioManager->registerIO(new qSlicerLiverResectionsWriter(this));
+  ioManager->registerIO(new qSlicerLiverResectionsWriter(logic, this));
 }
 
 //-----------------------------------------------------------------------------
@@ -56,6 +56,7 @@
 // VTK includes
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
 
 //-----------------------------------------------------------------------------
 class qSlicerLiverResectionsReaderPrivate
@@ -112,7 +113,8 @@ qSlicerIO::IOFileType qSlicerLiverResectionsReader::fileType()const
 //-----------------------------------------------------------------------------
 QStringList qSlicerLiverResectionsReader::extensions()const
 {
-  return QStringList() << "LiverResections CSV (*.lrp.fcsv)";
+  return QStringList() << "LiverResections CSV (*.lrp.fcsv)"
+                       << "LiverResections Binary (*.lrpb)";
 }
 
 //-----------------------------------------------------------------------------
@@ -120,6 +122,32 @@ bool qSlicerLiverResectionsReader::load(const IOProperties& properties)
 {
   Q_D(qSlicerLiverResectionsReader);
 
+  if (d->LiverResectionsLogic.GetPointer() == nullptr)
+    {
+    return false;
+    }
+
+  // Several resection plans are loaded together: parsed in parallel and
+  // added to the scene in a single batch process
+  if (properties.contains("fileNames"))
+    {
+    vtkNew<vtkStringArray> fileNames;
+    for (const QString& fileName : properties["fileNames"].toStringList())
+      {
+      fileNames->InsertNextValue(std::string(fileName.toUtf8()));
+      }
+    vtkNew<vtkStringArray> loadedNodeIDs;
+    this->userMessages()->ClearMessages();
+    d->LiverResectionsLogic->LoadLiverResections(fileNames, loadedNodeIDs, this->userMessages());
+    QStringList nodeIDList;
+    for (vtkIdType i = 0; i < loadedNodeIDs->GetNumberOfValues(); ++i)
+      {
+      nodeIDList.append(QString::fromStdString(loadedNodeIDs->GetValue(i)));
+      }
+    this->setLoadedNodes(nodeIDList);
+    return !nodeIDList.isEmpty();
+    }
+
   // get the properties
   Q_ASSERT(properties.contains("fileName"));
   QString fileName = properties["fileName"].toString();
@@ -130,11 +158,6 @@ bool qSlicerLiverResectionsReader::load(const IOProperties& properties)
     name = properties["name"].toString();
     }
 
-  if (d->LiverResectionsLogic.GetPointer() == nullptr)
-    {
-    return false;
-    }
-
   // pass to logic to do the loading
   this->userMessages()->ClearMessages();
   char * nodeIDs = d->LiverResectionsLogic->LoadLiverResection(std::string(fileName.toUtf8()),
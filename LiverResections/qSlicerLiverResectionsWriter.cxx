@@ -52,23 +52,41 @@
 // MRML includes
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSceneViewNode.h>
+#include "vtkMRMLLiverResectionBinaryStorageNode.h"
 #include "vtkMRMLLiverResectionCSVStorageNode.h"
+#include "vtkMRMLLiverResectionNode.h"
 
 #include <vtkMRMLStorageNode.h>
 
+// Logic includes
+#include "vtkSlicerLiverResectionsLogic.h"
+
 // VTK includes
 #include <vtkStdString.h>
 #include <vtkStringArray.h>
 
 //----------------------------------------------------------------------------
-qSlicerLiverResectionsWriter::qSlicerLiverResectionsWriter(QObject* parentObject)
+qSlicerLiverResectionsWriter::qSlicerLiverResectionsWriter(vtkSlicerLiverResectionsLogic* logic, QObject* parentObject)
   : qSlicerNodeWriter("LiverResections", QString("LiverResectionFile"), QStringList() << "vtkMRMLLiverResectionNode", true, parentObject)
 {
+  this->setLiverResectionsLogic(logic);
 }
 
 //----------------------------------------------------------------------------
 qSlicerLiverResectionsWriter::~qSlicerLiverResectionsWriter() = default;
 
+//----------------------------------------------------------------------------
+void qSlicerLiverResectionsWriter::setLiverResectionsLogic(vtkSlicerLiverResectionsLogic* logic)
+{
+  this->LiverResectionsLogic = logic;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerLiverResectionsLogic* qSlicerLiverResectionsWriter::liverResectionsLogic() const
+{
+  return this->LiverResectionsLogic.GetPointer();
+}
+
 //----------------------------------------------------------------------------
 QStringList qSlicerLiverResectionsWriter::extensions(vtkObject* vtkNotUsed(object))const
 {
@@ -90,6 +108,14 @@ QStringList qSlicerLiverResectionsWriter::extensions(vtkObject* vtkNotUsed(objec
     supportedExtensions << QString::fromStdString(format);
     }
 
+  vtkNew<vtkMRMLLiverResectionBinaryStorageNode> binaryStorageNode;
+  const int binaryFormatCount = binaryStorageNode->GetSupportedWriteFileTypes()->GetNumberOfValues();
+  for (int formatIt = 0; formatIt < binaryFormatCount; ++formatIt)
+    {
+    vtkStdString format = binaryStorageNode->GetSupportedWriteFileTypes()->GetValue(formatIt);
+    supportedExtensions << QString::fromStdString(format);
+    }
+
   return supportedExtensions;
 }
 
@@ -145,6 +171,23 @@ bool qSlicerLiverResectionsWriter::write(const qSlicerIO::IOProperties& properti
     // fcsv file needs to be written
     this->setStorageNodeClass(node, "vtkMRMLLiverResectionCSVStorageNode");
     }
+
+  vtkNew<vtkMRMLLiverResectionBinaryStorageNode> binaryStorageNode;
+  std::string binaryCompatibleFileExtension = binaryStorageNode->GetSupportedFileExtension(fileName.c_str(), false, true);
+  if (!binaryCompatibleFileExtension.empty())
+    {
+    this->setStorageNodeClass(node, "vtkMRMLLiverResectionBinaryStorageNode");
+
+    // The tessellation of the current control points is written along with
+    // the resection
+    auto resectionNode = vtkMRMLLiverResectionNode::SafeDownCast(node);
+    auto storageNode = vtkMRMLLiverResectionBinaryStorageNode::SafeDownCast(
+      resectionNode ? resectionNode->GetStorageNode() : nullptr);
+    if (storageNode && this->LiverResectionsLogic)
+      {
+      storageNode->SetTessellation(this->LiverResectionsLogic->GetResectionTessellation(resectionNode));
+      }
+    }
   // else
   //   {
   //   // json file needs to be written
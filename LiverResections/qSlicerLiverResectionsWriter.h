@@ -47,8 +47,12 @@
 #include "qSlicerLiverResectionsModuleExport.h"
 #include "qSlicerNodeWriter.h"
 
+// VTK includes
+#include <vtkWeakPointer.h>
+
 class vtkMRMLNode;
 class vtkMRMLStorableNode;
+class vtkSlicerLiverResectionsLogic;
 
 /// Utility class that offers writing of markups in both json format, regardless of the current storage node.
 class Q_SLICER_QTMODULES_LIVERRESECTIONS_EXPORT qSlicerLiverResectionsWriter
@@ -57,9 +61,13 @@ class Q_SLICER_QTMODULES_LIVERRESECTIONS_EXPORT qSlicerLiverResectionsWriter
   Q_OBJECT
 public:
   typedef qSlicerNodeWriter Superclass;
-  qSlicerLiverResectionsWriter(QObject* parent);
+  qSlicerLiverResectionsWriter(vtkSlicerLiverResectionsLogic* logic, QObject* parent);
   ~qSlicerLiverResectionsWriter() override;
 
+  /// Logic providing the tessellation written along with binary resections
+  vtkSlicerLiverResectionsLogic* liverResectionsLogic()const;
+  void setLiverResectionsLogic(vtkSlicerLiverResectionsLogic* logic);
+
   QStringList extensions(vtkObject* object)const override;
 
   bool write(const qSlicerIO::IOProperties& properties) override;
@@ -67,6 +75,8 @@ public:
   void setStorageNodeClass(vtkMRMLStorableNode* storableNode, const QString& storageNodeClassName);
 
 private:
+  vtkWeakPointer<vtkSlicerLiverResectionsLogic> LiverResectionsLogic;
+
   Q_DISABLE_COPY(qSlicerLiverResectionsWriter);
 };
 
@@ -136,6 +136,7 @@ class LiverSegmentsWidget(ScriptedLoadableModuleWidget, VTKObservationMixin):
     self.ui.inputSegmentSelectorWidget.connect('currentSegmentChanged(QString)', self.onSegmentChanged)
     self.addObserver(slicer.mrmlScene, slicer.mrmlScene.StartCloseEvent, self.onSceneStartClose)
     self.addObserver(slicer.mrmlScene, slicer.mrmlScene.EndCloseEvent, self.onSceneEndClose)
+    self.addObserver(slicer.mrmlScene, slicer.mrmlScene.NodeRemovedEvent, self.onNodeRemoved)
     self.ui.endPointsMarkupsSelector.connect('nodeAddedByUser(vtkMRMLNode*)', self.newEndpointsListCreated)
     #self.ui.endPointsMarkupsSelector.connect('nodeAdded(vtkMRMLNode*)', self.newEndpointsListCreated)
     self.ui.inputSurfaceSelector.connect('currentNodeChanged(bool)', self.segmentationNodeSelected)
@@ -394,6 +395,15 @@ class LiverSegmentsWidget(ScriptedLoadableModuleWidget, VTKObservationMixin):
     # Parameter node will be reset, do not use it anymore
     self.setParameterNode(None)
 
+  @vtk.calldata_type(vtk.VTK_OBJECT)
+  def onNodeRemoved(self, caller, event, node):
+    """
+    Called when a node is removed, deleted segment centerlines are removed from the territories
+    """
+    if slicer.mrmlScene.IsClosing() or not node.IsA("vtkMRMLModelNode"):
+      return
+    self.logic.removeCenterlineSegment(node)
+
   def onSceneEndClose(self, caller, event):
     """
     Called just after the scene is closed.
@@ -655,6 +665,9 @@ class LiverSegmentsWidget(ScriptedLoadableModuleWidget, VTKObservationMixin):
       self.useColorFromSelector(centerlineModelNode)
       centerlineModelNode.GetDisplayNode().SetLineWidth(3)
       endPointsMarkupsNode.SetDisplayVisibility(False)
+
+      # Territories already calculated are only updated around the new centerline
+      self.logic.updateVascularTerritoryMap(centerlineModelNode)
     except ValueError:
       logging.error("Error: Failed to extract centerline")
 
@@ -714,11 +727,18 @@ class LiverSegmentsLogic(ScriptedLoadableModuleLogic):
     self._inputLabelMap = None
     self._outputLabelMap = None
     self.centerlineProcessingLogic = None
+    self._centerlineModelNode = None
+    self._territoryMapNode = None
+    # Segment centerlines added to the complete centerline model by node ID:
+    # (node, mesh, mesh modification time, vascular territory ID)
+    self._centerlineModelSegments = dict()
 
     from vtkSlicerLiverSegmentsModuleLogicPython import vtkLiverSegmentsLogic
     # Create the segmentsclassification logic
     self.scl = vtkLiverSegmentsLogic()
     self.scl.SetMRMLScene(slicer.mrmlScene)
+    # Territory surfaces are generated when the territories are shown in 3D
+    self.scl.DeferTerritorySurfacesOn()
 
   def check_module_Extract_Centerline_installed(self):
     module_name = 'ExtractCenterline'
@@ -741,6 +761,12 @@ class LiverSegmentsLogic(ScriptedLoadableModuleLogic):
   def createCompleteCenterlineModel(self, colormap):
     nodeName = "CenterlineModel"
     completeCenterlineModelNode = slicer.mrmlScene.GetNodeByID(nodeName)
+    if completeCenterlineModelNode and completeCenterlineModelNode is self._centerlineModelNode:
+      # The model built before is reused and only updated with the segment centerlines that changed
+      completeCenterlineModelNode.GetDisplayNode().SetAndObserveColorNodeID(colormap.GetID())
+      return completeCenterlineModelNode
+
+    self._centerlineModelSegments = dict()
     if completeCenterlineModelNode:
         logging.error('Replacing completeCenterlineModelNode: ' + nodeName)
         slicer.mrmlScene.RemoveNode(completeCenterlineModelNode)
@@ -759,23 +785,92 @@ class LiverSegmentsLogic(ScriptedLoadableModuleLogic):
     displayNode.SetLineWidth(3)
     completeCenterlineModelNode.GetDisplayNode().SetAndObserveColorNodeID(colormap.GetID())
 
+    self._centerlineModelNode = completeCenterlineModelNode
     return completeCenterlineModelNode
 
-  def build_centerline_model(self, colormap, vascSegmSelected):
-    centerlineModel = self.createCompleteCenterlineModel(colormap)
+  def getCenterlineSegments(self, vascSegmSelected):
+    """
+    Get the segment centerline models of a vascular territory segmentation by node ID
+    """
+    centerlineSegments = dict()
     centerlineSegmentsDict = slicer.util.getNodes("*Territory*")
     for name, segmentObject in centerlineSegmentsDict.items():
-      if segmentObject.GetClassName() == "vtkMRMLModelNode":
-        VascTerrId = int(segmentObject.GetAttribute("LiverSegments.VascTerrId"))
+      if segmentObject.GetClassName() == "vtkMRMLModelNode" and segmentObject.GetMesh():
         VascTerrSegmId = int(segmentObject.GetAttribute("LiverSegments.SegmentationId"))
         if VascTerrSegmId == vascSegmSelected:
-          self.scl.MarkSegmentWithID(segmentObject, VascTerrId)
-          self.scl.AddSegmentToCenterlineModel(centerlineModel, segmentObject)
+          centerlineSegments[segmentObject.GetID()] = segmentObject
+    return centerlineSegments
+
+  def build_centerline_model(self, colormap, vascSegmSelected):
+    centerlineModel = self.createCompleteCenterlineModel(colormap)
+    centerlineSegments = self.getCenterlineSegments(vascSegmSelected)
+
+    # Segment centerlines that were deleted or belong to another segmentation
+    for segmentId in list(self._centerlineModelSegments.keys()):
+      if segmentId not in centerlineSegments:
+        segmentObject = self._centerlineModelSegments.pop(segmentId)[0]
+        self.scl.RemoveSegmentFromCenterlineModel(centerlineModel, segmentObject)
+
+    # Only new or modified segment centerlines are (re)added
+    for segmentId, segmentObject in centerlineSegments.items():
+      VascTerrId = int(segmentObject.GetAttribute("LiverSegments.VascTerrId"))
+      added = self._centerlineModelSegments.get(segmentId)
+      if added and added[1] is segmentObject.GetMesh() and added[2] == segmentObject.GetMesh().GetMTime() \
+         and added[3] == VascTerrId:
+        continue
+      self.scl.MarkSegmentWithID(segmentObject, VascTerrId)
+      self.scl.AddSegmentToCenterlineModel(centerlineModel, segmentObject)
+      self._centerlineModelSegments[segmentId] = (segmentObject, segmentObject.GetMesh(),
+                                                  segmentObject.GetMesh().GetMTime(), VascTerrId)
+
     self.scl.InitializeCenterlineSearchModel(centerlineModel)
     return centerlineModel
 
   def calculateVascularTerritoryMap(self, vascularTerritorySegmentationNode, refVolume, segmentation, centerlineModel, colormap):
     self.scl.calculateVascularTerritoryMap(vascularTerritorySegmentationNode, refVolume, segmentation, centerlineModel, colormap)
+    self._territoryMapNode = vascularTerritorySegmentationNode
+
+  def getTerritoryMapNode(self, segmentObject):
+    """
+    Get the vascular territory segmentation calculated from the complete centerline model, if the segment
+    centerline belongs to it
+    """
+    if self._territoryMapNode is None or self._centerlineModelNode is None \
+       or not slicer.mrmlScene.IsNodePresent(self._territoryMapNode) \
+       or not slicer.mrmlScene.IsNodePresent(self._centerlineModelNode):
+      return None
+    if segmentObject.GetAttribute("LiverSegments.SegmentationId") != self._territoryMapNode.GetAttribute("LiverSegments.SegmentationId"):
+      return None
+    return self._territoryMapNode
+
+  def updateVascularTerritoryMap(self, segmentObject):
+    """
+    Update the territories of the last calculated territory map after a segment centerline was added or edited.
+    Returns False if there is no territory map to update.
+    """
+    territoryMapNode = self.getTerritoryMapNode(segmentObject)
+    if territoryMapNode is None:
+      return False
+    VascTerrId = int(segmentObject.GetAttribute("LiverSegments.VascTerrId"))
+    self.scl.MarkSegmentWithID(segmentObject, VascTerrId)
+    if not self.scl.UpdateVascularTerritoryMap(territoryMapNode, self._centerlineModelNode, segmentObject):
+      return False
+    self._centerlineModelSegments[segmentObject.GetID()] = (segmentObject, segmentObject.GetMesh(),
+                                                            segmentObject.GetMesh().GetMTime(), VascTerrId)
+    return True
+
+  def removeCenterlineSegment(self, segmentObject):
+    """
+    Remove a deleted segment centerline from the complete centerline model and from the territories calculated
+    from it
+    """
+    if self._centerlineModelSegments.pop(segmentObject.GetID(), None) is None:
+      return
+    territoryMapNode = self.getTerritoryMapNode(segmentObject)
+    if territoryMapNode is not None:
+      self.scl.RemoveSegmentFromVascularTerritoryMap(territoryMapNode, self._centerlineModelNode, segmentObject)
+    elif self._centerlineModelNode is not None:
+      self.scl.RemoveSegmentFromCenterlineModel(self._centerlineModelNode, segmentObject)
 
   def copyIndex(self, endPointsMarkupsNode, centerlineModelNode):
     centerlineModelNode.SetAttribute("LiverSegments.VascTerrId", endPointsMarkupsNode.GetAttribute("LiverSegments.VascTerrId"))
@@ -41,11 +41,17 @@
 
 // MRMLLogic includes
 #include "vtkLiverSegmentsLogic.h"
+#include "vtkCenterlineAccumulator.h"
+#include "vtkParallelQuadricDecimation.h"
+#include "vtkVascularTerritoryConversionRule.h"
+#include "vtkVascularTerritoryEngine.h"
+#include "vtkVascularTerritorySurfaceEngine.h"
 
 // MRML includes
 #include "vtkMRMLCoreTestingMacros.h"
 #include "vtkMRMLScene.h"
 #include <vtkMRMLLabelMapVolumeNode.h>
+#include <vtkMRMLModelNode.h>
 
 // VTKSlicer includes
 #include <vtkMRMLLiverResectionNode.h>
@@ -54,9 +60,30 @@
 #include "qMRMLWidget.h"
 #include <vtkTestingOutputWindow.h>
 #include <vtkSphereSource.h>
+#include <vtkLineSource.h>
+#include <vtkMath.h>
 #include <vtkImageData.h>
 #include <vtkCellData.h>
 #include <vtkPointData.h>
+#include <vtkIntArray.h>
+#include <vtkIdList.h>
+#include <vtkCellArray.h>
+#include <vtkOrientedImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkDecimatePro.h>
+#include <vtkCleanPolyData.h>
+#include <vtkTriangleFilter.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkFeatureEdges.h>
+#include <vtkHausdorffDistancePointSetFilter.h>
+#include <vtkDataArray.h>
+#include <vtkSegment.h>
+#include <vtkSegmentation.h>
+#include <vtkSegmentationConverter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 
 // LiverSegments includes
@@ -73,6 +100,11 @@ namespace
 int TestDefaults();
 int TestFunctionsWithNullInput();
 int TestFunctionsWithDummyData();
+int TestTerritorySurfaceEngine();
+int TestTerritoryConversionRule();
+int TestCenterlineAccumulator();
+int TestVascularTerritoryEngine();
+int TestParallelQuadricDecimation();
 }
 
 int vtkSlicerLiverSegmentsLogicTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
@@ -80,6 +112,11 @@ int vtkSlicerLiverSegmentsLogicTest1(int vtkNotUsed(argc), char * vtkNotUsed(arg
     CHECK_EXIT_SUCCESS(TestDefaults());
     CHECK_EXIT_SUCCESS(TestFunctionsWithNullInput());
     CHECK_EXIT_SUCCESS(TestFunctionsWithDummyData());
+    CHECK_EXIT_SUCCESS(TestTerritorySurfaceEngine());
+    CHECK_EXIT_SUCCESS(TestTerritoryConversionRule());
+    CHECK_EXIT_SUCCESS(TestCenterlineAccumulator());
+    CHECK_EXIT_SUCCESS(TestVascularTerritoryEngine());
+    CHECK_EXIT_SUCCESS(TestParallelQuadricDecimation());
     return EXIT_SUCCESS;
 }
 namespace
@@ -152,4 +189,450 @@ int TestFunctionsWithDummyData()
     return EXIT_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+int TestTerritorySurfaceEngine()
+{
+    // Two territories touching along the plane x = 9.5
+    vtkNew<vtkOrientedImageData> labelmap;
+    labelmap->SetExtent(0, 19, 0, 19, 0, 19);
+    labelmap->AllocateScalars(VTK_SHORT, 1);
+    for (int k = 0; k < 20; k++)
+        for (int j = 0; j < 20; j++)
+            for (int i = 0; i < 20; i++)
+            {
+                short label = 0;
+                if (i >= 4 && i <= 15 && j >= 4 && j <= 15 && k >= 4 && k <= 15)
+                    label = (i < 10) ? 1 : 2;
+                *static_cast<short*>(labelmap->GetScalarPointer(i, j, k)) = label;
+            }
+
+    vtkNew<vtkVascularTerritorySurfaceEngine> engine;
+    engine->SetInputLabelmap(labelmap);
+
+    vtkNew<vtkIntArray> labels;
+    engine->GetLabels(labels);
+    CHECK_INT(labels->GetNumberOfValues(), 2);
+
+    // Surfaces are only generated on request
+    CHECK_BOOL(engine->HasSurface(1), false);
+    vtkNew<vtkIntArray> firstLabel;
+    firstLabel->InsertNextValue(1);
+    engine->GenerateSurfaces(firstLabel);
+    CHECK_BOOL(engine->HasSurface(1), true);
+    CHECK_BOOL(engine->HasSurface(2), false);
+    CHECK_NULL(engine->GetSurface(3));
+
+    vtkPolyData *firstSurface = engine->GetSurface(1);
+    vtkPolyData *secondSurface = engine->GetSurface(2);
+    CHECK_NOT_NULL(firstSurface);
+    CHECK_NOT_NULL(secondSurface);
+    CHECK_BOOL(firstSurface->GetNumberOfPolys() > 0, true);
+    CHECK_BOOL(firstSurface->GetPointData()->GetNormals() != nullptr, true);
+
+    // The seam vertices are not smoothed and are shared by both territories
+    int seamPoints = 0;
+    for (vtkIdType p = 0; p < firstSurface->GetNumberOfPoints(); p++)
+    {
+        double x[3];
+        firstSurface->GetPoint(p, x);
+        if (x[0] != 9.5)
+            continue;
+        seamPoints++;
+        bool shared = false;
+        for (vtkIdType q = 0; q < secondSurface->GetNumberOfPoints() && !shared; q++)
+        {
+            double y[3];
+            secondSurface->GetPoint(q, y);
+            shared = (x[0] == y[0] && x[1] == y[1] && x[2] == y[2]);
+        }
+        CHECK_BOOL(shared, true);
+    }
+    CHECK_BOOL(seamPoints > 0, true);
+
+    // Modifying the input drops the cached surfaces
+    labelmap->Modified();
+    CHECK_BOOL(engine->HasSurface(1), false);
+
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestTerritoryConversionRule()
+{
+    // The logic registers the rule, segmentations created afterwards use it
+    vtkNew<vtkLiverSegmentsLogic> liverSegmentsLogic;
+
+    vtkNew<vtkOrientedImageData> labelmap;
+    labelmap->SetExtent(0, 19, 0, 19, 0, 19);
+    labelmap->AllocateScalars(VTK_SHORT, 1);
+    for (int k = 0; k < 20; k++)
+        for (int j = 0; j < 20; j++)
+            for (int i = 0; i < 20; i++)
+            {
+                short label = 0;
+                if (i >= 4 && i <= 15 && j >= 4 && j <= 15 && k >= 4 && k <= 15)
+                    label = (i < 10) ? 1 : 2;
+                *static_cast<short*>(labelmap->GetScalarPointer(i, j, k)) = label;
+            }
+
+    vtkNew<vtkVascularTerritorySurfaceEngine> engine;
+    engine->SetInputLabelmap(labelmap);
+    vtkVascularTerritoryConversionRule::AddSurfaceEngine(engine);
+
+    const std::string closedSurfaceName = vtkSegmentationConverter::GetClosedSurfaceRepresentationName();
+    vtkNew<vtkSegmentation> segmentation;
+    for (int label = 1; label <= 2; label++)
+    {
+        vtkNew<vtkSegment> segment;
+        segment->SetLabelValue(label);
+        segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+        segmentation->AddSegment(segment, "Territory_" + std::to_string(label));
+    }
+
+    // The standard conversion takes the surfaces of the engine
+    CHECK_BOOL(segmentation->CreateRepresentation(closedSurfaceName), true);
+    for (int label = 1; label <= 2; label++)
+    {
+        CHECK_BOOL(engine->HasSurface(label), true);
+        vtkSegment *segment = segmentation->GetSegment("Territory_" + std::to_string(label));
+        auto closedSurface = vtkPolyData::SafeDownCast(segment->GetRepresentation(closedSurfaceName));
+        CHECK_NOT_NULL(closedSurface);
+        CHECK_INT(closedSurface->GetNumberOfPoints(), engine->GetSurface(label)->GetNumberOfPoints());
+        CHECK_INT(closedSurface->GetNumberOfPolys(), engine->GetSurface(label)->GetNumberOfPolys());
+    }
+
+    vtkVascularTerritoryConversionRule::RemoveSurfaceEngine(engine);
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> CreateLine(double x0, double y0, double x1, double y1, int resolution)
+{
+    vtkNew<vtkLineSource> line;
+    line->SetPoint1(x0, y0, 0.0);
+    line->SetPoint2(x1, y1, 0.0);
+    line->SetResolution(resolution);
+    line->Update();
+    return line->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+int TestCenterlineAccumulator()
+{
+    vtkNew<vtkCenterlineAccumulator> accumulator;
+    int first = accumulator->AddSegment(CreateLine(0, 0, 10, 0, 10), 1);
+    int second = accumulator->AddSegment(CreateLine(0, 10, 10, 10, 20), 2);
+    int third = accumulator->AddSegment(CreateLine(0, 20, 10, 20, 5), 3);
+    CHECK_INT(accumulator->GetNumberOfBlocks(), 3);
+    CHECK_INT(accumulator->GetOutput()->GetNumberOfPoints(), 11 + 21 + 6);
+    CHECK_INT(accumulator->GetOutput()->GetNumberOfLines(), 3);
+
+    // Replacing a block keeps the block order
+    CHECK_BOOL(accumulator->ReplaceSegment(second, CreateLine(0, 12, 10, 12, 40), 2), true);
+    CHECK_INT(accumulator->GetOutput()->GetNumberOfPoints(), 11 + 41 + 6);
+    CHECK_INT(accumulator->GetSegmentId(11), 2);
+    CHECK_INT(accumulator->GetSegmentId(11 + 41), 3);
+
+    CHECK_BOOL(accumulator->RemoveSegment(first), true);
+    CHECK_BOOL(accumulator->RemoveSegment(first), false);
+    CHECK_INT(accumulator->GetNumberOfBlocks(), 2);
+    CHECK_INT(accumulator->GetOutput()->GetNumberOfPoints(), 41 + 6);
+    CHECK_INT(accumulator->GetSegmentId(0), 2);
+    CHECK_INT(accumulator->GetSegmentId(41), 3);
+
+    // Lines reference the shifted point ids
+    vtkPolyData *output = accumulator->GetOutput();
+    vtkNew<vtkIdList> linePoints;
+    output->GetLines()->GetCellAtId(1, linePoints);
+    CHECK_INT(linePoints->GetId(0), 41);
+
+    // Per block queries match a brute force search over the merged model
+    for (int n = 0; n < 20; n++)
+    {
+        double x[3] = {vtkMath::Random(-5, 15), vtkMath::Random(-5, 25), vtkMath::Random(-5, 5)};
+        double distance2;
+        int blockId = -1;
+        vtkIdType closest = accumulator->FindClosestPoint(x, distance2, &blockId);
+
+        double bruteForceDistance2 = VTK_DOUBLE_MAX;
+        for (vtkIdType p = 0; p < output->GetNumberOfPoints(); p++)
+        {
+            double y[3];
+            output->GetPoint(p, y);
+            bruteForceDistance2 = std::min(bruteForceDistance2, vtkMath::Distance2BetweenPoints(x, y));
+        }
+        CHECK_BOOL(closest >= 0, true);
+        CHECK_DOUBLE_TOLERANCE(distance2, bruteForceDistance2, 1e-9);
+        CHECK_BOOL(blockId == second || blockId == third, true);
+    }
+
+    // Summed model used by the logic is updated in place
+    vtkNew<vtkMRMLScene> scene;
+    vtkNew<vtkLiverSegmentsLogic> logic;
+    logic->SetMRMLScene(scene);
+    vtkNew<vtkMRMLModelNode> summed;
+    vtkNew<vtkPolyData> emptyPolyData;
+    summed->SetAndObservePolyData(emptyPolyData);
+    scene->AddNode(summed);
+    vtkNew<vtkMRMLModelNode> segmentA;
+    segmentA->SetAndObservePolyData(CreateLine(0, 0, 10, 0, 10));
+    scene->AddNode(segmentA);
+    vtkNew<vtkMRMLModelNode> segmentB;
+    segmentB->SetAndObservePolyData(CreateLine(0, 10, 10, 10, 10));
+    scene->AddNode(segmentB);
+
+    logic->MarkSegmentWithID(segmentA, 1);
+    logic->MarkSegmentWithID(segmentB, 2);
+    logic->AddSegmentToCenterlineModel(summed, segmentA);
+    vtkPolyData *summedPolyData = summed->GetPolyData();
+    logic->AddSegmentToCenterlineModel(summed, segmentB);
+    CHECK_POINTER(summed->GetPolyData(), summedPolyData);
+    CHECK_INT(summed->GetPolyData()->GetNumberOfPoints(), 22);
+    // Adding the same segment again replaces it
+    logic->AddSegmentToCenterlineModel(summed, segmentB);
+    CHECK_INT(summed->GetPolyData()->GetNumberOfPoints(), 22);
+    logic->RemoveSegmentFromCenterlineModel(summed, segmentA);
+    CHECK_INT(summed->GetPolyData()->GetNumberOfPoints(), 11);
+
+    // Building another summed model leaves the first one untouched
+    vtkNew<vtkMRMLModelNode> otherSummed;
+    vtkNew<vtkPolyData> otherEmptyPolyData;
+    otherSummed->SetAndObservePolyData(otherEmptyPolyData);
+    scene->AddNode(otherSummed);
+    logic->AddSegmentToCenterlineModel(otherSummed, segmentA);
+    CHECK_BOOL(otherSummed->GetPolyData() != summed->GetPolyData(), true);
+    CHECK_INT(otherSummed->GetPolyData()->GetNumberOfPoints(), 11);
+    CHECK_POINTER(summed->GetPolyData(), summedPolyData);
+    CHECK_INT(summed->GetPolyData()->GetNumberOfPoints(), 11);
+    logic->AddSegmentToCenterlineModel(summed, segmentA);
+    CHECK_INT(summed->GetPolyData()->GetNumberOfPoints(), 22);
+    CHECK_INT(otherSummed->GetPolyData()->GetNumberOfPoints(), 11);
+
+    // A removed summed model releases its accumulator, even if its polydata
+    // is still referenced: added again, it starts from the polydata it holds
+    vtkSmartPointer<vtkPolyData> otherSummedPolyData = otherSummed->GetPolyData();
+    scene->RemoveNode(otherSummed);
+    scene->AddNode(otherSummed);
+    logic->AddSegmentToCenterlineModel(otherSummed, segmentA);
+    CHECK_BOOL(otherSummed->GetPolyData() != otherSummedPolyData, true);
+    CHECK_INT(otherSummed->GetPolyData()->GetNumberOfPoints(), 22);
+
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateLiverMask()
+{
+    auto mask = vtkSmartPointer<vtkImageData>::New();
+    mask->SetDimensions(80, 80, 3);
+    mask->AllocateScalars(VTK_SHORT, 1);
+    auto scalars = static_cast<short*>(mask->GetScalarPointer());
+    std::fill(scalars, scalars + mask->GetNumberOfPoints(), 1);
+    return mask;
+}
+
+//----------------------------------------------------------------------------
+int CompareWithFullClassification(vtkCenterlineAccumulator *accumulator, vtkVascularTerritoryEngine *engine,
+                                  vtkMatrix4x4 *ijkToRas)
+{
+    vtkNew<vtkVascularTerritoryEngine> reference;
+    reference->SetCenterlineAccumulator(accumulator);
+    vtkSmartPointer<vtkImageData> referenceLabelmap = CreateLiverMask();
+    CHECK_INT(reference->Classify(referenceLabelmap, ijkToRas), 1);
+
+    auto expected = static_cast<short*>(referenceLabelmap->GetScalarPointer());
+    auto actual = static_cast<short*>(engine->GetLabelmap()->GetScalarPointer());
+    CHECK_BOOL(std::equal(expected, expected + referenceLabelmap->GetNumberOfPoints(), actual), true);
+
+    vtkNew<vtkIntArray> labels;
+    reference->GetLabels(labels);
+    for (vtkIdType i = 0; i < labels->GetNumberOfValues(); i++)
+    {
+        int label = labels->GetValue(i);
+        CHECK_INT(engine->GetLabelVoxelCount(label), reference->GetLabelVoxelCount(label));
+    }
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestVascularTerritoryEngine()
+{
+    // A grid of short segments, one territory each. Integer coordinates on
+    // both the voxels and the segment points produce plenty of ties.
+    vtkNew<vtkCenterlineAccumulator> accumulator;
+    std::vector<int> blocks;
+    int segmentId = 2;
+    for (int j = 0; j < 4; j++)
+        for (int i = 0; i < 4; i++)
+        {
+            double x = 10 + 20 * i, y = 10 + 20 * j;
+            blocks.push_back(accumulator->AddSegment(CreateLine(x - 4, y, x + 4, y, 8), segmentId++));
+        }
+
+    vtkNew<vtkMatrix4x4> ijkToRas;
+    vtkSmartPointer<vtkImageData> labelmap = CreateLiverMask();
+    vtkNew<vtkVascularTerritoryEngine> engine;
+    engine->SetCenterlineAccumulator(accumulator);
+    CHECK_BOOL(engine->IsInitialized(), false);
+    CHECK_INT(engine->UpdateBlockReplaced(blocks[0]), 0);
+    CHECK_INT(engine->Classify(labelmap, ijkToRas), 1);
+    CHECK_BOOL(engine->IsInitialized(), true);
+    CHECK_EXIT_SUCCESS(CompareWithFullClassification(accumulator, engine, ijkToRas));
+    const vtkIdType numberOfVoxels = labelmap->GetNumberOfPoints();
+    CHECK_INT(engine->GetNumberOfEvaluatedVoxels(), numberOfVoxels);
+
+    // Moving one segment only evaluates the voxels around it
+    accumulator->ReplaceSegment(blocks[5], CreateLine(28, 34, 36, 27, 8), 7);
+    CHECK_INT(engine->UpdateBlockReplaced(blocks[5]), 1);
+    CHECK_EXIT_SUCCESS(CompareWithFullClassification(accumulator, engine, ijkToRas));
+    CHECK_BOOL(engine->GetNumberOfEvaluatedVoxels() > 0, true);
+    CHECK_BOOL(engine->GetNumberOfEvaluatedVoxels() < numberOfVoxels / 2, true);
+    vtkNew<vtkIntArray> modifiedLabels;
+    engine->GetModifiedLabels(modifiedLabels);
+    CHECK_BOOL(modifiedLabels->GetNumberOfValues() > 0, true);
+    CHECK_BOOL(modifiedLabels->LookupValue(7) >= 0, true);
+    CHECK_BOOL(modifiedLabels->LookupValue(17) < 0, true);
+
+    // A new segment takes voxels from its neighbours
+    int added = accumulator->AddSegment(CreateLine(45, 45, 55, 55, 10), 20);
+    CHECK_INT(engine->UpdateBlockAdded(added), 1);
+    CHECK_EXIT_SUCCESS(CompareWithFullClassification(accumulator, engine, ijkToRas));
+    CHECK_BOOL(engine->GetLabelVoxelCount(20) > 0, true);
+    CHECK_BOOL(engine->GetNumberOfEvaluatedVoxels() < numberOfVoxels, true);
+
+    // Removing segments gives their voxels back
+    accumulator->RemoveSegment(added);
+    CHECK_INT(engine->UpdateBlockRemoved(added), 1);
+    CHECK_EXIT_SUCCESS(CompareWithFullClassification(accumulator, engine, ijkToRas));
+    CHECK_INT(engine->GetLabelVoxelCount(20), 0);
+
+    accumulator->RemoveSegment(blocks[0]);
+    CHECK_INT(engine->UpdateBlockRemoved(blocks[0]), 1);
+    CHECK_EXIT_SUCCESS(CompareWithFullClassification(accumulator, engine, ijkToRas));
+    CHECK_INT(engine->GetLabelVoxelCount(2), 0);
+
+    return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Decimation chain used by preprocessAndDecimate before the parallel filter
+vtkSmartPointer<vtkPolyData> DecimateWithChain(vtkPolyData *input, double reduction)
+{
+    vtkNew<vtkDecimatePro> decimator;
+    decimator->SetInputData(input);
+    decimator->SetFeatureAngle(60);
+    decimator->SplittingOff();
+    decimator->PreserveTopologyOn();
+    decimator->SetMaximumError(1);
+    decimator->SetTargetReduction(reduction);
+    vtkNew<vtkCleanPolyData> cleaner;
+    cleaner->SetInputConnection(decimator->GetOutputPort());
+    vtkNew<vtkTriangleFilter> triangulator;
+    triangulator->SetInputConnection(cleaner->GetOutputPort());
+    triangulator->PassLinesOff();
+    triangulator->PassVertsOff();
+    vtkNew<vtkPolyDataNormals> normals;
+    normals->SetInputConnection(triangulator->GetOutputPort());
+    normals->AutoOrientNormalsOn();
+    normals->ConsistencyOn();
+    normals->SplittingOff();
+    normals->Update();
+    return normals->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+double HausdorffDistance(vtkPolyData *a, vtkPolyData *b)
+{
+    vtkNew<vtkHausdorffDistancePointSetFilter> hausdorff;
+    hausdorff->SetInputData(0, a);
+    hausdorff->SetInputData(1, b);
+    hausdorff->SetTargetDistanceMethodToPointToCell();
+    hausdorff->Update();
+    return hausdorff->GetHausdorffDistance();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType CountBoundaryEdges(vtkPolyData *mesh)
+{
+    vtkNew<vtkFeatureEdges> edges;
+    edges->SetInputData(mesh);
+    edges->BoundaryEdgesOn();
+    edges->NonManifoldEdgesOn();
+    edges->FeatureEdgesOff();
+    edges->ManifoldEdgesOff();
+    edges->Update();
+    return edges->GetOutput()->GetNumberOfLines();
+}
+
+//----------------------------------------------------------------------------
+int TestParallelQuadricDecimation()
+{
+    vtkNew<vtkSphereSource> sphere;
+    sphere->SetRadius(10.0);
+    sphere->SetThetaResolution(300);
+    sphere->SetPhiResolution(300);
+    sphere->Update();
+    vtkPolyData *input = sphere->GetOutput();
+    const double reduction = 0.8;
+
+    vtkSmartPointer<vtkPolyData> chainOutput = DecimateWithChain(input, reduction);
+
+    vtkNew<vtkParallelQuadricDecimation> decimator;
+    decimator->SetInputData(input);
+    decimator->SetTargetReduction(reduction);
+    decimator->SetNumberOfPartitions(4);
+    decimator->Update();
+    vtkPolyData *output = decimator->GetOutput();
+
+    const double tolerance = 0.1;
+    double chainError = HausdorffDistance(chainOutput, input);
+    double parallelError = HausdorffDistance(output, input);
+    CHECK_BOOL(chainError <= tolerance, true);
+
+    // Same reduction, closed output, same error tolerance as the chain
+    CHECK_INT(decimator->GetNumberOfUsedPartitions(), 4);
+    CHECK_BOOL(output->GetNumberOfPolys() <= static_cast<vtkIdType>(std::ceil((1.0 - reduction) * input->GetNumberOfPolys())) + 4, true);
+    CHECK_INT(static_cast<int>(CountBoundaryEdges(output)), 0);
+    CHECK_BOOL(parallelError <= tolerance, true);
+
+    // Outward point normals
+    vtkDataArray *normals = output->GetPointData()->GetNormals();
+    CHECK_NOT_NULL(normals);
+    for (vtkIdType p = 0; p < output->GetNumberOfPoints(); p += 97)
+    {
+        double x[3];
+        output->GetPoint(p, x);
+        CHECK_BOOL(vtkMath::Dot(x, normals->GetTuple3(p)) > 0.0, true);
+    }
+
+    // The error bound stops the collapses before the target reduction
+    CHECK_BOOL(decimator->GetMaximumError() < VTK_DOUBLE_MAX, true);
+    decimator->SetMaximumError(1e-4);
+    decimator->Update();
+    CHECK_BOOL(decimator->GetOutput()->GetNumberOfPolys() > input->GetNumberOfPolys() / 2, true);
+    decimator->SetMaximumError(1.0);
+
+    // Open meshes keep their border
+    vtkNew<vtkPolyData> hemisphere;
+    {
+        vtkNew<vtkSphereSource> cap;
+        cap->SetThetaResolution(120);
+        cap->SetPhiResolution(120);
+        cap->SetEndPhi(90);
+        cap->Update();
+        hemisphere->DeepCopy(cap->GetOutput());
+    }
+    vtkNew<vtkCleanPolyData> cleanHemisphere;
+    cleanHemisphere->SetInputData(hemisphere);
+    cleanHemisphere->Update();
+    vtkIdType border = CountBoundaryEdges(cleanHemisphere->GetOutput());
+    decimator->SetInputData(hemisphere);
+    decimator->SetTargetReduction(0.9);
+    decimator->Update();
+    CHECK_BOOL(border > 0, true);
+    CHECK_INT(static_cast<int>(CountBoundaryEdges(decimator->GetOutput())), static_cast<int>(border));
+
+    return EXIT_SUCCESS;
+}
+
 }
@@ -0,0 +1,388 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#include "vtkCenterlineAccumulator.h"
+
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkIntArray.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkStaticPointLocator.h>
+
+#include <algorithm>
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Squared distance from x to an axis aligned box
+double DistanceToBounds2(const double x[3], const double bounds[6])
+{
+    double distance2 = 0.0;
+    for(int c = 0; c < 3; ++c)
+    {
+        double delta = 0.0;
+        if(x[c] < bounds[2 * c])
+            delta = bounds[2 * c] - x[c];
+        else if(x[c] > bounds[2 * c + 1])
+            delta = x[c] - bounds[2 * c + 1];
+        distance2 += delta * delta;
+    }
+    return distance2;
+}
+
+//------------------------------------------------------------------------------
+// Inserts the lines of source into target, shifting the point ids by offset
+void AppendLines(vtkCellArray *target, vtkCellArray *source, vtkIdType offset)
+{
+    std::vector<vtkIdType> cell;
+    auto iter = vtk::TakeSmartPointer(source->NewIterator());
+    vtkIdType npts;
+    const vtkIdType *pts;
+    for(iter->GoToFirstCell(); !iter->IsDoneWithTraversal(); iter->GoToNextCell())
+    {
+        iter->GetCurrentCell(npts, pts);
+        cell.resize(npts);
+        for(vtkIdType n = 0; n < npts; ++n)
+            cell[n] = pts[n] + offset;
+        target->InsertNextCell(npts, cell.data());
+    }
+}
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkCenterlineAccumulator);
+
+//------------------------------------------------------------------------------
+vtkCenterlineAccumulator::vtkCenterlineAccumulator()
+  : NextBlockId(0)
+{
+    this->Output = vtkSmartPointer<vtkPolyData>::New();
+    this->Reset();
+}
+
+//------------------------------------------------------------------------------
+vtkCenterlineAccumulator::~vtkCenterlineAccumulator() = default;
+
+//------------------------------------------------------------------------------
+void vtkCenterlineAccumulator::PrintSelf(ostream &os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Number of blocks: " << this->Blocks.size() << "\n";
+  os << indent << "Number of points: " << this->Output->GetNumberOfPoints() << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkCenterlineAccumulator::Reset()
+{
+    this->Blocks.clear();
+
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto lines = vtkSmartPointer<vtkCellArray>::New();
+    auto idArray = vtkSmartPointer<vtkIntArray>::New();
+    idArray->SetName("segmentId");
+
+    this->Output->Initialize();
+    this->Output->SetPoints(points);
+    this->Output->SetLines(lines);
+    this->Output->GetPointData()->SetScalars(idArray);
+    this->Output->Modified();
+}
+
+//------------------------------------------------------------------------------
+vtkPolyData *vtkCenterlineAccumulator::GetOutput()
+{
+    return this->Output;
+}
+
+//------------------------------------------------------------------------------
+int vtkCenterlineAccumulator::GetNumberOfBlocks() const
+{
+    return static_cast<int>(this->Blocks.size());
+}
+
+//------------------------------------------------------------------------------
+size_t vtkCenterlineAccumulator::FindBlock(int blockId) const
+{
+    for(size_t position = 0; position < this->Blocks.size(); ++position)
+        if(this->Blocks[position].Id == blockId)
+            return position;
+    return this->Blocks.size();
+}
+
+//------------------------------------------------------------------------------
+bool vtkCenterlineAccumulator::HasBlock(int blockId) const
+{
+    return this->FindBlock(blockId) < this->Blocks.size();
+}
+
+//------------------------------------------------------------------------------
+void vtkCenterlineAccumulator::GetBlockIds(std::vector<int> &blockIds) const
+{
+    blockIds.clear();
+    for(const Block &block : this->Blocks)
+        blockIds.push_back(block.Id);
+}
+
+//------------------------------------------------------------------------------
+bool vtkCenterlineAccumulator::GetBlockBounds(int blockId, double bounds[6]) const
+{
+    size_t position = this->FindBlock(blockId);
+    if(position == this->Blocks.size() || this->Blocks[position].Geometry->GetNumberOfPoints() == 0)
+        return false;
+    std::copy(this->Blocks[position].Bounds, this->Blocks[position].Bounds + 6, bounds);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkCenterlineAccumulator::CopySegment(vtkPolyData *segment, int segmentId, Block &block)
+{
+    if(!segment)
+        return false;
+
+    auto geometry = vtkSmartPointer<vtkPolyData>::New();
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    if(segment->GetPoints())
+        points->DeepCopy(segment->GetPoints());
+    auto lines = vtkSmartPointer<vtkCellArray>::New();
+    if(segment->GetLines())
+        lines->DeepCopy(segment->GetLines());
+
+    vtkIdType numberOfPoints = points->GetNumberOfPoints();
+    auto idArray = vtkSmartPointer<vtkIntArray>::New();
+    idArray->SetName("segmentId");
+    idArray->SetNumberOfValues(numberOfPoints);
+    vtkDataArray *segmentIds = segment->GetPointData()->GetScalars();
+    if(segmentId < 0 && segmentIds && segmentIds->GetNumberOfTuples() == numberOfPoints)
+    {
+        for(vtkIdType p = 0; p < numberOfPoints; ++p)
+            idArray->SetValue(p, static_cast<int>(segmentIds->GetTuple1(p)));
+    }
+    else
+    {
+        idArray->FillValue(std::max(segmentId, 0));
+    }
+
+    geometry->SetPoints(points);
+    geometry->SetLines(lines);
+    geometry->GetPointData()->SetScalars(idArray);
+
+    block.Geometry = geometry;
+    block.Locator = nullptr;
+    block.LocatorDirty = true;
+    if(numberOfPoints > 0)
+        geometry->GetBounds(block.Bounds);
+    else
+        vtkMath::UninitializeBounds(block.Bounds);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkCenterlineAccumulator::AppendBlock(Block &block)
+{
+    vtkPoints *points = this->Output->GetPoints();
+    auto idArray = vtkIntArray::SafeDownCast(this->Output->GetPointData()->GetScalars());
+
+    block.PointOffset = points->GetNumberOfPoints();
+    vtkIdType numberOfPoints = block.Geometry->GetNumberOfPoints();
+    if(numberOfPoints == 0)
+        return;
+
+    // InsertTuples grows the arrays geometrically, so appending is amortized O(k)
+    points->GetData()->InsertTuples(block.PointOffset, numberOfPoints, 0, block.Geometry->GetPoints()->GetData());
+    idArray->InsertTuples(block.PointOffset, numberOfPoints, 0, block.Geometry->GetPointData()->GetScalars());
+}
+
+//------------------------------------------------------------------------------
+void vtkCenterlineAccumulator::RebuildLines()
+{
+    auto lines = vtkSmartPointer<vtkCellArray>::New();
+    for(const Block &block : this->Blocks)
+        AppendLines(lines, block.Geometry->GetLines(), block.PointOffset);
+    this->Output->SetLines(lines);
+}
+
+//------------------------------------------------------------------------------
+void vtkCenterlineAccumulator::RebuildFrom(size_t position)
+{
+    vtkIdType offset = 0;
+    if(position > 0)
+        offset = this->Blocks[position - 1].PointOffset + this->Blocks[position - 1].Geometry->GetNumberOfPoints();
+
+    this->Output->GetPoints()->SetNumberOfPoints(offset);
+    this->Output->GetPointData()->GetScalars()->SetNumberOfTuples(offset);
+    for(size_t n = position; n < this->Blocks.size(); ++n)
+        this->AppendBlock(this->Blocks[n]);
+
+    this->RebuildLines();
+    this->Output->GetPoints()->Modified();
+    this->Output->Modified();
+}
+
+//------------------------------------------------------------------------------
+int vtkCenterlineAccumulator::AddSegment(vtkPolyData *segment, int segmentId)
+{
+    Block block;
+    if(!this->CopySegment(segment, segmentId, block))
+    {
+        vtkErrorMacro("AddSegment: invalid segment.");
+        return -1;
+    }
+    block.Id = this->NextBlockId++;
+
+    this->AppendBlock(block);
+    AppendLines(this->Output->GetLines(), block.Geometry->GetLines(), block.PointOffset);
+    this->Blocks.push_back(block);
+
+    this->Output->GetPoints()->Modified();
+    this->Output->GetLines()->Modified();
+    this->Output->Modified();
+    return block.Id;
+}
+
+//------------------------------------------------------------------------------
+bool vtkCenterlineAccumulator::ReplaceSegment(int blockId, vtkPolyData *segment, int segmentId)
+{
+    size_t position = this->FindBlock(blockId);
+    if(position == this->Blocks.size())
+        return false;
+
+    Block block;
+    if(!this->CopySegment(segment, segmentId, block))
+    {
+        vtkErrorMacro("ReplaceSegment: invalid segment.");
+        return false;
+    }
+    block.Id = blockId;
+    this->Blocks[position] = block;
+    this->RebuildFrom(position);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkCenterlineAccumulator::RemoveSegment(int blockId)
+{
+    size_t position = this->FindBlock(blockId);
+    if(position == this->Blocks.size())
+        return false;
+
+    this->Blocks.erase(this->Blocks.begin() + position);
+    this->RebuildFrom(position);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkCenterlineAccumulator::BuildLocators()
+{
+    for(Block &block : this->Blocks)
+    {
+        if(!block.LocatorDirty)
+            continue;
+        block.LocatorDirty = false;
+        block.Locator = nullptr;
+        if(block.Geometry->GetNumberOfPoints() == 0)
+            continue;
+        block.Locator = vtkSmartPointer<vtkStaticPointLocator>::New();
+        block.Locator->SetDataSet(block.Geometry);
+        block.Locator->BuildLocator();
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkCenterlineAccumulator::FindClosestPointInBlock(int blockId, const double x[3], double &distance2)
+{
+    distance2 = VTK_DOUBLE_MAX;
+    size_t position = this->FindBlock(blockId);
+    if(position == this->Blocks.size())
+        return -1;
+
+    this->BuildLocators();
+    Block &block = this->Blocks[position];
+    if(!block.Locator)
+        return -1;
+
+    vtkIdType localId = block.Locator->FindClosestPoint(x);
+    if(localId < 0)
+        return -1;
+    double closest[3];
+    block.Geometry->GetPoint(localId, closest);
+    distance2 = vtkMath::Distance2BetweenPoints(x, closest);
+    return block.PointOffset + localId;
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkCenterlineAccumulator::FindClosestPoint(const double x[3], double &distance2, int *blockId)
+{
+    this->BuildLocators();
+
+    vtkIdType closestId = -1;
+    distance2 = VTK_DOUBLE_MAX;
+    for(const Block &block : this->Blocks)
+    {
+        if(!block.Locator || DistanceToBounds2(x, block.Bounds) > distance2)
+            continue;
+
+        vtkIdType localId = block.Locator->FindClosestPoint(x);
+        if(localId < 0)
+            continue;
+        double closest[3];
+        block.Geometry->GetPoint(localId, closest);
+        double blockDistance2 = vtkMath::Distance2BetweenPoints(x, closest);
+        if(blockDistance2 < distance2)
+        {
+            distance2 = blockDistance2;
+            closestId = block.PointOffset + localId;
+            if(blockId)
+                *blockId = block.Id;
+        }
+    }
+    return closestId;
+}
+
+//------------------------------------------------------------------------------
+int vtkCenterlineAccumulator::GetSegmentId(vtkIdType pointId) const
+{
+    auto idArray = vtkIntArray::SafeDownCast(this->Output->GetPointData()->GetScalars());
+    if(!idArray || pointId < 0 || pointId >= idArray->GetNumberOfValues())
+        return 0;
+    return idArray->GetValue(pointId);
+}
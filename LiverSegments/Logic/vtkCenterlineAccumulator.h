@@ -0,0 +1,147 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#ifndef __vtkCenterlineAccumulator_h
+#define __vtkCenterlineAccumulator_h
+
+#include "vtkSlicerLiverSegmentsModuleLogicExport.h"
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+// Forward declarations
+class vtkStaticPointLocator;
+class vtkPolyData;
+
+// Accumulates centerline segments into a single polydata (points, lines and a
+// "segmentId" point array) without re-copying the whole model on every
+// addition. Every segment is kept as a block: appending a segment of k points
+// costs amortized O(k), and removing or replacing a block only re-appends the
+// blocks stored after it. Closest point queries use one locator per block, so
+// editing a segment only rebuilds the locator of that segment.
+class VTK_SLICER_LIVERSEGMENTS_MODULE_LOGIC_EXPORT
+vtkCenterlineAccumulator : public vtkObject
+{
+ public:
+  static vtkCenterlineAccumulator *New();
+  vtkTypeMacro(vtkCenterlineAccumulator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Appends a segment and returns the id of the new block (-1 on error). If
+  // segmentId is negative the ids are taken from the integer point scalars of
+  // the segment (as set by vtkLiverSegmentsLogic::MarkSegmentWithID).
+  int AddSegment(vtkPolyData *segment, int segmentId = -1);
+
+  // Replaces the geometry of an existing block. Returns false if the block
+  // does not exist.
+  bool ReplaceSegment(int blockId, vtkPolyData *segment, int segmentId = -1);
+
+  // Removes a block. Returns false if the block does not exist.
+  bool RemoveSegment(int blockId);
+
+  // Removes all the blocks
+  void Reset();
+
+  int GetNumberOfBlocks() const;
+  bool HasBlock(int blockId) const;
+
+  // Ids of the blocks, in the order they are stored in the output
+  void GetBlockIds(std::vector<int> &blockIds) const;
+
+  // Returns the bounds of a block. Returns false if the block does not exist
+  // or is empty.
+  bool GetBlockBounds(int blockId, double bounds[6]) const;
+
+  // Merged centerline. The same object is updated in place.
+  vtkPolyData *GetOutput();
+
+  // Builds the locators of the blocks that changed since the last call
+  void BuildLocators();
+
+  // Returns the id (in the output) of the accumulated point closest to x, or
+  // -1 if there are no points. Ties are resolved in favour of the block stored
+  // first. Locators are built on demand.
+  vtkIdType FindClosestPoint(const double x[3], double &distance2, int *blockId = nullptr);
+
+  // Same as FindClosestPoint but restricted to one block
+  vtkIdType FindClosestPointInBlock(int blockId, const double x[3], double &distance2);
+
+  // Returns the segment id of a point of the output
+  int GetSegmentId(vtkIdType pointId) const;
+
+ protected:
+  vtkCenterlineAccumulator();
+  ~vtkCenterlineAccumulator() override;
+
+  struct Block
+  {
+    int Id;
+    vtkSmartPointer<vtkPolyData> Geometry;
+    vtkSmartPointer<vtkStaticPointLocator> Locator;
+    bool LocatorDirty;
+    vtkIdType PointOffset;
+    double Bounds[6];
+  };
+
+  // Copies points, lines and ids of a segment into a block
+  bool CopySegment(vtkPolyData *segment, int segmentId, Block &block);
+
+  // Appends the block points and ids to the output
+  void AppendBlock(Block &block);
+
+  // Truncates the output to the blocks stored before position, re-appends the
+  // remaining ones and rebuilds the lines
+  void RebuildFrom(size_t position);
+  void RebuildLines();
+
+  size_t FindBlock(int blockId) const;
+
+ protected:
+  std::vector<Block> Blocks;
+  int NextBlockId;
+  vtkSmartPointer<vtkPolyData> Output;
+
+ private:
+  vtkCenterlineAccumulator(const vtkCenterlineAccumulator&) = delete;
+  void operator=(const vtkCenterlineAccumulator&) = delete;
+};
+
+#endif
@@ -38,71 +38,135 @@
    ===============================================================================*/
 
 #include "vtkLiverSegmentsLogic.h"
+#include "vtkCenterlineAccumulator.h"
+#include "vtkParallelQuadricDecimation.h"
+#include "vtkVascularTerritoryConversionRule.h"
+#include "vtkVascularTerritoryEngine.h"
+#include "vtkVascularTerritorySurfaceEngine.h"
 
 #include <vtkMRMLLabelMapVolumeNode.h>
 #include <vtkMRMLSegmentationNode.h>
 #include <vtkMRMLModelNode.h>
 #include <vtkMRMLDisplayNode.h>
+#include <vtkMRMLSegmentationDisplayNode.h>
 
 #include <vtkMRMLScene.h>
 #include <vtkSlicerSegmentationsModuleLogic.h>
+#include <vtkMRMLColorNode.h>
+#include <vtkSegment.h>
+#include <vtkSegmentation.h>
+#include <vtkSegmentationConverter.h>
 
+#include <vtkCommand.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkImageData.h>
+#include <vtkImageCast.h>
 #include <vtkImageIterator.h>
+#include <vtkIntArray.h>
 #include <vtkKdTreePointLocator.h>
 #include <vtkPointSet.h>
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
 #include <vtkStringArray.h>
-#include <vtkAppendPolyData.h>
 #include <vtkOrientedImageData.h>
 #include <vtkMatrix4x4.h>
-#include <vtkDecimatePro.h>
-#include <vtkCleanPolyData.h>
-#include <vtkTriangleFilter.h>
-#include <vtkPolyDataNormals.h>
 #include <vtkCellData.h>
 
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkLiverSegmentsLogic);
 
 //------------------------------------------------------------------------------
 vtkLiverSegmentsLogic::vtkLiverSegmentsLogic()
+  : UseCenterlineAccumulator(false)
+  , DeferTerritorySurfaces(false)
 {
   this->Locator = vtkSmartPointer<vtkKdTreePointLocator>::New();
+  this->TerritoryEngine = vtkSmartPointer<vtkVascularTerritoryEngine>::New();
+  this->SurfaceEngine = vtkSmartPointer<vtkVascularTerritorySurfaceEngine>::New();
+
+  // Standard closed surface conversions of the territories (Show 3D,
+  // CreateClosedSurfaceRepresentation) take the surfaces from the engine
+  vtkVascularTerritoryConversionRule::RegisterRule();
+  vtkVascularTerritoryConversionRule::AddSurfaceEngine(this->SurfaceEngine);
 }
 
 //------------------------------------------------------------------------------
 vtkLiverSegmentsLogic::~vtkLiverSegmentsLogic()
 {
-  
+  vtkVascularTerritoryConversionRule::RemoveSurfaceEngine(this->SurfaceEngine);
 }
 
 //------------------------------------------------------------------------------
 void vtkLiverSegmentsLogic::PrintSelf(ostream &os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "DeferTerritorySurfaces: " << this->DeferTerritorySurfaces << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkLiverSegmentsLogic::SetMRMLSceneInternal(vtkMRMLScene *newScene)
+{
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+  events->InsertNextValue(vtkMRMLScene::EndCloseEvent);
+  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
+}
+
+//------------------------------------------------------------------------------
+void vtkLiverSegmentsLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode *node)
+{
+  // Release the accumulator of a removed summed centerline model
+  if (node && node->GetID())
+    {
+    this->CenterlineModels.erase(node->GetID());
+    }
+
+  if (vtkMRMLSegmentationDisplayNode::SafeDownCast(node))
+    {
+    vtkUnObserveMRMLNodeMacro(node);
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkLiverSegmentsLogic::OnMRMLSceneEndClose()
+{
+  this->CenterlineModels.clear();
+}
+
+//------------------------------------------------------------------------------
+void vtkLiverSegmentsLogic::ProcessMRMLNodesEvents(vtkObject *caller, unsigned long event, void *callData)
+{
+  // Territories whose surface generation was deferred get their surface
+  // once they are made visible
+  auto displayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(caller);
+  if (displayNode && event == vtkCommand::ModifiedEvent)
+    {
+    this->GenerateTerritorySurfaces(vtkMRMLSegmentationNode::SafeDownCast(displayNode->GetDisplayableNode()), true);
+    return;
+    }
+
+  this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
 }
 
 void vtkLiverSegmentsLogic::MarkSegmentWithID(vtkMRMLModelNode *segment, int segmentId)
 {
-    auto idArray = vtkSmartPointer<vtkIntArray>::New();
-    idArray->SetName("segmentId");
-    
-    if(!segment) //Allow function to run with nullptr as input
+    if(!segment || !segment->GetPolyData()) //Allow function to run with nullptr as input
     {
         std::cout << "MarkSegmentWithID Error: No input" << std::endl;
         return;
     }
     
     auto polydata = segment->GetPolyData();
-    int numberOfPoints = polydata->GetNumberOfPoints();
-    for(int i=0;i<numberOfPoints;i++) {
-        idArray->InsertNextValue(segmentId);
-    }
+    auto idArray = vtkSmartPointer<vtkIntArray>::New();
+    idArray->SetName("segmentId");
+    idArray->SetNumberOfValues(polydata->GetNumberOfPoints());
+    idArray->FillValue(segmentId);
     polydata->GetPointData()->SetScalars(idArray);
 }
 
@@ -113,17 +177,87 @@ void vtkLiverSegmentsLogic::AddSegmentToCenterlineModel(vtkMRMLModelNode *summed
         std::cout << "AddSegmentToCenterlineModel Error: No input" << std::endl;
         return;
     }
+    if(!summedCenterline->GetID())
+    {
+        std::cout << "AddSegmentToCenterlineModel Error: Summed centerline model is not in a scene" << std::endl;
+        return;
+    }
     auto segment = segmentCenterline->GetPolyData();
     auto centerlineModel = summedCenterline->GetPolyData();
+    if(!segment)
+    {
+        std::cout << "AddSegmentToCenterlineModel Error: No segment PolyData" << std::endl;
+        return;
+    }
+
+    // Start accumulating on a new summed model (or one whose polydata was
+    // replaced), keeping what it already holds. The models built before keep
+    // their own accumulators.
+    CenterlineModel *model = this->FindCenterlineModel(summedCenterline);
+    if(!model)
+    {
+        auto accumulator = vtkSmartPointer<vtkCenterlineAccumulator>::New();
+        if(centerlineModel && centerlineModel->GetNumberOfPoints() > 0)
+            accumulator->AddSegment(centerlineModel);
+        model = &this->CenterlineModels[summedCenterline->GetID()];
+        model->Accumulator = accumulator;
+        model->Blocks.clear();
+    }
+
+    std::string segmentKey = segmentCenterline->GetID() ? segmentCenterline->GetID() : "";
+    auto block = model->Blocks.find(segmentKey);
+    if(!segmentKey.empty() && block != model->Blocks.end()
+       && model->Accumulator->ReplaceSegment(block->second, segment))
+    {
+        // Segment updated in place
+    }
+    else
+    {
+        int blockId = model->Accumulator->AddSegment(segment);
+        if(!segmentKey.empty())
+            model->Blocks[segmentKey] = blockId;
+    }
 
-    auto summedModel = vtkSmartPointer<vtkPolyData>::New();
-    auto appendFilter = vtkSmartPointer<vtkAppendPolyData>::New();
-    appendFilter->AddInputData(centerlineModel);
-    appendFilter->AddInputData(segment);
-    summedModel = appendFilter->GetOutput();
-    appendFilter->Update();
+    if(summedCenterline->GetPolyData() != model->Accumulator->GetOutput())
+        summedCenterline->SetAndObservePolyData(model->Accumulator->GetOutput());
+}
+
+void vtkLiverSegmentsLogic::RemoveSegmentFromCenterlineModel(vtkMRMLModelNode *summedCenterline, vtkMRMLModelNode *segmentCenterline)
+{
+    if(!summedCenterline || !segmentCenterline || !segmentCenterline->GetID()) //Allow function to run with nullptr as input
+    {
+        std::cout << "RemoveSegmentFromCenterlineModel Error: No input" << std::endl;
+        return;
+    }
+    CenterlineModel *model = this->FindCenterlineModel(summedCenterline);
+    if(!model)
+    {
+        std::cout << "RemoveSegmentFromCenterlineModel Error: Centerline model was not built by this logic" << std::endl;
+        return;
+    }
+
+    auto block = model->Blocks.find(segmentCenterline->GetID());
+    if(block == model->Blocks.end())
+        return;
+    model->Accumulator->RemoveSegment(block->second);
+    model->Blocks.erase(block);
+}
 
-    summedCenterline->SetAndObservePolyData(summedModel);
+vtkLiverSegmentsLogic::CenterlineModel *vtkLiverSegmentsLogic::FindCenterlineModel(vtkMRMLModelNode *summedCenterline)
+{
+    if(!summedCenterline || !summedCenterline->GetID())
+        return nullptr;
+    auto model = this->CenterlineModels.find(summedCenterline->GetID());
+    if(model == this->CenterlineModels.end()
+       || summedCenterline->GetPolyData() != model->second.Accumulator->GetOutput())
+        return nullptr;
+    return &model->second;
+}
+
+bool vtkLiverSegmentsLogic::IsTerritoryEngineModel(vtkMRMLModelNode *summedCenterline)
+{
+    vtkCenterlineAccumulator *accumulator = this->TerritoryEngine->GetCenterlineAccumulator();
+    return accumulator && summedCenterline && summedCenterline->GetPolyData() == accumulator->GetOutput();
 }
 
 int vtkLiverSegmentsLogic::SegmentClassificationProcessing(vtkMRMLModelNode *centerlineModel, vtkMRMLLabelMapVolumeNode *labelMap)
@@ -138,7 +272,23 @@ int vtkLiverSegmentsLogic::SegmentClassificationProcessing(vtkMRMLModelNode *cen
     
     labelMap->GetIJKToRASMatrix(ijkToRas);
 
+    return this->ClassifyLabelmapVoxels(centerlineModel, labelMap->GetImageData(), ijkToRas);
+}
+
+int vtkLiverSegmentsLogic::ClassifyLabelmapVoxels(vtkMRMLModelNode *centerlineModel, vtkImageData *imageData,
+                                                  vtkMatrix4x4 *ijkToRas, std::set<int> *assignedLabels)
+{
+    if(!centerlineModel || !imageData || !ijkToRas)
+    {
+        std::cout << "ClassifyLabelmapVoxels Error: No input" << std::endl;
+        return 0;
+    }
+
     auto centerlinePolyData = centerlineModel->GetPolyData();
+    if(centerlinePolyData == nullptr) {
+        std::cout << "Error: No PolyData in centerline model" << std::endl;
+        return 0;
+    }
     auto pointData = centerlinePolyData->GetPointData();
 
     auto centerlineSegmentIDs = vtkIntArray::SafeDownCast(pointData->GetScalars());
@@ -148,15 +298,39 @@ int vtkLiverSegmentsLogic::SegmentClassificationProcessing(vtkMRMLModelNode *cen
         return 0;
     }
 
-    auto imageData = labelMap->GetImageData();
+    if(imageData->GetScalarType() != VTK_SHORT || imageData->GetNumberOfScalarComponents() != 1) {
+        std::cout << "Error: Labelmap voxels are expected to be single component short" << std::endl;
+        return 0;
+    }
+
+    bool useAccumulator = this->UseCenterlineAccumulator && this->IsTerritoryEngineModel(centerlineModel);
+
+    // Accumulated models are classified by the territory engine, which keeps
+    // the state needed to update the territories after a segment edit
+    if(useAccumulator)
+    {
+        if(!this->TerritoryEngine->Classify(imageData, ijkToRas))
+            return 0;
+        if(assignedLabels)
+        {
+            vtkNew<vtkIntArray> labels;
+            this->TerritoryEngine->GetLabels(labels);
+            for(vtkIdType i = 0; i < labels->GetNumberOfValues(); ++i)
+                assignedLabels->insert(labels->GetValue(i));
+        }
+        return 1;
+    }
+
     int extent[6];
     imageData->GetExtent(extent);
 
     for (int z=extent[4]; z<=extent[5]; z++)
         for(int y=extent[2]; y<=extent[3]; y++)
-            for(int x=extent[0]; x<=extent[1]; x++)
+        {
+            // Rows are contiguous, so only the first voxel of each row needs a pointer lookup
+            auto label = static_cast<short*>(imageData->GetScalarPointer(extent[0],y,z));
+            for(int x=extent[0]; x<=extent[1]; x++, label++)
             {
-                auto label = static_cast<short*>(imageData->GetScalarPointer(x,y,z));
                 if(*label==1) {
                     double position_IJK[4];
                     position_IJK[0] = static_cast<double>(x);
@@ -166,25 +340,47 @@ int vtkLiverSegmentsLogic::SegmentClassificationProcessing(vtkMRMLModelNode *cen
                     double position_RAS[4];
                     ijkToRas->MultiplyPoint(position_IJK, position_RAS);
                     double vtkVoxelPoint[3] = {position_RAS[0], position_RAS[1], position_RAS[2]};
-                    double vtkCenterlinePoint[3];
                     vtkIdType id = this->Locator->FindClosestPoint(vtkVoxelPoint);
-                    centerlinePolyData->GetPoint(id, vtkCenterlinePoint);
-                    *label = centerlineSegmentIDs->GetTuple1(id);
+                    if(id < 0)
+                        continue;
+                    *label = centerlineSegmentIDs->GetValue(id);
+                    if(assignedLabels)
+                        assignedLabels->insert(*label);
                 }
             }
+        }
 
+    imageData->Modified();
     return 1;
 }
 
 void vtkLiverSegmentsLogic::InitializeCenterlineSearchModel(vtkMRMLModelNode *summedCenterline)
 {
     this->Locator->Initialize();
+    this->UseCenterlineAccumulator = false;
     if(!summedCenterline) //Allow function to run with nullptr as input
     {
         std::cout << "InitializeCenterlineSearchModel Error: No input" << std::endl;
         return;
     }
     auto centerlineModel = summedCenterline->GetPolyData();
+    if(!centerlineModel)
+    {
+        std::cout << "InitializeCenterlineSearchModel Error: No PolyData in centerline model" << std::endl;
+        return;
+    }
+
+    // Accumulated models keep one locator per segment and only rebuild the
+    // locators of the segments that changed
+    CenterlineModel *model = this->FindCenterlineModel(summedCenterline);
+    if(model)
+    {
+        model->Accumulator->BuildLocators();
+        this->TerritoryEngine->SetCenterlineAccumulator(model->Accumulator);
+        this->UseCenterlineAccumulator = true;
+        return;
+    }
+
     this->Locator->SetDataSet(vtkPointSet::SafeDownCast(centerlineModel));
     if(centerlineModel->GetPointData()->GetNumberOfArrays() > 0)
         this->Locator->BuildLocator();
@@ -198,40 +394,63 @@ void vtkLiverSegmentsLogic::calculateVascularTerritoryMap(vtkMRMLSegmentationNod
                                                           vtkMRMLModelNode *centerlineModel,
                                                           vtkMRMLColorNode *colormap)
 {
-    vtkMRMLScene *mrmlScene = this->GetMRMLScene();
-
-    if (!mrmlScene)
-        vtkErrorMacro("Error in calculateVascularTerritoryMap: no valid MRML scene.");
-
-  vtkMRMLNode *labelmapNode = mrmlScene->AddNewNodeByClass("vtkMRMLLabelMapVolumeNode");
-  vtkMRMLLabelMapVolumeNode *labelmapVolumeNode = vtkMRMLLabelMapVolumeNode::SafeDownCast(labelmapNode);
-  auto segmentationIds = vtkSmartPointer<vtkStringArray>::New();
-  
-  if(!vascularTerritorySegmentationNode || !segmentation || !colormap)
+  if(!vascularTerritorySegmentationNode || !refVolume || !refVolume->GetImageData()
+     || !segmentation || !centerlineModel || !colormap)
   {
     std::cout << "calculateVascularTerritoryMap Error: No input" << std::endl;
     return;
   }
 
   //Get voxels tagged as liver
-  std::string segmentId = segmentation->GetSegmentation()->GetSegmentIdBySegmentName("liver");
-  //Check metadata for segmentation
   vtkSegmentation* segm = segmentation->GetSegmentation();
-  int numberOfSegments = segm->GetNumberOfSegments();
-  std::cout << "Liver segmentId: "  << segmentId << " numberOfSegments: " << numberOfSegments << std::endl;
+  std::string segmentId = segm->GetSegmentIdBySegmentName("liver");
+  if(segmentId.empty())
+  {
+    std::cout << "calculateVascularTerritoryMap Error: No liver segment in the input segmentation" << std::endl;
+    return;
+  }
 
-  vtkSegment *liverSegm = segm->GetSegment(segmentId);
-  if(liverSegm)
-      std::cout << "Segment name: "  << liverSegm->GetName() << " Segment label: " << liverSegm->GetLabelValue() << std::endl;
+  // The liver mask is rasterized directly on the reference volume geometry and
+  // classified in place. The same image is then shared by all the territory
+  // segments as one binary labelmap layer, so no intermediate labelmap node is
+  // added to the scene and the voxels are neither copied nor split per segment.
+  auto ijkToRas = vtkSmartPointer<vtkMatrix4x4>::New();
+  refVolume->GetIJKToRASMatrix(ijkToRas);
+  auto referenceGeometry = vtkSmartPointer<vtkOrientedImageData>::New();
+  referenceGeometry->SetExtent(refVolume->GetImageData()->GetExtent());
+  referenceGeometry->SetImageToWorldMatrix(ijkToRas);
 
+  auto segmentationIds = vtkSmartPointer<vtkStringArray>::New();
   segmentationIds->InsertNextValue(segmentId);
-  vtkSlicerSegmentationsModuleLogic::ExportSegmentsToLabelmapNode(segmentation, segmentationIds, labelmapVolumeNode, refVolume);
-  int result = SegmentClassificationProcessing(centerlineModel, labelmapVolumeNode);
+  auto territoryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  if(!segmentation->GenerateMergedLabelmapForAllSegments(territoryLabelmap, vtkSegmentation::EXTENT_REFERENCE_GEOMETRY,
+                                                         referenceGeometry, segmentationIds))
+  {
+    vtkErrorMacro("Error in calculateVascularTerritoryMap: failed to rasterize the liver segment.");
+    return;
+  }
+
+  if(territoryLabelmap->GetScalarType() != VTK_SHORT)
+  {
+    auto imageCast = vtkSmartPointer<vtkImageCast>::New();
+    imageCast->SetInputData(territoryLabelmap);
+    imageCast->SetOutputScalarTypeToShort();
+    imageCast->Update();
+    auto castLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    castLabelmap->ShallowCopy(imageCast->GetOutput());
+    castLabelmap->CopyDirections(territoryLabelmap);
+    territoryLabelmap = castLabelmap;
+  }
+
+  territoryLabelmap->GetImageToWorldMatrix(ijkToRas);
+  std::set<int> territoryLabels;
+  int result = this->ClassifyLabelmapVoxels(centerlineModel, territoryLabelmap, ijkToRas, &territoryLabels);
   if(result == 0)
+  {
     vtkErrorMacro("Corrupt centerline model - Not possible to calculate vascular segments.");
-  labelmapVolumeNode->GetDisplayNode()->SetAndObserveColorNodeID(colormap->GetID());
-  //slicer.util.arrayFromVolumeModified(labelmapVolumeNode)
-  labelmapVolumeNode->Modified();//Is this enough, or is more of the code in arrayFromVolumeModified needed?
+    return;
+  }
+
   const char * segmentationId = vascularTerritorySegmentationNode->GetAttribute("LiverSegments.SegmentationId");
   std::string segmentationIdCopy;
   if (segmentationId)
@@ -240,16 +459,251 @@ void vtkLiverSegmentsLogic::calculateVascularTerritoryMap(vtkMRMLSegmentationNod
   }
 
   vascularTerritorySegmentationNode->Reset(nullptr);
-  vascularTerritorySegmentationNode->SetAttribute("LiverSegments.SegmentationId", segmentationId);
   vascularTerritorySegmentationNode->CreateDefaultDisplayNodes(); // only needed for display
-  vtkSlicerSegmentationsModuleLogic::ImportLabelmapToSegmentationNode(labelmapVolumeNode, vascularTerritorySegmentationNode);
-  vascularTerritorySegmentationNode->CreateClosedSurfaceRepresentation();
+
+  vtkSegmentation *territories = vascularTerritorySegmentationNode->GetSegmentation();
+  territories->SetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName(),
+                                      vtkSegmentationConverter::SerializeImageGeometry(territoryLabelmap));
+
+  this->TerritoryColormap = colormap;
+  for(int label : territoryLabels)
+    this->AddTerritorySegment(vascularTerritorySegmentationNode, territoryLabelmap, label);
+
+  this->SurfaceEngine->SetInputLabelmap(territoryLabelmap);
+  this->GenerateTerritorySurfaces(vascularTerritorySegmentationNode, this->DeferTerritorySurfaces);
+
+  if (this->DeferTerritorySurfaces)
+  {
+    auto displayNode = vascularTerritorySegmentationNode->GetDisplayNode();
+    if (displayNode)
+    {
+      vtkNew<vtkIntArray> displayNodeEvents;
+      displayNodeEvents->InsertNextValue(vtkCommand::ModifiedEvent);
+      vtkUnObserveMRMLNodeMacro(displayNode);
+      vtkObserveMRMLNodeEventsMacro(displayNode, displayNodeEvents.GetPointer());
+    }
+  }
 
   if (!segmentationIdCopy.empty())
   {
     vascularTerritorySegmentationNode->SetAttribute("LiverSegments.SegmentationId", segmentationIdCopy.c_str());
   }
-  mrmlScene->RemoveNode(labelmapVolumeNode);
+}
+
+void vtkLiverSegmentsLogic::AddTerritorySegment(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode,
+                                                vtkOrientedImageData *territoryLabelmap, int label)
+{
+  if(label <= 0)
+    return;
+
+  std::string segmentName;
+  const char *colorName = this->TerritoryColormap ? this->TerritoryColormap->GetColorName(label) : nullptr;
+  if(colorName && colorName[0] != '\0')
+    segmentName = colorName;
+  else
+    segmentName = "Label_" + std::to_string(label);
+
+  double color[4] = {0.5, 0.5, 0.5, 1.0};
+  if(this->TerritoryColormap)
+    this->TerritoryColormap->GetColor(label, color);
+
+  vtkSegmentation *territories = vascularTerritorySegmentationNode->GetSegmentation();
+  auto segment = vtkSmartPointer<vtkSegment>::New();
+  segment->SetName(segmentName.c_str());
+  segment->SetColor(color[0], color[1], color[2]);
+  segment->SetLabelValue(label);
+  segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), territoryLabelmap);
+  territories->AddSegment(segment, territories->GenerateUniqueSegmentID(segmentName));
+}
+
+int vtkLiverSegmentsLogic::UpdateVascularTerritoryMap(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode,
+                                                      vtkMRMLModelNode *summedCenterline,
+                                                      vtkMRMLModelNode *segmentCenterline)
+{
+  if(!vascularTerritorySegmentationNode || !summedCenterline || !segmentCenterline
+     || !segmentCenterline->GetID() || !segmentCenterline->GetPolyData())
+  {
+    std::cout << "UpdateVascularTerritoryMap Error: No input" << std::endl;
+    return 0;
+  }
+  if(!this->TerritoryEngine->IsInitialized() || !this->IsTerritoryEngineModel(summedCenterline))
+  {
+    std::cout << "UpdateVascularTerritoryMap Error: No vascular territory map to update" << std::endl;
+    return 0;
+  }
+
+  CenterlineModel *model = this->FindCenterlineModel(summedCenterline);
+  if(!model)
+  {
+    std::cout << "UpdateVascularTerritoryMap Error: Centerline model was not built by this logic" << std::endl;
+    return 0;
+  }
+  bool replaced = model->Blocks.count(segmentCenterline->GetID()) > 0;
+  this->AddSegmentToCenterlineModel(summedCenterline, segmentCenterline);
+  int blockId = model->Blocks[segmentCenterline->GetID()];
+
+  // The territory labelmap is relabelled in place. The segmentation is not
+  // notified, as it would drop and reconvert the representations of every
+  // territory. UpdateTerritorySegments only updates the modified ones.
+  vtkSegmentation *territories = vascularTerritorySegmentationNode->GetSegmentation();
+  bool sourceModifiedEnabled = territories->SetSourceRepresentationModifiedEnabled(false);
+  int result = replaced ? this->TerritoryEngine->UpdateBlockReplaced(blockId)
+                        : this->TerritoryEngine->UpdateBlockAdded(blockId);
+  territories->SetSourceRepresentationModifiedEnabled(sourceModifiedEnabled);
+  if(result == 0)
+    return 0;
+
+  return this->UpdateTerritorySegments(vascularTerritorySegmentationNode);
+}
+
+int vtkLiverSegmentsLogic::RemoveSegmentFromVascularTerritoryMap(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode,
+                                                                 vtkMRMLModelNode *summedCenterline,
+                                                                 vtkMRMLModelNode *segmentCenterline)
+{
+  if(!vascularTerritorySegmentationNode || !summedCenterline || !segmentCenterline || !segmentCenterline->GetID())
+  {
+    std::cout << "RemoveSegmentFromVascularTerritoryMap Error: No input" << std::endl;
+    return 0;
+  }
+  if(!this->TerritoryEngine->IsInitialized() || !this->IsTerritoryEngineModel(summedCenterline))
+  {
+    std::cout << "RemoveSegmentFromVascularTerritoryMap Error: No vascular territory map to update" << std::endl;
+    return 0;
+  }
+
+  CenterlineModel *model = this->FindCenterlineModel(summedCenterline);
+  if(!model)
+  {
+    std::cout << "RemoveSegmentFromVascularTerritoryMap Error: Centerline model was not built by this logic" << std::endl;
+    return 0;
+  }
+  auto block = model->Blocks.find(segmentCenterline->GetID());
+  if(block == model->Blocks.end())
+    return 1;
+  int blockId = block->second;
+
+  this->RemoveSegmentFromCenterlineModel(summedCenterline, segmentCenterline);
+
+  // Relabelled in place without notifying the segmentation, as in UpdateVascularTerritoryMap
+  vtkSegmentation *territories = vascularTerritorySegmentationNode->GetSegmentation();
+  bool sourceModifiedEnabled = territories->SetSourceRepresentationModifiedEnabled(false);
+  int result = this->TerritoryEngine->UpdateBlockRemoved(blockId);
+  territories->SetSourceRepresentationModifiedEnabled(sourceModifiedEnabled);
+  if(result == 0)
+    return 0;
+
+  return this->UpdateTerritorySegments(vascularTerritorySegmentationNode);
+}
+
+int vtkLiverSegmentsLogic::UpdateTerritorySegments(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode)
+{
+  auto territoryLabelmap = vtkOrientedImageData::SafeDownCast(this->TerritoryEngine->GetLabelmap());
+  vtkSegmentation *territories = vascularTerritorySegmentationNode->GetSegmentation();
+  if(!territoryLabelmap || !territories)
+  {
+    std::cout << "UpdateTerritorySegments Error: No territory labelmap" << std::endl;
+    return 0;
+  }
+
+  vtkNew<vtkIntArray> modifiedLabels;
+  this->TerritoryEngine->GetModifiedLabels(modifiedLabels);
+  if(modifiedLabels->GetNumberOfValues() == 0)
+    return 1;
+
+  // Only the surfaces of the territories that gained or lost voxels are
+  // dropped, the rest of the cached surfaces remain valid
+  if(this->SurfaceEngine->GetInputLabelmap() == territoryLabelmap)
+    this->SurfaceEngine->InvalidateSurfaces(modifiedLabels);
+
+  // Territory segments stored in the engine labelmap, by label
+  const std::string closedSurfaceName = vtkSegmentationConverter::GetClosedSurfaceRepresentationName();
+  std::map<int, std::string> territorySegments;
+  std::vector<std::string> segmentIds;
+  territories->GetSegmentIDs(segmentIds);
+  for(const std::string &segmentId : segmentIds)
+  {
+    vtkSegment *segment = territories->GetSegment(segmentId);
+    if(segment && segment->GetRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()) == territoryLabelmap)
+      territorySegments[segment->GetLabelValue()] = segmentId;
+  }
+
+  for(vtkIdType i = 0; i < modifiedLabels->GetNumberOfValues(); ++i)
+  {
+    int label = modifiedLabels->GetValue(i);
+    if(label <= 0)
+      continue;
+
+    auto territorySegment = territorySegments.find(label);
+    std::string segmentId = territorySegment != territorySegments.end() ? territorySegment->second : "";
+    if(segmentId.empty())
+    {
+      if(this->TerritoryEngine->GetLabelVoxelCount(label) > 0)
+        this->AddTerritorySegment(vascularTerritorySegmentationNode, territoryLabelmap, label);
+    }
+    else if(this->TerritoryEngine->GetLabelVoxelCount(label) == 0)
+    {
+      territories->RemoveSegment(segmentId);
+    }
+    else
+    {
+      territories->GetSegment(segmentId)->RemoveRepresentation(closedSurfaceName);
+      territories->InvokeEvent(vtkSegmentation::RepresentationModified, const_cast<char*>(segmentId.c_str()));
+    }
+  }
+
+  return this->GenerateTerritorySurfaces(vascularTerritorySegmentationNode, this->DeferTerritorySurfaces);
+}
+
+int vtkLiverSegmentsLogic::GenerateTerritorySurfaces(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode, bool onlyVisible)
+{
+  if(!vascularTerritorySegmentationNode || !vascularTerritorySegmentationNode->GetSegmentation())
+  {
+    std::cout << "GenerateTerritorySurfaces Error: No input" << std::endl;
+    return 0;
+  }
+
+  auto displayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(vascularTerritorySegmentationNode->GetDisplayNode());
+  if(onlyVisible && (!displayNode || !displayNode->GetVisibility() || !displayNode->GetVisibility3D()))
+    return 1;
+
+  const std::string closedSurfaceName = vtkSegmentationConverter::GetClosedSurfaceRepresentationName();
+  const std::string binaryLabelmapName = vtkSegmentationConverter::GetBinaryLabelmapRepresentationName();
+
+  // Segments still missing a surface, grouped by the labelmap layer they share
+  vtkSegmentation *territories = vascularTerritorySegmentationNode->GetSegmentation();
+  std::vector<std::string> segmentIds;
+  territories->GetSegmentIDs(segmentIds);
+  std::map<vtkOrientedImageData*, std::vector<std::string>> pendingSegments;
+  for(const std::string &segmentId : segmentIds)
+  {
+    vtkSegment *segment = territories->GetSegment(segmentId);
+    if(!segment || segment->GetRepresentation(closedSurfaceName))
+      continue;
+    if(onlyVisible && !displayNode->GetSegmentVisibility3D(segmentId))
+      continue;
+    auto labelmap = vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(binaryLabelmapName));
+    if(labelmap)
+      pendingSegments[labelmap].push_back(segmentId);
+  }
+
+  for(const auto &layer : pendingSegments)
+  {
+    this->SurfaceEngine->SetInputLabelmap(layer.first);
+    vtkNew<vtkIntArray> labels;
+    for(const std::string &segmentId : layer.second)
+      labels->InsertNextValue(territories->GetSegment(segmentId)->GetLabelValue());
+    this->SurfaceEngine->GenerateSurfaces(labels);
+
+    for(const std::string &segmentId : layer.second)
+    {
+      vtkSegment *segment = territories->GetSegment(segmentId);
+      vtkPolyData *surface = this->SurfaceEngine->GetSurface(segment->GetLabelValue());
+      if(surface)
+        segment->AddRepresentation(closedSurfaceName, surface);
+    }
+  }
+
+  return 1;
 }
 
 void vtkLiverSegmentsLogic::preprocessAndDecimate(vtkPolyData *surfacePolyData, vtkPolyData *returnPolyData)
@@ -265,34 +719,15 @@ void vtkLiverSegmentsLogic::preprocessAndDecimate(vtkPolyData *surfacePolyData,
         return;
     }
 
-    vtkSmartPointer<vtkDecimatePro> decimator = vtkSmartPointer<vtkDecimatePro>::New();
+    // Decimation, cleaning, triangulation and normals in a single parallel pass
+    vtkSmartPointer<vtkParallelQuadricDecimation> decimator = vtkSmartPointer<vtkParallelQuadricDecimation>::New();
     double decimationFactor = 0.8;
     decimator->SetInputData(surfacePolyData);
-    decimator->SetFeatureAngle(60);
-    decimator->SplittingOff();
-    decimator->PreserveTopologyOn();
-    decimator->SetMaximumError(1);
-
     decimator->SetTargetReduction(decimationFactor);
+    decimator->SetMaximumError(1.0);
+    decimator->ComputeNormalsOn();
+    decimator->AutoOrientNormalsOn();
     decimator->Update();
 
-    vtkSmartPointer<vtkCleanPolyData> surfaceCleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-    surfaceCleaner->SetInputData(decimator->GetOutput());
-    surfaceCleaner->Update();
-
-    vtkSmartPointer<vtkTriangleFilter> surfaceTriangulator = vtkSmartPointer<vtkTriangleFilter>::New();
-    surfaceTriangulator->SetInputData(surfaceCleaner->GetOutput());
-    surfaceTriangulator->PassLinesOff();
-    surfaceTriangulator->PassVertsOff();
-    surfaceTriangulator->Update();
-
-    vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-    normals->SetInputData(surfaceTriangulator->GetOutput());
-    normals->SetAutoOrientNormals(1);
-    normals->SetFlipNormals(0);
-    normals->SetConsistency(1);
-    normals->SplittingOff();
-    normals->Update();
-
-    returnPolyData->ShallowCopy(normals->GetOutput());
+    returnPolyData->ShallowCopy(decimator->GetOutput());
 }
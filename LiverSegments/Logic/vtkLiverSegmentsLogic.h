@@ -49,14 +49,24 @@
 #include <vtkObject.h>
 #include <vtkSmartPointer.h>
 
+#include <map>
+#include <set>
+#include <string>
+
 // Forward delcarations
+class vtkCenterlineAccumulator;
 class vtkKdTreePointLocator;
+class vtkVascularTerritoryEngine;
+class vtkVascularTerritorySurfaceEngine;
 class vtkMRMLLabelMapVolumeNode;
 class vtkMRMLSegmentationNode;
 class vtkMRMLModelNode;
 class vtkMRMLColorNode;
 class vtkMRMLScalarVolumeNode;
 class vtkPolyData;
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkOrientedImageData;
 
 
 class VTK_SLICER_LIVERSEGMENTS_MODULE_LOGIC_EXPORT
@@ -64,6 +74,21 @@ vtkLiverSegmentsLogic : public vtkSlicerModuleLogic
 {
  private:
     vtkSmartPointer<vtkKdTreePointLocator> Locator;
+    // Every summed centerline model built by the logic has its own accumulator
+    // (keyed by the summed model node ID, released when the node is removed)
+    // with the accumulator block of each of its segment centerline models (by
+    // node ID)
+    struct CenterlineModel
+    {
+        vtkSmartPointer<vtkCenterlineAccumulator> Accumulator;
+        std::map<std::string, int> Blocks;
+    };
+    std::map<std::string, CenterlineModel> CenterlineModels;
+    bool UseCenterlineAccumulator;
+    vtkSmartPointer<vtkVascularTerritoryEngine> TerritoryEngine;
+    vtkSmartPointer<vtkMRMLColorNode> TerritoryColormap;
+    vtkSmartPointer<vtkVascularTerritorySurfaceEngine> SurfaceEngine;
+    bool DeferTerritorySurfaces;
 
  public:
   static vtkLiverSegmentsLogic *New();
@@ -72,7 +97,11 @@ vtkLiverSegmentsLogic : public vtkSlicerModuleLogic
 
  public:
   void MarkSegmentWithID(vtkMRMLModelNode *segment, int segmentId);
+  // Appends (or replaces, if it was already added) a segment centerline to the
+  // summed centerline model. The summed model polydata is updated in place.
   void AddSegmentToCenterlineModel(vtkMRMLModelNode *summedCenterline, vtkMRMLModelNode *segmentCenterline);
+  // Removes a segment centerline previously added to the summed centerline model
+  void RemoveSegmentFromCenterlineModel(vtkMRMLModelNode *summedCenterline, vtkMRMLModelNode *segmentCenterline);
   int  SegmentClassificationProcessing(vtkMRMLModelNode *centerlineModel, vtkMRMLLabelMapVolumeNode *labelMap);
   void InitializeCenterlineSearchModel(vtkMRMLModelNode *summedCenterline);
   void calculateVascularTerritoryMap(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode,
@@ -82,6 +111,60 @@ vtkLiverSegmentsLogic : public vtkSlicerModuleLogic
                                      vtkMRMLColorNode *colormap);
   void preprocessAndDecimate(vtkPolyData *surfacePolyData, vtkPolyData *returnPolyData);
 
+  // Adds or replaces a segment centerline in the summed centerline model and
+  // updates the territories computed by the last calculateVascularTerritoryMap
+  // call. Only the voxels that the edited segment can affect are evaluated and
+  // only the surfaces of the territories that changed are regenerated. Returns
+  // 0 if there is no territory map to update.
+  int UpdateVascularTerritoryMap(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode,
+                                 vtkMRMLModelNode *summedCenterline,
+                                 vtkMRMLModelNode *segmentCenterline);
+  // Removes a segment centerline from the summed centerline model and updates
+  // the territories as UpdateVascularTerritoryMap does
+  int RemoveSegmentFromVascularTerritoryMap(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode,
+                                            vtkMRMLModelNode *summedCenterline,
+                                            vtkMRMLModelNode *segmentCenterline);
+
+  // When enabled, calculateVascularTerritoryMap only generates the closed
+  // surfaces of the territories visible in 3D. The remaining ones are
+  // generated when they are shown.
+  vtkSetMacro(DeferTerritorySurfaces, bool);
+  vtkGetMacro(DeferTerritorySurfaces, bool);
+  vtkBooleanMacro(DeferTerritorySurfaces, bool);
+
+  // Generates the missing closed surfaces of a vascular territory segmentation
+  // in parallel, either for all the territories or only for those visible in
+  // 3D. Returns 0 on invalid input.
+  int GenerateTerritorySurfaces(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode, bool onlyVisible = false);
+
+ protected:
+  void SetMRMLSceneInternal(vtkMRMLScene *newScene) override;
+  void OnMRMLSceneNodeRemoved(vtkMRMLNode *node) override;
+  void OnMRMLSceneEndClose() override;
+  void ProcessMRMLNodesEvents(vtkObject *caller, unsigned long event, void *callData) override;
+
+  // Assigns every voxel labelled 1 in imageData (short scalars) the segment id of
+  // the closest centerline point. The locator must have been initialized with
+  // InitializeCenterlineSearchModel. The assigned labels are collected in
+  // assignedLabels when provided.
+  int ClassifyLabelmapVoxels(vtkMRMLModelNode *centerlineModel, vtkImageData *imageData,
+                             vtkMatrix4x4 *ijkToRas, std::set<int> *assignedLabels = nullptr);
+
+  // Adds the territory of a label as a segment sharing the territory labelmap
+  void AddTerritorySegment(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode,
+                           vtkOrientedImageData *territoryLabelmap, int label);
+
+  // Brings the territory segments in line with the labels modified by the
+  // last incremental update of the territory engine
+  int UpdateTerritorySegments(vtkMRMLSegmentationNode *vascularTerritorySegmentationNode);
+
+  // Returns the accumulated model of the given summed centerline model node,
+  // or nullptr if the logic did not build its current polydata
+  CenterlineModel *FindCenterlineModel(vtkMRMLModelNode *summedCenterline);
+
+  // True if the territory engine works on the given summed centerline model
+  bool IsTerritoryEngineModel(vtkMRMLModelNode *summedCenterline);
+
  protected:
   vtkLiverSegmentsLogic();
   ~vtkLiverSegmentsLogic() override;
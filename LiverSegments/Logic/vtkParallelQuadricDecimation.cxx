@@ -0,0 +1,838 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#include "vtkParallelQuadricDecimation.h"
+
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkFloatArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+// Collapses are rejected when they turn a triangle normal by more than
+// about 80 degrees
+const double MinimumNormalCosine = 0.2;
+
+// Smallest number of triangles worth a partition of its own
+const vtkIdType MinimumTrianglesPerPartition = 20000;
+
+// Symmetric 4x4 matrix stored as its upper triangle:
+// aa ab ac ad bb bc bd cc cd dd
+using Quadric = std::array<double, 10>;
+
+//------------------------------------------------------------------------------
+void AddPlaneQuadric(const double p0[3], const double p1[3], const double p2[3], Quadric &q)
+{
+    double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    double n[3];
+    vtkMath::Cross(e1, e2, n);
+    if(vtkMath::Normalize(n) == 0.0)
+        return;
+    double d = -vtkMath::Dot(n, p0);
+    q[0] += n[0] * n[0]; q[1] += n[0] * n[1]; q[2] += n[0] * n[2]; q[3] += n[0] * d;
+    q[4] += n[1] * n[1]; q[5] += n[1] * n[2]; q[6] += n[1] * d;
+    q[7] += n[2] * n[2]; q[8] += n[2] * d;
+    q[9] += d * d;
+}
+
+//------------------------------------------------------------------------------
+double QuadricError(const Quadric &q, const double x[3])
+{
+    return q[0] * x[0] * x[0] + 2.0 * q[1] * x[0] * x[1] + 2.0 * q[2] * x[0] * x[2] + 2.0 * q[3] * x[0]
+         + q[4] * x[1] * x[1] + 2.0 * q[5] * x[1] * x[2] + 2.0 * q[6] * x[1]
+         + q[7] * x[2] * x[2] + 2.0 * q[8] * x[2]
+         + q[9];
+}
+
+//------------------------------------------------------------------------------
+// Position minimizing the quadric error. Returns false when the quadric is
+// (close to) singular, as it is on flat or cylindrical regions.
+bool OptimalPosition(const Quadric &q, double x[3])
+{
+    double a[3][3] = {{q[0], q[1], q[2]}, {q[1], q[4], q[5]}, {q[2], q[5], q[7]}};
+    double trace = q[0] + q[4] + q[7];
+    double determinant = vtkMath::Determinant3x3(a);
+    if(trace <= 0.0 || std::fabs(determinant) <= 1e-6 * trace * trace * trace)
+        return false;
+    double inverse[3][3];
+    vtkMath::Invert3x3(a, inverse);
+    double b[3] = {-q[3], -q[6], -q[8]};
+    vtkMath::Multiply3x3(inverse, b, x);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Unnormalized normal of triangle (p0, p1, p2)
+void TriangleNormal(const double p0[3], const double p1[3], const double p2[3], double n[3])
+{
+    double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    vtkMath::Cross(e1, e2, n);
+}
+
+//------------------------------------------------------------------------------
+// Part of the mesh simplified by one thread. Locked vertices are shared with
+// other partitions or lie on the mesh boundary and never move.
+struct MeshPartition
+{
+    std::vector<vtkIdType> GlobalIds;
+    std::vector<std::array<double, 3>> Positions;
+    std::vector<Quadric> Quadrics;
+    std::vector<char> Locked;
+    std::vector<char> RemovedVertices;
+    std::vector<std::array<int, 3>> Triangles;
+    std::vector<char> RemovedTriangles;
+};
+
+//------------------------------------------------------------------------------
+// Greedy quadric-error edge collapse on a partition
+class EdgeCollapser
+{
+ public:
+    explicit EdgeCollapser(MeshPartition &mesh) : Mesh(mesh), NumberOfTriangles(0) {}
+
+    void Run(vtkIdType targetTriangles, double maximumError2)
+    {
+        const int numberOfVertices = static_cast<int>(this->Mesh.Positions.size());
+        const int numberOfTriangles = static_cast<int>(this->Mesh.Triangles.size());
+        this->Mesh.RemovedVertices.assign(numberOfVertices, 0);
+        this->Mesh.RemovedTriangles.assign(numberOfTriangles, 0);
+        this->VertexTriangles.assign(numberOfVertices, std::vector<int>());
+        this->Stamps.assign(numberOfVertices, 0);
+        this->NumberOfTriangles = numberOfTriangles;
+
+        std::vector<std::pair<int, int>> edges;
+        edges.reserve(3 * numberOfTriangles);
+        for(int t = 0; t < numberOfTriangles; ++t)
+        {
+            const std::array<int, 3> &triangle = this->Mesh.Triangles[t];
+            for(int n = 0; n < 3; ++n)
+            {
+                this->VertexTriangles[triangle[n]].push_back(t);
+                int u = triangle[n];
+                int v = triangle[(n + 1) % 3];
+                edges.emplace_back(std::min(u, v), std::max(u, v));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        for(const auto &edge : edges)
+            this->PushEdge(edge.first, edge.second);
+
+        while(!this->Queue.empty() && this->NumberOfTriangles > targetTriangles)
+        {
+            Candidate candidate = this->Queue.top();
+            this->Queue.pop();
+            if(candidate.Error > maximumError2)
+                break;
+            this->Collapse(candidate);
+        }
+    }
+
+ private:
+    struct Candidate
+    {
+        double Error;
+        int A;
+        int B;
+        unsigned int StampA;
+        unsigned int StampB;
+        std::array<double, 3> Position;
+
+        // Smallest error first, vertex ids break ties deterministically
+        bool operator<(const Candidate &other) const
+        {
+            if(this->Error != other.Error)
+                return this->Error > other.Error;
+            if(this->A != other.A)
+                return this->A > other.A;
+            return this->B > other.B;
+        }
+    };
+
+    // Queues the collapse of edge (u, v). B is merged into A.
+    void PushEdge(int u, int v)
+    {
+        const std::vector<char> &locked = this->Mesh.Locked;
+        if(locked[u] && locked[v])
+            return;
+
+        Quadric q;
+        for(int i = 0; i < 10; ++i)
+            q[i] = this->Mesh.Quadrics[u][i] + this->Mesh.Quadrics[v][i];
+
+        Candidate candidate;
+        candidate.A = locked[v] ? v : u;
+        candidate.B = locked[v] ? u : v;
+        const double *pa = this->Mesh.Positions[candidate.A].data();
+        const double *pb = this->Mesh.Positions[candidate.B].data();
+        double *x = candidate.Position.data();
+
+        if(locked[candidate.A])
+        {
+            std::copy(pa, pa + 3, x);
+        }
+        else
+        {
+            // The optimal position is only trusted close to the edge
+            double midpoint[3] = {0.5 * (pa[0] + pb[0]), 0.5 * (pa[1] + pb[1]), 0.5 * (pa[2] + pb[2])};
+            double length2 = vtkMath::Distance2BetweenPoints(pa, pb);
+            if(!OptimalPosition(q, x) || vtkMath::Distance2BetweenPoints(x, midpoint) > 4.0 * length2)
+            {
+                const double *options[3] = {pa, pb, midpoint};
+                double best = VTK_DOUBLE_MAX;
+                for(const double *option : options)
+                {
+                    double error = QuadricError(q, option);
+                    if(error < best)
+                    {
+                        best = error;
+                        std::copy(option, option + 3, x);
+                    }
+                }
+            }
+        }
+
+        candidate.Error = std::max(0.0, QuadricError(q, x));
+        candidate.StampA = this->Stamps[candidate.A];
+        candidate.StampB = this->Stamps[candidate.B];
+        this->Queue.push(candidate);
+    }
+
+    bool Contains(int t, int v) const
+    {
+        const std::array<int, 3> &triangle = this->Mesh.Triangles[t];
+        return triangle[0] == v || triangle[1] == v || triangle[2] == v;
+    }
+
+    void GetNeighbours(int v, std::vector<int> &neighbours) const
+    {
+        neighbours.clear();
+        for(int t : this->VertexTriangles[v])
+            for(int w : this->Mesh.Triangles[t])
+                if(w != v)
+                    neighbours.push_back(w);
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    }
+
+    // Whether moving vertex v of triangle t to x flips or degenerates it
+    bool TriangleFlips(int t, int v, const double x[3]) const
+    {
+        const std::array<int, 3> &triangle = this->Mesh.Triangles[t];
+        const double *p[3];
+        const double *q[3];
+        for(int n = 0; n < 3; ++n)
+        {
+            p[n] = this->Mesh.Positions[triangle[n]].data();
+            q[n] = triangle[n] == v ? x : p[n];
+        }
+        double before[3];
+        double after[3];
+        TriangleNormal(p[0], p[1], p[2], before);
+        TriangleNormal(q[0], q[1], q[2], after);
+        double lengthBefore = vtkMath::Norm(before);
+        double lengthAfter = vtkMath::Norm(after);
+        if(lengthBefore == 0.0)
+            return false;
+        if(lengthAfter <= 1e-12 * lengthBefore)
+            return true;
+        return vtkMath::Dot(before, after) < MinimumNormalCosine * lengthBefore * lengthAfter;
+    }
+
+    bool Collapse(const Candidate &candidate)
+    {
+        const int a = candidate.A;
+        const int b = candidate.B;
+        if(this->Mesh.RemovedVertices[a] || this->Mesh.RemovedVertices[b]
+           || this->Stamps[a] != candidate.StampA || this->Stamps[b] != candidate.StampB)
+            return false;
+
+        // Only manifold edges whose endpoints share exactly the two opposite
+        // vertices can be collapsed without changing the topology
+        int shared = 0;
+        for(int t : this->VertexTriangles[b])
+            if(this->Contains(t, a))
+                shared++;
+        if(shared != 2)
+            return false;
+
+        this->GetNeighbours(a, this->NeighboursA);
+        this->GetNeighbours(b, this->NeighboursB);
+        std::vector<int> common;
+        std::set_intersection(this->NeighboursA.begin(), this->NeighboursA.end(),
+                              this->NeighboursB.begin(), this->NeighboursB.end(), std::back_inserter(common));
+        if(common.size() != 2)
+            return false;
+
+        // An opposite vertex with only three triangles would be left with
+        // two identical ones
+        if(this->VertexTriangles[common[0]].size() <= 3 || this->VertexTriangles[common[1]].size() <= 3)
+            return false;
+
+        const double *x = candidate.Position.data();
+        for(int t : this->VertexTriangles[b])
+            if(!this->Contains(t, a) && this->TriangleFlips(t, b, x))
+                return false;
+        for(int t : this->VertexTriangles[a])
+            if(!this->Contains(t, b) && this->TriangleFlips(t, a, x))
+                return false;
+
+        for(int i = 0; i < 10; ++i)
+            this->Mesh.Quadrics[a][i] += this->Mesh.Quadrics[b][i];
+        std::copy(x, x + 3, this->Mesh.Positions[a].begin());
+
+        for(int t : this->VertexTriangles[b])
+        {
+            std::array<int, 3> &triangle = this->Mesh.Triangles[t];
+            if(this->Contains(t, a))
+            {
+                this->Mesh.RemovedTriangles[t] = 1;
+                this->NumberOfTriangles--;
+                for(int w : triangle)
+                    if(w != b)
+                    {
+                        std::vector<int> &triangles = this->VertexTriangles[w];
+                        triangles.erase(std::remove(triangles.begin(), triangles.end(), t), triangles.end());
+                    }
+            }
+            else
+            {
+                std::replace(triangle.begin(), triangle.end(), b, a);
+                this->VertexTriangles[a].push_back(t);
+            }
+        }
+        this->VertexTriangles[b].clear();
+        this->Mesh.RemovedVertices[b] = 1;
+        this->Stamps[a]++;
+
+        this->GetNeighbours(a, this->NeighboursA);
+        for(int w : this->NeighboursA)
+            this->PushEdge(a, w);
+        return true;
+    }
+
+    MeshPartition &Mesh;
+    std::vector<std::vector<int>> VertexTriangles;
+    std::vector<unsigned int> Stamps;
+    std::priority_queue<Candidate> Queue;
+    std::vector<int> NeighboursA;
+    std::vector<int> NeighboursB;
+    vtkIdType NumberOfTriangles;
+};
+
+//------------------------------------------------------------------------------
+// Vertex to triangle adjacency (compressed rows)
+void BuildVertexTriangles(vtkIdType numberOfVertices, const std::vector<std::array<vtkIdType, 3>> &triangles,
+                          std::vector<vtkIdType> &offsets, std::vector<vtkIdType> &vertexTriangles)
+{
+    offsets.assign(numberOfVertices + 1, 0);
+    for(const auto &triangle : triangles)
+        for(vtkIdType v : triangle)
+            offsets[v + 1]++;
+    for(vtkIdType v = 0; v < numberOfVertices; ++v)
+        offsets[v + 1] += offsets[v];
+    vertexTriangles.resize(offsets[numberOfVertices]);
+    std::vector<vtkIdType> next(offsets.begin(), offsets.end() - 1);
+    for(vtkIdType t = 0; t < static_cast<vtkIdType>(triangles.size()); ++t)
+        for(vtkIdType v : triangles[t])
+            vertexTriangles[next[v]++] = t;
+}
+
+//------------------------------------------------------------------------------
+// Undirected edges (smaller id first) of the triangles, with their triangle,
+// sorted so that the uses of an edge are contiguous
+struct EdgeUse
+{
+    vtkIdType U;
+    vtkIdType V;
+    vtkIdType Triangle;
+    bool operator<(const EdgeUse &other) const
+    {
+        if(this->U != other.U)
+            return this->U < other.U;
+        if(this->V != other.V)
+            return this->V < other.V;
+        return this->Triangle < other.Triangle;
+    }
+};
+
+std::vector<EdgeUse> BuildEdgeUses(const std::vector<std::array<vtkIdType, 3>> &triangles)
+{
+    std::vector<EdgeUse> edges;
+    edges.reserve(3 * triangles.size());
+    for(vtkIdType t = 0; t < static_cast<vtkIdType>(triangles.size()); ++t)
+        for(int n = 0; n < 3; ++n)
+        {
+            vtkIdType u = triangles[t][n];
+            vtkIdType v = triangles[t][(n + 1) % 3];
+            edges.push_back({std::min(u, v), std::max(u, v), t});
+        }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+//------------------------------------------------------------------------------
+bool HasDirectedEdge(const std::array<vtkIdType, 3> &triangle, vtkIdType u, vtkIdType v)
+{
+    for(int n = 0; n < 3; ++n)
+        if(triangle[n] == u && triangle[(n + 1) % 3] == v)
+            return true;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Makes neighbouring triangles agree on their orientation and, when
+// requested, orients closed components outwards
+void OrientTriangles(const std::vector<std::array<double, 3>> &positions,
+                     std::vector<std::array<vtkIdType, 3>> &triangles, bool outwards)
+{
+    const vtkIdType numberOfTriangles = static_cast<vtkIdType>(triangles.size());
+    std::vector<EdgeUse> edges = BuildEdgeUses(triangles);
+
+    // Neighbours across manifold edges
+    std::vector<std::array<vtkIdType, 3>> neighbours(numberOfTriangles, {{-1, -1, -1}});
+    std::vector<char> open(numberOfTriangles, 0);
+    for(size_t begin = 0; begin < edges.size();)
+    {
+        size_t end = begin + 1;
+        while(end < edges.size() && edges[end].U == edges[begin].U && edges[end].V == edges[begin].V)
+            end++;
+        if(end - begin == 2)
+        {
+            vtkIdType t0 = edges[begin].Triangle;
+            vtkIdType t1 = edges[begin + 1].Triangle;
+            for(vtkIdType &neighbour : neighbours[t0])
+                if(neighbour < 0) { neighbour = t1; break; }
+            for(vtkIdType &neighbour : neighbours[t1])
+                if(neighbour < 0) { neighbour = t0; break; }
+        }
+        else
+        {
+            for(size_t e = begin; e < end; ++e)
+                open[edges[e].Triangle] = 1;
+        }
+        begin = end;
+    }
+
+    std::vector<char> visited(numberOfTriangles, 0);
+    std::vector<vtkIdType> component;
+    for(vtkIdType seed = 0; seed < numberOfTriangles; ++seed)
+    {
+        if(visited[seed])
+            continue;
+        visited[seed] = 1;
+        component.assign(1, seed);
+        bool closed = true;
+        for(size_t next = 0; next < component.size(); ++next)
+        {
+            vtkIdType t = component[next];
+            closed = closed && !open[t];
+            for(vtkIdType neighbour : neighbours[t])
+            {
+                if(neighbour < 0 || visited[neighbour])
+                    continue;
+                // Shared edge, traversed in opposite directions when consistent
+                for(int n = 0; n < 3; ++n)
+                {
+                    vtkIdType u = triangles[t][n];
+                    vtkIdType v = triangles[t][(n + 1) % 3];
+                    std::array<vtkIdType, 3> &other = triangles[neighbour];
+                    if(std::find(other.begin(), other.end(), u) == other.end()
+                       || std::find(other.begin(), other.end(), v) == other.end())
+                        continue;
+                    if(HasDirectedEdge(other, u, v))
+                        std::swap(other[1], other[2]);
+                    break;
+                }
+                visited[neighbour] = 1;
+                component.push_back(neighbour);
+            }
+        }
+
+        if(!outwards || !closed)
+            continue;
+        double volume = 0.0;
+        for(vtkIdType t : component)
+        {
+            double n[3];
+            const double *p0 = positions[triangles[t][0]].data();
+            vtkMath::Cross(positions[triangles[t][1]].data(), positions[triangles[t][2]].data(), n);
+            volume += vtkMath::Dot(p0, n);
+        }
+        if(volume < 0.0)
+            for(vtkIdType t : component)
+                std::swap(triangles[t][1], triangles[t][2]);
+    }
+}
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkParallelQuadricDecimation);
+
+//------------------------------------------------------------------------------
+vtkParallelQuadricDecimation::vtkParallelQuadricDecimation()
+  : TargetReduction(0.9)
+  , MaximumError(1.0)
+  , NumberOfPartitions(0)
+  , ComputeNormals(true)
+  , AutoOrientNormals(true)
+  , NumberOfUsedPartitions(0)
+{
+}
+
+//------------------------------------------------------------------------------
+vtkParallelQuadricDecimation::~vtkParallelQuadricDecimation() = default;
+
+//------------------------------------------------------------------------------
+void vtkParallelQuadricDecimation::PrintSelf(ostream &os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "TargetReduction: " << this->TargetReduction << "\n";
+  os << indent << "MaximumError: " << this->MaximumError << "\n";
+  os << indent << "NumberOfPartitions: " << this->NumberOfPartitions << "\n";
+  os << indent << "ComputeNormals: " << this->ComputeNormals << "\n";
+  os << indent << "AutoOrientNormals: " << this->AutoOrientNormals << "\n";
+}
+
+//------------------------------------------------------------------------------
+int vtkParallelQuadricDecimation::RequestData(vtkInformation *vtkNotUsed(request),
+                                              vtkInformationVector **inputVector,
+                                              vtkInformationVector *outputVector)
+{
+    vtkPolyData *input = vtkPolyData::GetData(inputVector[0]);
+    vtkPolyData *output = vtkPolyData::GetData(outputVector);
+    if(!input || !output)
+        return 0;
+
+    this->NumberOfUsedPartitions = 0;
+    vtkPoints *inputPoints = input->GetPoints();
+    const vtkIdType numberOfInputPoints = input->GetNumberOfPoints();
+    if(!inputPoints || numberOfInputPoints == 0 || input->GetNumberOfPolys() + input->GetNumberOfStrips() == 0)
+    {
+        vtkDebugMacro("No triangles to decimate");
+        return 1;
+    }
+
+    // Coincident points are merged. Vertices are numbered in the order of the
+    // first input point of each group.
+    std::vector<std::array<double, 3>> inputPositions(numberOfInputPoints);
+    vtkSMPTools::For(0, numberOfInputPoints, [&](vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType p = begin; p < end; ++p)
+            inputPoints->GetPoint(p, inputPositions[p].data());
+    });
+    std::vector<vtkIdType> order(numberOfInputPoints);
+    std::iota(order.begin(), order.end(), 0);
+    vtkSMPTools::Sort(order.begin(), order.end(), [&](vtkIdType p, vtkIdType q)
+    {
+        return inputPositions[p] != inputPositions[q] ? inputPositions[p] < inputPositions[q] : p < q;
+    });
+    std::vector<vtkIdType> representative(numberOfInputPoints);
+    for(vtkIdType n = 0; n < numberOfInputPoints; ++n)
+    {
+        bool first = n == 0 || inputPositions[order[n]] != inputPositions[order[n - 1]];
+        representative[order[n]] = first ? order[n] : representative[order[n - 1]];
+    }
+    std::vector<vtkIdType> vertexOf(numberOfInputPoints, -1);
+    std::vector<std::array<double, 3>> positions;
+    for(vtkIdType p = 0; p < numberOfInputPoints; ++p)
+    {
+        if(representative[p] == p)
+        {
+            vertexOf[p] = static_cast<vtkIdType>(positions.size());
+            positions.push_back(inputPositions[p]);
+        }
+    }
+    for(vtkIdType p = 0; p < numberOfInputPoints; ++p)
+        vertexOf[p] = vertexOf[representative[p]];
+    inputPositions.clear();
+    inputPositions.shrink_to_fit();
+    const vtkIdType numberOfVertices = static_cast<vtkIdType>(positions.size());
+
+    // Polygons are fan triangulated and strips decomposed. Triangles that
+    // collapsed when merging points are dropped.
+    std::vector<std::array<vtkIdType, 3>> triangles;
+    triangles.reserve(input->GetNumberOfPolys());
+    auto addTriangle = [&](vtkIdType p0, vtkIdType p1, vtkIdType p2)
+    {
+        std::array<vtkIdType, 3> triangle = {{vertexOf[p0], vertexOf[p1], vertexOf[p2]}};
+        if(triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[0] != triangle[2])
+            triangles.push_back(triangle);
+    };
+    vtkIdType npts;
+    const vtkIdType *pts;
+    auto polys = vtk::TakeSmartPointer(input->GetPolys()->NewIterator());
+    for(polys->GoToFirstCell(); !polys->IsDoneWithTraversal(); polys->GoToNextCell())
+    {
+        polys->GetCurrentCell(npts, pts);
+        for(vtkIdType n = 2; n < npts; ++n)
+            addTriangle(pts[0], pts[n - 1], pts[n]);
+    }
+    auto strips = vtk::TakeSmartPointer(input->GetStrips()->NewIterator());
+    for(strips->GoToFirstCell(); !strips->IsDoneWithTraversal(); strips->GoToNextCell())
+    {
+        strips->GetCurrentCell(npts, pts);
+        for(vtkIdType n = 2; n < npts; ++n)
+        {
+            if(n % 2 == 0)
+                addTriangle(pts[n - 2], pts[n - 1], pts[n]);
+            else
+                addTriangle(pts[n - 1], pts[n - 2], pts[n]);
+        }
+    }
+    const vtkIdType numberOfTriangles = static_cast<vtkIdType>(triangles.size());
+    if(numberOfTriangles == 0)
+    {
+        vtkDebugMacro("No triangles to decimate");
+        return 1;
+    }
+
+    std::vector<vtkIdType> offsets;
+    std::vector<vtkIdType> vertexTriangles;
+    BuildVertexTriangles(numberOfVertices, triangles, offsets, vertexTriangles);
+
+    // Quadric of every vertex, from the planes of its triangles
+    std::vector<Quadric> quadrics(numberOfVertices);
+    vtkSMPTools::For(0, numberOfVertices, [&](vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType v = begin; v < end; ++v)
+        {
+            quadrics[v].fill(0.0);
+            for(vtkIdType n = offsets[v]; n < offsets[v + 1]; ++n)
+            {
+                const std::array<vtkIdType, 3> &triangle = triangles[vertexTriangles[n]];
+                AddPlaneQuadric(positions[triangle[0]].data(), positions[triangle[1]].data(),
+                                positions[triangle[2]].data(), quadrics[v]);
+            }
+        }
+    });
+
+    // Vertices on boundary and non-manifold edges are locked
+    std::vector<char> locked(numberOfVertices, 0);
+    {
+        std::vector<EdgeUse> edges = BuildEdgeUses(triangles);
+        for(size_t begin = 0; begin < edges.size();)
+        {
+            size_t end = begin + 1;
+            while(end < edges.size() && edges[end].U == edges[begin].U && edges[end].V == edges[begin].V)
+                end++;
+            if(end - begin != 2)
+                locked[edges[begin].U] = locked[edges[begin].V] = 1;
+            begin = end;
+        }
+    }
+
+    // Slabs with the same number of triangles along the longest axis
+    int numberOfPartitions = this->NumberOfPartitions;
+    if(numberOfPartitions <= 0)
+        numberOfPartitions = static_cast<int>(std::min<vtkIdType>(
+            std::max(1, vtkSMPTools::GetEstimatedNumberOfThreads()),
+            std::max<vtkIdType>(1, numberOfTriangles / MinimumTrianglesPerPartition)));
+    numberOfPartitions = static_cast<int>(std::min<vtkIdType>(numberOfPartitions, numberOfTriangles));
+    this->NumberOfUsedPartitions = numberOfPartitions;
+
+    double bounds[6];
+    input->GetBounds(bounds);
+    int axis = 0;
+    for(int c = 1; c < 3; ++c)
+        if(bounds[2 * c + 1] - bounds[2 * c] > bounds[2 * axis + 1] - bounds[2 * axis])
+            axis = c;
+    std::vector<double> centroids(numberOfTriangles);
+    for(vtkIdType t = 0; t < numberOfTriangles; ++t)
+        centroids[t] = positions[triangles[t][0]][axis] + positions[triangles[t][1]][axis] + positions[triangles[t][2]][axis];
+    std::vector<vtkIdType> triangleOrder(numberOfTriangles);
+    std::iota(triangleOrder.begin(), triangleOrder.end(), 0);
+    vtkSMPTools::Sort(triangleOrder.begin(), triangleOrder.end(), [&](vtkIdType s, vtkIdType t)
+    {
+        return centroids[s] != centroids[t] ? centroids[s] < centroids[t] : s < t;
+    });
+    auto partitionBegin = [&](vtkIdType p) { return p * numberOfTriangles / numberOfPartitions; };
+    std::vector<int> trianglePartition(numberOfTriangles);
+    for(int p = 0; p < numberOfPartitions; ++p)
+        for(vtkIdType n = partitionBegin(p); n < partitionBegin(p + 1); ++n)
+            trianglePartition[triangleOrder[n]] = p;
+
+    // Vertices used by more than one slab are locked
+    for(vtkIdType v = 0; v < numberOfVertices; ++v)
+        for(vtkIdType n = offsets[v] + 1; n < offsets[v + 1]; ++n)
+            if(trianglePartition[vertexTriangles[n]] != trianglePartition[vertexTriangles[offsets[v]]])
+            {
+                locked[v] = 1;
+                break;
+            }
+
+    // Every slab is simplified on its own copy of its vertices
+    std::vector<MeshPartition> partitions(numberOfPartitions);
+    const double reduction = this->TargetReduction;
+    const double maximumError2 = this->MaximumError < std::sqrt(VTK_DOUBLE_MAX)
+                                 ? this->MaximumError * this->MaximumError : VTK_DOUBLE_MAX;
+    vtkSMPTools::For(0, numberOfPartitions, 1, [&](vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType p = begin; p < end; ++p)
+        {
+            MeshPartition &partition = partitions[p];
+            std::unordered_map<vtkIdType, int> localIds;
+            vtkIdType first = partitionBegin(p);
+            vtkIdType last = partitionBegin(p + 1);
+            for(vtkIdType n = first; n < last; ++n)
+            {
+                const std::array<vtkIdType, 3> &triangle = triangles[triangleOrder[n]];
+                std::array<int, 3> localTriangle;
+                for(int c = 0; c < 3; ++c)
+                {
+                    auto inserted = localIds.emplace(triangle[c], static_cast<int>(partition.GlobalIds.size()));
+                    if(inserted.second)
+                    {
+                        partition.GlobalIds.push_back(triangle[c]);
+                        partition.Positions.push_back(positions[triangle[c]]);
+                        partition.Quadrics.push_back(quadrics[triangle[c]]);
+                        partition.Locked.push_back(locked[triangle[c]]);
+                    }
+                    localTriangle[c] = inserted.first->second;
+                }
+                partition.Triangles.push_back(localTriangle);
+            }
+
+            vtkIdType target = static_cast<vtkIdType>(std::ceil((1.0 - reduction) * (last - first)));
+            EdgeCollapser collapser(partition);
+            collapser.Run(target, maximumError2);
+        }
+    });
+
+    // Slabs are stitched back through their (unmoved) locked vertices
+    std::vector<vtkIdType> lockedOutputIds(numberOfVertices, -1);
+    std::vector<std::array<double, 3>> outputPositions;
+    std::vector<std::array<vtkIdType, 3>> outputTriangles;
+    for(MeshPartition &partition : partitions)
+    {
+        std::vector<vtkIdType> outputIds(partition.Positions.size(), -1);
+        for(size_t v = 0; v < partition.Positions.size(); ++v)
+        {
+            if(partition.RemovedVertices[v])
+                continue;
+            vtkIdType &outputId = partition.Locked[v] ? lockedOutputIds[partition.GlobalIds[v]] : outputIds[v];
+            if(outputId < 0)
+            {
+                outputId = static_cast<vtkIdType>(outputPositions.size());
+                outputPositions.push_back(partition.Positions[v]);
+            }
+            outputIds[v] = outputId;
+        }
+        for(size_t t = 0; t < partition.Triangles.size(); ++t)
+        {
+            if(partition.RemovedTriangles[t])
+                continue;
+            const std::array<int, 3> &triangle = partition.Triangles[t];
+            outputTriangles.push_back({{outputIds[triangle[0]], outputIds[triangle[1]], outputIds[triangle[2]]}});
+        }
+    }
+    partitions.clear();
+
+    OrientTriangles(outputPositions, outputTriangles, this->AutoOrientNormals);
+
+    const vtkIdType numberOfOutputPoints = static_cast<vtkIdType>(outputPositions.size());
+    const vtkIdType numberOfOutputTriangles = static_cast<vtkIdType>(outputTriangles.size());
+    vtkNew<vtkPoints> outputPoints;
+    outputPoints->SetDataType(inputPoints->GetDataType());
+    outputPoints->SetNumberOfPoints(numberOfOutputPoints);
+    for(vtkIdType p = 0; p < numberOfOutputPoints; ++p)
+        outputPoints->SetPoint(p, outputPositions[p].data());
+
+    vtkNew<vtkCellArray> outputPolys;
+    outputPolys->AllocateExact(numberOfOutputTriangles, 3 * numberOfOutputTriangles);
+    for(const std::array<vtkIdType, 3> &triangle : outputTriangles)
+        outputPolys->InsertNextCell(3, triangle.data());
+
+    output->Initialize();
+    output->SetPoints(outputPoints);
+    output->SetPolys(outputPolys);
+
+    if(this->ComputeNormals && numberOfOutputPoints > 0)
+    {
+        // Area weighted average of the normals of the triangles around a point
+        std::vector<std::array<double, 3>> triangleNormals(numberOfOutputTriangles);
+        vtkSMPTools::For(0, numberOfOutputTriangles, [&](vtkIdType begin, vtkIdType end)
+        {
+            for(vtkIdType t = begin; t < end; ++t)
+                TriangleNormal(outputPositions[outputTriangles[t][0]].data(), outputPositions[outputTriangles[t][1]].data(),
+                               outputPositions[outputTriangles[t][2]].data(), triangleNormals[t].data());
+        });
+        BuildVertexTriangles(numberOfOutputPoints, outputTriangles, offsets, vertexTriangles);
+
+        vtkNew<vtkFloatArray> normals;
+        normals->SetName("Normals");
+        normals->SetNumberOfComponents(3);
+        normals->SetNumberOfTuples(numberOfOutputPoints);
+        vtkSMPTools::For(0, numberOfOutputPoints, [&](vtkIdType begin, vtkIdType end)
+        {
+            for(vtkIdType p = begin; p < end; ++p)
+            {
+                double normal[3] = {0.0, 0.0, 0.0};
+                for(vtkIdType n = offsets[p]; n < offsets[p + 1]; ++n)
+                    for(int c = 0; c < 3; ++c)
+                        normal[c] += triangleNormals[vertexTriangles[n]][c];
+                vtkMath::Normalize(normal);
+                float tuple[3] = {static_cast<float>(normal[0]), static_cast<float>(normal[1]), static_cast<float>(normal[2])};
+                normals->SetTypedTuple(p, tuple);
+            }
+        });
+        output->GetPointData()->SetNormals(normals);
+    }
+
+    return 1;
+}
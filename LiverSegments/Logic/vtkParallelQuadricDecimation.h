@@ -0,0 +1,117 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#ifndef __vtkParallelQuadricDecimation_h
+#define __vtkParallelQuadricDecimation_h
+
+#include "vtkSlicerLiverSegmentsModuleLogicExport.h"
+
+#include <vtkPolyDataAlgorithm.h>
+
+// Simplifies a triangle mesh by quadric-error edge collapses and produces, in
+// a single filter, the output previously obtained by chaining decimation,
+// cleaning, triangulation and normal computation:
+//
+//  - coincident points are merged and polygons and strips are triangulated;
+//  - the mesh is split in slabs along its longest axis, which are simplified
+//    in parallel. Vertices shared by two slabs and vertices on the mesh
+//    boundary are locked, so the slabs stitch back without cracks and open
+//    borders are preserved;
+//  - collapses that would flip a triangle or change the topology are
+//    rejected;
+//  - triangles are oriented consistently (and outwards for closed
+//    components when AutoOrientNormals is on) and point normals are added.
+//
+// Point and cell data of the input are not passed to the output.
+class VTK_SLICER_LIVERSEGMENTS_MODULE_LOGIC_EXPORT
+vtkParallelQuadricDecimation : public vtkPolyDataAlgorithm
+{
+ public:
+  static vtkParallelQuadricDecimation *New();
+  vtkTypeMacro(vtkParallelQuadricDecimation, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Fraction of the triangles to remove
+  vtkSetClampMacro(TargetReduction, double, 0.0, 1.0);
+  vtkGetMacro(TargetReduction, double);
+
+  // Collapses stop when the quadric error of the cheapest one exceeds the
+  // square of this distance (1 by default, in the units of the input points)
+  vtkSetClampMacro(MaximumError, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(MaximumError, double);
+
+  // Number of slabs simplified in parallel. 0 picks it from the number of
+  // threads and the size of the mesh.
+  vtkSetClampMacro(NumberOfPartitions, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfPartitions, int);
+
+  // Add point normals to the output
+  vtkSetMacro(ComputeNormals, bool);
+  vtkGetMacro(ComputeNormals, bool);
+  vtkBooleanMacro(ComputeNormals, bool);
+
+  // Orient closed components so that their normals point outwards
+  vtkSetMacro(AutoOrientNormals, bool);
+  vtkGetMacro(AutoOrientNormals, bool);
+  vtkBooleanMacro(AutoOrientNormals, bool);
+
+  // Number of slabs used in the last execution
+  vtkGetMacro(NumberOfUsedPartitions, int);
+
+ protected:
+  vtkParallelQuadricDecimation();
+  ~vtkParallelQuadricDecimation() override;
+
+  int RequestData(vtkInformation *request, vtkInformationVector **inputVector,
+                  vtkInformationVector *outputVector) override;
+
+ protected:
+  double TargetReduction;
+  double MaximumError;
+  int NumberOfPartitions;
+  bool ComputeNormals;
+  bool AutoOrientNormals;
+  int NumberOfUsedPartitions;
+
+ private:
+  vtkParallelQuadricDecimation(const vtkParallelQuadricDecimation&) = delete;
+  void operator=(const vtkParallelQuadricDecimation&) = delete;
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#include "vtkVascularTerritoryConversionRule.h"
+#include "vtkVascularTerritorySurfaceEngine.h"
+
+#include <vtkOrientedImageData.h>
+#include <vtkSegment.h>
+#include <vtkSegmentation.h>
+#include <vtkSegmentationConverter.h>
+#include <vtkSegmentationConverterFactory.h>
+
+#include <vtkIntArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+//------------------------------------------------------------------------------
+std::vector<vtkWeakPointer<vtkVascularTerritorySurfaceEngine>> &SurfaceEngines()
+{
+    static std::vector<vtkWeakPointer<vtkVascularTerritorySurfaceEngine>> engines;
+    return engines;
+}
+}
+
+//------------------------------------------------------------------------------
+vtkSegmentationConverterRuleNewMacro(vtkVascularTerritoryConversionRule);
+
+//------------------------------------------------------------------------------
+vtkVascularTerritoryConversionRule::vtkVascularTerritoryConversionRule() = default;
+
+//------------------------------------------------------------------------------
+vtkVascularTerritoryConversionRule::~vtkVascularTerritoryConversionRule() = default;
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryConversionRule::RegisterRule()
+{
+    static bool registered = false;
+    if(registered)
+        return;
+    vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+        vtkSmartPointer<vtkVascularTerritoryConversionRule>::New());
+    registered = true;
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryConversionRule::AddSurfaceEngine(vtkVascularTerritorySurfaceEngine *engine)
+{
+    auto &engines = SurfaceEngines();
+    if(engine && std::find(engines.begin(), engines.end(), engine) == engines.end())
+        engines.emplace_back(engine);
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryConversionRule::RemoveSurfaceEngine(vtkVascularTerritorySurfaceEngine *engine)
+{
+    // Engines that were deleted meanwhile are dropped too
+    auto &engines = SurfaceEngines();
+    engines.erase(std::remove_if(engines.begin(), engines.end(),
+                                 [engine](const vtkWeakPointer<vtkVascularTerritorySurfaceEngine> &registered)
+                                 { return !registered || registered == engine; }),
+                  engines.end());
+}
+
+//------------------------------------------------------------------------------
+vtkVascularTerritorySurfaceEngine *vtkVascularTerritoryConversionRule::FindSurfaceEngine(vtkDataObject *labelmap)
+{
+    if(!labelmap)
+        return nullptr;
+    for(vtkVascularTerritorySurfaceEngine *engine : SurfaceEngines())
+        if(engine && engine->GetInputLabelmap() == labelmap)
+            return engine;
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+unsigned int vtkVascularTerritoryConversionRule::GetConversionCost(vtkDataObject *sourceRepresentation,
+                                                                   vtkDataObject *targetRepresentation)
+{
+    unsigned int cost = this->Superclass::GetConversionCost(sourceRepresentation, targetRepresentation);
+    return cost > 1 ? cost - 1 : cost;
+}
+
+//------------------------------------------------------------------------------
+bool vtkVascularTerritoryConversionRule::PreConvert(vtkSegmentation *segmentation)
+{
+    if(!segmentation)
+        return false;
+
+    // Territories sharing the input of an engine are generated together
+    std::map<vtkVascularTerritorySurfaceEngine*, vtkSmartPointer<vtkIntArray>> territoryLabels;
+    std::vector<std::string> segmentIds;
+    segmentation->GetSegmentIDs(segmentIds);
+    for(const std::string &segmentId : segmentIds)
+    {
+        vtkSegment *segment = segmentation->GetSegment(segmentId);
+        vtkVascularTerritorySurfaceEngine *engine =
+            segment ? FindSurfaceEngine(segment->GetRepresentation(this->GetSourceRepresentationName())) : nullptr;
+        if(!engine)
+            continue;
+        vtkSmartPointer<vtkIntArray> &labels = territoryLabels[engine];
+        if(!labels)
+            labels = vtkSmartPointer<vtkIntArray>::New();
+        labels->InsertNextValue(segment->GetLabelValue());
+    }
+    for(const auto &engineLabels : territoryLabels)
+        engineLabels.first->GenerateSurfaces(engineLabels.second);
+
+    return this->Superclass::PreConvert(segmentation);
+}
+
+//------------------------------------------------------------------------------
+bool vtkVascularTerritoryConversionRule::Convert(vtkSegment *segment)
+{
+    if(!segment)
+        return false;
+
+    vtkVascularTerritorySurfaceEngine *engine =
+        FindSurfaceEngine(segment->GetRepresentation(this->GetSourceRepresentationName()));
+    if(!engine)
+        return this->Superclass::Convert(segment);
+
+    auto closedSurface = vtkPolyData::SafeDownCast(segment->GetRepresentation(this->GetTargetRepresentationName()));
+    if(!closedSurface)
+    {
+        auto newClosedSurface = vtkSmartPointer<vtkPolyData>::New();
+        segment->AddRepresentation(this->GetTargetRepresentationName(), newClosedSurface);
+        closedSurface = newClosedSurface;
+    }
+
+    // Territories without voxels get an empty surface
+    vtkPolyData *surface = engine->GetSurface(segment->GetLabelValue());
+    if(surface)
+        closedSurface->ShallowCopy(surface);
+    else
+        closedSurface->Initialize();
+    return true;
+}
@@ -0,0 +1,97 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#ifndef __vtkVascularTerritoryConversionRule_h
+#define __vtkVascularTerritoryConversionRule_h
+
+#include "vtkSlicerLiverSegmentsModuleLogicExport.h"
+
+#include <vtkBinaryLabelmapToClosedSurfaceConversionRule.h>
+
+// Forward declarations
+class vtkOrientedImageData;
+class vtkVascularTerritorySurfaceEngine;
+
+// Binary labelmap to closed surface conversion rule that takes the surfaces
+// of the vascular territories from the registered territory surface engines.
+// Once registered with the segmentation converter factory, the standard
+// conversions (Show 3D, CreateClosedSurfaceRepresentation) generate all the
+// territory surfaces of a segmentation in one parallel batch. Segments that
+// are not stored in the input labelmap of a registered engine are converted
+// by the default binary labelmap to closed surface rule.
+class VTK_SLICER_LIVERSEGMENTS_MODULE_LOGIC_EXPORT
+vtkVascularTerritoryConversionRule : public vtkBinaryLabelmapToClosedSurfaceConversionRule
+{
+ public:
+  static vtkVascularTerritoryConversionRule *New();
+  vtkTypeMacro(vtkVascularTerritoryConversionRule, vtkBinaryLabelmapToClosedSurfaceConversionRule);
+  vtkSegmentationConverterRule *CreateRuleInstance() override;
+
+  // Registers the rule with the segmentation converter factory (once).
+  // Segmentations created afterwards use it.
+  static void RegisterRule();
+
+  // Surface engines whose input labelmap holds vascular territories
+  static void AddSurfaceEngine(vtkVascularTerritorySurfaceEngine *engine);
+  static void RemoveSurfaceEngine(vtkVascularTerritorySurfaceEngine *engine);
+
+  const char *GetName() override { return "Vascular territory labelmap to closed surface"; }
+
+  // Cheaper than the default rule, so that it takes over the conversion
+  unsigned int GetConversionCost(vtkDataObject *sourceRepresentation = nullptr,
+                                 vtkDataObject *targetRepresentation = nullptr) override;
+
+  // Generates the missing territory surfaces of the segmentation in parallel
+  bool PreConvert(vtkSegmentation *segmentation) override;
+
+  bool Convert(vtkSegment *segment) override;
+
+ protected:
+  vtkVascularTerritoryConversionRule();
+  ~vtkVascularTerritoryConversionRule() override;
+
+  // Registered engine whose input is the given labelmap, if any
+  static vtkVascularTerritorySurfaceEngine *FindSurfaceEngine(vtkDataObject *labelmap);
+
+ private:
+  vtkVascularTerritoryConversionRule(const vtkVascularTerritoryConversionRule&) = delete;
+  void operator=(const vtkVascularTerritoryConversionRule&) = delete;
+};
+
+#endif
@@ -0,0 +1,540 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#include "vtkVascularTerritoryEngine.h"
+#include "vtkCenterlineAccumulator.h"
+
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Squared distance from x to an axis aligned box
+double DistanceToBounds2(const double x[3], const double bounds[6])
+{
+    double distance2 = 0.0;
+    for(int c = 0; c < 3; ++c)
+    {
+        double delta = 0.0;
+        if(x[c] < bounds[2 * c])
+            delta = bounds[2 * c] - x[c];
+        else if(x[c] > bounds[2 * c + 1])
+            delta = x[c] - bounds[2 * c + 1];
+        distance2 += delta * delta;
+    }
+    return distance2;
+}
+
+// New label of a voxel found during a parallel pass
+using LabelChange = std::pair<vtkIdType, short>;
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkVascularTerritoryEngine);
+
+//------------------------------------------------------------------------------
+vtkVascularTerritoryEngine::vtkVascularTerritoryEngine()
+  : MaskLabel(1)
+  , Initialized(false)
+  , MaximumDistance2(VTK_DOUBLE_MAX)
+  , NumberOfEvaluatedVoxels(0)
+  , NumberOfRelabelledVoxels(0)
+{
+    vtkMatrix4x4::Identity(this->IJKToRAS);
+    vtkMatrix4x4::Identity(this->RASToIJK);
+    std::fill(this->Extent, this->Extent + 6, 0);
+}
+
+//------------------------------------------------------------------------------
+vtkVascularTerritoryEngine::~vtkVascularTerritoryEngine() = default;
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::PrintSelf(ostream &os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "MaskLabel: " << this->MaskLabel << "\n";
+  os << indent << "Initialized: " << this->Initialized << "\n";
+  os << indent << "Classified voxels: " << this->Voxels.size() << "\n";
+  os << indent << "NumberOfEvaluatedVoxels: " << this->NumberOfEvaluatedVoxels << "\n";
+  os << indent << "NumberOfRelabelledVoxels: " << this->NumberOfRelabelledVoxels << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::SetCenterlineAccumulator(vtkCenterlineAccumulator *accumulator)
+{
+    if(this->CenterlineAccumulator == accumulator)
+        return;
+    this->CenterlineAccumulator = accumulator;
+    this->Initialized = false;
+    this->Modified();
+}
+
+//------------------------------------------------------------------------------
+vtkCenterlineAccumulator *vtkVascularTerritoryEngine::GetCenterlineAccumulator()
+{
+    return this->CenterlineAccumulator;
+}
+
+//------------------------------------------------------------------------------
+bool vtkVascularTerritoryEngine::IsInitialized() const
+{
+    return this->Initialized;
+}
+
+//------------------------------------------------------------------------------
+vtkImageData *vtkVascularTerritoryEngine::GetLabelmap()
+{
+    return this->Labelmap;
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::GetVoxelPosition(vtkIdType voxel, double x[3]) const
+{
+    vtkIdType nx = this->Extent[1] - this->Extent[0] + 1;
+    vtkIdType ny = this->Extent[3] - this->Extent[2] + 1;
+    vtkIdType offset = this->Voxels[voxel];
+    double ijk[3] = {static_cast<double>(this->Extent[0] + offset % nx),
+                     static_cast<double>(this->Extent[2] + (offset / nx) % ny),
+                     static_cast<double>(this->Extent[4] + offset / (nx * ny))};
+    const double *m = this->IJKToRAS;
+    x[0] = m[0] * ijk[0] + m[1] * ijk[1] + m[2] * ijk[2] + m[3];
+    x[1] = m[4] * ijk[0] + m[5] * ijk[1] + m[6] * ijk[2] + m[7];
+    x[2] = m[8] * ijk[0] + m[9] * ijk[1] + m[10] * ijk[2] + m[11];
+}
+
+//------------------------------------------------------------------------------
+int vtkVascularTerritoryEngine::Classify(vtkImageData *labelmap, vtkMatrix4x4 *ijkToRas)
+{
+    this->Initialized = false;
+    if(!labelmap || !ijkToRas || !this->CenterlineAccumulator)
+    {
+        vtkErrorMacro("Classify: missing labelmap, matrix or centerline accumulator.");
+        return 0;
+    }
+    if(labelmap->GetScalarType() != VTK_SHORT || labelmap->GetNumberOfScalarComponents() != 1)
+    {
+        vtkErrorMacro("Classify: labelmap voxels are expected to be single component short.");
+        return 0;
+    }
+
+    this->Labelmap = labelmap;
+    labelmap->GetExtent(this->Extent);
+    std::copy(ijkToRas->GetData(), ijkToRas->GetData() + 16, this->IJKToRAS);
+    vtkMatrix4x4::Invert(this->IJKToRAS, this->RASToIJK);
+
+    // Voxels to classify, grouped by row
+    vtkIdType nx = this->Extent[1] - this->Extent[0] + 1;
+    vtkIdType numberOfRows = static_cast<vtkIdType>(this->Extent[3] - this->Extent[2] + 1)
+                             * (this->Extent[5] - this->Extent[4] + 1);
+    short *scalars = static_cast<short*>(labelmap->GetScalarPointer());
+    this->Voxels.clear();
+    this->RowStart.assign(numberOfRows + 1, 0);
+    for(vtkIdType row = 0; row < numberOfRows; ++row)
+    {
+        this->RowStart[row] = static_cast<vtkIdType>(this->Voxels.size());
+        for(vtkIdType i = 0; i < nx; ++i)
+            if(scalars[row * nx + i] == this->MaskLabel)
+                this->Voxels.push_back(row * nx + i);
+    }
+    this->RowStart[numberOfRows] = static_cast<vtkIdType>(this->Voxels.size());
+
+    vtkIdType numberOfVoxels = static_cast<vtkIdType>(this->Voxels.size());
+    this->Distance2.assign(numberOfVoxels, VTK_DOUBLE_MAX);
+    this->Block.assign(numberOfVoxels, -1);
+
+    vtkCenterlineAccumulator *accumulator = this->CenterlineAccumulator;
+    accumulator->BuildLocators();
+    vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType n = begin; n < end; ++n)
+        {
+            double x[3];
+            this->GetVoxelPosition(n, x);
+            double distance2;
+            int blockId = -1;
+            vtkIdType pointId = accumulator->FindClosestPoint(x, distance2, &blockId);
+            if(pointId < 0)
+                continue;
+            this->Distance2[n] = distance2;
+            this->Block[n] = blockId;
+            scalars[this->Voxels[n]] = static_cast<short>(accumulator->GetSegmentId(pointId));
+        }
+    });
+
+    this->LabelCounts.clear();
+    for(vtkIdType offset : this->Voxels)
+        this->LabelCounts[scalars[offset]]++;
+    this->ModifiedLabels.clear();
+    for(const auto &labelCount : this->LabelCounts)
+        this->ModifiedLabels.push_back(labelCount.first);
+
+    this->MaximumDistance2 = 0.0;
+    for(double distance2 : this->Distance2)
+        this->MaximumDistance2 = std::max(this->MaximumDistance2, distance2);
+
+    this->SnapshotBlockBounds();
+    this->NumberOfEvaluatedVoxels = numberOfVoxels;
+    this->NumberOfRelabelledVoxels = numberOfVoxels;
+    this->Initialized = true;
+    labelmap->Modified();
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::SnapshotBlockBounds()
+{
+    this->BlockBounds.clear();
+    std::vector<int> blockIds;
+    this->CenterlineAccumulator->GetBlockIds(blockIds);
+    for(int blockId : blockIds)
+    {
+        std::array<double, 6> bounds;
+        if(this->CenterlineAccumulator->GetBlockBounds(blockId, bounds.data()))
+            this->BlockBounds[blockId] = bounds;
+    }
+}
+
+//------------------------------------------------------------------------------
+double vtkVascularTerritoryEngine::GetSearchMargin() const
+{
+    // Unclassified voxels (no centerline points yet) can be anywhere
+    if(this->MaximumDistance2 >= VTK_DOUBLE_MAX)
+        return VTK_DOUBLE_MAX;
+    return std::sqrt(this->MaximumDistance2);
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::GetRowsInBounds(const double bounds[6], double margin,
+                                                 std::vector<std::array<vtkIdType, 2>> &rows) const
+{
+    rows.clear();
+    int ijkRange[6];
+    std::copy(this->Extent, this->Extent + 6, ijkRange);
+
+    if(margin < VTK_DOUBLE_MAX)
+    {
+        // IJK box of the grown bounds
+        double ijkBounds[6] = {VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+        const double *m = this->RASToIJK;
+        for(int corner = 0; corner < 8; ++corner)
+        {
+            double x[3] = {(corner & 1) ? bounds[1] + margin : bounds[0] - margin,
+                           (corner & 2) ? bounds[3] + margin : bounds[2] - margin,
+                           (corner & 4) ? bounds[5] + margin : bounds[4] - margin};
+            for(int c = 0; c < 3; ++c)
+            {
+                double ijk = m[4 * c] * x[0] + m[4 * c + 1] * x[1] + m[4 * c + 2] * x[2] + m[4 * c + 3];
+                ijkBounds[2 * c] = std::min(ijkBounds[2 * c], ijk);
+                ijkBounds[2 * c + 1] = std::max(ijkBounds[2 * c + 1], ijk);
+            }
+        }
+        for(int c = 0; c < 3; ++c)
+        {
+            double first = std::max(static_cast<double>(ijkRange[2 * c]), std::floor(ijkBounds[2 * c]));
+            double last = std::min(static_cast<double>(ijkRange[2 * c + 1]), std::ceil(ijkBounds[2 * c + 1]));
+            if(first > last)
+                return;
+            ijkRange[2 * c] = static_cast<int>(first);
+            ijkRange[2 * c + 1] = static_cast<int>(last);
+        }
+    }
+
+    vtkIdType nx = this->Extent[1] - this->Extent[0] + 1;
+    vtkIdType ny = this->Extent[3] - this->Extent[2] + 1;
+    for(int k = ijkRange[4]; k <= ijkRange[5]; ++k)
+        for(int j = ijkRange[2]; j <= ijkRange[3]; ++j)
+        {
+            vtkIdType row = (k - this->Extent[4]) * ny + (j - this->Extent[2]);
+            auto rowBegin = this->Voxels.begin() + this->RowStart[row];
+            auto rowEnd = this->Voxels.begin() + this->RowStart[row + 1];
+            auto first = std::lower_bound(rowBegin, rowEnd, row * nx + (ijkRange[0] - this->Extent[0]));
+            auto last = std::upper_bound(first, rowEnd, row * nx + (ijkRange[1] - this->Extent[0]));
+            if(first != last)
+                rows.push_back({static_cast<vtkIdType>(first - this->Voxels.begin()),
+                                static_cast<vtkIdType>(last - this->Voxels.begin())});
+        }
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::Relabel(vtkIdType voxel, short newLabel)
+{
+    short *scalars = static_cast<short*>(this->Labelmap->GetScalarPointer());
+    short &label = scalars[this->Voxels[voxel]];
+    if(label == newLabel)
+        return;
+
+    if(--this->LabelCounts[label] == 0)
+        this->LabelCounts.erase(label);
+    this->LabelCounts[newLabel]++;
+    this->ModifiedLabels.push_back(label);
+    this->ModifiedLabels.push_back(newLabel);
+    label = newLabel;
+    this->NumberOfRelabelledVoxels++;
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::ReclassifyBlockVoxels(int blockId, const std::vector<std::array<vtkIdType, 2>> &rows)
+{
+    vtkCenterlineAccumulator *accumulator = this->CenterlineAccumulator;
+    const short *scalars = static_cast<short*>(this->Labelmap->GetScalarPointer());
+    vtkSMPThreadLocal<std::vector<LabelChange>> threadChanges;
+    vtkSMPThreadLocal<vtkIdType> threadEvaluated(0);
+    vtkSMPThreadLocal<double> threadMaximum(0.0);
+
+    vtkSMPTools::For(0, static_cast<vtkIdType>(rows.size()), [&](vtkIdType begin, vtkIdType end)
+    {
+        std::vector<LabelChange> &changes = threadChanges.Local();
+        vtkIdType &evaluated = threadEvaluated.Local();
+        double &maximum = threadMaximum.Local();
+        for(vtkIdType r = begin; r < end; ++r)
+            for(vtkIdType n = rows[r][0]; n < rows[r][1]; ++n)
+            {
+                if(this->Block[n] != blockId)
+                    continue;
+                evaluated++;
+                double x[3];
+                this->GetVoxelPosition(n, x);
+                double distance2;
+                int closestBlock = -1;
+                vtkIdType pointId = accumulator->FindClosestPoint(x, distance2, &closestBlock);
+                short newLabel = static_cast<short>(this->MaskLabel);
+                if(pointId >= 0)
+                    newLabel = static_cast<short>(accumulator->GetSegmentId(pointId));
+                else
+                    distance2 = VTK_DOUBLE_MAX;
+                this->Distance2[n] = distance2;
+                this->Block[n] = closestBlock;
+                maximum = std::max(maximum, distance2);
+                if(scalars[this->Voxels[n]] != newLabel)
+                    changes.emplace_back(n, newLabel);
+            }
+    });
+
+    for(vtkIdType evaluated : threadEvaluated)
+        this->NumberOfEvaluatedVoxels += evaluated;
+    for(double maximum : threadMaximum)
+        this->MaximumDistance2 = std::max(this->MaximumDistance2, maximum);
+    for(const std::vector<LabelChange> &changes : threadChanges)
+        for(const LabelChange &change : changes)
+            this->Relabel(change.first, change.second);
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::CompareWithBlock(int blockId, const std::vector<std::array<vtkIdType, 2>> &rows)
+{
+    vtkCenterlineAccumulator *accumulator = this->CenterlineAccumulator;
+    double bounds[6];
+    if(!accumulator->GetBlockBounds(blockId, bounds))
+        return;
+
+    // Tie breaking follows the storage order of the blocks
+    std::vector<int> blockIds;
+    accumulator->GetBlockIds(blockIds);
+    std::map<int, size_t> blockPosition;
+    for(size_t position = 0; position < blockIds.size(); ++position)
+        blockPosition[blockIds[position]] = position;
+    const size_t position = blockPosition[blockId];
+
+    const short *scalars = static_cast<short*>(this->Labelmap->GetScalarPointer());
+    vtkSMPThreadLocal<std::vector<LabelChange>> threadChanges;
+    vtkSMPThreadLocal<vtkIdType> threadEvaluated(0);
+
+    vtkSMPTools::For(0, static_cast<vtkIdType>(rows.size()), [&](vtkIdType begin, vtkIdType end)
+    {
+        std::vector<LabelChange> &changes = threadChanges.Local();
+        vtkIdType &evaluated = threadEvaluated.Local();
+        for(vtkIdType r = begin; r < end; ++r)
+            for(vtkIdType n = rows[r][0]; n < rows[r][1]; ++n)
+            {
+                double x[3];
+                this->GetVoxelPosition(n, x);
+                if(DistanceToBounds2(x, bounds) > this->Distance2[n])
+                    continue;
+                evaluated++;
+                double distance2;
+                vtkIdType pointId = accumulator->FindClosestPointInBlock(blockId, x, distance2);
+                if(pointId < 0)
+                    continue;
+
+                bool closer = distance2 < this->Distance2[n];
+                if(!closer && distance2 == this->Distance2[n] && this->Block[n] != blockId)
+                {
+                    auto current = blockPosition.find(this->Block[n]);
+                    closer = (current == blockPosition.end() || position < current->second);
+                }
+                if(!closer)
+                    continue;
+
+                this->Distance2[n] = distance2;
+                this->Block[n] = blockId;
+                short newLabel = static_cast<short>(accumulator->GetSegmentId(pointId));
+                if(scalars[this->Voxels[n]] != newLabel)
+                    changes.emplace_back(n, newLabel);
+            }
+    });
+
+    for(vtkIdType evaluated : threadEvaluated)
+        this->NumberOfEvaluatedVoxels += evaluated;
+    for(const std::vector<LabelChange> &changes : threadChanges)
+        for(const LabelChange &change : changes)
+            this->Relabel(change.first, change.second);
+}
+
+//------------------------------------------------------------------------------
+int vtkVascularTerritoryEngine::UpdateBlockAdded(int blockId)
+{
+    if(!this->Initialized || !this->CenterlineAccumulator->HasBlock(blockId))
+        return 0;
+
+    this->ModifiedLabels.clear();
+    this->NumberOfEvaluatedVoxels = 0;
+    this->NumberOfRelabelledVoxels = 0;
+    this->CenterlineAccumulator->BuildLocators();
+
+    double bounds[6];
+    if(this->CenterlineAccumulator->GetBlockBounds(blockId, bounds))
+    {
+        std::vector<std::array<vtkIdType, 2>> rows;
+        this->GetRowsInBounds(bounds, this->GetSearchMargin(), rows);
+        this->CompareWithBlock(blockId, rows);
+        this->BlockBounds[blockId] = {bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5]};
+    }
+
+    if(this->NumberOfRelabelledVoxels > 0)
+        this->Labelmap->Modified();
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int vtkVascularTerritoryEngine::UpdateBlockReplaced(int blockId)
+{
+    if(!this->Initialized || !this->CenterlineAccumulator->HasBlock(blockId))
+        return 0;
+
+    this->ModifiedLabels.clear();
+    this->NumberOfEvaluatedVoxels = 0;
+    this->NumberOfRelabelledVoxels = 0;
+    this->CenterlineAccumulator->BuildLocators();
+
+    // Voxels that were closest to the old geometry are classified again
+    std::vector<std::array<vtkIdType, 2>> rows;
+    auto oldBounds = this->BlockBounds.find(blockId);
+    if(oldBounds != this->BlockBounds.end())
+    {
+        this->GetRowsInBounds(oldBounds->second.data(), this->GetSearchMargin(), rows);
+        this->ReclassifyBlockVoxels(blockId, rows);
+        this->BlockBounds.erase(oldBounds);
+    }
+
+    // The remaining voxels can only get closer to the new geometry
+    double bounds[6];
+    if(this->CenterlineAccumulator->GetBlockBounds(blockId, bounds))
+    {
+        this->GetRowsInBounds(bounds, this->GetSearchMargin(), rows);
+        this->CompareWithBlock(blockId, rows);
+        this->BlockBounds[blockId] = {bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5]};
+    }
+
+    if(this->NumberOfRelabelledVoxels > 0)
+        this->Labelmap->Modified();
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int vtkVascularTerritoryEngine::UpdateBlockRemoved(int blockId)
+{
+    if(!this->Initialized || this->CenterlineAccumulator->HasBlock(blockId))
+        return 0;
+
+    this->ModifiedLabels.clear();
+    this->NumberOfEvaluatedVoxels = 0;
+    this->NumberOfRelabelledVoxels = 0;
+    this->CenterlineAccumulator->BuildLocators();
+
+    auto oldBounds = this->BlockBounds.find(blockId);
+    if(oldBounds == this->BlockBounds.end())
+        return 1;
+
+    std::vector<std::array<vtkIdType, 2>> rows;
+    this->GetRowsInBounds(oldBounds->second.data(), this->GetSearchMargin(), rows);
+    this->ReclassifyBlockVoxels(blockId, rows);
+    this->BlockBounds.erase(oldBounds);
+
+    if(this->NumberOfRelabelledVoxels > 0)
+        this->Labelmap->Modified();
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::GetModifiedLabels(vtkIntArray *labels)
+{
+    if(!labels)
+        return;
+    labels->Initialize();
+    std::set<int> uniqueLabels(this->ModifiedLabels.begin(), this->ModifiedLabels.end());
+    for(int label : uniqueLabels)
+        labels->InsertNextValue(label);
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritoryEngine::GetLabels(vtkIntArray *labels)
+{
+    if(!labels)
+        return;
+    labels->Initialize();
+    for(const auto &labelCount : this->LabelCounts)
+        labels->InsertNextValue(labelCount.first);
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkVascularTerritoryEngine::GetLabelVoxelCount(int label)
+{
+    auto labelCount = this->LabelCounts.find(label);
+    return labelCount == this->LabelCounts.end() ? 0 : labelCount->second;
+}
@@ -0,0 +1,175 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#ifndef __vtkVascularTerritoryEngine_h
+#define __vtkVascularTerritoryEngine_h
+
+#include "vtkSlicerLiverSegmentsModuleLogicExport.h"
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <map>
+#include <vector>
+
+// Forward declarations
+class vtkCenterlineAccumulator;
+class vtkImageData;
+class vtkIntArray;
+class vtkMatrix4x4;
+
+// Assigns every liver voxel of a labelmap the segment id of the closest
+// centerline point, and keeps the distance and the centerline block of the
+// closest point of every voxel. With this state an edit of one centerline
+// segment only re-evaluates the voxels it can affect:
+//
+//  - voxels whose closest point belonged to a removed or replaced segment are
+//    classified again against all the segments;
+//  - the remaining voxels are only compared against the new geometry, and
+//    only if the new segment bounds are closer than their current distance.
+//
+// Both searches are restricted to the segment bounds grown by the largest
+// voxel distance. Ties are resolved in favour of the block stored first in
+// the accumulator, as vtkCenterlineAccumulator::FindClosestPoint does, so the
+// result is identical to a full classification.
+class VTK_SLICER_LIVERSEGMENTS_MODULE_LOGIC_EXPORT
+vtkVascularTerritoryEngine : public vtkObject
+{
+ public:
+  static vtkVascularTerritoryEngine *New();
+  vtkTypeMacro(vtkVascularTerritoryEngine, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Centerline segments used as classification sites
+  void SetCenterlineAccumulator(vtkCenterlineAccumulator *accumulator);
+  vtkCenterlineAccumulator *GetCenterlineAccumulator();
+
+  // Value of the voxels to classify in the labelmap given to Classify
+  vtkSetMacro(MaskLabel, int);
+  vtkGetMacro(MaskLabel, int);
+
+  // Classifies all the voxels of labelmap (short scalars) with value
+  // MaskLabel, in place. Returns 0 on invalid input.
+  int Classify(vtkImageData *labelmap, vtkMatrix4x4 *ijkToRas);
+
+  // Returns true once Classify has succeeded
+  bool IsInitialized() const;
+
+  // The labelmap being classified
+  vtkImageData *GetLabelmap();
+
+  // Incremental updates after a change in the accumulator. Return 0 if the
+  // engine is not initialized or the block is unknown.
+  int UpdateBlockAdded(int blockId);
+  int UpdateBlockReplaced(int blockId);
+  int UpdateBlockRemoved(int blockId);
+
+  // Labels that gained or lost voxels in the last classification or update
+  void GetModifiedLabels(vtkIntArray *labels);
+
+  // Labels currently assigned to at least one voxel
+  void GetLabels(vtkIntArray *labels);
+
+  // Number of voxels currently holding a label
+  vtkIdType GetLabelVoxelCount(int label);
+
+  // Number of voxels evaluated and relabelled in the last update
+  vtkGetMacro(NumberOfEvaluatedVoxels, vtkIdType);
+  vtkGetMacro(NumberOfRelabelledVoxels, vtkIdType);
+
+ protected:
+  vtkVascularTerritoryEngine();
+  ~vtkVascularTerritoryEngine() override;
+
+  // RAS position of a classified voxel
+  void GetVoxelPosition(vtkIdType voxel, double x[3]) const;
+
+  // Largest distance from a classified voxel to its closest centerline point
+  double GetSearchMargin() const;
+
+  // IJK rows (ranges of classified voxels) overlapping bounds grown by margin
+  void GetRowsInBounds(const double bounds[6], double margin, std::vector<std::array<vtkIdType, 2>> &rows) const;
+
+  // Re-evaluates the voxels in the given rows whose closest block is blockId
+  // against all the blocks
+  void ReclassifyBlockVoxels(int blockId, const std::vector<std::array<vtkIdType, 2>> &rows);
+
+  // Compares the voxels in the given rows against blockId only
+  void CompareWithBlock(int blockId, const std::vector<std::array<vtkIdType, 2>> &rows);
+
+  // Stores the new classification of a voxel and keeps track of the labels
+  void Relabel(vtkIdType voxel, short newLabel);
+
+  void SnapshotBlockBounds();
+
+ protected:
+  vtkSmartPointer<vtkCenterlineAccumulator> CenterlineAccumulator;
+  vtkSmartPointer<vtkImageData> Labelmap;
+  int MaskLabel;
+  bool Initialized;
+
+  double IJKToRAS[16];
+  double RASToIJK[16];
+  int Extent[6];
+
+  // Classified voxels (offsets into the labelmap scalars, in increasing
+  // order) and the first classified voxel of every (j,k) row
+  std::vector<vtkIdType> Voxels;
+  std::vector<vtkIdType> RowStart;
+
+  // Squared distance to, and block of, the closest centerline point
+  std::vector<double> Distance2;
+  std::vector<int> Block;
+  double MaximumDistance2;
+
+  // Bounds of the blocks at the time they were last processed
+  std::map<int, std::array<double, 6>> BlockBounds;
+
+  std::map<int, vtkIdType> LabelCounts;
+  std::vector<int> ModifiedLabels;
+  vtkIdType NumberOfEvaluatedVoxels;
+  vtkIdType NumberOfRelabelledVoxels;
+
+ private:
+  vtkVascularTerritoryEngine(const vtkVascularTerritoryEngine&) = delete;
+  void operator=(const vtkVascularTerritoryEngine&) = delete;
+};
+
+#endif
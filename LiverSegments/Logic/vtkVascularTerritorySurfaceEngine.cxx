@@ -0,0 +1,474 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#include "vtkVascularTerritorySurfaceEngine.h"
+
+#include <vtkOrientedImageData.h>
+
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkDiscreteFlyingEdges3D.h>
+#include <vtkImageCast.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace
+{
+// Taubin pass-band frequency used to derive the inflate step
+const double TaubinPassBand = 0.1;
+
+//------------------------------------------------------------------------------
+// Returns the label of voxel (i,j,k) of an IJK space short labelmap, or 0
+// outside of its extent
+short LabelAt(vtkImageData *labelmap, const int extent[6], int i, int j, int k)
+{
+    if(i < extent[0] || i > extent[1] || j < extent[2] || j > extent[3] || k < extent[4] || k > extent[5])
+        return 0;
+    return *static_cast<short*>(labelmap->GetScalarPointer(i, j, k));
+}
+
+//------------------------------------------------------------------------------
+// Builds the vertex adjacency (compressed rows) of a triangle mesh
+void BuildVertexNeighbours(vtkPolyData *mesh, std::vector<vtkIdType> &offsets, std::vector<vtkIdType> &neighbours)
+{
+    vtkIdType numberOfPoints = mesh->GetNumberOfPoints();
+    std::vector<std::pair<vtkIdType, vtkIdType>> edges;
+    edges.reserve(static_cast<size_t>(mesh->GetNumberOfPolys()) * 6);
+
+    auto iter = vtk::TakeSmartPointer(mesh->GetPolys()->NewIterator());
+    vtkIdType npts;
+    const vtkIdType *pts;
+    for(iter->GoToFirstCell(); !iter->IsDoneWithTraversal(); iter->GoToNextCell())
+    {
+        iter->GetCurrentCell(npts, pts);
+        for(vtkIdType n = 0; n < npts; ++n)
+        {
+            vtkIdType a = pts[n];
+            vtkIdType b = pts[(n + 1) % npts];
+            edges.emplace_back(a, b);
+            edges.emplace_back(b, a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    offsets.assign(numberOfPoints + 1, 0);
+    neighbours.resize(edges.size());
+    for(size_t e = 0; e < edges.size(); ++e)
+    {
+        offsets[edges[e].first + 1]++;
+        neighbours[e] = edges[e].second;
+    }
+    for(vtkIdType p = 0; p < numberOfPoints; ++p)
+        offsets[p + 1] += offsets[p];
+}
+
+//------------------------------------------------------------------------------
+// One umbrella-operator relaxation step. Locked vertices do not move.
+void RelaxVertices(std::vector<double> &positions, const std::vector<vtkIdType> &offsets,
+                   const std::vector<vtkIdType> &neighbours, const std::vector<char> &locked, double factor)
+{
+    std::vector<double> relaxed(positions);
+    vtkIdType numberOfPoints = static_cast<vtkIdType>(locked.size());
+    for(vtkIdType p = 0; p < numberOfPoints; ++p)
+    {
+        vtkIdType count = offsets[p + 1] - offsets[p];
+        if(locked[p] || count == 0)
+            continue;
+        double mean[3] = {0.0, 0.0, 0.0};
+        for(vtkIdType n = offsets[p]; n < offsets[p + 1]; ++n)
+        {
+            const double *q = &positions[3 * neighbours[n]];
+            mean[0] += q[0];
+            mean[1] += q[1];
+            mean[2] += q[2];
+        }
+        for(int c = 0; c < 3; ++c)
+            relaxed[3 * p + c] = positions[3 * p + c] + factor * (mean[c] / count - positions[3 * p + c]);
+    }
+    positions.swap(relaxed);
+}
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkVascularTerritorySurfaceEngine);
+
+//------------------------------------------------------------------------------
+vtkVascularTerritorySurfaceEngine::vtkVascularTerritorySurfaceEngine()
+  : SmoothingIterations(15)
+  , SmoothingFactor(0.5)
+{
+    vtkMatrix4x4::Identity(this->ImageToWorld);
+}
+
+//------------------------------------------------------------------------------
+vtkVascularTerritorySurfaceEngine::~vtkVascularTerritorySurfaceEngine() = default;
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::PrintSelf(ostream &os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "SmoothingIterations: " << this->SmoothingIterations << "\n";
+  os << indent << "SmoothingFactor: " << this->SmoothingFactor << "\n";
+  os << indent << "Cached surfaces: " << this->Surfaces.size() << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::SetInputLabelmap(vtkOrientedImageData *labelmap)
+{
+    if(this->InputLabelmap == labelmap)
+        return;
+    this->InputLabelmap = labelmap;
+    this->Modified();
+}
+
+//------------------------------------------------------------------------------
+vtkOrientedImageData *vtkVascularTerritorySurfaceEngine::GetInputLabelmap()
+{
+    return this->InputLabelmap;
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::ClearSurfaces()
+{
+    this->Surfaces.clear();
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::UpdateCache()
+{
+    if(!this->InputLabelmap)
+    {
+        this->Surfaces.clear();
+        this->LabelExtents.clear();
+        this->WorkingLabelmap = nullptr;
+        return;
+    }
+
+    if(this->WorkingLabelmap
+       && this->CacheTime > this->GetMTime()
+       && this->CacheTime > this->InputLabelmap->GetMTime())
+        return;
+
+    this->Surfaces.clear();
+    this->LabelExtents.clear();
+
+    // Work in IJK space on short scalars. The scalars are shared with the input
+    // unless a type conversion is needed.
+    int extent[6];
+    this->InputLabelmap->GetExtent(extent);
+    this->WorkingLabelmap = vtkSmartPointer<vtkImageData>::New();
+    this->WorkingLabelmap->SetExtent(extent);
+    if(this->InputLabelmap->GetScalarType() == VTK_SHORT && this->InputLabelmap->GetNumberOfScalarComponents() == 1)
+    {
+        this->WorkingLabelmap->GetPointData()->SetScalars(this->InputLabelmap->GetPointData()->GetScalars());
+    }
+    else
+    {
+        auto imageCast = vtkSmartPointer<vtkImageCast>::New();
+        imageCast->SetInputData(this->InputLabelmap);
+        imageCast->SetOutputScalarTypeToShort();
+        imageCast->Update();
+        this->WorkingLabelmap->GetPointData()->SetScalars(imageCast->GetOutput()->GetPointData()->GetScalars());
+    }
+
+    auto imageToWorld = vtkSmartPointer<vtkMatrix4x4>::New();
+    this->InputLabelmap->GetImageToWorldMatrix(imageToWorld);
+    std::memcpy(this->ImageToWorld, imageToWorld->GetData(), sizeof(this->ImageToWorld));
+
+    this->UpdateLabelExtents();
+    this->CacheTime.Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::UpdateLabelExtents()
+{
+    this->LabelExtents.clear();
+    int extent[6];
+    this->WorkingLabelmap->GetExtent(extent);
+
+    // Bounding extent of every label, in a single pass
+    if(extent[0] <= extent[1] && extent[2] <= extent[3] && extent[4] <= extent[5])
+    {
+        const int maxLabel = std::numeric_limits<short>::max();
+        std::vector<std::array<int, 6>> extents(maxLabel + 1);
+        std::vector<char> present(maxLabel + 1, 0);
+        const short *label = static_cast<short*>(this->WorkingLabelmap->GetScalarPointer());
+        for(int k = extent[4]; k <= extent[5]; ++k)
+            for(int j = extent[2]; j <= extent[3]; ++j)
+                for(int i = extent[0]; i <= extent[1]; ++i, ++label)
+                {
+                    short value = *label;
+                    if(value <= 0)
+                        continue;
+                    std::array<int, 6> &labelExtent = extents[value];
+                    if(!present[value])
+                    {
+                        present[value] = 1;
+                        labelExtent = {i, i, j, j, k, k};
+                        continue;
+                    }
+                    labelExtent[0] = std::min(labelExtent[0], i);
+                    labelExtent[1] = std::max(labelExtent[1], i);
+                    labelExtent[2] = std::min(labelExtent[2], j);
+                    labelExtent[3] = std::max(labelExtent[3], j);
+                    labelExtent[4] = std::min(labelExtent[4], k);
+                    labelExtent[5] = std::max(labelExtent[5], k);
+                }
+        for(int value = 1; value <= maxLabel; ++value)
+            if(present[value])
+                this->LabelExtents[value] = extents[value];
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::InvalidateSurfaces(vtkIntArray *labels)
+{
+    if(!this->InputLabelmap || !this->WorkingLabelmap || !labels)
+    {
+        this->UpdateCache();
+        return;
+    }
+
+    // Scalars converted on input have to be converted again
+    if(this->WorkingLabelmap->GetPointData()->GetScalars() != this->InputLabelmap->GetPointData()->GetScalars())
+    {
+        this->WorkingLabelmap = nullptr;
+        this->UpdateCache();
+        return;
+    }
+
+    for(vtkIdType n = 0; n < labels->GetNumberOfValues(); ++n)
+        this->Surfaces.erase(labels->GetValue(n));
+    this->UpdateLabelExtents();
+    this->CacheTime.Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::GetLabels(vtkIntArray *labels)
+{
+    if(!labels)
+        return;
+    labels->Initialize();
+    this->UpdateCache();
+    for(const auto &labelExtent : this->LabelExtents)
+        labels->InsertNextValue(labelExtent.first);
+}
+
+//------------------------------------------------------------------------------
+void vtkVascularTerritorySurfaceEngine::GenerateSurfaces(vtkIntArray *labels)
+{
+    this->UpdateCache();
+
+    std::vector<int> pending;
+    if(labels)
+    {
+        for(vtkIdType n = 0; n < labels->GetNumberOfValues(); ++n)
+        {
+            int label = labels->GetValue(n);
+            if(this->LabelExtents.count(label) && !this->Surfaces.count(label)
+               && std::find(pending.begin(), pending.end(), label) == pending.end())
+                pending.push_back(label);
+        }
+    }
+    else
+    {
+        for(const auto &labelExtent : this->LabelExtents)
+            if(!this->Surfaces.count(labelExtent.first))
+                pending.push_back(labelExtent.first);
+    }
+
+    if(pending.empty())
+        return;
+
+    // Each territory only touches its own cropped copy of the labelmap, so the
+    // surfaces can be generated concurrently.
+    std::vector<vtkSmartPointer<vtkPolyData>> surfaces(pending.size());
+    vtkSMPTools::For(0, static_cast<vtkIdType>(pending.size()),
+                     [&](vtkIdType begin, vtkIdType end)
+    {
+        for(vtkIdType n = begin; n < end; ++n)
+            surfaces[n] = this->ComputeSurface(pending[n], this->LabelExtents.at(pending[n]));
+    });
+
+    for(size_t n = 0; n < pending.size(); ++n)
+        this->Surfaces[pending[n]] = surfaces[n];
+}
+
+//------------------------------------------------------------------------------
+vtkPolyData *vtkVascularTerritorySurfaceEngine::GetSurface(int label)
+{
+    this->UpdateCache();
+    if(!this->LabelExtents.count(label))
+        return nullptr;
+
+    auto surface = this->Surfaces.find(label);
+    if(surface == this->Surfaces.end())
+    {
+        auto newSurface = this->ComputeSurface(label, this->LabelExtents[label]);
+        surface = this->Surfaces.emplace(label, newSurface).first;
+    }
+    return surface->second;
+}
+
+//------------------------------------------------------------------------------
+bool vtkVascularTerritorySurfaceEngine::HasSurface(int label)
+{
+    this->UpdateCache();
+    return this->Surfaces.count(label) > 0;
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkVascularTerritorySurfaceEngine::ComputeSurface(int label, const std::array<int, 6> &labelExtent)
+{
+    int extent[6];
+    this->WorkingLabelmap->GetExtent(extent);
+
+    // Cropped copy of the label extent, padded with one background voxel so
+    // that territories touching the image border are closed too
+    int cropExtent[6] = {labelExtent[0] - 1, labelExtent[1] + 1,
+                         labelExtent[2] - 1, labelExtent[3] + 1,
+                         labelExtent[4] - 1, labelExtent[5] + 1};
+    auto crop = vtkSmartPointer<vtkImageData>::New();
+    crop->SetExtent(cropExtent);
+    crop->AllocateScalars(VTK_SHORT, 1);
+    short *cropVoxel = static_cast<short*>(crop->GetScalarPointer());
+    for(int k = cropExtent[4]; k <= cropExtent[5]; ++k)
+        for(int j = cropExtent[2]; j <= cropExtent[3]; ++j)
+            for(int i = cropExtent[0]; i <= cropExtent[1]; ++i, ++cropVoxel)
+                *cropVoxel = LabelAt(this->WorkingLabelmap, extent, i, j, k);
+
+    auto contour = vtkSmartPointer<vtkDiscreteFlyingEdges3D>::New();
+    contour->SetInputData(crop);
+    contour->SetValue(0, label);
+    contour->ComputeNormalsOff();
+    contour->ComputeGradientsOff();
+    contour->ComputeScalarsOff();
+    contour->Update();
+
+    auto surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->ShallowCopy(contour->GetOutput());
+    vtkIdType numberOfPoints = surface->GetNumberOfPoints();
+    if(numberOfPoints == 0)
+        return surface;
+
+    std::vector<double> positions(3 * numberOfPoints);
+    for(vtkIdType p = 0; p < numberOfPoints; ++p)
+        surface->GetPoint(p, &positions[3 * p]);
+
+    // Discrete contour vertices lie halfway between a voxel of this territory
+    // and a neighbouring voxel. When the neighbour belongs to another territory
+    // the vertex is part of the shared seam and must not move.
+    std::vector<char> locked(numberOfPoints, 0);
+    for(vtkIdType p = 0; p < numberOfPoints; ++p)
+    {
+        const double *x = &positions[3 * p];
+        int voxel[3] = {static_cast<int>(std::lround(x[0])),
+                        static_cast<int>(std::lround(x[1])),
+                        static_cast<int>(std::lround(x[2]))};
+        int axis = -1;
+        for(int c = 0; c < 3; ++c)
+            if(std::fabs(x[c] - voxel[c]) > 0.25)
+                axis = c;
+        if(axis < 0)
+            continue;
+
+        int first[3] = {voxel[0], voxel[1], voxel[2]};
+        int second[3] = {voxel[0], voxel[1], voxel[2]};
+        first[axis] = static_cast<int>(std::floor(x[axis]));
+        second[axis] = first[axis] + 1;
+        short firstLabel = LabelAt(this->WorkingLabelmap, extent, first[0], first[1], first[2]);
+        short secondLabel = LabelAt(this->WorkingLabelmap, extent, second[0], second[1], second[2]);
+        short neighbourLabel = (firstLabel == label) ? secondLabel : firstLabel;
+        locked[p] = (neighbourLabel > 0 && neighbourLabel != label) ? 1 : 0;
+    }
+
+    if(this->SmoothingIterations > 0 && this->SmoothingFactor > 0.0)
+    {
+        std::vector<vtkIdType> offsets;
+        std::vector<vtkIdType> neighbours;
+        BuildVertexNeighbours(surface, offsets, neighbours);
+
+        double lambda = this->SmoothingFactor;
+        double mu = 1.0 / (TaubinPassBand - 1.0 / lambda);
+        for(int iteration = 0; iteration < this->SmoothingIterations; ++iteration)
+        {
+            RelaxVertices(positions, offsets, neighbours, locked, lambda);
+            RelaxVertices(positions, offsets, neighbours, locked, mu);
+        }
+    }
+
+    // IJK to RAS
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetNumberOfPoints(numberOfPoints);
+    const double *m = this->ImageToWorld;
+    for(vtkIdType p = 0; p < numberOfPoints; ++p)
+    {
+        const double *x = &positions[3 * p];
+        points->SetPoint(p,
+                         m[0] * x[0] + m[1] * x[1] + m[2] * x[2] + m[3],
+                         m[4] * x[0] + m[5] * x[1] + m[6] * x[2] + m[7],
+                         m[8] * x[0] + m[9] * x[1] + m[10] * x[2] + m[11]);
+    }
+    surface->SetPoints(points);
+
+    auto normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+    normals->SetInputData(surface);
+    normals->ConsistencyOn();
+    normals->AutoOrientNormalsOn();
+    normals->SplittingOff();
+    normals->Update();
+
+    auto result = vtkSmartPointer<vtkPolyData>::New();
+    result->ShallowCopy(normals->GetOutput());
+    return result;
+}
@@ -0,0 +1,141 @@
+/*===============================================================================
+
+  Distributed under the OSI-approved BSD 3-Clause License.
+
+   Copyright (c) Oslo University Hospital. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+
+   * Neither the name of Oslo University Hospital nor the names
+     of Contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   This file was originally developed by Ole V. Solberg, Geir A. Tangen, Javier
+   Perez-de-Frutos (SINTEF, Norway) and Rafael Palomar (Oslo University
+   Hospital) through the ALive project (grant nr. 311393).
+
+  ===============================================================================*/
+
+#ifndef __vtkVascularTerritorySurfaceEngine_h
+#define __vtkVascularTerritorySurfaceEngine_h
+
+#include "vtkSlicerLiverSegmentsModuleLogicExport.h"
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+
+#include <array>
+#include <map>
+#include <vector>
+
+// Forward declarations
+class vtkImageData;
+class vtkIntArray;
+class vtkOrientedImageData;
+class vtkPolyData;
+
+// Generates one closed surface per label of a multi-label vascular territory
+// map. Each territory is contoured with discrete flying edges on its own
+// cropped extent and smoothed with a Taubin filter, and the territories are
+// processed in parallel. Vertices lying between two different territories
+// are kept fixed during smoothing, so the surfaces of neighbouring
+// territories share their seam exactly and tile without gaps.
+//
+// Surfaces are cached per label and only computed when requested, which lets
+// callers defer the work until a territory is actually shown.
+class VTK_SLICER_LIVERSEGMENTS_MODULE_LOGIC_EXPORT
+vtkVascularTerritorySurfaceEngine : public vtkObject
+{
+ public:
+  static vtkVascularTerritorySurfaceEngine *New();
+  vtkTypeMacro(vtkVascularTerritorySurfaceEngine, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Multi-label territory map. Voxels with value 0 are background.
+  void SetInputLabelmap(vtkOrientedImageData *labelmap);
+  vtkOrientedImageData *GetInputLabelmap();
+
+  // Number of Taubin smoothing iterations (0 disables smoothing)
+  vtkSetClampMacro(SmoothingIterations, int, 0, 1000);
+  vtkGetMacro(SmoothingIterations, int);
+
+  // Taubin shrink step (lambda). The inflate step is derived from it.
+  vtkSetClampMacro(SmoothingFactor, double, 0.0, 1.0);
+  vtkGetMacro(SmoothingFactor, double);
+
+  // Fills labels with the non-zero labels present in the input
+  void GetLabels(vtkIntArray *labels);
+
+  // Computes the surfaces of the given labels that are not cached yet, in
+  // parallel. All the labels present in the input are generated when labels
+  // is nullptr.
+  void GenerateSurfaces(vtkIntArray *labels = nullptr);
+
+  // Returns the surface (RAS coordinates, with point normals) of the given
+  // label, generating it if needed. Returns nullptr if the label is not
+  // present in the input.
+  vtkPolyData *GetSurface(int label);
+
+  // Returns true if the surface of the given label is already computed
+  bool HasSurface(int label);
+
+  // Discards all the cached surfaces
+  void ClearSurfaces();
+
+  // To be called after the input labelmap was modified in place and only the
+  // given labels changed. The surfaces of the other labels are kept.
+  void InvalidateSurfaces(vtkIntArray *labels);
+
+ protected:
+  vtkVascularTerritorySurfaceEngine();
+  ~vtkVascularTerritorySurfaceEngine() override;
+
+  // Drops the cache when the input or the parameters have changed since the
+  // last update and recomputes the per-label extents.
+  void UpdateCache();
+
+  // Computes the bounding extent of every label of the working labelmap
+  void UpdateLabelExtents();
+
+  vtkSmartPointer<vtkPolyData> ComputeSurface(int label, const std::array<int, 6> &labelExtent);
+
+ protected:
+  vtkSmartPointer<vtkOrientedImageData> InputLabelmap;
+  // Short scalars of the input on an IJK space image
+  vtkSmartPointer<vtkImageData> WorkingLabelmap;
+  double ImageToWorld[16];
+  int SmoothingIterations;
+  double SmoothingFactor;
+
+  std::map<int, std::array<int, 6>> LabelExtents;
+  std::map<int, vtkSmartPointer<vtkPolyData>> Surfaces;
+  vtkTimeStamp CacheTime;
+
+ private:
+  vtkVascularTerritorySurfaceEngine(const vtkVascularTerritorySurfaceEngine&) = delete;
+  void operator=(const vtkVascularTerritorySurfaceEngine&) = delete;
+};
+
+#endif